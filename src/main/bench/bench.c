@@ -0,0 +1,181 @@
+#include "bench.h"
+
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1E-9;
+}
+
+/// @brief Returns the duration in seconds of calls calls of run.
+static double time_calls(void (*run)(void *), void *ctx, size_t calls)
+{
+    double start = now_s();
+    for (size_t i = 0; i < calls; ++i)
+        run(ctx);
+    return now_s() - start;
+}
+
+/// @brief Returns the factor from units per second to the reported throughput.
+static double unit_scale(BenchUnit unit)
+{
+    return unit == BenchItems ? 1.0 : 1E-9;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void bench_measure(const BenchConfig *config, void (*run)(void *ctx),
+                   void *ctx, double work, BenchUnit unit, BenchResult *res)
+{
+    if (config->samples == 0)
+        errx(EXIT_FAILURE, "A benchmark needs at least one sample.");
+
+    // Warms up while doubling the calls per sample until a sample is long
+    // enough.
+    size_t calls = 1;
+    double warmup = 0.0;
+    for (;;)
+    {
+        double elapsed = time_calls(run, ctx, calls);
+        warmup += elapsed;
+        if (elapsed < config->min_sample_time)
+            calls *= 2;
+        else if (warmup >= config->warmup_time)
+            break;
+    }
+
+    double *durations = malloc(config->samples * sizeof(double));
+    if (durations == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    double total = 0.0;
+    for (size_t i = 0; i < config->samples; ++i)
+    {
+        durations[i] = time_calls(run, ctx, calls) / calls;
+        total += durations[i];
+    }
+
+    qsort(durations, config->samples, sizeof(double), compare_doubles);
+
+    size_t n = config->samples;
+    res->samples = n;
+    res->calls_per_sample = calls;
+    res->min = durations[0];
+    res->median = n % 2 ? durations[n / 2]
+                        : (durations[n / 2 - 1] + durations[n / 2]) / 2.0;
+    res->p95 = durations[(n * 95 + 99) / 100 - 1];
+    res->mean = total / n;
+    res->work = work;
+    res->unit = unit;
+    res->throughput = work / res->median * unit_scale(unit);
+
+    free(durations);
+}
+
+int bench_parse_format(const char *name, BenchFormat *format)
+{
+    static const char *const NAMES[] = {"table", "csv", "json"};
+
+    for (size_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); ++i)
+    {
+        if (strcmp(name, NAMES[i]) == 0)
+        {
+            *format = (BenchFormat)i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static const char *unit_name(BenchUnit unit)
+{
+    switch (unit)
+    {
+    case BenchFlops:
+        return "GFLOP/s";
+    case BenchBytes:
+        return "GB/s";
+    default:
+        return "items/s";
+    }
+}
+
+void bench_report_begin(BenchReport *report, FILE *out, BenchFormat format)
+{
+    report->out = out;
+    report->format = format;
+    report->count = 0;
+
+    switch (format)
+    {
+    case BenchTable:
+        fprintf(out, "%-24s %-12s %-12s %4s %12s %12s %12s %10s\n",
+                "operation", "shape", "variant", "thr", "median (us)",
+                "p95 (us)", "min (us)", "throughput");
+        break;
+    case BenchCsv:
+        fprintf(out, "name,shape,variant,threads,samples,calls_per_sample,"
+                     "min_ns,median_ns,p95_ns,mean_ns,work,unit,"
+                     "throughput\n");
+        break;
+    case BenchJson:
+        fprintf(out, "[");
+        break;
+    }
+}
+
+void bench_report_add(BenchReport *report, const BenchResult *res)
+{
+    FILE *out = report->out;
+
+    switch (report->format)
+    {
+    case BenchTable:
+        fprintf(out,
+                "%-24s %-12s %-12s %4zu %12.2f %12.2f %12.2f %10.3f %s\n",
+                res->name, res->shape, res->variant, res->threads,
+                res->median * 1E6, res->p95 * 1E6, res->min * 1E6,
+                res->throughput, unit_name(res->unit));
+        break;
+    case BenchCsv:
+        fprintf(out, "%s,%s,%s,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.0f,%s,%.4f\n",
+                res->name, res->shape, res->variant, res->threads, res->samples,
+                res->calls_per_sample, res->min * 1E9, res->median * 1E9,
+                res->p95 * 1E9, res->mean * 1E9, res->work,
+                unit_name(res->unit), res->throughput);
+        break;
+    case BenchJson:
+        fprintf(out,
+                "%s\n  {\"name\": \"%s\", \"shape\": \"%s\", \"variant\": "
+                "\"%s\", \"threads\": %zu, \"samples\": %zu, "
+                "\"calls_per_sample\": %zu, \"min_ns\": %.1f, \"median_ns\": "
+                "%.1f, \"p95_ns\": %.1f, \"mean_ns\": %.1f, \"work\": %.0f, "
+                "\"unit\": \"%s\", \"throughput\": %.4f}",
+                report->count ? "," : "", res->name, res->shape, res->variant,
+                res->threads, res->samples, res->calls_per_sample,
+                res->min * 1E9, res->median * 1E9, res->p95 * 1E9,
+                res->mean * 1E9, res->work, unit_name(res->unit),
+                res->throughput);
+        break;
+    }
+
+    report->count++;
+    fflush(out);
+}
+
+void bench_report_end(BenchReport *report)
+{
+    if (report->format == BenchJson)
+        fprintf(report->out, "\n]\n");
+    fflush(report->out);
+}
@@ -0,0 +1,111 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/// @brief The unit of the work done by a benchmarked call, which gives the
+/// unit of its throughput.
+typedef enum BenchUnit
+{
+    /// Floating point operations, reported in GFLOP/s.
+    BenchFlops,
+    /// Bytes read and written, reported in GB/s.
+    BenchBytes,
+    /// Items processed, e.g. training samples, reported in items/s.
+    BenchItems
+} BenchUnit;
+
+/// @brief The output formats of a benchmark report.
+typedef enum BenchFormat
+{
+    /// An aligned table for humans.
+    BenchTable,
+    /// One comma-separated line per result, after a header line.
+    BenchCsv,
+    /// A JSON array of one object per result.
+    BenchJson
+} BenchFormat;
+
+/// @brief How a call is measured.
+typedef struct BenchConfig
+{
+    /// @brief The minimum duration in seconds of the untimed warmup calls.
+    double warmup_time;
+    /// @brief The minimum duration in seconds of a sample. Fast calls are
+    /// repeated within a sample so that it stays well above the resolution
+    /// of the clock.
+    double min_sample_time;
+    /// @brief The number of timed samples.
+    size_t samples;
+} BenchConfig;
+
+/// @brief The default configuration: 20 ms of warmup and 25 samples of at
+/// least 2 ms.
+#define BENCH_DEFAULT_CONFIG                                                   \
+    ((BenchConfig){                                                            \
+        .warmup_time = 20E-3, .min_sample_time = 2E-3, .samples = 25})
+
+/// @brief The statistics of a benchmarked call. The durations are those of a
+/// single call, in seconds.
+typedef struct BenchResult
+{
+    /// @brief The name of the operation.
+    const char *name;
+    /// @brief The shape of its operands, e.g. "128x784".
+    const char *shape;
+    /// @brief The variant measured, e.g. the SIMD tier.
+    const char *variant;
+    /// @brief The number of threads of the variant.
+    size_t threads;
+    size_t samples;
+    size_t calls_per_sample;
+    double min;
+    double median;
+    double p95;
+    double mean;
+    /// @brief The work done by one call, in unit.
+    double work;
+    BenchUnit unit;
+    /// @brief The work done per second at the median duration, in billions of
+    /// unit, or in unit for BenchItems.
+    double throughput;
+} BenchResult;
+
+/// @brief Measures a call: warms it up, calibrates the number of calls per
+/// sample, then times config->samples samples.
+/// @param[in] config The measure configuration.
+/// @param[in] run The benchmarked call.
+/// @param[in] ctx The argument of run.
+/// @param[in] work The work done by one call.
+/// @param[in] unit The unit of work.
+/// @param[out] res The statistics of the call. Its labels (name, shape,
+/// variant and threads) are left to the caller.
+void bench_measure(const BenchConfig *config, void (*run)(void *ctx),
+                   void *ctx, double work, BenchUnit unit, BenchResult *res);
+
+/// @brief Parses a format name ("table", "csv" or "json").
+/// @param[in] name The name.
+/// @param[out] format The parsed format.
+/// @return 0 on success, or -1 if the name is unknown.
+int bench_parse_format(const char *name, BenchFormat *format);
+
+/// @brief A report being written, one result at a time.
+typedef struct BenchReport
+{
+    FILE *out;
+    BenchFormat format;
+    size_t count;
+} BenchReport;
+
+/// @brief Starts a report, e.g. writes the CSV header or opens the JSON array.
+void bench_report_begin(BenchReport *report, FILE *out, BenchFormat format);
+
+/// @brief Writes a result and flushes the output, so that a long run can be
+/// followed.
+void bench_report_add(BenchReport *report, const BenchResult *res);
+
+/// @brief Ends a report, e.g. closes the JSON array.
+void bench_report_end(BenchReport *report);
+
+#endif
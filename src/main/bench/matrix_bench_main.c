@@ -0,0 +1,916 @@
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench/bench.h"
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "matrix/simd.h"
+#include "ocr/neural_network.h"
+#include "utils/random/random.h"
+
+/// @brief The shapes of the element-wise operations: an input sample of the
+/// OCR network, its two weight matrices, and a page scanned at 150 dpi.
+static const struct
+{
+    const char *name;
+    size_t height;
+    size_t width;
+} SHAPES[] = {
+    {"784x1", 784, 1},
+    {"128x784", 128, 784},
+    {"26x128", 26, 128},
+    {"page", 1754, 1240},
+};
+
+/// @brief The operands of the element-wise operations, all of the same shape.
+typedef struct Operands
+{
+    /// @brief Uniform coefficients in [-1, 1].
+    Matrix *a;
+    Matrix *b;
+    /// @brief Coefficients of -1 and 1, so that repeated in-place products
+    /// neither vanish nor overflow.
+    Matrix *signs;
+    /// @brief A black image with a white rectangle in its middle.
+    Matrix *glyph;
+    /// @brief The smallest view of glyph holding its white rectangle.
+    MatView box;
+    /// @brief A copy of a whose rows are padded.
+    Matrix *padded;
+    /// @brief The coefficients of a in a single column.
+    Matrix *flat;
+    /// @brief A column of the height of a, and a column of its width.
+    Matrix *column;
+    Matrix *row;
+    /// @brief Columns of the height of a, one per column of a.
+    Matrix **columns;
+    /// @brief The indices of the rows of a, and room for the indices of every
+    /// coefficient of a.
+    size_t *rows;
+    size_t *indices;
+    /// @brief A matrix of the shape of the transpose of a.
+    Matrix *transposed;
+    Matrix *scratch;
+} Operands;
+
+static float negate(float x) { return -x; }
+
+static float negate_with_indexes(float x, size_t h, size_t w)
+{
+    (void)h;
+    (void)w;
+    return -x;
+}
+
+static const MatOpParams PARAMS = {.low = -0.5f, .high = 0.5f};
+
+#define OPERANDS Operands *o = ctx
+
+static void run_create_zero(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_zero(mat_height(o->a), mat_width(o->a)));
+}
+static void run_create_filled(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_filled(mat_height(o->a), mat_width(o->a), 1.0f));
+}
+static void run_create_random_uniform(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_random_uniform(mat_height(o->a), mat_width(o->a),
+                                       -1.0f, 1.0f));
+}
+static void run_create_padded(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_padded(mat_height(o->a), mat_width(o->a)));
+}
+static void run_create_from_arr(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_from_arr(mat_height(o->a), mat_width(o->a),
+                                 mat_unsafe_coef_ptr(o->a, 0, 0)));
+}
+static void run_create_random_gaussian(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_random_gaussian(mat_height(o->a), mat_width(o->a)));
+}
+static void run_create_random_normal(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_random_normal(mat_height(o->a), mat_width(o->a), 0.0f,
+                                      1.0f));
+}
+static void run_deepcopy(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_deepcopy(o->a));
+}
+static void run_copy(void *ctx)
+{
+    OPERANDS;
+    mat_copy(o->scratch, o->a);
+}
+static void run_eq(void *ctx)
+{
+    OPERANDS;
+    mat_eq(o->a, o->a, 0.0f);
+}
+static void run_addition(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_addition(o->a, o->b));
+}
+static void run_inplace_addition(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_addition(o->scratch, o->b);
+}
+static void run_inplace_add_column(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_add_column(o->scratch, o->column);
+}
+static void run_add_rows(void *ctx)
+{
+    OPERANDS;
+    mat_add_rows(o->row, o->a, o->rows, mat_height(o->a));
+}
+static void run_binary_indices(void *ctx)
+{
+    OPERANDS;
+    size_t count;
+    mat_binary_indices(o->glyph, o->indices, &count);
+}
+static void run_set_columns(void *ctx)
+{
+    OPERANDS;
+    mat_set_columns(o->scratch, (const Matrix *const *)o->columns);
+}
+static void run_subtraction(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_subtraction(o->a, o->b));
+}
+static void run_inplace_subtraction(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_subtraction(o->scratch, o->b);
+}
+static void run_scalar_multiplication(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_scalar_multiplication(o->a, 0.5f));
+}
+static void run_inplace_scalar_multiplication(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_scalar_multiplication(o->scratch, -1.0f);
+}
+static void run_hadamard(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_hadamard(o->a, o->b));
+}
+static void run_inplace_hadamard(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_hadamard(o->scratch, o->signs);
+}
+static void run_relu(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_relu(o->a));
+}
+static void run_inplace_relu(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_relu(o->scratch);
+}
+static void run_relu_derivative(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_relu_derivative(o->a));
+}
+static void run_inplace_relu_derivative(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_relu_derivative(o->scratch);
+}
+static void run_exp(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_exp(o->a));
+}
+// Repeated exponentials overflow: the input is restored before each call.
+static void run_copy_inplace_exp(void *ctx)
+{
+    OPERANDS;
+    mat_copy(o->scratch, o->a);
+    mat_inplace_exp(o->scratch);
+}
+static void run_softmax(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_softmax(o->a));
+}
+static void run_inplace_softmax(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_softmax(o->scratch);
+}
+static void run_inplace_row_softmax(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_row_softmax(o->scratch);
+}
+static void run_inplace_column_softmax(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_column_softmax(o->scratch);
+}
+static void run_inplace_toggle(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_toggle(o->scratch);
+}
+static void run_transpose(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_transpose(o->a));
+}
+static void run_transpose_into(void *ctx)
+{
+    OPERANDS;
+    mat_transpose_into(o->transposed, o->a);
+}
+static void run_inplace_transpose(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_transpose(o->scratch);
+}
+// A flattened matrix stays a column: each call flattens a new copy of a padded
+// matrix.
+static void run_deepcopy_inplace_vertical_flatten(void *ctx)
+{
+    OPERANDS;
+    Matrix *m = mat_deepcopy(o->padded);
+    mat_inplace_vertical_flatten(m);
+    mat_free(m);
+}
+static void run_sum(void *ctx)
+{
+    OPERANDS;
+    mat_sum(o->a);
+}
+static void run_sum_columns(void *ctx)
+{
+    OPERANDS;
+    mat_sum_columns(o->column, o->a);
+}
+static void run_max(void *ctx)
+{
+    OPERANDS;
+    mat_max(o->a);
+}
+static void run_max_h(void *ctx)
+{
+    OPERANDS;
+    mat_max_h(o->flat);
+}
+static void run_mean_stddev(void *ctx)
+{
+    OPERANDS;
+    float mean, stddev;
+    mat_mean_stddev(o->a, &mean, &stddev);
+}
+static void run_normalize(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_normalize(o->a));
+}
+static void run_inplace_normalize(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_normalize(o->scratch);
+}
+static void run_map(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_map(o->a, negate));
+}
+static void run_inplace_map(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_map(o->scratch, negate);
+}
+static void run_map_with_indexes(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_map_with_indexes(o->a, negate_with_indexes));
+}
+static void run_inplace_map_with_indexes(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_map_with_indexes(o->scratch, negate_with_indexes);
+}
+static void run_apply_sigmoid(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_apply(o->a, MAT_OP_SIGMOID, PARAMS));
+}
+static void run_apply_tanh(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_apply(o->a, MAT_OP_TANH, PARAMS));
+}
+static void run_apply_clamp(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_apply(o->a, MAT_OP_CLAMP, PARAMS));
+}
+static void run_apply_threshold(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_apply(o->a, MAT_OP_THRESHOLD, PARAMS));
+}
+static void run_inplace_apply_sigmoid(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_apply(o->scratch, MAT_OP_SIGMOID, PARAMS);
+}
+static void run_inplace_to_one_hot(void *ctx)
+{
+    OPERANDS;
+    mat_inplace_to_one_hot(o->scratch);
+}
+static void run_strip_margins(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_strip_margins(o->glyph));
+}
+static void run_scale_to_28(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_scale_to_28(o->glyph, 0.0f));
+}
+static void run_view_strip_margins(void *ctx)
+{
+    OPERANDS;
+    mat_view_strip_margins(mat_view(o->glyph));
+}
+static void run_view_scale_to_28(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_view_scale_to_28(o->box, 0.0f));
+}
+static void run_view_sum(void *ctx)
+{
+    OPERANDS;
+    mat_view_sum(o->box);
+}
+static void run_view_max(void *ctx)
+{
+    OPERANDS;
+    mat_view_max(o->box);
+}
+static void run_view_mean_stddev(void *ctx)
+{
+    OPERANDS;
+    float mean, stddev;
+    mat_view_mean_stddev(o->box, &mean, &stddev);
+}
+static void run_view_max_h(void *ctx)
+{
+    OPERANDS;
+    mat_view_max_h(o->box);
+}
+static void run_create_from_view(void *ctx)
+{
+    OPERANDS;
+    mat_free(mat_create_from_view(o->box));
+}
+
+/// @brief An element-wise operation and the number of matrices of the shape
+/// of its operands that one call reads or writes.
+static const struct
+{
+    const char *name;
+    void (*run)(void *ctx);
+    double streams;
+} ELEMENTWISE[] = {
+    {"create_zero", run_create_zero, 1},
+    {"create_filled", run_create_filled, 1},
+    {"create_padded", run_create_padded, 1},
+    {"create_from_arr", run_create_from_arr, 2},
+    {"create_random_uniform", run_create_random_uniform, 1},
+    {"create_random_gaussian", run_create_random_gaussian, 1},
+    {"create_random_normal", run_create_random_normal, 1},
+    {"deepcopy", run_deepcopy, 2},
+    {"copy", run_copy, 2},
+    {"eq", run_eq, 2},
+    {"addition", run_addition, 3},
+    {"inplace_addition", run_inplace_addition, 3},
+    {"inplace_add_column", run_inplace_add_column, 2},
+    {"add_rows", run_add_rows, 1},
+    {"binary_indices", run_binary_indices, 1},
+    {"set_columns", run_set_columns, 2},
+    {"subtraction", run_subtraction, 3},
+    {"inplace_subtraction", run_inplace_subtraction, 3},
+    {"scalar_multiplication", run_scalar_multiplication, 2},
+    {"inplace_scalar_mult", run_inplace_scalar_multiplication, 2},
+    {"hadamard", run_hadamard, 3},
+    {"inplace_hadamard", run_inplace_hadamard, 3},
+    {"relu", run_relu, 2},
+    {"inplace_relu", run_inplace_relu, 2},
+    {"relu_derivative", run_relu_derivative, 2},
+    {"inplace_relu_derivative", run_inplace_relu_derivative, 2},
+    {"exp", run_exp, 2},
+    {"copy+inplace_exp", run_copy_inplace_exp, 4},
+    {"softmax", run_softmax, 2},
+    {"inplace_softmax", run_inplace_softmax, 2},
+    {"inplace_row_softmax", run_inplace_row_softmax, 2},
+    {"inplace_column_softmax", run_inplace_column_softmax, 2},
+    {"inplace_toggle", run_inplace_toggle, 2},
+    {"transpose", run_transpose, 2},
+    {"transpose_into", run_transpose_into, 2},
+    {"inplace_transpose", run_inplace_transpose, 2},
+    {"inplace_vertical_flatten", run_deepcopy_inplace_vertical_flatten, 4},
+    {"sum", run_sum, 1},
+    {"sum_columns", run_sum_columns, 1},
+    {"max", run_max, 1},
+    {"max_h", run_max_h, 1},
+    {"mean_stddev", run_mean_stddev, 1},
+    {"normalize", run_normalize, 2},
+    {"inplace_normalize", run_inplace_normalize, 2},
+    {"map", run_map, 2},
+    {"inplace_map", run_inplace_map, 2},
+    {"map_with_indexes", run_map_with_indexes, 2},
+    {"inplace_map_with_indexes", run_inplace_map_with_indexes, 2},
+    {"apply_sigmoid", run_apply_sigmoid, 2},
+    {"apply_tanh", run_apply_tanh, 2},
+    {"apply_clamp", run_apply_clamp, 2},
+    {"apply_threshold", run_apply_threshold, 2},
+    {"inplace_apply_sigmoid", run_inplace_apply_sigmoid, 2},
+    {"inplace_to_one_hot", run_inplace_to_one_hot, 2},
+    {"strip_margins", run_strip_margins, 1},
+    {"scale_to_28", run_scale_to_28, 1},
+    // The box of the glyph is a quarter of the matrix.
+    {"view_strip_margins", run_view_strip_margins, 1},
+    {"view_scale_to_28", run_view_scale_to_28, 0.25},
+    {"view_sum", run_view_sum, 0.25},
+    {"view_max", run_view_max, 0.25},
+    {"view_mean_stddev", run_view_mean_stddev, 0.25},
+    {"view_max_h", run_view_max_h, 0.25},
+    {"create_from_view", run_create_from_view, 0.5},
+};
+
+/// @brief The operands of the products: a is m×k, b is k×n, and the bias and
+/// outputs of the dense layers are m×1.
+typedef struct Product
+{
+    Matrix *a;
+    Matrix *b;
+    Matrix *bias;
+    Matrix *pre;
+    Matrix *act;
+    /// @brief The m×n product.
+    Matrix *dst;
+} Product;
+
+#define PRODUCT Product *p = ctx
+
+static void run_multiplication(void *ctx)
+{
+    PRODUCT;
+    mat_free(mat_multiplication(p->a, p->b));
+}
+static void run_multiplication_into(void *ctx)
+{
+    PRODUCT;
+    mat_multiplication_into(p->dst, p->a, p->b);
+}
+static void run_gemv(void *ctx)
+{
+    PRODUCT;
+    mat_free(mat_gemv(p->a, p->b));
+}
+static void run_gemv_add_bias(void *ctx)
+{
+    PRODUCT;
+    mat_free(mat_gemv_add_bias(p->a, p->b, p->bias));
+}
+static void run_dense_relu(void *ctx)
+{
+    PRODUCT;
+    mat_dense_relu(p->a, p->b, p->bias, p->pre, p->act);
+}
+
+/// @brief The products of the OCR network (m, k, n): the layers of
+/// net_feed_forward, the transposed products and outer products of
+/// net_back_propagation, and the products of a mini-batch of 64 samples.
+static const struct
+{
+    const char *name;
+    void (*run)(void *ctx);
+    size_t m, k, n;
+} PRODUCTS[] = {
+    {"multiplication", run_multiplication, 128, 784, 1},
+    {"multiplication", run_multiplication, 26, 128, 1},
+    {"multiplication", run_multiplication, 784, 128, 1},
+    {"multiplication", run_multiplication, 128, 1, 784},
+    {"multiplication", run_multiplication, 26, 1, 128},
+    {"multiplication", run_multiplication, 128, 784, 64},
+    {"multiplication", run_multiplication, 26, 128, 64},
+    {"multiplication_into", run_multiplication_into, 128, 784, 64},
+    {"multiplication_into", run_multiplication_into, 26, 128, 64},
+    {"gemv", run_gemv, 128, 784, 1},
+    {"gemv", run_gemv, 26, 128, 1},
+    {"gemv", run_gemv, 784, 128, 1},
+    {"gemv_add_bias", run_gemv_add_bias, 128, 784, 1},
+    {"gemv_add_bias", run_gemv_add_bias, 26, 128, 1},
+    {"dense_relu", run_dense_relu, 128, 784, 1},
+    {"dense_relu", run_dense_relu, 26, 128, 1},
+};
+
+#define LENGTH(array) (sizeof(array) / sizeof(array[0]))
+
+/// @brief The command line options.
+static struct
+{
+    BenchFormat format;
+    BenchConfig config;
+    /// @brief Only the operations whose name contains filter are run.
+    const char *filter;
+    /// @brief Whether every tier supported by the CPU is measured, or only
+    /// the active one.
+    int all_tiers;
+} options;
+
+static BenchReport report;
+
+static int selected(const char *name)
+{
+    return options.filter == NULL || strstr(name, options.filter) != NULL;
+}
+
+static void add_result(BenchResult *res, const char *name, const char *shape)
+{
+    res->name = name;
+    res->shape = shape;
+    res->variant = simd_tier_name(simd_tier());
+    res->threads = mat_thread_count();
+    bench_report_add(&report, res);
+}
+
+static void bench_elementwise()
+{
+    for (size_t s = 0; s < LENGTH(SHAPES); ++s)
+    {
+        size_t height = SHAPES[s].height, width = SHAPES[s].width;
+
+        Operands o = {
+            .a = mat_create_random_uniform(height, width, -1.0f, 1.0f),
+            .b = mat_create_random_uniform(height, width, -1.0f, 1.0f),
+            .signs = mat_create_filled(height, width, 1.0f),
+            .glyph = mat_create_zero(height, width),
+        };
+        for (size_t h = 0; h < height; ++h)
+            for (size_t w = 0; w < width; ++w)
+            {
+                if (rand() % 2)
+                    *mat_unsafe_coef_ptr(o.signs, h, w) = -1.0f;
+                if (h >= height / 4 && h < height - height / 4 &&
+                    w >= width / 4 && w < width - width / 4)
+                    *mat_unsafe_coef_ptr(o.glyph, h, w) = 1.0f;
+            }
+
+        o.box = mat_view_strip_margins(mat_view(o.glyph));
+        o.padded = mat_create_padded(height, width);
+        mat_copy(o.padded, o.a);
+        o.flat = mat_deepcopy(o.a);
+        mat_inplace_vertical_flatten(o.flat);
+        o.column = mat_create_zero(height, 1);
+        o.row = mat_create_zero(width, 1);
+        o.transposed = mat_create(width, height);
+        o.columns = malloc(width * sizeof(Matrix *));
+        o.rows = malloc(height * sizeof(size_t));
+        o.indices = malloc(height * width * sizeof(size_t));
+        if (o.columns == NULL || o.rows == NULL || o.indices == NULL)
+            errx(EXIT_FAILURE, "Memory allocation failed");
+        for (size_t w = 0; w < width; ++w)
+            o.columns[w] = mat_create_random_uniform(height, 1, -1.0f, 1.0f);
+        for (size_t h = 0; h < height; ++h)
+            o.rows[h] = h;
+
+        double bytes = (double)height * width * sizeof(float);
+
+        for (size_t i = 0; i < LENGTH(ELEMENTWISE); ++i)
+        {
+            if (!selected(ELEMENTWISE[i].name))
+                continue;
+
+            // In-place operations start from a fresh copy of a.
+            o.scratch = mat_deepcopy(o.a);
+
+            BenchResult res;
+            bench_measure(&options.config, ELEMENTWISE[i].run, &o,
+                          ELEMENTWISE[i].streams * bytes, BenchBytes, &res);
+            add_result(&res, ELEMENTWISE[i].name, SHAPES[s].name);
+
+            mat_free(o.scratch);
+        }
+
+        mat_free(o.a);
+        mat_free(o.b);
+        mat_free(o.signs);
+        mat_free(o.glyph);
+        mat_free(o.padded);
+        mat_free(o.flat);
+        mat_free(o.column);
+        mat_free(o.row);
+        mat_free(o.transposed);
+        mat_free_matrix_array(o.columns, width);
+        free(o.rows);
+        free(o.indices);
+    }
+}
+
+static void bench_products()
+{
+    for (size_t i = 0; i < LENGTH(PRODUCTS); ++i)
+    {
+        if (!selected(PRODUCTS[i].name))
+            continue;
+
+        size_t m = PRODUCTS[i].m, k = PRODUCTS[i].k, n = PRODUCTS[i].n;
+        Product p = {
+            .a = mat_create_random_uniform(m, k, -1.0f, 1.0f),
+            .b = mat_create_random_uniform(k, n, -1.0f, 1.0f),
+            .bias = mat_create_random_uniform(m, 1, -1.0f, 1.0f),
+            .pre = mat_create(m, 1),
+            .act = mat_create(m, 1),
+            .dst = mat_create(m, n),
+        };
+
+        char shape[32];
+        snprintf(shape, sizeof(shape), "%zux%zux%zu", m, k, n);
+
+        BenchResult res;
+        bench_measure(&options.config, PRODUCTS[i].run, &p,
+                      2.0 * (double)m * k * n, BenchFlops, &res);
+        add_result(&res, PRODUCTS[i].name, shape);
+
+        mat_free(p.a);
+        mat_free(p.b);
+        mat_free(p.bias);
+        mat_free(p.pre);
+        mat_free(p.act);
+        mat_free(p.dst);
+    }
+}
+
+/// @brief The matrix files written and read by the file benchmarks, in the
+/// current directory like the network files below.
+#define MATRIX_FILE_LEGACY "bench_matrix_legacy.matrix"
+#define MATRIX_FILE_V2 "bench_matrix_v2.matrix"
+
+/// @brief A matrix and the file it is written to or read from.
+typedef struct MatrixFile
+{
+    const Matrix *m;
+    const char *filename;
+} MatrixFile;
+
+static void run_save(void *ctx)
+{
+    MatrixFile *f = ctx;
+    mat_save_to_file(f->m, f->filename);
+}
+static void run_save_v2(void *ctx)
+{
+    MatrixFile *f = ctx;
+    mat_save_to_file_v2(f->m, f->filename);
+}
+static void run_load(void *ctx)
+{
+    MatrixFile *f = ctx;
+    mat_free(mat_load_from_file(f->filename));
+}
+static void run_mmap_file(void *ctx)
+{
+    MatrixFile *f = ctx;
+    mat_free(mat_mmap_file(f->filename));
+}
+
+/// @brief The operations on matrix files, and whether they use the version 2
+/// format.
+static const struct
+{
+    const char *name;
+    void (*run)(void *ctx);
+    int v2;
+} MATRIX_FILE_OPERATIONS[] = {
+    {"save", run_save, 0},           {"save_v2", run_save_v2, 1},
+    {"load_legacy", run_load, 0},    {"load_v2", run_load, 1},
+    {"mmap_file", run_mmap_file, 1},
+};
+
+static double file_size(const char *filename)
+{
+    struct stat st;
+    if (stat(filename, &st) == -1)
+        errx(EXIT_FAILURE, "Failed to stat file: %s", filename);
+    return (double)st.st_size;
+}
+
+/// @brief Measures the writes and reads of matrix files of every shape, in
+/// both formats, with a warm page cache. They do not depend on the SIMD tier.
+static void bench_matrix_files()
+{
+    for (size_t s = 0; s < LENGTH(SHAPES); ++s)
+    {
+        Matrix *m = mat_create_random_uniform(SHAPES[s].height,
+                                              SHAPES[s].width, -1.0f, 1.0f);
+        mat_save_to_file(m, MATRIX_FILE_LEGACY);
+        mat_save_to_file_v2(m, MATRIX_FILE_V2);
+
+        for (size_t i = 0; i < LENGTH(MATRIX_FILE_OPERATIONS); ++i)
+        {
+            if (!selected(MATRIX_FILE_OPERATIONS[i].name))
+                continue;
+
+            MatrixFile f = {
+                .m = m,
+                .filename = MATRIX_FILE_OPERATIONS[i].v2 ? MATRIX_FILE_V2
+                                                         : MATRIX_FILE_LEGACY,
+            };
+
+            BenchResult res;
+            bench_measure(&options.config, MATRIX_FILE_OPERATIONS[i].run, &f,
+                          file_size(f.filename), BenchBytes, &res);
+            res.name = MATRIX_FILE_OPERATIONS[i].name;
+            res.shape = SHAPES[s].name;
+            res.variant = "warm";
+            res.threads = 1;
+            bench_report_add(&report, &res);
+        }
+
+        unlink(MATRIX_FILE_LEGACY);
+        unlink(MATRIX_FILE_V2);
+        mat_free(m);
+    }
+}
+
+/// @brief The network files measured by the load benchmarks, written in the
+/// current directory rather than in /tmp, which may be in memory and have no
+/// cache to drop.
+static const struct
+{
+    const char *name;
+    const char *filename;
+    /// @brief Whether the file is in the version 2 format.
+    int v2;
+} MODEL_FILES[] = {
+    {"net_load_legacy", "bench_model_legacy.nn", 0},
+    {"net_load_v2", "bench_model_v2.nn", 1},
+};
+
+/// @brief A network file to load, and whether its pages are evicted from the
+/// page cache before each load.
+typedef struct ModelLoad
+{
+    const char *filename;
+    int cold;
+} ModelLoad;
+
+/// @brief Evicts the pages of a file from the page cache. It must have been
+/// synced: dirty pages are not evicted.
+static void drop_page_cache(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static void run_net_load(void *ctx)
+{
+    ModelLoad *l = ctx;
+    if (l->cold)
+        drop_page_cache(l->filename);
+    net_free(net_load_from_file((char *)l->filename));
+}
+
+/// @brief Measures the load of a network of the shape of the OCR models in
+/// each file format, with cold and warm page caches. The loads do not depend
+/// on the SIMD tier: the variant is the state of the cache.
+static void bench_model_loads()
+{
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 128, 26});
+
+    for (size_t i = 0; i < LENGTH(MODEL_FILES); ++i)
+    {
+        if (!selected(MODEL_FILES[i].name))
+            continue;
+
+        const char *filename = MODEL_FILES[i].filename;
+        if (MODEL_FILES[i].v2)
+            net_save_to_file_v2(net, filename);
+        else
+            net_save_to_file(net, (char *)filename);
+
+        int fd = open(filename, O_RDONLY);
+        struct stat st;
+        if (fd == -1 || fsync(fd) == -1 || fstat(fd, &st) == -1)
+            errx(EXIT_FAILURE, "Failed to sync file: %s", filename);
+        close(fd);
+
+        for (int cold = 1; cold >= 0; --cold)
+        {
+            ModelLoad l = {.filename = filename, .cold = cold};
+
+            BenchResult res;
+            bench_measure(&options.config, run_net_load, &l,
+                          (double)st.st_size, BenchBytes, &res);
+            res.name = MODEL_FILES[i].name;
+            res.shape = "784x128x26";
+            res.variant = cold ? "cold" : "warm";
+            res.threads = 1;
+            bench_report_add(&report, &res);
+        }
+
+        unlink(filename);
+    }
+
+    net_free(net);
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE,
+         "Usage: %s [--format table|csv|json] [--all-tiers] [--samples N] "
+         "[--filter NAME]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    options.format = BenchTable;
+    options.config = BENCH_DEFAULT_CONFIG;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--all-tiers") == 0)
+            options.all_tiers = 1;
+        else if (i + 1 >= argc)
+            usage(argv[0]);
+        else if (strcmp(argv[i], "--format") == 0)
+        {
+            if (bench_parse_format(argv[++i], &options.format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0)
+        {
+            options.config.samples = strtoul(argv[++i], NULL, 10);
+            if (options.config.samples == 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--filter") == 0)
+            options.filter = argv[++i];
+        else
+            usage(argv[0]);
+    }
+
+    rand_seed();
+
+    SimdTier active = simd_tier();
+    SimdTier first = options.all_tiers ? SimdScalar : active;
+    SimdTier last = options.all_tiers ? simd_detect_tier() : active;
+
+    bench_report_begin(&report, stdout, options.format);
+
+    for (SimdTier tier = first; tier <= last; ++tier)
+    {
+        simd_set_tier(tier);
+        bench_elementwise();
+        bench_products();
+    }
+
+    bench_matrix_files();
+    bench_model_loads();
+
+    bench_report_end(&report);
+    simd_set_tier(active);
+
+    return EXIT_SUCCESS;
+}
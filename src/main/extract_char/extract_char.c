@@ -34,21 +34,29 @@ int save_image_region(const Matrix *matrix, const char *name, size_t x0,
     size_t width = 1 + x1 - x0;
     size_t height = 1 + y1 - y0;
 
+    return save_view_to_png(
+        mat_subview(mat_view(matrix), y0, x0, height, width), name);
+}
+
+int save_view_to_png(MatView view, const char *name)
+{
     GdkPixbuf *pixbuf =
-        gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+        gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, view.width, view.height);
     guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
     int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
 
-    for (size_t j = 0; j < height; j++)
+    for (size_t j = 0; j < view.height; j++)
     {
         guchar *p = pixels + j * rowstride;
-        for (size_t i = 0; i < width; i++)
+        const float *row = mat_view_row(view, j);
+        for (size_t i = 0; i < view.width; i++)
         {
-            float val = mat_coef(matrix, j + y0, i + x0);
+            float val = row[i];
 
             if (val > 255 || val < 0)
             {
-                fprintf(stderr, "save_image_region: value out of bound\n");
+                fprintf(stderr, "save_view_to_png: value out of bound\n");
+                g_object_unref(pixbuf);
                 return -3;
             }
 
@@ -62,8 +70,7 @@ int save_image_region(const Matrix *matrix, const char *name, size_t x0,
 
     if (!save_success)
     {
-        fprintf(stderr,
-                "save_image_region: Failed to save the region as png\n");
+        fprintf(stderr, "save_view_to_png: Failed to save the view as png\n");
         g_object_unref(pixbuf);
         return -4;
     }
@@ -23,4 +23,13 @@
 int save_image_region(const Matrix *matrix, const char *name, size_t x0,
                       size_t y0, size_t x1, size_t y1);
 
+/// @brief Saves a view of a matrix as a grayscale PNG image, without copying
+/// it first.
+/// @param[in] view The view to save. Its coefficients must be in [0, 255].
+/// @param[in] name Output PNG filename. Must not be NULL.
+/// @return 0 on success, or a negative error code:
+///         -3 if a pixel value is out of bounds,
+///         -4 if saving the PNG fails.
+int save_view_to_png(MatView view, const char *name);
+
 #endif
@@ -6,8 +6,9 @@
 #include <string.h>
 
 #include "image_loader/image_loading.h"
+#include "matrix/arena.h"
 #include "matrix/matrix.h"
-#include "ocr/neural_network.h"
+#include "ocr/ocr_client.h"
 #include "pretreatment/pretreatment.h"
 #include "pretreatment/visualization.h"
 
@@ -19,16 +20,18 @@ static void build_cell_path(char *out, size_t outsz, const char *folder,
     snprintf(out, outsz, "%s/(%zu_%zu).png", folder, r, c);
 }
 
-static char recognize_letter_from_png(const char *path, Neural_Network *net)
+/// @brief Loads a cell image as an input of the OCR network, or returns NULL if
+/// it cannot be read or is empty.
+static Matrix *load_letter_input(const char *path)
 {
     ImageData *img = load_image(path);
     if (!img)
-        return '?';
+        return NULL;
 
     Matrix *m = image_to_grayscale(img);
     free_image(img);
     if (!m)
-        return '?';
+        return NULL;
 
     // Matrix *tmp = adaptative_gaussian_thresholding(m, 1.0f, 3, 1, 1);
     // export_matrix(tmp, "test.png");
@@ -37,22 +40,22 @@ static char recognize_letter_from_png(const char *path, Neural_Network *net)
 
     mat_inplace_toggle(m);
 
-    Matrix *tmp = mat_strip_margins(m);
-    mat_free(m);
-    if (!tmp)
-        return '?';
-    m = tmp;
+    // The margins are stripped without copying: only the scaled letter is
+    // allocated.
+    MatView glyph = mat_view_strip_margins(mat_view(m));
+    if (glyph.height == 0)
+    {
+        mat_free(m);
+        return NULL;
+    }
 
-    tmp = mat_scale_to_28(m, 0.0f);
+    Matrix *tmp = mat_view_scale_to_28(glyph, 0.0f);
     mat_free(m);
     m = tmp;
 
     mat_inplace_vertical_flatten(m);
 
-    char letter = net_decode_letter(net, m, NULL);
-
-    mat_free(m);
-    return letter;
+    return m;
 }
 
 static int detect_grid_size(const char *folder, size_t *rows, size_t *cols)
@@ -98,38 +101,55 @@ Grid *grid_rebuild_from_folder_with_model(const char *folder,
         return NULL;
     }
 
-    Neural_Network *net = net_load_from_file((char *)model_path);
-    if (!net)
-        return NULL;
-
     Grid *g = malloc(sizeof(Grid));
     if (!g)
-    {
-        net_free(net);
         return NULL;
-    }
 
     g->height = rows;
     g->width = cols;
     g->content = calloc(rows * cols, sizeof(char));
     if (!g->content)
     {
-        net_free(net);
         free(g);
         return NULL;
     }
 
     char path[MAX_PATH];
 
+    // The cells have similar sizes: their matrices are recycled by the arena.
+    MatArena *arena = mat_arena_create();
+    mat_arena_begin(arena);
+
+    Matrix **cells = calloc(rows * cols, sizeof(Matrix *));
+    if (!cells)
+    {
+        mat_arena_end();
+        mat_arena_free(arena);
+        free(g->content);
+        free(g);
+        return NULL;
+    }
+
+    // Every cell is loaded first, then they are all decoded in a single
+    // forward pass, by the OCR server if one runs.
     for (size_t r = 0; r < rows; ++r)
     {
         for (size_t c = 0; c < cols; ++c)
         {
             build_cell_path(path, sizeof(path), folder, c, r);
-            g->content[r * cols + c] = recognize_letter_from_png(path, net);
+            cells[r * cols + c] = load_letter_input(path);
         }
     }
 
-    net_free(net);
+    ocr_decode_letter_array(model_path, cells, rows * cols, g->content);
+
+    for (size_t i = 0; i < rows * cols; ++i)
+        if (cells[i])
+            mat_free(cells[i]);
+    free(cells);
+
+    mat_arena_end();
+    mat_arena_free(arena);
+
     return g;
 }
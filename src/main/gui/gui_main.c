@@ -1,7 +1,7 @@
 #include "grid_rebuild/grid_rebuild.h"
 #include "image_loader/image_loading.h"
 #include "location/letters_extraction.h"
-#include "ocr/neural_network.h"
+#include "ocr/ocr_client.h"
 #include "pretreatment/pretreatment.h"
 #include "pretreatment/visualization.h"
 #include "solver/grid.h"
@@ -139,12 +139,10 @@ static void load_action(GtkButton *button, gpointer user_data)
 
         mat_inplace_vertical_flatten(m);
 
-        Neural_Network *net =
-            net_load_from_file("assets/ocr/model/" MODEL ".nn");
-        char res = net_decode_letter(net, m, NULL);
+        char res;
+        ocr_decode_letter_array("assets/ocr/model/" MODEL ".nn", &m, 1, &res);
 
         mat_free(m);
-        net_free(net);
         g_print("The character is : %c\n", res);
         int **word_pos = grid_solve(grid, words, nb_words);
         highlight_words(POSTTREATMENT_FILENAME, word_pos, points, nb_words);
@@ -129,30 +129,7 @@ void statistics_on_accumulator(Matrix *accumulator, float *stddev_out,
 {
     if (stddev_out == NULL || mean_out == NULL)
         errx(EXIT_FAILURE, "Got null out parameters : stddev or mean");
-    size_t height = mat_height(accumulator);
-    size_t width = mat_width(accumulator);
-    size_t N = height * width;
-    float sum = 0;
-    for (size_t h = 0; h < height; h++)
-    {
-        for (size_t w = 0; w < width; w++)
-        {
-            sum += mat_coef(accumulator, h, w);
-        }
-    }
-    *mean_out = sum / N;
-
-    float var_sum = 0;
-    for (size_t h = 0; h < height; h++)
-    {
-        for (size_t w = 0; w < width; w++)
-        {
-            float diff = mat_coef(accumulator, h, w) - *mean_out;
-            var_sum += diff * diff;
-        }
-    }
-
-    *stddev_out = sqrtf(var_sum / N);
+    mat_mean_stddev(accumulator, mean_out, stddev_out);
 }
 
 Line **extract_hough_lines(Matrix *accumulator, size_t threshold,
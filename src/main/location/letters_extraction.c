@@ -3,6 +3,7 @@
 #include "location/location_word_letters.h"
 #include "location/split_letters.h"
 
+#include "matrix/arena.h"
 #include "pretreatment/pretreatment.h"
 #include "pretreatment/visualization.h"
 #include "rotation/rotation.h"
@@ -26,39 +27,35 @@ Matrix *load_and_preprocess_image(const char *input_image, Matrix **rotated_out)
     if (img == NULL)
         return NULL;
 
-    Matrix *gray = image_to_grayscale(img);
-    if (gray == NULL)
-    {
-        free_image(img);
-        return NULL;
-    }
-    status_export = export_matrix(gray, GRAYSCALED_FILENAME);
+    // The grayscale stages work on byte matrices and the binary ones on bits;
+    // only the deskewing, whose Hough transform needs float arithmetic, works
+    // on a float matrix.
+    MatU8 *gray = image_to_grayscale_u8(img);
+    status_export = export_matrix_u8(gray, GRAYSCALED_FILENAME);
     if (status_export != 0)
     {
         fprintf(stderr, "step export : failed to export grayscale\n");
     }
     free_image(img);
 
-    Matrix *threshold = adaptative_gaussian_thresholding(gray, 255, 11, 7, 4);
+    MatU8 *threshold = adaptative_gaussian_thresholding_u8(gray, 255, 11, 7, 4);
+    mat_u8_free(gray);
     if (threshold == NULL)
-    {
-        mat_free(gray);
         return NULL;
-    }
 
-    status_export = export_matrix(threshold, THRESHOLDED_FILENAME);
+    status_export = export_matrix_u8(threshold, THRESHOLDED_FILENAME);
     if (status_export != 0)
     {
         fprintf(stderr, "step export : failed to export thresholded\n");
     }
-    mat_free(gray);
 
-    Matrix *rotated = auto_deskew_matrix(threshold);
+    Matrix *threshold_f = mat_u8_to_matrix(threshold);
+    mat_u8_free(threshold);
+
+    Matrix *rotated = auto_deskew_matrix(threshold_f);
+    mat_free(threshold_f);
     if (rotated == NULL)
-    {
-        mat_free(threshold);
         return NULL;
-    }
 
     *rotated_out = rotated;
 
@@ -67,41 +64,47 @@ Matrix *load_and_preprocess_image(const char *input_image, Matrix **rotated_out)
     {
         fprintf(stderr, "step export : failed to export rotated\n");
     }
-    mat_free(threshold);
 
-    Matrix *closing = morph_transform(rotated, 1, Closing);
+    // The deskewed image is binary: the morphology runs on packed bits.
+    BitMatrix *rotated_bits = mat_bit_from_view(mat_view(rotated), 127.0f);
+    BitMatrix *closing = morph_transform_bit(rotated_bits, 1, Closing);
+    mat_bit_free(rotated_bits);
     if (closing == NULL)
     {
         mat_free(rotated);
+        *rotated_out = NULL;
         return NULL;
     }
 
-    status_export = export_matrix(closing, CLOSING_FILENAME);
+    status_export = export_bit_matrix(closing, CLOSING_FILENAME);
     if (status_export != 0)
     {
         fprintf(stderr, "step export : failed to export closing\n");
     }
 
-    Matrix *opening = morph_transform(closing, 2, Opening);
+    BitMatrix *opening = morph_transform_bit(closing, 2, Opening);
+    mat_bit_free(closing);
     if (opening == NULL)
     {
-        mat_free(closing);
         mat_free(rotated);
+        *rotated_out = NULL;
         return NULL;
     }
 
-    status_export = export_matrix(opening, OPENING_FILENAME);
+    status_export = export_bit_matrix(opening, OPENING_FILENAME);
     if (status_export != 0)
     {
         fprintf(stderr, "step export : failed to export opening\n");
     }
-    status_export = export_matrix(opening, POSTTREATMENT_FILENAME);
+    status_export = export_bit_matrix(opening, POSTTREATMENT_FILENAME);
     if (status_export != 0)
     {
         fprintf(stderr, "step export : failed to export post treatment\n");
     }
-    mat_free(closing);
-    return opening;
+
+    Matrix *processed = mat_bit_to_matrix(opening, 0.0f, 255.0f);
+    mat_bit_free(opening);
+    return processed;
 }
 
 /// @brief Runs Hough line detection on the rotated image and extracts
@@ -165,14 +168,18 @@ static int extract_words_and_letters(Matrix *processed_img,
 
     int status_export;
 
+    // The histograms are computed on the packed binary image.
+    BitMatrix *bits = mat_bit_from_view(mat_view(processed_img), 0.0f);
+
     /// ======== Extract word bounding boxes ========
     size_t nb_words;
-    BoundingBox **words_boxes = get_bounding_box_words(
-        processed_img, remaining_box, 5, 20, 4, &nb_words);
+    BoundingBox **words_boxes =
+        get_bounding_box_words(bits, remaining_box, 5, 20, 4, &nb_words);
 
     if (words_boxes == NULL)
     {
         fprintf(stderr, "Failed to get word bounding boxes\n");
+        mat_bit_free(bits);
         return -2;
     }
 
@@ -194,7 +201,8 @@ static int extract_words_and_letters(Matrix *processed_img,
 
     size_t *word_nb_letters;
     BoundingBox ***letters_boxes = get_bounding_box_letters(
-        processed_img, words_boxes, nb_words, 2, &word_nb_letters);
+        bits, words_boxes, nb_words, 2, &word_nb_letters);
+    mat_bit_free(bits);
 
     if (letters_boxes == NULL)
     {
@@ -256,9 +264,11 @@ static int extract_words_and_letters(Matrix *processed_img,
     return EXIT_SUCCESS;
 }
 
-int locate_and_extract_letters_png(const char *input_image,
-                                   Point ***out_intersection_points,
-                                   size_t *out_h_points, size_t *out_w_points)
+/// @brief Runs the pipeline of locate_and_extract_letters_png, in the arena
+/// scope of its caller.
+static int locate_and_extract(const char *input_image,
+                              Point ***out_intersection_points,
+                              size_t *out_h_points, size_t *out_w_points)
 {
     cleanup_folders();
     setup_folders();
@@ -343,4 +353,23 @@ int locate_and_extract_letters_png(const char *input_image,
     mat_free(processed_img);
 
     return (status == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
-}
\ No newline at end of file
+}
+
+int locate_and_extract_letters_png(const char *input_image,
+                                   Point ***out_intersection_points,
+                                   size_t *out_h_points, size_t *out_w_points)
+{
+    // The images of a run have the sizes of those of the previous one: their
+    // matrices are recycled by an arena kept from one run to the next. None of
+    // them outlives the run.
+    static MatArena *arena = NULL;
+    if (arena == NULL)
+        arena = mat_arena_create();
+
+    mat_arena_begin(arena);
+    int status = locate_and_extract(input_image, out_intersection_points,
+                                    out_h_points, out_w_points);
+    mat_arena_end();
+
+    return status;
+}
@@ -2,6 +2,7 @@
 #include "extract_char/extract_char.h"
 #include "rotation/rotation.h"
 #include "utils/utils.h"
+#include <err.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -14,6 +15,18 @@ void free_bboxes(BoundingBox **boxes, size_t size)
     free(boxes);
 }
 
+MatView bbox_view(const Matrix *src, const BoundingBox *box)
+{
+    if (box->tl.x < 0 || box->tl.y < 0 || box->tl.x > box->br.x ||
+        box->tl.y > box->br.y)
+        errx(EXIT_FAILURE, "bbox_view: invalid bounding box (%d, %d) -> (%d, "
+                           "%d)",
+             box->tl.x, box->tl.y, box->br.x, box->br.y);
+
+    return mat_subview(mat_view(src), box->tl.y, box->tl.x,
+                       box->br.y - box->tl.y + 1, box->br.x - box->tl.x + 1);
+}
+
 void cleanup_folders()
 {
     char cmd[255];
@@ -13,6 +13,14 @@ typedef struct BoundingBox
     Point br;
 } BoundingBox;
 
+/// @brief Returns a view of the region of a matrix inside a bounding box (both
+/// corners included), without copying it.
+/// @param[in] src Pointer to the source matrix.
+/// @param[in] box Pointer to the bounding box. It must be inside src.
+/// @return The view of the region.
+/// @throw Terminates the program if the box is not inside src.
+MatView bbox_view(const Matrix *src, const BoundingBox *box);
+
 /// @brief Frees an array of BoundingBox previously allocated on the heap
 /// @param boxes An array of pointers to BoundingBox to free
 /// @param size The size of the array
@@ -105,7 +105,8 @@ BoundingBox *find_biggest_remaining_area(BoundingBox *grid_box,
     return remaining_area;
 }
 
-size_t *histogram_horizontal(Matrix *src, BoundingBox *area, size_t *size_out)
+size_t *histogram_horizontal(const BitMatrix *src, BoundingBox *area,
+                             size_t *size_out)
 {
     if (area == NULL)
     {
@@ -125,9 +126,9 @@ size_t *histogram_horizontal(Matrix *src, BoundingBox *area, size_t *size_out)
         return NULL;
     }
 
-    size_t height = mat_height(src);
-    size_t width = mat_width(src);
-    if (area->br.y >= (int)height || area->br.y >= (int)width)
+    size_t height = mat_bit_height(src);
+    size_t width = mat_bit_width(src);
+    if (area->br.y >= (int)height || area->br.x >= (int)width)
     {
         fprintf(stderr, "histogram_horizontal: The area concerned is outside "
                         "of the bounds of the src matrix\n");
@@ -136,23 +137,18 @@ size_t *histogram_horizontal(Matrix *src, BoundingBox *area, size_t *size_out)
 
     *size_out = area->br.y - area->tl.y + 1;
     size_t vert_size = area->br.x - area->tl.x + 1;
-    size_t *histogram = calloc(*size_out, sizeof(size_t));
+    size_t *histogram = malloc(*size_out * sizeof(size_t));
     if (histogram == NULL)
     {
         fprintf(stderr, "histogram_horizontal: Histogram allocation failed\n");
         return NULL;
     }
+
+    // The set bits are the white pixels: the black ones are the others.
+    mat_bit_row_histogram(src, area->tl.y, area->tl.x, *size_out, vert_size,
+                          histogram);
     for (size_t h = 0; h < *size_out; h++)
-    {
-        for (size_t w = 0; w < vert_size; w++)
-        {
-            float pixel = mat_coef(src, h + area->tl.y, w + area->tl.x);
-            if (pixel == 0.0f)
-            {
-                histogram[h] += 1;
-            }
-        }
-    }
+        histogram[h] = vert_size - histogram[h];
     return histogram;
 }
 
@@ -257,7 +253,7 @@ BoundingBox **find_words_histogram_threshold(BoundingBox *area,
     return words_boxes;
 }
 
-BoundingBox **get_bounding_box_words(Matrix *src, BoundingBox *area,
+BoundingBox **get_bounding_box_words(const BitMatrix *src, BoundingBox *area,
                                      size_t threshold, size_t area_padding,
                                      size_t word_margin, size_t *size_out)
 {
@@ -322,7 +318,8 @@ BoundingBox **get_bounding_box_words(Matrix *src, BoundingBox *area,
     return words_boxes;
 }
 
-size_t *histogram_vertical(Matrix *src, BoundingBox *area, size_t *size_out)
+size_t *histogram_vertical(const BitMatrix *src, BoundingBox *area,
+                           size_t *size_out)
 {
     if (area == NULL)
     {
@@ -341,8 +338,8 @@ size_t *histogram_vertical(Matrix *src, BoundingBox *area, size_t *size_out)
         return NULL;
     }
 
-    size_t height = mat_height(src);
-    size_t width = mat_width(src);
+    size_t height = mat_bit_height(src);
+    size_t width = mat_bit_width(src);
 
     // Reject negative coordinates
     if (area->tl.x < 0 || area->tl.y < 0 || area->br.x < 0 || area->br.y < 0)
@@ -367,23 +364,18 @@ size_t *histogram_vertical(Matrix *src, BoundingBox *area, size_t *size_out)
 
     size_t horiz_size = area->br.y - area->tl.y + 1;
     *size_out = area->br.x - area->tl.x + 1;
-    size_t *histogram = calloc(*size_out, sizeof(size_t));
+    size_t *histogram = malloc(*size_out * sizeof(size_t));
     if (histogram == NULL)
     {
         fprintf(stderr, "histogram_vertical: Histogram allocation failed\n");
         return NULL;
     }
-    for (size_t h = 0; h < horiz_size; h++)
-    {
-        for (size_t w = 0; w < *size_out; w++)
-        {
-            float pixel = mat_coef(src, h + area->tl.y, w + area->tl.x);
-            if (pixel == 0.0f)
-            {
-                histogram[w] += 1;
-            }
-        }
-    }
+
+    // The set bits are the white pixels: the black ones are the others.
+    mat_bit_column_histogram(src, area->tl.y, area->tl.x, horiz_size,
+                             *size_out, histogram);
+    for (size_t w = 0; w < *size_out; w++)
+        histogram[w] = horiz_size - histogram[w];
     return histogram;
 }
 
@@ -462,7 +454,8 @@ BoundingBox **find_letters_histogram_threshold(BoundingBox *area,
     return letters_boxes;
 }
 
-BoundingBox ***get_bounding_box_letters(Matrix *src, BoundingBox **words_boxes,
+BoundingBox ***get_bounding_box_letters(const BitMatrix *src,
+                                        BoundingBox **words_boxes,
                                         size_t nb_words, size_t threshold,
                                         size_t **size_out)
 {
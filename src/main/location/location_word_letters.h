@@ -1,6 +1,7 @@
 #ifndef LOCATION_WORDS_H
 #define LOCATION_WORDS_H
 #include "location/location.h"
+#include "matrix/bit_matrix.h"
 
 #undef MAX
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
@@ -56,7 +57,8 @@ int extract_boundingbox_to_png(Matrix *src, BoundingBox *box,
                                const char *filename);
 
 /// @brief Computes bounding boxes of letters inside each word region.
-/// @param[in] src Pointer to the source matrix. Must not be NULL.
+/// @param[in] src Binary image whose set bits are the white pixels. Must not
+/// be NULL.
 /// @param[in] words_boxes Array of word bounding boxes. Must not be NULL.
 /// @param[in] nb_words Number of words in the array.
 /// @param[in] threshold Threshold used for letter segmentation.
@@ -66,7 +68,8 @@ int extract_boundingbox_to_png(Matrix *src, BoundingBox *box,
 /// @return A 2D array of allocated BoundingBox pointers for each word,
 ///         or NULL on error (e.g., invalid parameters or memory allocation
 ///         failure).
-BoundingBox ***get_bounding_box_letters(Matrix *src, BoundingBox **words_boxes,
+BoundingBox ***get_bounding_box_letters(const BitMatrix *src,
+                                        BoundingBox **words_boxes,
                                         size_t nb_words, size_t threshold,
                                         size_t **size_out);
 
@@ -86,16 +89,19 @@ BoundingBox **find_letters_histogram_threshold(BoundingBox *area,
                                                size_t *size_out);
 
 /// @brief Computes a vertical histogram of black pixels within a given area.
-/// @param src Source matrix (must not be NULL).
+/// @param src Binary image whose set bits are the white pixels (must not be
+/// NULL).
 /// @param area Bounding box defining the region to analyze (must not be NULL).
 /// @param size_out Output parameter storing the histogram width (must not be
 /// NULL).
 /// @return A newly allocated array where each element counts black pixels in a
 /// column or NULL in case of error.
-size_t *histogram_vertical(Matrix *src, BoundingBox *area, size_t *size_out);
+size_t *histogram_vertical(const BitMatrix *src, BoundingBox *area,
+                           size_t *size_out);
 
 /// @brief Detects and returns bounding boxes of words within a specified area.
-/// @param[in] src Pointer to the source matrix. Must not be NULL.
+/// @param[in] src Binary image whose set bits are the white pixels. Must not
+/// be NULL.
 /// @param[in] area Pointer to the bounding box defining the region to analyze.
 /// Must not be NULL.
 /// @param[in] threshold Threshold used for word segmentation.
@@ -106,7 +112,7 @@ size_t *histogram_vertical(Matrix *src, BoundingBox *area, size_t *size_out);
 /// @return Array of allocated BoundingBox pointers representing detected words,
 ///         or NULL on error (e.g., invalid parameters or memory allocation
 ///         failure).
-BoundingBox **get_bounding_box_words(Matrix *src, BoundingBox *area,
+BoundingBox **get_bounding_box_words(const BitMatrix *src, BoundingBox *area,
                                      size_t threshold, size_t area_padding,
                                      size_t word_margin, size_t *size_out);
 
@@ -145,12 +151,14 @@ int pad_bounding_box(BoundingBox *box, size_t top, size_t bottom, size_t right,
                      size_t left);
 
 /// @brief Computes a horizontal histogram of black pixels within a given area.
-/// @param src Source matrix (must not be NULL).
+/// @param src Binary image whose set bits are the white pixels (must not be
+/// NULL).
 /// @param area Bounding box defining the region to analyze (must not be NULL).
 /// @param size_out Output parameter storing the histogram height (must not be
 /// NULL).
 /// @return A newly allocated array where each element counts black pixels in a
 /// row or NULL on error.
-size_t *histogram_horizontal(Matrix *src, BoundingBox *area, size_t *size_out);
+size_t *histogram_horizontal(const BitMatrix *src, BoundingBox *area,
+                             size_t *size_out);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include <err.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "matrix.h"
+
+// Blocks sitting in a pool are poisoned so that AddressSanitizer still reports
+// the use of a freed matrix even though its memory is not given back to libc.
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/asan_interface.h>
+#else
+#define ASAN_POISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
+#define ASAN_UNPOISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
+#endif
+
+/// @brief The size in bytes of the smallest size class.
+#define MIN_CLASS_SHIFT 8
+
+/// @brief Each power of two is split into this many size classes, so that at
+/// most a quarter of a block is wasted.
+#define CLASS_STEPS 4
+
+#define CLASS_COUNT                                                            \
+    ((sizeof(size_t) * 8 - MIN_CLASS_SHIFT) * CLASS_STEPS + 1)
+
+/// @brief The maximal number of nested arena scopes on a thread.
+#define MAX_SCOPE_DEPTH 32
+
+/// @brief The header stored in front of every block.
+typedef struct Block
+{
+    /// @brief The arena owning the block, or NULL for a heap block.
+    MatArena *arena;
+    /// @brief The next block of the same size class in the pool of the arena.
+    struct Block *next_free;
+    /// @brief The next block owned by the arena (pooled or in use).
+    struct Block *next;
+    /// @brief The size class of the block.
+    size_t size_class;
+} Block;
+
+/// @brief The header is padded to MAT_ALIGNMENT bytes to keep the payload
+/// aligned.
+#define HEADER_SIZE MAT_ALIGNMENT
+
+_Static_assert(sizeof(Block) <= HEADER_SIZE, "Block header too large.");
+
+struct MatArena
+{
+    /// @brief The pooled blocks, by size class.
+    Block *free_lists[CLASS_COUNT];
+    /// @brief Every block owned by the arena.
+    Block *blocks;
+    /// @brief The number of blocks allocated on the heap by the arena.
+    size_t heap_allocations;
+};
+
+static atomic_size_t heap_allocations;
+
+/// @brief The stack of the active arenas of the thread.
+static _Thread_local MatArena *scopes[MAX_SCOPE_DEPTH];
+static _Thread_local size_t scope_depth;
+
+/// @brief Returns the index of the smallest size class of at least the given
+/// number of bytes (header included).
+static size_t size_class(size_t bytes)
+{
+    if (bytes <= (size_t)1 << MIN_CLASS_SHIFT)
+        return 0;
+
+    size_t e = sizeof(long long) * 8 - 1 - __builtin_clzll(bytes - 1);
+    size_t step = ((bytes - 1) >> (e - 2)) & (CLASS_STEPS - 1);
+
+    return (e - MIN_CLASS_SHIFT) * CLASS_STEPS + step + 1;
+}
+
+/// @brief Returns the number of bytes of the blocks of a size class. It is a
+/// multiple of MAT_ALIGNMENT.
+static size_t class_bytes(size_t size_class)
+{
+    if (size_class == 0)
+        return (size_t)1 << MIN_CLASS_SHIFT;
+
+    size_t e = (size_class - 1) / CLASS_STEPS + MIN_CLASS_SHIFT;
+    size_t step = (size_class - 1) % CLASS_STEPS;
+
+    return ((size_t)1 << e) + ((step + 1) << (e - 2));
+}
+
+static Block *heap_block(size_t bytes)
+{
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    bytes = (bytes + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT;
+
+    Block *block = aligned_alloc(MAT_ALIGNMENT, bytes);
+    if (block == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in mat_block_alloc.");
+
+    atomic_fetch_add_explicit(&heap_allocations, 1, memory_order_relaxed);
+
+    return block;
+}
+
+static inline void *payload(Block *block)
+{
+    return (char *)block + HEADER_SIZE;
+}
+
+MatArena *mat_arena_create()
+{
+    MatArena *arena = calloc(1, sizeof(MatArena));
+    if (arena == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in mat_arena_create.");
+
+    return arena;
+}
+
+void mat_arena_free(MatArena *arena)
+{
+    for (size_t i = 0; i < scope_depth; ++i)
+    {
+        if (scopes[i] == arena)
+            errx(EXIT_FAILURE, "mat_arena_free: the arena is still active.");
+    }
+
+    Block *block = arena->blocks;
+    while (block != NULL)
+    {
+        Block *next = block->next;
+        ASAN_UNPOISON_MEMORY_REGION(payload(block),
+                                    class_bytes(block->size_class) -
+                                        HEADER_SIZE);
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+void mat_arena_begin(MatArena *arena)
+{
+    if (arena == NULL)
+        errx(EXIT_FAILURE, "mat_arena_begin: arena is NULL.");
+    if (scope_depth == MAX_SCOPE_DEPTH)
+        errx(EXIT_FAILURE,
+             "mat_arena_begin: more than %d nested arena scopes.",
+             MAX_SCOPE_DEPTH);
+
+    scopes[scope_depth++] = arena;
+}
+
+void mat_arena_end()
+{
+    if (scope_depth == 0)
+        errx(EXIT_FAILURE, "mat_arena_end: no arena is active.");
+
+    scopes[--scope_depth] = NULL;
+}
+
+void mat_arena_reset(MatArena *arena)
+{
+    for (size_t i = 0; i < CLASS_COUNT; ++i)
+        arena->free_lists[i] = NULL;
+
+    for (Block *block = arena->blocks; block != NULL; block = block->next)
+    {
+        block->next_free = arena->free_lists[block->size_class];
+        arena->free_lists[block->size_class] = block;
+        ASAN_POISON_MEMORY_REGION(payload(block),
+                                  class_bytes(block->size_class) -
+                                      HEADER_SIZE);
+    }
+}
+
+size_t mat_arena_heap_allocations(const MatArena *arena)
+{
+    return arena->heap_allocations;
+}
+
+size_t mat_heap_allocations()
+{
+    return atomic_load_explicit(&heap_allocations, memory_order_relaxed);
+}
+
+void *mat_block_alloc(size_t bytes)
+{
+    bytes += HEADER_SIZE;
+
+    if (scope_depth == 0)
+    {
+        Block *block = heap_block(bytes);
+        block->arena = NULL;
+        return payload(block);
+    }
+
+    MatArena *arena = scopes[scope_depth - 1];
+    size_t c = size_class(bytes);
+    Block *block = arena->free_lists[c];
+
+    if (block != NULL)
+    {
+        arena->free_lists[c] = block->next_free;
+        ASAN_UNPOISON_MEMORY_REGION(payload(block), bytes - HEADER_SIZE);
+        return payload(block);
+    }
+
+    block = heap_block(class_bytes(c));
+    block->arena = arena;
+    block->size_class = c;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->heap_allocations++;
+
+    return payload(block);
+}
+
+void mat_block_free(void *ptr)
+{
+    Block *block = (Block *)((char *)ptr - HEADER_SIZE);
+    MatArena *arena = block->arena;
+
+    if (arena == NULL)
+    {
+        free(block);
+        return;
+    }
+
+    block->next_free = arena->free_lists[block->size_class];
+    arena->free_lists[block->size_class] = block;
+    ASAN_POISON_MEMORY_REGION(ptr, class_bytes(block->size_class) -
+                                       HEADER_SIZE);
+}
@@ -0,0 +1,80 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/// @brief A pool of matrix buffers sorted by size class.
+///
+/// While an arena is active on a thread (see `mat_arena_begin`), every matrix
+/// created by the matrix library on that thread draws its memory from the
+/// arena, and `mat_free` gives it back to the arena instead of the heap. A
+/// buffer of a given size class is therefore allocated on the heap only the
+/// first time it is needed, which removes the per-operation malloc/free pairs
+/// of hot loops such as the training of a neural network.
+///
+/// A matrix remembers the arena it comes from: it may be freed after the scope
+/// that created it has ended, but not after its arena has been reset or freed.
+/// An arena must only be used by one thread at a time.
+typedef struct MatArena MatArena;
+
+/// @brief Creates an empty arena. No buffer is allocated until a matrix is
+/// created in it.
+/// @return A pointer to the newly allocated arena.
+/// @throw Terminates the program if memory allocation fails.
+MatArena *mat_arena_create();
+
+/// @brief Frees an arena and every buffer it owns.
+/// @param[in] arena The arena to free. It must not be active on any thread.
+/// @note Every matrix created in the arena becomes invalid and must not be
+/// used nor freed afterwards.
+void mat_arena_free(MatArena *arena);
+
+/// @brief Makes an arena the active arena of the calling thread, until the
+/// matching call to `mat_arena_end`. Scopes may be nested, with the same or
+/// different arenas.
+/// @param[in] arena The arena in which the matrices will be created.
+/// @throw Terminates the program if arena is NULL.
+void mat_arena_begin(MatArena *arena);
+
+/// @brief Ends the innermost arena scope of the calling thread and restores
+/// the previously active arena, if any.
+/// @throw Terminates the program if no arena is active on the calling thread.
+void mat_arena_end();
+
+/// @brief Gives every buffer of an arena back to its pool at once, whether the
+/// matrix using it has been freed or not. It is meant to drop all the
+/// temporaries of an iteration without freeing them one by one.
+/// @param[in] arena The arena to reset.
+/// @note Every matrix created in the arena becomes invalid and must not be
+/// used nor freed afterwards.
+void mat_arena_reset(MatArena *arena);
+
+/// @brief Returns the number of buffers an arena has allocated on the heap.
+/// @param[in] arena The arena.
+/// @return The number of heap allocations made by the arena.
+size_t mat_arena_heap_allocations(const MatArena *arena);
+
+/// @brief Returns the number of heap allocations made by the matrix library,
+/// in or out of arenas, since the start of the program, on every thread. The
+/// difference of two calls around a piece of code is the number of heap calls
+/// it made to create matrices.
+/// @return The number of heap allocations made by the matrix library.
+size_t mat_heap_allocations();
+
+/// @brief Allocates a MAT_ALIGNMENT-aligned block of at least the given size,
+/// from the active arena of the calling thread if there is one, or from the
+/// heap otherwise.
+/// @param[in] bytes The size of the block in bytes.
+/// @return A pointer to the block, to be released with `mat_block_free`.
+/// @throw Terminates the program if memory allocation fails.
+/// @note Internal to the matrix library, which stores each matrix and its
+/// coefficients in one block.
+void *mat_block_alloc(size_t bytes);
+
+/// @brief Releases a block returned by `mat_block_alloc`, to the arena it
+/// comes from or to the heap.
+/// @param[in] block The block to release.
+/// @note Internal to the matrix library.
+void mat_block_free(void *block);
+
+#endif
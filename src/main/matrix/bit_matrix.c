@@ -0,0 +1,573 @@
+#include <err.h>
+#include <string.h>
+
+#include "arena.h"
+#include "bit_matrix.h"
+#include "kernels.h"
+#include "parallel.h"
+
+/// @brief The number of bits of a word.
+#define WORD_BITS 64
+
+/// @brief A 2D matrix of bits.
+struct BitMatrix
+{
+    /// @brief Number of rows (height) of the matrix.
+    size_t height;
+    /// @brief Number of columns (width) of the matrix.
+    size_t width;
+    /// @brief Number of words holding the bits of a row.
+    size_t words;
+    /// @brief Number of words between the starts of two consecutive rows, a
+    /// multiple of MAT_ALIGNMENT bytes.
+    size_t stride;
+    /// @brief The rows stored in a MAT_ALIGNMENT-aligned array of height ×
+    /// stride words.
+    uint64_t *content;
+};
+
+/// @brief The offset in bytes of the words of a matrix from its structure,
+/// which precedes them in the same block.
+#define CONTENT_OFFSET                                                         \
+    ((sizeof(BitMatrix) + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT)
+
+static BitMatrix *alloc_bit_matrix(size_t height, size_t width)
+{
+    if (height == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create bit matrix: invalid height '%zu'. Height must "
+             "be non-zero.",
+             height);
+    if (width == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create bit matrix: invalid width '%zu'. Width must be "
+             "non-zero.",
+             width);
+
+    const size_t row_words = MAT_ALIGNMENT / sizeof(uint64_t);
+    size_t words = (width + WORD_BITS - 1) / WORD_BITS;
+    size_t stride = (words + row_words - 1) / row_words * row_words;
+
+    BitMatrix *b =
+        mat_block_alloc(CONTENT_OFFSET + height * stride * sizeof(uint64_t));
+
+    b->height = height;
+    b->width = width;
+    b->words = words;
+    b->stride = stride;
+    b->content = (uint64_t *)((char *)b + CONTENT_OFFSET);
+
+    return b;
+}
+
+static inline uint64_t *row_ptr(const BitMatrix *b, size_t h)
+{
+    return b->content + h * b->stride;
+}
+
+/// @brief Returns the mask of the bits of the last word of a row that are
+/// within the width.
+static inline uint64_t last_word_mask(size_t width)
+{
+    size_t rem = width % WORD_BITS;
+    return rem == 0 ? ~(uint64_t)0 : ((uint64_t)1 << rem) - 1;
+}
+
+size_t mat_bit_height(const BitMatrix *b) { return b->height; }
+
+size_t mat_bit_width(const BitMatrix *b) { return b->width; }
+
+BitMatrix *mat_bit_create(size_t height, size_t width)
+{
+    BitMatrix *b = alloc_bit_matrix(height, width);
+    memset(b->content, 0, height * b->stride * sizeof(uint64_t));
+    return b;
+}
+
+void mat_bit_free(BitMatrix *b) { mat_block_free(b); }
+
+int mat_bit_get(const BitMatrix *b, size_t h, size_t w)
+{
+    if (h >= b->height || w >= b->width)
+        errx(EXIT_FAILURE,
+             "Failed to get bit: index (%zu, %zu) out of bounds for a bit "
+             "matrix of shape (%zu, %zu).",
+             h, w, b->height, b->width);
+
+    return (row_ptr(b, h)[w / WORD_BITS] >> (w % WORD_BITS)) & 1;
+}
+
+void mat_bit_set(BitMatrix *b, size_t h, size_t w, int value)
+{
+    if (h >= b->height || w >= b->width)
+        errx(EXIT_FAILURE,
+             "Failed to set bit: index (%zu, %zu) out of bounds for a bit "
+             "matrix of shape (%zu, %zu).",
+             h, w, b->height, b->width);
+
+    uint64_t bit = (uint64_t)1 << (w % WORD_BITS);
+    uint64_t *word = row_ptr(b, h) + w / WORD_BITS;
+    *word = value ? *word | bit : *word & ~bit;
+}
+
+int mat_bit_eq(const BitMatrix *a, const BitMatrix *b)
+{
+    if (a->height != b->height || a->width != b->width)
+        return 0;
+
+    for (size_t h = 0; h < a->height; h++)
+        if (memcmp(row_ptr(a, h), row_ptr(b, h),
+                   a->words * sizeof(uint64_t)) != 0)
+            return 0;
+
+    return 1;
+}
+
+BitMatrix *mat_bit_from_view(MatView v, float threshold)
+{
+    BitMatrix *b = mat_bit_create(v.height, v.width);
+
+    for (size_t h = 0; h < v.height; h++)
+    {
+        const float *src = mat_view_row(v, h);
+        uint64_t *dst = row_ptr(b, h);
+        for (size_t w = 0; w < v.width; w++)
+            dst[w / WORD_BITS] |= (uint64_t)(src[w] > threshold)
+                                  << (w % WORD_BITS);
+    }
+
+    return b;
+}
+
+BitMatrix *mat_bit_from_u8(const MatU8 *m, uint8_t threshold)
+{
+    size_t height = mat_u8_height(m);
+    size_t width = mat_u8_width(m);
+    BitMatrix *b = mat_bit_create(height, width);
+
+    for (size_t h = 0; h < height; h++)
+    {
+        const uint8_t *src = mat_u8_row(m, h);
+        uint64_t *dst = row_ptr(b, h);
+        for (size_t w = 0; w < width; w++)
+            dst[w / WORD_BITS] |= (uint64_t)(src[w] > threshold)
+                                  << (w % WORD_BITS);
+    }
+
+    return b;
+}
+
+MatU8 *mat_bit_to_u8(const BitMatrix *b, uint8_t zero, uint8_t one)
+{
+    MatU8 *m = mat_u8_create(b->height, b->width);
+
+    for (size_t h = 0; h < b->height; h++)
+    {
+        const uint64_t *src = row_ptr(b, h);
+        uint8_t *dst = mat_u8_row(m, h);
+        for (size_t w = 0; w < b->width; w++)
+            dst[w] = (src[w / WORD_BITS] >> (w % WORD_BITS)) & 1 ? one : zero;
+    }
+
+    return m;
+}
+
+Matrix *mat_bit_to_matrix(const BitMatrix *b, float zero, float one)
+{
+    Matrix *m = mat_create_padded(b->height, b->width);
+
+    for (size_t h = 0; h < b->height; h++)
+    {
+        const uint64_t *src = row_ptr(b, h);
+        float *dst = mat_coef_ptr(m, h, 0);
+        for (size_t w = 0; w < b->width; w++)
+            dst[w] = (src[w / WORD_BITS] >> (w % WORD_BITS)) & 1 ? one : zero;
+    }
+
+    return m;
+}
+
+int mat_bit_pack(BitMatrix *dst, const Matrix *m)
+{
+    size_t height = mat_height(m), width = mat_width(m);
+    int binary = 1;
+
+    if (dst->height < height || dst->width < width)
+        errx(EXIT_FAILURE,
+             "Failed to pack matrix: a %zux%zu matrix does not fit in a bit "
+             "matrix of shape (%zu, %zu).",
+             height, width, dst->height, dst->width);
+
+    for (size_t h = 0; h < height; h++)
+    {
+        const float *src = mat_coef_ptr(m, h, 0);
+        uint64_t *row = row_ptr(dst, h);
+        memset(row, 0, dst->words * sizeof(uint64_t));
+
+        for (size_t w = 0; w < width; w++)
+        {
+            row[w / WORD_BITS] |= (uint64_t)(src[w] == 1.0f) << (w % WORD_BITS);
+            binary &= (src[w] == 0.0f) | (src[w] == 1.0f);
+        }
+    }
+
+    return binary;
+}
+
+int mat_bit_pack_columns(BitMatrix *dst, const Matrix *m)
+{
+    size_t height = mat_height(m), width = mat_width(m);
+    int binary = 1;
+
+    if (dst->height < width || dst->width < height)
+        errx(EXIT_FAILURE,
+             "Failed to pack columns: the transpose of a %zux%zu matrix does "
+             "not fit in a bit matrix of shape (%zu, %zu).",
+             height, width, dst->height, dst->width);
+
+    for (size_t w = 0; w < width; w++)
+        memset(row_ptr(dst, w), 0, dst->words * sizeof(uint64_t));
+
+    // Coefficient (h, w) is bit h of row w: m is read row by row, and every
+    // row sets the same bit of each packed row.
+    for (size_t h = 0; h < height; h++)
+    {
+        const float *src = mat_coef_ptr(m, h, 0);
+        for (size_t w = 0; w < width; w++)
+        {
+            row_ptr(dst, w)[h / WORD_BITS] |= (uint64_t)(src[w] == 1.0f)
+                                              << (h % WORD_BITS);
+            binary &= (src[w] == 0.0f) | (src[w] == 1.0f);
+        }
+    }
+
+    return binary;
+}
+
+/// @brief A product by a bit matrix, split by rows of a and dst.
+typedef struct
+{
+    Matrix *dst;
+    const BitMatrix *a;
+    const Matrix *b;
+} BitMultiplicationTask;
+
+static void bit_multiplication_body(size_t begin, size_t end, void *ctx)
+{
+    const BitMultiplicationTask *t = ctx;
+    size_t columns = mat_height(t->b), width = mat_width(t->b);
+    size_t words = (columns + WORD_BITS - 1) / WORD_BITS;
+    size_t indices[columns];
+
+    for (size_t r = begin; r < end; r++)
+    {
+        // The indices of the set bits of the row, lowest first.
+        const uint64_t *bits = row_ptr(t->a, r);
+        size_t count = 0;
+        for (size_t k = 0; k < words; k++)
+        {
+            uint64_t word = bits[k];
+            if (k == words - 1)
+                word &= last_word_mask(columns);
+            for (; word != 0; word &= word - 1)
+                indices[count++] = k * WORD_BITS + __builtin_ctzll(word);
+        }
+
+        float *dst_row = mat_coef_ptr(t->dst, r, 0);
+        mat_kernels->fill(dst_row, 0.0f, width);
+        mat_kernels->add_rows(dst_row, mat_coef_ptr(t->b, 0, 0),
+                              mat_stride(t->b), indices, count, width);
+    }
+}
+
+void mat_bit_multiplication(Matrix *dst, const BitMatrix *a, const Matrix *b)
+{
+    size_t rows = mat_height(dst), columns = mat_height(b);
+
+    if (a->height < rows || a->width < columns ||
+        mat_width(dst) != mat_width(b))
+        errx(EXIT_FAILURE,
+             "Bit matrix multiplication failed: cannot multiply %zux%zu bits "
+             "of a bit matrix of shape (%zu, %zu) by a %zux%zu matrix into a "
+             "%zux%zu matrix.",
+             rows, columns, a->height, a->width, columns, mat_width(b), rows,
+             mat_width(dst));
+
+    // A row costs about half of its columns times the width of b.
+    BitMultiplicationTask t = {.dst = dst, .a = a, .b = b};
+    mat_parallel_for(rows, columns * mat_width(b) / 2, bit_multiplication_body,
+                     &t);
+}
+
+size_t mat_bit_popcount(const BitMatrix *b)
+{
+    size_t count = 0;
+    for (size_t h = 0; h < b->height; h++)
+    {
+        const uint64_t *row = row_ptr(b, h);
+        for (size_t k = 0; k < b->words; k++)
+            count += __builtin_popcountll(row[k]);
+    }
+    return count;
+}
+
+static void check_rectangle(const BitMatrix *b, size_t h, size_t w,
+                            size_t height, size_t width)
+{
+    if (h + height > b->height || w + width > b->width)
+        errx(EXIT_FAILURE,
+             "The rectangle of shape (%zu, %zu) at (%zu, %zu) is out of "
+             "bounds for a bit matrix of shape (%zu, %zu).",
+             height, width, h, w, b->height, b->width);
+}
+
+/// @brief Counts the set bits of the columns [w, w + width) of a row, with
+/// width non-zero.
+static size_t range_popcount(const uint64_t *row, size_t w, size_t width)
+{
+    size_t first = w / WORD_BITS;
+    size_t last = (w + width - 1) / WORD_BITS;
+    uint64_t first_mask = ~(uint64_t)0 << (w % WORD_BITS);
+    uint64_t last_mask = last_word_mask(w + width);
+
+    if (first == last)
+        return __builtin_popcountll(row[first] & first_mask & last_mask);
+
+    size_t count = __builtin_popcountll(row[first] & first_mask);
+    for (size_t k = first + 1; k < last; k++)
+        count += __builtin_popcountll(row[k]);
+    return count + __builtin_popcountll(row[last] & last_mask);
+}
+
+size_t mat_bit_row_popcount(const BitMatrix *b, size_t h, size_t w,
+                            size_t width)
+{
+    check_rectangle(b, h, w, 1, width);
+    return width == 0 ? 0 : range_popcount(row_ptr(b, h), w, width);
+}
+
+void mat_bit_row_histogram(const BitMatrix *b, size_t h, size_t w,
+                           size_t height, size_t width, size_t *histogram)
+{
+    check_rectangle(b, h, w, height, width);
+
+    for (size_t i = 0; i < height; i++)
+        histogram[i] =
+            width == 0 ? 0 : range_popcount(row_ptr(b, h + i), w, width);
+}
+
+void mat_bit_column_histogram(const BitMatrix *b, size_t h, size_t w,
+                              size_t height, size_t width, size_t *histogram)
+{
+    check_rectangle(b, h, w, height, width);
+
+    if (width == 0)
+        return;
+
+    size_t first = w / WORD_BITS;
+    size_t words = (w + width - 1) / WORD_BITS - first + 1;
+    uint64_t first_mask = ~(uint64_t)0 << (w % WORD_BITS);
+    uint64_t last_mask = last_word_mask(w + width);
+
+    // Bit-sliced counters: the bit j of planes[p][k] is the bit p of the count
+    // of the column j of the word k. Each row is added to the 64 counters of a
+    // word at once, with a ripple carry that usually stops after a plane or
+    // two.
+    size_t plane_count = 1;
+    while (((size_t)1 << plane_count) <= height)
+        plane_count++;
+    uint64_t *planes = calloc(plane_count * words, sizeof(uint64_t));
+    if (planes == NULL)
+        errx(EXIT_FAILURE, "Failed to compute the column histogram: memory "
+                           "allocation failed.");
+
+    for (size_t i = 0; i < height; i++)
+    {
+        const uint64_t *row = row_ptr(b, h + i) + first;
+        for (size_t k = 0; k < words; k++)
+        {
+            uint64_t carry = row[k];
+            if (k == 0)
+                carry &= first_mask;
+            if (k == words - 1)
+                carry &= last_mask;
+
+            for (size_t p = 0; carry != 0; p++)
+            {
+                uint64_t *plane = planes + p * words + k;
+                uint64_t next = *plane & carry;
+                *plane ^= carry;
+                carry = next;
+            }
+        }
+    }
+
+    for (size_t j = 0; j < width; j++)
+    {
+        size_t bit = (w + j) % WORD_BITS;
+        size_t k = (w + j) / WORD_BITS - first;
+        size_t count = 0;
+        for (size_t p = 0; p < plane_count; p++)
+            count |= (size_t)((planes[p * words + k] >> bit) & 1) << p;
+        histogram[j] = count;
+    }
+
+    free(planes);
+}
+
+static int is_row_empty(const BitMatrix *b, size_t h)
+{
+    const uint64_t *row = row_ptr(b, h);
+    for (size_t k = 0; k < b->words; k++)
+        if (row[k] != 0)
+            return 0;
+    return 1;
+}
+
+int mat_bit_strip_margins(const BitMatrix *b, size_t *h, size_t *w,
+                          size_t *height, size_t *width)
+{
+    size_t h_i = 0, h_f = b->height;
+
+    while (h_i < h_f && is_row_empty(b, h_i))
+        h_i++;
+    if (h_i == h_f)
+        return 0;
+    while (is_row_empty(b, h_f - 1))
+        h_f--;
+
+    // The columns of the set bits are those of the OR of the rows.
+    uint64_t *columns = calloc(b->words, sizeof(uint64_t));
+    if (columns == NULL)
+        errx(EXIT_FAILURE, "Failed to strip margins: memory allocation "
+                           "failed.");
+    for (size_t r = h_i; r < h_f; r++)
+    {
+        const uint64_t *row = row_ptr(b, r);
+        for (size_t k = 0; k < b->words; k++)
+            columns[k] |= row[k];
+    }
+
+    size_t first = 0, last = b->words - 1;
+    while (columns[first] == 0)
+        first++;
+    while (columns[last] == 0)
+        last--;
+
+    size_t w_i = first * WORD_BITS + __builtin_ctzll(columns[first]);
+    size_t w_f =
+        last * WORD_BITS + (WORD_BITS - __builtin_clzll(columns[last]));
+    free(columns);
+
+    *h = h_i;
+    *w = w_i;
+    *height = h_f - h_i;
+    *width = w_f - w_i;
+    return 1;
+}
+
+/// @brief ORs into dst the row src shifted so that the pixel y of dst receives
+/// the pixel y + d of src. Pixels shifted in from outside the row are 0.
+static void or_shifted(uint64_t *dst, const uint64_t *src, size_t words,
+                       long d)
+{
+    size_t q = (d < 0 ? -d : d) / WORD_BITS;
+    unsigned r = (d < 0 ? -d : d) % WORD_BITS;
+
+    for (size_t k = 0; k < words; k++)
+    {
+        uint64_t word = 0;
+        if (d >= 0)
+        {
+            if (k + q < words)
+                word = src[k + q] >> r;
+            if (r != 0 && k + q + 1 < words)
+                word |= src[k + q + 1] << (WORD_BITS - r);
+        }
+        else
+        {
+            if (k >= q)
+                word = src[k - q] << r;
+            if (r != 0 && k >= q + 1)
+                word |= src[k - q - 1] >> (WORD_BITS - r);
+        }
+        dst[k] |= word;
+    }
+}
+
+/// @brief Applies a separable OR (maximum) or AND (minimum) filter. The
+/// horizontal AND is computed as the complement of the OR of the complement,
+/// so that the pixels shifted in from outside the row, which are 0, never
+/// change the result: the extremum over a window clamped to the image is the
+/// same as with repeated border pixels.
+static BitMatrix *extremum_filter(const BitMatrix *src, size_t kernel_size,
+                                  int maximum)
+{
+    if (kernel_size == 0)
+        errx(EXIT_FAILURE, "Failed to filter: the kernel size must be "
+                           "non-zero.");
+
+    size_t height = src->height;
+    size_t words = src->words;
+    long before = kernel_size / 2;
+    long after = kernel_size - before - 1;
+    uint64_t mask = last_word_mask(src->width);
+
+    uint64_t *row = malloc(words * sizeof(uint64_t));
+    if (row == NULL)
+        errx(EXIT_FAILURE, "Failed to filter: memory allocation failed.");
+
+    // Horizontal pass.
+    BitMatrix *tmp = mat_bit_create(height, src->width);
+    for (size_t x = 0; x < height; x++)
+    {
+        const uint64_t *src_row = row_ptr(src, x);
+        uint64_t *tmp_row = row_ptr(tmp, x);
+
+        for (size_t k = 0; k < words; k++)
+            row[k] = maximum ? src_row[k] : ~src_row[k];
+        row[words - 1] &= mask;
+
+        for (long d = -before; d <= after; d++)
+            or_shifted(tmp_row, row, words, d);
+
+        if (!maximum)
+            for (size_t k = 0; k < words; k++)
+                tmp_row[k] = ~tmp_row[k];
+        tmp_row[words - 1] &= mask;
+    }
+    free(row);
+
+    // Vertical pass, a whole row at a time.
+    BitMatrix *dst = alloc_bit_matrix(height, src->width);
+    for (size_t x = 0; x < height; x++)
+    {
+        size_t lo = (long)x < before ? 0 : x - before;
+        size_t hi = x + after < height ? x + after : height - 1;
+        uint64_t *dst_row = row_ptr(dst, x);
+        memcpy(dst_row, row_ptr(tmp, lo), dst->stride * sizeof(uint64_t));
+        for (size_t r = lo + 1; r <= hi; r++)
+        {
+            const uint64_t *tmp_row = row_ptr(tmp, r);
+            if (maximum)
+                for (size_t k = 0; k < words; k++)
+                    dst_row[k] |= tmp_row[k];
+            else
+                for (size_t k = 0; k < words; k++)
+                    dst_row[k] &= tmp_row[k];
+        }
+    }
+
+    mat_bit_free(tmp);
+    return dst;
+}
+
+BitMatrix *mat_bit_max_filter(const BitMatrix *src, size_t kernel_size)
+{
+    return extremum_filter(src, kernel_size, 1);
+}
+
+BitMatrix *mat_bit_min_filter(const BitMatrix *src, size_t kernel_size)
+{
+    return extremum_filter(src, kernel_size, 0);
+}
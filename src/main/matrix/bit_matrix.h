@@ -0,0 +1,195 @@
+#ifndef BIT_MATRIX_H
+#define BIT_MATRIX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "matrix.h"
+#include "matrix_u8.h"
+
+/// @brief A 2D matrix of bits, used for the binary images of the pipeline once
+/// they have been thresholded. Each row is packed into 64-bit words, pixel w
+/// being the bit w % 64 of the word w / 64, so that the row and column
+/// operations process 64 pixels at a time. The bits past the width of a row
+/// are always 0.
+typedef struct BitMatrix BitMatrix;
+
+/// @brief Returns the height (number of rows) of the given matrix.
+/// @param[in] b Pointer to the matrix.
+/// @return The number of rows in the matrix.
+size_t mat_bit_height(const BitMatrix *b);
+
+/// @brief Returns the width (number of columns) of the given matrix.
+/// @param[in] b Pointer to the matrix.
+/// @return The number of columns in the matrix.
+size_t mat_bit_width(const BitMatrix *b);
+
+/// @brief Creates a bit matrix whose bits are all 0. Its rows are padded to a
+/// multiple of MAT_ALIGNMENT bytes.
+/// @param[in] height Number of rows in the new matrix (must be non-zero).
+/// @param[in] width Number of columns in the new matrix (must be non-zero).
+/// @return A pointer to a newly allocated matrix.
+/// @throw Terminates the program if height or width is zero, or if memory
+/// allocation fails.
+BitMatrix *mat_bit_create(size_t height, size_t width);
+
+/// @brief Frees a bit matrix. Like matrices, bit matrices created while a
+/// matrix arena is active return to it (see `matrix/arena.h`).
+/// @param[in] b Pointer to the matrix to free.
+void mat_bit_free(BitMatrix *b);
+
+/// @brief Returns the bit at the given position.
+/// @param[in] b Pointer to the matrix.
+/// @param[in] h Row index.
+/// @param[in] w Column index.
+/// @return 1 if the bit is set, 0 otherwise.
+/// @throw Terminates the program if the indices are out of bounds.
+int mat_bit_get(const BitMatrix *b, size_t h, size_t w);
+
+/// @brief Sets or clears the bit at the given position.
+/// @param[in] b Pointer to the matrix.
+/// @param[in] h Row index.
+/// @param[in] w Column index.
+/// @param[in] value Whether the bit is set.
+/// @throw Terminates the program if the indices are out of bounds.
+void mat_bit_set(BitMatrix *b, size_t h, size_t w, int value);
+
+/// @brief Checks whether two bit matrices have the same shape and bits.
+/// @param[in] a Pointer to the first matrix.
+/// @param[in] b Pointer to the second matrix.
+/// @return 1 if they are equal, 0 otherwise.
+int mat_bit_eq(const BitMatrix *a, const BitMatrix *b);
+
+/// @brief Packs a view of a float matrix into bits: a bit is set where the
+/// coefficient is greater than the threshold.
+/// @param[in] v The view (must not be empty).
+/// @param[in] threshold The threshold.
+/// @return A newly allocated bit matrix of the shape of the view.
+BitMatrix *mat_bit_from_view(MatView v, float threshold);
+
+/// @brief Packs a byte image into bits: a bit is set where the pixel is
+/// greater than the threshold.
+/// @param[in] m Pointer to the image.
+/// @param[in] threshold The threshold.
+/// @return A newly allocated bit matrix of the same shape.
+BitMatrix *mat_bit_from_u8(const MatU8 *m, uint8_t threshold);
+
+/// @brief Unpacks a bit matrix into a byte image.
+/// @param[in] b Pointer to the bit matrix.
+/// @param[in] zero The value of the pixels whose bit is 0.
+/// @param[in] one The value of the pixels whose bit is 1.
+/// @return A newly allocated byte image of the same shape.
+MatU8 *mat_bit_to_u8(const BitMatrix *b, uint8_t zero, uint8_t one);
+
+/// @brief Unpacks a bit matrix into a padded float matrix (see
+/// `mat_create_padded`).
+/// @param[in] b Pointer to the bit matrix.
+/// @param[in] zero The value of the coefficients whose bit is 0.
+/// @param[in] one The value of the coefficients whose bit is 1.
+/// @return A newly allocated float matrix of the same shape.
+Matrix *mat_bit_to_matrix(const BitMatrix *b, float zero, float one);
+
+/// @brief Packs a binary float matrix into the top-left corner of a bit
+/// matrix, without allocating: it lets a bit matrix created for the largest
+/// batch hold smaller ones.
+/// @param[out] dst Pointer to the bit matrix, at least as large as m. The
+/// bits of its first m->height rows past the width of m are cleared.
+/// @param[in] m Pointer to the float matrix.
+/// @return 1 if every coefficient of m is 0 or 1, 0 otherwise (the packed
+/// rows are then meaningless).
+/// @throw Terminates the program if m does not fit in dst.
+int mat_bit_pack(BitMatrix *dst, const Matrix *m);
+
+/// @brief Packs the transpose of a binary float matrix into the top-left
+/// corner of a bit matrix (see `mat_bit_pack`), e.g. a batch of binary images
+/// with one image per column into one image per row.
+/// @param[out] dst Pointer to the bit matrix, at least as large as the
+/// transpose of m.
+/// @param[in] m Pointer to the float matrix.
+/// @return 1 if every coefficient of m is 0 or 1, 0 otherwise.
+/// @throw Terminates the program if the transpose of m does not fit in dst.
+int mat_bit_pack_columns(BitMatrix *dst, const Matrix *m);
+
+/// @brief Computes the product of the top-left corner of a bit matrix by a
+/// float matrix: each row of dst is the sum of the rows of b selected by the
+/// set bits of the same row of a, so that the cost only depends on the number
+/// of set bits. With the transposed weights of a layer as b and a batch of
+/// binary inputs packed by `mat_bit_pack_columns` as a, it is the transposed
+/// product of the weights by the inputs.
+/// @param[out] dst Pointer to the product, of the width of b.
+/// @param[in] a Pointer to the bit matrix, whose first dst->height rows and
+/// b->height columns are used.
+/// @param[in] b Pointer to the float matrix.
+/// @throw Terminates the program if the dimensions mismatch.
+void mat_bit_multiplication(Matrix *dst, const BitMatrix *a, const Matrix *b);
+
+/// @brief Counts the set bits of a matrix.
+/// @param[in] b Pointer to the matrix.
+/// @return The number of set bits.
+size_t mat_bit_popcount(const BitMatrix *b);
+
+/// @brief Counts the set bits of a range of a row.
+/// @param[in] b Pointer to the matrix.
+/// @param[in] h Row index.
+/// @param[in] w Index of the first column of the range.
+/// @param[in] width Number of columns of the range.
+/// @return The number of set bits in the columns [w, w + width) of row h.
+/// @throw Terminates the program if the range is out of bounds.
+size_t mat_bit_row_popcount(const BitMatrix *b, size_t h, size_t w,
+                            size_t width);
+
+/// @brief Counts the set bits of every row of a rectangle (horizontal
+/// projection).
+/// @param[in] b Pointer to the matrix.
+/// @param[in] h Index of the top row of the rectangle.
+/// @param[in] w Index of the left column of the rectangle.
+/// @param[in] height Number of rows of the rectangle.
+/// @param[in] width Number of columns of the rectangle.
+/// @param[out] histogram Array of height counts, one per row.
+/// @throw Terminates the program if the rectangle is out of bounds.
+void mat_bit_row_histogram(const BitMatrix *b, size_t h, size_t w,
+                           size_t height, size_t width, size_t *histogram);
+
+/// @brief Counts the set bits of every column of a rectangle (vertical
+/// projection). The counts of 64 columns are updated at once with bit-sliced
+/// counters, so the cost depends on the number of words rather than on the
+/// number of pixels.
+/// @param[in] b Pointer to the matrix.
+/// @param[in] h Index of the top row of the rectangle.
+/// @param[in] w Index of the left column of the rectangle.
+/// @param[in] height Number of rows of the rectangle.
+/// @param[in] width Number of columns of the rectangle.
+/// @param[out] histogram Array of width counts, one per column.
+/// @throw Terminates the program if the rectangle is out of bounds.
+void mat_bit_column_histogram(const BitMatrix *b, size_t h, size_t w,
+                              size_t height, size_t width, size_t *histogram);
+
+/// @brief Finds the smallest rectangle containing every set bit.
+/// @param[in] b Pointer to the matrix.
+/// @param[out] h Index of the top row of the rectangle.
+/// @param[out] w Index of the left column of the rectangle.
+/// @param[out] height Number of rows of the rectangle.
+/// @param[out] width Number of columns of the rectangle.
+/// @return 1 if the matrix has a set bit, 0 otherwise (and the outputs are
+/// left unchanged).
+int mat_bit_strip_margins(const BitMatrix *b, size_t *h, size_t *w,
+                          size_t *height, size_t *width);
+
+/// @brief Sets every bit to the OR of its kernel_size × kernel_size
+/// neighbourhood, whose anchor is at kernel_size / 2. It is the bit version of
+/// `mat_u8_max_filter`: border pixels are repeated outside the image.
+/// @param[in] src Pointer to the matrix.
+/// @param[in] kernel_size The size of the neighbourhood (must be non-zero).
+/// @return A newly allocated filtered matrix.
+/// @throw Terminates the program if kernel_size is zero.
+BitMatrix *mat_bit_max_filter(const BitMatrix *src, size_t kernel_size);
+
+/// @brief Sets every bit to the AND of its kernel_size × kernel_size
+/// neighbourhood, see `mat_bit_max_filter`.
+/// @param[in] src Pointer to the matrix.
+/// @param[in] kernel_size The size of the neighbourhood (must be non-zero).
+/// @return A newly allocated filtered matrix.
+/// @throw Terminates the program if kernel_size is zero.
+BitMatrix *mat_bit_min_filter(const BitMatrix *src, size_t kernel_size);
+
+#endif
@@ -0,0 +1,186 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/bench.h"
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "matrix/simd.h"
+#include "utils/random/random.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_LEGACY_AVX
+#endif
+
+/// @brief Shapes (height of A, width of A, width of B) used by the OCR network.
+/// The width 1 shapes are the per-sample products of net_feed_forward and
+/// net_back_propagation, the width 64 ones are the products of a mini-batch.
+static const size_t SHAPES[][3] = {
+    {128, 784, 1}, {26, 128, 1},  {128, 26, 1},   {128, 1, 784},
+    {26, 1, 128},  {128, 784, 64}, {26, 128, 64}, {128, 64, 784},
+};
+
+/// @brief The previous scalar implementation of mat_multiplication: one dot
+/// product per coefficient of the result.
+static Matrix *legacy_multiplication(const Matrix *a, const Matrix *b)
+{
+    size_t m = mat_height(a), k = mat_width(a), n = mat_width(b);
+    Matrix *res = mat_create(m, n);
+
+    for (size_t h = 0; h < m; ++h)
+    {
+        for (size_t w = 0; w < n; ++w)
+        {
+            float sum = 0.0f;
+            for (size_t i = 0; i < k; ++i)
+                sum += *mat_unsafe_coef_ptr(a, h, i) *
+                       *mat_unsafe_coef_ptr(b, i, w);
+            *mat_unsafe_coef_ptr(res, h, w) = sum;
+        }
+    }
+
+    return res;
+}
+
+#ifdef HAS_LEGACY_AVX
+/// @brief The previous AVX2 implementation of mat_multiplication: b is
+/// transposed on every call and each coefficient is an 8-lane dot product.
+/// It must only be called if the CPU supports AVX2 and FMA.
+__attribute__((target("avx2,fma"))) static Matrix *
+legacy_avx_multiplication(const Matrix *a, const Matrix *b)
+{
+    size_t m = mat_height(a), k = mat_width(a), n = mat_width(b);
+    Matrix *res = mat_create(m, n);
+    Matrix *b_t = mat_transpose(b);
+
+    for (size_t h = 0; h < m; ++h)
+    {
+        for (size_t w = 0; w < n; ++w)
+        {
+            const float *a_row = mat_unsafe_coef_ptr(a, h, 0);
+            const float *b_col = mat_unsafe_coef_ptr(b_t, w, 0);
+
+            __m256 sum = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 8 <= k; i += 8)
+                sum = _mm256_fmadd_ps(_mm256_loadu_ps(&a_row[i]),
+                                      _mm256_loadu_ps(&b_col[i]), sum);
+
+            float tmp[8];
+            _mm256_storeu_ps(tmp, sum);
+            float total = tmp[0] + tmp[1] + tmp[2] + tmp[3] + tmp[4] + tmp[5] +
+                          tmp[6] + tmp[7];
+            for (; i < k; ++i)
+                total += a_row[i] * b_col[i];
+
+            *mat_unsafe_coef_ptr(res, h, w) = total;
+        }
+    }
+
+    mat_free(b_t);
+    return res;
+}
+#endif
+
+/// @brief A multiplication, the benchmarked call.
+typedef struct Product
+{
+    Matrix *(*mul)(const Matrix *, const Matrix *);
+    const Matrix *a;
+    const Matrix *b;
+} Product;
+
+static void run_product(void *ctx)
+{
+    Product *p = ctx;
+    mat_free(p->mul(p->a, p->b));
+}
+
+static BenchConfig config;
+static BenchReport report;
+
+/// @brief Measures a multiplication function on the given operands and
+/// reports its throughput in GFLOP/s.
+static void bench(const char *variant, size_t threads, const char *shape,
+                  Matrix *(*mul)(const Matrix *, const Matrix *),
+                  const Matrix *a, const Matrix *b)
+{
+    Product p = {.mul = mul, .a = a, .b = b};
+    double flops = 2.0 * (double)mat_height(a) * (double)mat_width(a) *
+                   (double)mat_width(b);
+
+    BenchResult res;
+    bench_measure(&config, run_product, &p, flops, BenchFlops, &res);
+    res.name = "mat_multiplication";
+    res.shape = shape;
+    res.variant = variant;
+    res.threads = threads;
+    bench_report_add(&report, &res);
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE, "Usage: %s [--format table|csv|json] [--samples N]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    config = BENCH_DEFAULT_CONFIG;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else
+            usage(argv[0]);
+    }
+
+    rand_seed();
+
+    int legacy_avx = 0;
+#ifdef HAS_LEGACY_AVX
+    legacy_avx = simd_detect_tier() >= SimdAvx2;
+#endif
+
+    bench_report_begin(&report, stdout, format);
+
+    for (size_t s = 0; s < sizeof(SHAPES) / sizeof(SHAPES[0]); ++s)
+    {
+        Matrix *a = mat_create_random_uniform(SHAPES[s][0], SHAPES[s][1],
+                                              -1.0f, 1.0f);
+        Matrix *b = mat_create_random_uniform(SHAPES[s][1], SHAPES[s][2],
+                                              -1.0f, 1.0f);
+
+        char shape[32];
+        snprintf(shape, sizeof(shape), "%zux%zux%zu", SHAPES[s][0],
+                 SHAPES[s][1], SHAPES[s][2]);
+
+        bench("legacy", 1, shape, legacy_multiplication, a, b);
+#ifdef HAS_LEGACY_AVX
+        if (legacy_avx)
+            bench("legacy_avx2", 1, shape, legacy_avx_multiplication, a, b);
+#endif
+        bench(simd_tier_name(simd_tier()), mat_thread_count(), shape,
+              mat_multiplication, a, b);
+
+        mat_free(a);
+        mat_free(b);
+    }
+
+    bench_report_end(&report);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include <err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernels.h"
+#include "simd.h"
+
+_Thread_local float gemm_packed_a[GEMM_MC * GEMM_KC]
+    __attribute__((aligned(64)));
+_Thread_local float gemm_packed_b[GEMM_KC * GEMM_NC]
+    __attribute__((aligned(64)));
+
+/// @brief The kernel tables indexed by tier.
+static const MatKernels *const KERNELS[] = {
+    [SimdScalar] = &kernels_scalar,
+    [SimdSse42] = &kernels_sse42,
+    [SimdAvx2] = &kernels_avx2,
+    [SimdAvx512] = &kernels_avx512,
+};
+
+/// @brief The tier names, as accepted by the SIMD_ENV_VAR environment
+/// variable.
+static const char *const TIER_NAMES[] = {
+    [SimdScalar] = "scalar",
+    [SimdSse42] = "sse4.2",
+    [SimdAvx2] = "avx2",
+    [SimdAvx512] = "avx512",
+};
+
+#define TIER_COUNT (sizeof(KERNELS) / sizeof(KERNELS[0]))
+
+const MatKernels *mat_kernels = &kernels_scalar;
+
+SimdTier simd_detect_tier()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    // __builtin_cpu_supports also checks that the operating system saves the
+    // corresponding registers.
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw"))
+        return SimdAvx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdAvx2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SimdSse42;
+#endif
+    return SimdScalar;
+}
+
+SimdTier simd_tier() { return mat_kernels->tier; }
+
+int simd_set_tier(SimdTier tier)
+{
+    if ((size_t)tier >= TIER_COUNT || tier > simd_detect_tier())
+        return -1;
+
+    mat_kernels = KERNELS[tier];
+    return 0;
+}
+
+const char *simd_tier_name(SimdTier tier)
+{
+    if ((size_t)tier >= TIER_COUNT)
+        errx(EXIT_FAILURE, "Invalid SIMD tier '%i'.", (int)tier);
+
+    return TIER_NAMES[tier];
+}
+
+/// @brief Selects the kernels once, before main is called: the tier forced by
+/// the SIMD_ENV_VAR environment variable if set, the best supported one
+/// otherwise.
+__attribute__((constructor)) static void kernels_init()
+{
+    SimdTier best = simd_detect_tier();
+    const char *forced = getenv(SIMD_ENV_VAR);
+
+    if (forced == NULL || forced[0] == '\0')
+    {
+        simd_set_tier(best);
+        return;
+    }
+
+    for (size_t tier = 0; tier < TIER_COUNT; ++tier)
+    {
+        if (strcmp(forced, TIER_NAMES[tier]) != 0)
+            continue;
+
+        if (simd_set_tier((SimdTier)tier) != 0)
+            errx(EXIT_FAILURE,
+                 "%s=%s: this CPU does not support the '%s' tier (best "
+                 "supported tier: '%s').",
+                 SIMD_ENV_VAR, forced, forced, TIER_NAMES[best]);
+        return;
+    }
+
+    errx(EXIT_FAILURE,
+         "%s=%s: unknown SIMD tier. Expected 'scalar', 'sse4.2', 'avx2' or "
+         "'avx512'.",
+         SIMD_ENV_VAR, forced);
+}
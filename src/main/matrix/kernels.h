@@ -0,0 +1,140 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "matrix/simd.h"
+
+// GEMM blocking parameters. A MC×KC block of the left operand is packed so
+// that it stays in L2, each KC×NR micro-panel of the right operand stays in L1
+// and every MR×NR tile of the result is accumulated in registers. NR is the
+// vector length of the kernel tier, GEMM_NC must be a multiple of all of them.
+#define GEMM_MR 8
+#define GEMM_MC 128
+#define GEMM_KC 256
+#define GEMM_NC 512
+
+/// @brief GEMM packing buffers, shared by all the kernel tiers. They are
+/// allocated once per thread instead of once per product.
+extern _Thread_local float gemm_packed_a[GEMM_MC * GEMM_KC];
+extern _Thread_local float gemm_packed_b[GEMM_KC * GEMM_NC];
+
+/// @brief The hot loops of the matrix library for a given instruction set.
+/// Element-wise kernels work on contiguous arrays of n floats and support
+/// dst being one of their sources (in-place operations). They switch to
+/// aligned loads and stores when all their arrays are aligned on a vector.
+typedef struct MatKernels
+{
+    /// @brief The tier these kernels were compiled for.
+    SimdTier tier;
+
+    /// @brief dst[i] = value.
+    void (*fill)(float *dst, float value, size_t n);
+
+    /// @brief dst[i] = a[i] + b[i].
+    void (*add)(float *dst, const float *a, const float *b, size_t n);
+
+    /// @brief dst[i] = a[i] - b[i].
+    void (*sub)(float *dst, const float *a, const float *b, size_t n);
+
+    /// @brief dst[i] = a[i] * b[i].
+    void (*hadamard)(float *dst, const float *a, const float *b, size_t n);
+
+    /// @brief dst[i] = a * src[i].
+    void (*scale)(float *dst, const float *src, float a, size_t n);
+
+    /// @brief dst[i] = max(src[i], 0).
+    void (*relu)(float *dst, const float *src, size_t n);
+
+    /// @brief dst[i] = src[i] > 0 ? 1 : 0.
+    void (*relu_derivative)(float *dst, const float *src, size_t n);
+
+    /// @brief dst[j] += the sum of src[indices[i] × lds + j] for i < count,
+    /// for j < n: adds the rows of src at the given indices to dst.
+    void (*add_rows)(float *dst, const float *src, size_t lds,
+                     const size_t *indices, size_t count, size_t n);
+
+    /// @brief c = a × b where a is m×k, b is k×n and c is m×n, all row-major
+    /// with the given leading dimensions. c does not have to be initialized.
+    void (*gemm)(size_t m, size_t n, size_t k, const float *a, size_t lda,
+                 const float *b, size_t ldb, float *c, size_t ldc);
+
+    /// @brief y = a × x (+ bias) where a is m×k (row-major with leading
+    /// dimension lda), x a contiguous vector of length k and y a contiguous
+    /// vector of length m. bias can be NULL.
+    void (*gemv)(size_t m, size_t k, const float *a, size_t lda,
+                 const float *x, const float *bias, float *y);
+
+    /// @brief y = a × x (+ bias) like gemv and, if act is not NULL,
+    /// act = relu(y), in a single pass. act may be y.
+    void (*dense)(size_t m, size_t k, const float *a, size_t lda,
+                  const float *x, const float *bias, float *y, float *act);
+
+    /// @brief y[i] = the dot product of the row i of a by x for i < m, where a
+    /// is m×k signed bytes (row-major with leading dimension lda) and x is k
+    /// unsigned bytes. Pairs of products are summed in 16 bits first: the x[j]
+    /// must be at most 127 and the coefficients of a at least -127 for these
+    /// sums not to saturate.
+    void (*gemv_s8)(size_t m, size_t k, const int8_t *a, size_t lda,
+                    const uint8_t *x, int32_t *y);
+
+    /// @brief dst[i] = src[i] × scale rounded to the nearest integer (halves
+    /// upwards), where the products must be at most 255. Negative products
+    /// give 0.
+    void (*quantize_u8)(uint8_t *dst, const float *src, float scale,
+                        size_t n);
+
+    /// @brief dst[i] = exp(src[i]). For src[i] in ]-87.33, 88], the error is
+    /// at most 1 ulp against the correctly rounded result on every tier
+    /// (measured on 2×10^7 random inputs, the tests allow 2). exp(x) is 0 for
+    /// x <= -87.33 (denormal results are flushed to zero) and exp(88) for
+    /// x > 88. NaN is not supported.
+    void (*exp)(float *dst, const float *src, size_t n);
+
+    /// @brief dst[i] = exp(src[i] - shift), with the accuracy of exp, and
+    /// returns the sum of the dst[i]. It is the main pass of a softmax.
+    float (*exp_sum)(float *dst, const float *src, float shift, size_t n);
+
+    /// @brief dst[i] = 1 / (1 + exp(-src[i])), computed with exp. The error
+    /// is at most 3 ulp on every tier (measured on [-20, 20], the tests allow
+    /// 4).
+    void (*sigmoid)(float *dst, const float *src, size_t n);
+
+    /// @brief dst[i] = tanh(src[i]). The error is at most 2 ulp on every tier
+    /// (measured on [-20, 20], the tests allow 3). NaN is not supported.
+    void (*tanh)(float *dst, const float *src, size_t n);
+
+    /// @brief dst[i] = min(max(src[i], low), high).
+    void (*clip)(float *dst, const float *src, float low, float high,
+                 size_t n);
+
+    /// @brief dst[i] = src[i] > threshold ? high : low.
+    void (*threshold)(float *dst, const float *src, float threshold,
+                      float low, float high, size_t n);
+
+    /// @brief Returns the sum of src[i].
+    float (*sum)(const float *src, size_t n);
+
+    /// @brief Returns the maximum of src[i]. n must be non-zero.
+    float (*max)(const float *src, size_t n);
+
+    /// @brief Returns the sum of (src[i] - mean)^2.
+    float (*sum_sq_diff)(const float *src, float mean, size_t n);
+
+    /// @brief dst = transpose(src) where src is height×width and dst is
+    /// width×height, both row-major with the given leading dimensions.
+    void (*transpose)(float *dst, size_t ldd, const float *src, size_t lds,
+                      size_t height, size_t width);
+} MatKernels;
+
+extern const MatKernels kernels_scalar;
+extern const MatKernels kernels_sse42;
+extern const MatKernels kernels_avx2;
+extern const MatKernels kernels_avx512;
+
+/// @brief The kernels of the active tier. It is selected once at startup (see
+/// simd.h) and must not be modified directly.
+extern const MatKernels *mat_kernels;
+
+#endif
@@ -0,0 +1,113 @@
+// AVX2 and FMA kernels. This file is compiled with -mavx2 -mfma (see the
+// Makefile) and its functions must only be called through the kernel
+// dispatch.
+
+#include <immintrin.h>
+
+#define KERNEL_TABLE kernels_avx2
+#define KERNEL_TIER SimdAvx2
+
+#define avx_vect_t __m256
+#define avx(op, ...) _mm256_##op##_ps(__VA_ARGS__)
+#define avx_vect_len 8
+
+#define avx_fmadd(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define avx_step(v, zero, one)                                                 \
+    _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GT_OQ), one)
+#define avx_select(v, threshold, a, b)                                         \
+    _mm256_blendv_ps(b, a, _mm256_cmp_ps(v, threshold, _CMP_GT_OQ))
+#define avx_round(v)                                                           \
+    _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define avx_ldexp(v, n)                                                        \
+    _mm256_mul_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(                    \
+                         _mm256_add_epi32(_mm256_cvtps_epi32(n),               \
+                                          _mm256_set1_epi32(127)),             \
+                         23)))
+
+/// @brief Returns the sum of the 8 lanes of v.
+static inline float avx_hsum(__m256 v)
+{
+    __m128 s =
+        _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+/// @brief Stores the sums of the 8 lanes of v0, v1, v2 and v3 into dst.
+static inline void avx_hsum4(__m256 v0, __m256 v1, __m256 v2, __m256 v3,
+                             float *dst)
+{
+    __m256 s01 = _mm256_hadd_ps(v0, v1);
+    __m256 s23 = _mm256_hadd_ps(v2, v3);
+    __m256 s = _mm256_hadd_ps(s01, s23);
+    _mm_storeu_ps(dst, _mm_add_ps(_mm256_castps256_ps128(s),
+                                  _mm256_extractf128_ps(s, 1)));
+}
+
+#define avx_i8_t __m256i
+#define avx_i8_len 32
+#define avx_i8_loadu(p) _mm256_loadu_si256((const __m256i *)(p))
+#define avx_i8_zero() _mm256_setzero_si256()
+#define avx_i8_dot(acc, x, a)                                                  \
+    _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(x, a),        \
+                                            _mm256_set1_epi16(1)))
+
+/// @brief Returns the sum of the 8 32-bit lanes of v.
+static inline int32_t avx_i8_hsum(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+#define avx_store_u8(p, v)                                                     \
+    do                                                                         \
+    {                                                                          \
+        __m256i i32 = _mm256_cvttps_epi32(v);                                  \
+        __m128i u16 = _mm_packus_epi32(_mm256_castsi256_si128(i32),            \
+                                       _mm256_extracti128_si256(i32, 1));      \
+        _mm_storel_epi64((__m128i *)(p), _mm_packus_epi16(u16, u16));          \
+    } while (0)
+
+#define avx_transpose_square transpose_square
+
+/// @brief Transposes the 8×8 tile src (with a leading dimension of lds) into
+/// dst (with a leading dimension of ldd).
+static inline void transpose_square(const float *src, size_t lds, float *dst,
+                                    size_t ldd)
+{
+    __m256 r[8], t[8], u[8];
+
+    for (size_t i = 0; i < 8; ++i)
+        r[i] = _mm256_loadu_ps(src + i * lds);
+
+    // Interleave pairs of rows: in each 128-bit lane of t[2i] (resp. t[2i+1])
+    // are the columns 0 and 1 (resp. 2 and 3) of the rows 2i and 2i+1.
+    for (size_t i = 0; i < 4; ++i)
+    {
+        t[2 * i] = _mm256_unpacklo_ps(r[2 * i], r[2 * i + 1]);
+        t[2 * i + 1] = _mm256_unpackhi_ps(r[2 * i], r[2 * i + 1]);
+    }
+
+    // In each 128-bit lane of u[4g+c] is the column c of the rows 4g to 4g+3.
+    for (size_t g = 0; g < 2; ++g)
+    {
+        u[4 * g + 0] = _mm256_shuffle_ps(t[4 * g], t[4 * g + 2], 0x44);
+        u[4 * g + 1] = _mm256_shuffle_ps(t[4 * g], t[4 * g + 2], 0xEE);
+        u[4 * g + 2] = _mm256_shuffle_ps(t[4 * g + 1], t[4 * g + 3], 0x44);
+        u[4 * g + 3] = _mm256_shuffle_ps(t[4 * g + 1], t[4 * g + 3], 0xEE);
+    }
+
+    // Gather the 128-bit lanes of the two groups of rows.
+    for (size_t c = 0; c < 4; ++c)
+    {
+        _mm256_storeu_ps(dst + c * ldd,
+                         _mm256_permute2f128_ps(u[c], u[4 + c], 0x20));
+        _mm256_storeu_ps(dst + (4 + c) * ldd,
+                         _mm256_permute2f128_ps(u[c], u[4 + c], 0x31));
+    }
+}
+
+#include "matrix/kernels_template.h"
@@ -0,0 +1,99 @@
+// AVX-512F kernels. This file is compiled with -mavx512f -mavx512bw -mavx2
+// -mfma (see the Makefile) and its functions must only be called through the
+// kernel dispatch. Remainders are handled with masked loads and stores.
+
+#include <immintrin.h>
+
+#define KERNEL_TABLE kernels_avx512
+#define KERNEL_TIER SimdAvx512
+
+#define avx_vect_t __m512
+#define avx(op, ...) _mm512_##op##_ps(__VA_ARGS__)
+#define avx_vect_len 16
+
+#define avx_fmadd(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define avx_step(v, zero, one)                                                 \
+    _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(v, zero, _CMP_GT_OQ), one)
+#define avx_select(v, threshold, a, b)                                         \
+    _mm512_mask_blend_ps(_mm512_cmp_ps_mask(v, threshold, _CMP_GT_OQ), b, a)
+#define avx_hsum(v) _mm512_reduce_add_ps(v)
+#define avx_round(v)                                                           \
+    _mm512_roundscale_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define avx_ldexp(v, n) _mm512_scalef_ps(v, n)
+
+#define avx_i8_t __m512i
+#define avx_i8_len 64
+#define avx_i8_loadu(p) _mm512_loadu_si512(p)
+#define avx_i8_zero() _mm512_setzero_si512()
+#define avx_i8_dot(acc, x, a)                                                  \
+    _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_maddubs_epi16(x, a),        \
+                                            _mm512_set1_epi16(1)))
+#define avx_i8_hsum(v) _mm512_reduce_add_epi32(v)
+#define avx_store_u8(p, v)                                                     \
+    _mm_storeu_si128((__m128i *)(p),                                           \
+                     _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(v)))
+
+#define avx_mask_t __mmask16
+#define avx_tail_mask(n) ((__mmask16)((1U << (n)) - 1))
+#define avx_transpose_tile transpose_tile
+
+/// @brief Stores the sums of the 16 lanes of v0, v1, v2 and v3 into dst.
+static inline void avx_hsum4(__m512 v0, __m512 v1, __m512 v2, __m512 v3,
+                             float *dst)
+{
+    dst[0] = _mm512_reduce_add_ps(v0);
+    dst[1] = _mm512_reduce_add_ps(v1);
+    dst[2] = _mm512_reduce_add_ps(v2);
+    dst[3] = _mm512_reduce_add_ps(v3);
+}
+
+/// @brief Transposes the top-left rows×cols corner of the 16×16 tile src (with
+/// a leading dimension of lds) into dst (with a leading dimension of ldd).
+/// Partial tiles are loaded and stored with masks.
+static inline void transpose_tile(const float *src, size_t lds, float *dst,
+                                  size_t ldd, size_t rows, size_t cols)
+{
+    __m512 r[16], t[16], u[16];
+
+    __mmask16 col_mask = avx_tail_mask(cols);
+    for (size_t i = 0; i < 16; ++i)
+        r[i] = i < rows ? _mm512_maskz_loadu_ps(col_mask, src + i * lds)
+                        : _mm512_setzero_ps();
+
+    // Interleave pairs of rows: in each 128-bit lane of t[2i] (resp. t[2i+1])
+    // are the columns 0 and 1 (resp. 2 and 3) of the rows 2i and 2i+1.
+    for (size_t i = 0; i < 8; ++i)
+    {
+        t[2 * i] = _mm512_unpacklo_ps(r[2 * i], r[2 * i + 1]);
+        t[2 * i + 1] = _mm512_unpackhi_ps(r[2 * i], r[2 * i + 1]);
+    }
+
+    // In each 128-bit lane of u[4g+c] is the column c of the rows 4g to 4g+3.
+    for (size_t g = 0; g < 4; ++g)
+    {
+        u[4 * g + 0] = _mm512_shuffle_ps(t[4 * g], t[4 * g + 2], 0x44);
+        u[4 * g + 1] = _mm512_shuffle_ps(t[4 * g], t[4 * g + 2], 0xEE);
+        u[4 * g + 2] = _mm512_shuffle_ps(t[4 * g + 1], t[4 * g + 3], 0x44);
+        u[4 * g + 3] = _mm512_shuffle_ps(t[4 * g + 1], t[4 * g + 3], 0xEE);
+    }
+
+    // Gather the 128-bit lanes of the four groups of rows.
+    for (size_t c = 0; c < 4; ++c)
+    {
+        __m512 v_even = _mm512_shuffle_f32x4(u[c], u[4 + c], 0x88);
+        __m512 v_odd = _mm512_shuffle_f32x4(u[c], u[4 + c], 0xDD);
+        __m512 w_even = _mm512_shuffle_f32x4(u[8 + c], u[12 + c], 0x88);
+        __m512 w_odd = _mm512_shuffle_f32x4(u[8 + c], u[12 + c], 0xDD);
+
+        r[c] = _mm512_shuffle_f32x4(v_even, w_even, 0x88);
+        r[4 + c] = _mm512_shuffle_f32x4(v_odd, w_odd, 0x88);
+        r[8 + c] = _mm512_shuffle_f32x4(v_even, w_even, 0xDD);
+        r[12 + c] = _mm512_shuffle_f32x4(v_odd, w_odd, 0xDD);
+    }
+
+    __mmask16 row_mask = avx_tail_mask(rows);
+    for (size_t j = 0; j < cols; ++j)
+        _mm512_mask_storeu_ps(dst + j * ldd, row_mask, r[j]);
+}
+
+#include "matrix/kernels_template.h"
@@ -0,0 +1,6 @@
+// Portable kernels, used on CPUs without any supported SIMD extension.
+
+#define KERNEL_TABLE kernels_scalar
+#define KERNEL_TIER SimdScalar
+
+#include "matrix/kernels_template.h"
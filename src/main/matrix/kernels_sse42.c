@@ -0,0 +1,81 @@
+// SSE4.2 kernels. This file is compiled with -msse4.2 (see the Makefile) and
+// its functions must only be called through the kernel dispatch.
+
+#include <immintrin.h>
+
+#define KERNEL_TABLE kernels_sse42
+#define KERNEL_TIER SimdSse42
+
+#define avx_vect_t __m128
+#define avx(op, ...) _mm_##op##_ps(__VA_ARGS__)
+#define avx_vect_len 4
+
+// SSE4.2 has no fused multiply-add.
+#define avx_fmadd(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define avx_step(v, zero, one) _mm_and_ps(_mm_cmpgt_ps(v, zero), one)
+#define avx_select(v, threshold, a, b)                                         \
+    _mm_blendv_ps(b, a, _mm_cmpgt_ps(v, threshold))
+#define avx_round(v)                                                           \
+    _mm_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define avx_ldexp(v, n)                                                        \
+    _mm_mul_ps(v, _mm_castsi128_ps(_mm_slli_epi32(                             \
+                      _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)),  \
+                      23)))
+
+static inline float avx_hsum(__m128 v)
+{
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+static inline void avx_hsum4(__m128 v0, __m128 v1, __m128 v2, __m128 v3,
+                             float *dst)
+{
+    _mm_storeu_ps(dst, _mm_hadd_ps(_mm_hadd_ps(v0, v1), _mm_hadd_ps(v2, v3)));
+}
+
+#define avx_i8_t __m128i
+#define avx_i8_len 16
+#define avx_i8_loadu(p) _mm_loadu_si128((const __m128i *)(p))
+#define avx_i8_zero() _mm_setzero_si128()
+#define avx_i8_dot(acc, x, a)                                                  \
+    _mm_add_epi32(acc,                                                         \
+                  _mm_madd_epi16(_mm_maddubs_epi16(x, a), _mm_set1_epi16(1)))
+
+static inline int32_t avx_i8_hsum(__m128i v)
+{
+    __m128i s = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+#define avx_store_u8(p, v)                                                     \
+    do                                                                         \
+    {                                                                          \
+        __m128i i32 = _mm_cvttps_epi32(v);                                     \
+        __m128i u8 = _mm_packus_epi16(_mm_packus_epi32(i32, i32), i32);        \
+        int32_t bytes = _mm_cvtsi128_si32(u8);                                 \
+        memcpy(p, &bytes, 4);                                                  \
+    } while (0)
+
+#define avx_transpose_square transpose_square
+
+/// @brief Transposes the 4×4 tile src (with a leading dimension of lds) into
+/// dst (with a leading dimension of ldd).
+static inline void transpose_square(const float *src, size_t lds, float *dst,
+                                    size_t ldd)
+{
+    __m128 r0 = _mm_loadu_ps(src);
+    __m128 r1 = _mm_loadu_ps(src + lds);
+    __m128 r2 = _mm_loadu_ps(src + 2 * lds);
+    __m128 r3 = _mm_loadu_ps(src + 3 * lds);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    _mm_storeu_ps(dst, r0);
+    _mm_storeu_ps(dst + ldd, r1);
+    _mm_storeu_ps(dst + 2 * ldd, r2);
+    _mm_storeu_ps(dst + 3 * ldd, r3);
+}
+
+#include "matrix/kernels_template.h"
@@ -0,0 +1,1178 @@
+// Kernels of the matrix library, written once and compiled once per SIMD tier.
+// This file has no include guard: it is meant to be included at the end of a
+// kernels_<tier>.c file, which must define beforehand:
+//   - KERNEL_TABLE: the name of the MatKernels table to define,
+//   - KERNEL_TIER: the SimdTier of the table.
+// Vectorized tiers must also define:
+//   - avx_vect_t: the vector type,
+//   - avx(op, ...): the intrinsic of the given operation on avx_vect_t,
+//   - avx_vect_len: the number of floats in avx_vect_t,
+//   - avx_fmadd(a, b, c): a * b + c,
+//   - avx_step(v, zero, one): one where v > zero and 0 elsewhere,
+//   - avx_select(v, threshold, a, b): a where v > threshold and b elsewhere,
+//   - avx_hsum(v): the sum of the lanes of v as a float,
+//   - avx_hsum4(v0, v1, v2, v3, dst): stores the sums of the lanes of v0, v1,
+//     v2 and v3 into the 4 floats pointed by dst,
+//   - avx_round(v): v rounded to the nearest integers (ties to even),
+//   - avx_ldexp(v, n): v * 2^n for n integral in [-126, 127].
+// Tiers with masked loads and stores can also define:
+//   - avx_mask_t: the mask type,
+//   - avx_tail_mask(n): the mask of the n first lanes (0 < n <= avx_vect_len),
+//   - avx_transpose_tile(src, lds, dst, ldd, rows, cols): transposes the
+//     top-left rows×cols corner of an avx_vect_len×avx_vect_len tile.
+// Remainders are then handled with a single masked iteration instead of a
+// scalar loop. The scalar tier defines none of them. Vectorized tiers without
+// masks can define instead:
+//   - avx_transpose_square(src, lds, dst, ldd): transposes a full
+//     avx_vect_len×avx_vect_len tile, the partial tiles being transposed by a
+//     scalar loop.
+// Tiers with 8-bit integer multiply-adds can also define:
+//   - avx_i8_t: the integer vector type,
+//   - avx_i8_len: the number of bytes in avx_i8_t,
+//   - avx_i8_loadu(p): an unaligned load of avx_i8_len bytes,
+//   - avx_i8_zero(): a vector of zeros,
+//   - avx_i8_dot(acc, x, a): acc plus the products of the unsigned bytes of x
+//     by the signed bytes of a, summed by groups of 4 into 32-bit lanes,
+//   - avx_i8_hsum(acc): the sum of the 32-bit lanes of acc,
+//   - avx_store_u8(p, v): stores the avx_vect_len floats of v, in [0, 256[,
+//     truncated to bytes at p.
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "matrix/kernels.h"
+
+#if !defined(KERNEL_TABLE) || !defined(KERNEL_TIER)
+#error "KERNEL_TABLE and KERNEL_TIER must be defined before this file."
+#endif
+
+#ifdef avx_vect_len
+#define avx_for(counter, length)                                               \
+    for (; counter + avx_vect_len <= length; counter += avx_vect_len)
+#define GEMM_NR avx_vect_len
+
+/// @brief Whether p can be used with the aligned loads and stores.
+#define avx_is_aligned(p)                                                      \
+    ((uintptr_t)(p) % (avx_vect_len * sizeof(float)) == 0)
+#else
+#define GEMM_NR 8
+#endif
+
+#if GEMM_NC % GEMM_NR != 0
+#error "GEMM_NC must be a multiple of GEMM_NR."
+#endif
+
+static void kernel_fill(float *dst, float value, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_vect_t v = avx(set1, value);
+    if (avx_is_aligned(dst))
+        avx_for(i, n) avx(store, &dst[i], v);
+    else
+        avx_for(i, n) avx(storeu, &dst[i], v);
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx(mask_storeu, &dst[i], mask, v);
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = value;
+#endif
+}
+
+static void kernel_add(float *dst, const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    if (avx_is_aligned(dst) && avx_is_aligned(a) && avx_is_aligned(b))
+        avx_for(i, n) avx(store, &dst[i],
+                          avx(add, avx(load, &a[i]), avx(load, &b[i])));
+    else
+        avx_for(i, n) avx(storeu, &dst[i],
+                          avx(add, avx(loadu, &a[i]), avx(loadu, &b[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t a_v = avx(maskz_loadu, mask, &a[i]);
+        avx_vect_t b_v = avx(maskz_loadu, mask, &b[i]);
+        avx(mask_storeu, &dst[i], mask, avx(add, a_v, b_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = a[i] + b[i];
+#endif
+}
+
+static void kernel_add_rows(float *dst, const float *src, size_t lds,
+                            const size_t *indices, size_t count, size_t n)
+{
+    size_t j = 0;
+#ifdef avx_vect_len
+    // Four vectors of dst stay in registers while every row is added.
+    for (; j + 4 * avx_vect_len <= n; j += 4 * avx_vect_len)
+    {
+        avx_vect_t s0 = avx(loadu, &dst[j]);
+        avx_vect_t s1 = avx(loadu, &dst[j + avx_vect_len]);
+        avx_vect_t s2 = avx(loadu, &dst[j + 2 * avx_vect_len]);
+        avx_vect_t s3 = avx(loadu, &dst[j + 3 * avx_vect_len]);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float *row = src + indices[i] * lds + j;
+            s0 = avx(add, s0, avx(loadu, row));
+            s1 = avx(add, s1, avx(loadu, row + avx_vect_len));
+            s2 = avx(add, s2, avx(loadu, row + 2 * avx_vect_len));
+            s3 = avx(add, s3, avx(loadu, row + 3 * avx_vect_len));
+        }
+        avx(storeu, &dst[j], s0);
+        avx(storeu, &dst[j + avx_vect_len], s1);
+        avx(storeu, &dst[j + 2 * avx_vect_len], s2);
+        avx(storeu, &dst[j + 3 * avx_vect_len], s3);
+    }
+    avx_for(j, n)
+    {
+        avx_vect_t s = avx(loadu, &dst[j]);
+        for (size_t i = 0; i < count; ++i)
+            s = avx(add, s, avx(loadu, src + indices[i] * lds + j));
+        avx(storeu, &dst[j], s);
+    }
+#endif
+#ifdef avx_tail_mask
+    if (j < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - j);
+        avx_vect_t s = avx(maskz_loadu, mask, &dst[j]);
+        for (size_t i = 0; i < count; ++i)
+            s = avx(add, s,
+                    avx(maskz_loadu, mask, src + indices[i] * lds + j));
+        avx(mask_storeu, &dst[j], mask, s);
+    }
+#else
+    for (; j < n; ++j)
+    {
+        float s = dst[j];
+        for (size_t i = 0; i < count; ++i)
+            s += src[indices[i] * lds + j];
+        dst[j] = s;
+    }
+#endif
+}
+
+static void kernel_gemv_s8(size_t m, size_t k, const int8_t *a, size_t lda,
+                           const uint8_t *x, int32_t *y)
+{
+    size_t i = 0;
+#ifdef avx_i8_len
+    // Four rows share each load of x.
+    for (; i + 4 <= m; i += 4)
+    {
+        const int8_t *a0 = a + i * lda, *a1 = a0 + lda, *a2 = a1 + lda,
+                     *a3 = a2 + lda;
+        avx_i8_t s0 = avx_i8_zero(), s1 = avx_i8_zero(), s2 = avx_i8_zero(),
+                 s3 = avx_i8_zero();
+
+        size_t j = 0;
+        for (; j + avx_i8_len <= k; j += avx_i8_len)
+        {
+            avx_i8_t v = avx_i8_loadu(x + j);
+            s0 = avx_i8_dot(s0, v, avx_i8_loadu(a0 + j));
+            s1 = avx_i8_dot(s1, v, avx_i8_loadu(a1 + j));
+            s2 = avx_i8_dot(s2, v, avx_i8_loadu(a2 + j));
+            s3 = avx_i8_dot(s3, v, avx_i8_loadu(a3 + j));
+        }
+
+        int32_t r0 = avx_i8_hsum(s0), r1 = avx_i8_hsum(s1),
+                r2 = avx_i8_hsum(s2), r3 = avx_i8_hsum(s3);
+        for (; j < k; ++j)
+        {
+            r0 += (int32_t)x[j] * a0[j];
+            r1 += (int32_t)x[j] * a1[j];
+            r2 += (int32_t)x[j] * a2[j];
+            r3 += (int32_t)x[j] * a3[j];
+        }
+        y[i] = r0;
+        y[i + 1] = r1;
+        y[i + 2] = r2;
+        y[i + 3] = r3;
+    }
+#endif
+    for (; i < m; ++i)
+    {
+        const int8_t *row = a + i * lda;
+        int32_t s = 0;
+        size_t j = 0;
+#ifdef avx_i8_len
+        avx_i8_t acc = avx_i8_zero();
+        for (; j + avx_i8_len <= k; j += avx_i8_len)
+            acc = avx_i8_dot(acc, avx_i8_loadu(x + j), avx_i8_loadu(row + j));
+        s = avx_i8_hsum(acc);
+#endif
+        for (; j < k; ++j)
+            s += (int32_t)x[j] * row[j];
+        y[i] = s;
+    }
+}
+
+static void kernel_quantize_u8(uint8_t *dst, const float *src, float scale,
+                               size_t n)
+{
+    size_t i = 0;
+#ifdef avx_store_u8
+    avx_vect_t s = avx(set1, scale), half = avx(set1, 0.5f),
+               zero = avx(setzero);
+    avx_for(i, n)
+    {
+        avx_vect_t v = avx_fmadd(avx(loadu, &src[i]), s, half);
+        avx_store_u8(&dst[i], avx(max, v, zero));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float v = src[i] * scale + 0.5f;
+        dst[i] = (uint8_t)(int32_t)(v > 0.0f ? v : 0.0f);
+    }
+}
+
+static void kernel_sub(float *dst, const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    if (avx_is_aligned(dst) && avx_is_aligned(a) && avx_is_aligned(b))
+        avx_for(i, n) avx(store, &dst[i],
+                          avx(sub, avx(load, &a[i]), avx(load, &b[i])));
+    else
+        avx_for(i, n) avx(storeu, &dst[i],
+                          avx(sub, avx(loadu, &a[i]), avx(loadu, &b[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t a_v = avx(maskz_loadu, mask, &a[i]);
+        avx_vect_t b_v = avx(maskz_loadu, mask, &b[i]);
+        avx(mask_storeu, &dst[i], mask, avx(sub, a_v, b_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = a[i] - b[i];
+#endif
+}
+
+static void kernel_hadamard(float *dst, const float *a, const float *b,
+                            size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    if (avx_is_aligned(dst) && avx_is_aligned(a) && avx_is_aligned(b))
+        avx_for(i, n) avx(store, &dst[i],
+                          avx(mul, avx(load, &a[i]), avx(load, &b[i])));
+    else
+        avx_for(i, n) avx(storeu, &dst[i],
+                          avx(mul, avx(loadu, &a[i]), avx(loadu, &b[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t a_v = avx(maskz_loadu, mask, &a[i]);
+        avx_vect_t b_v = avx(maskz_loadu, mask, &b[i]);
+        avx(mask_storeu, &dst[i], mask, avx(mul, a_v, b_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = a[i] * b[i];
+#endif
+}
+
+static void kernel_scale(float *dst, const float *src, float a, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_vect_t a_v = avx(set1, a);
+    if (avx_is_aligned(dst) && avx_is_aligned(src))
+        avx_for(i, n) avx(store, &dst[i], avx(mul, a_v, avx(load, &src[i])));
+    else
+        avx_for(i, n) avx(storeu, &dst[i], avx(mul, a_v, avx(loadu, &src[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask, avx(mul, a_v, src_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = a * src[i];
+#endif
+}
+
+static void kernel_relu(float *dst, const float *src, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_vect_t zero = avx(setzero);
+    if (avx_is_aligned(dst) && avx_is_aligned(src))
+        avx_for(i, n) avx(store, &dst[i], avx(max, avx(load, &src[i]), zero));
+    else
+        avx_for(i, n) avx(storeu, &dst[i], avx(max, avx(loadu, &src[i]), zero));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask, avx(max, src_v, zero));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = src[i] > 0.0f ? src[i] : 0.0f;
+#endif
+}
+
+static void kernel_relu_derivative(float *dst, const float *src, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_vect_t zero = avx(setzero);
+    avx_vect_t one = avx(set1, 1.0f);
+    if (avx_is_aligned(dst) && avx_is_aligned(src))
+        avx_for(i, n)
+            avx(store, &dst[i], avx_step(avx(load, &src[i]), zero, one));
+    else
+        avx_for(i, n)
+            avx(storeu, &dst[i], avx_step(avx(loadu, &src[i]), zero, one));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask, avx_step(src_v, zero, one));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = src[i] > 0.0f ? 1.0f : 0.0f;
+#endif
+}
+
+// The exponential is computed as in Cephes' expf: x = n ln(2) + r with n an
+// integer and |r| <= ln(2) / 2, then exp(x) = 2^n exp(r) where exp(r) is
+// approximated by a polynomial of degree 7. ln(2) is split in two constants so
+// that n ln(2) is exact. See kernels.h for the accuracy.
+
+/// @brief exp(x) is 0 for x <= EXP_MIN = ln(2^-126), the smallest normal
+/// float.
+#define EXP_MIN -87.3365447505531f
+/// @brief Inputs above EXP_MAX are clamped so that 2^n stays a normal float.
+#define EXP_MAX 88.0f
+#define EXP_LOG2E 1.44269504088896341f
+#define EXP_LN2_HI 0.693359375f
+#define EXP_LN2_LO -2.12194440e-4f
+#define EXP_P0 1.9875691500e-4f
+#define EXP_P1 1.3981999507e-3f
+#define EXP_P2 8.3334519073e-3f
+#define EXP_P3 4.1665795894e-2f
+#define EXP_P4 1.6666665459e-1f
+#define EXP_P5 5.0000001201e-1f
+
+/// @brief Returns exp(x), with the same algorithm as the vectorized kernels.
+/// It is used by the scalar tier and for the remainders of the tiers without
+/// masks.
+static inline float exp_scalar(float x)
+{
+    if (!(x > EXP_MIN))
+        return 0.0f;
+    if (x > EXP_MAX)
+        x = EXP_MAX;
+
+    float n = rintf(x * EXP_LOG2E);
+    float r = x - n * EXP_LN2_HI;
+    r = r - n * EXP_LN2_LO;
+
+    float p = EXP_P0;
+    p = p * r + EXP_P1;
+    p = p * r + EXP_P2;
+    p = p * r + EXP_P3;
+    p = p * r + EXP_P4;
+    p = p * r + EXP_P5;
+
+    return ldexpf(p * r * r + r + 1.0f, (int)n);
+}
+
+#ifdef avx_vect_len
+/// @brief Returns the exponential of each lane of x.
+static inline avx_vect_t avx_exp(avx_vect_t x)
+{
+    avx_vect_t one = avx(set1, 1.0f);
+    avx_vect_t min = avx(set1, EXP_MIN);
+
+    // 1 where exp(x) is a normal float, 0 where it underflows.
+    avx_vect_t normal = avx_step(x, min, one);
+
+    x = avx(max, avx(min, x, avx(set1, EXP_MAX)), min);
+
+    avx_vect_t n = avx_round(avx(mul, x, avx(set1, EXP_LOG2E)));
+    avx_vect_t r = avx_fmadd(n, avx(set1, -EXP_LN2_HI), x);
+    r = avx_fmadd(n, avx(set1, -EXP_LN2_LO), r);
+
+    avx_vect_t p = avx(set1, EXP_P0);
+    p = avx_fmadd(p, r, avx(set1, EXP_P1));
+    p = avx_fmadd(p, r, avx(set1, EXP_P2));
+    p = avx_fmadd(p, r, avx(set1, EXP_P3));
+    p = avx_fmadd(p, r, avx(set1, EXP_P4));
+    p = avx_fmadd(p, r, avx(set1, EXP_P5));
+
+    avx_vect_t y = avx_fmadd(p, avx(mul, r, r), avx(add, r, one));
+
+    return avx(mul, avx_ldexp(y, n), normal);
+}
+
+/// @brief Returns the maximum of the lanes of v.
+static inline float avx_hmax(avx_vect_t v)
+{
+    float lanes[avx_vect_len];
+    avx(storeu, lanes, v);
+
+    float max = lanes[0];
+    for (size_t i = 1; i < avx_vect_len; ++i)
+        max = lanes[i] > max ? lanes[i] : max;
+    return max;
+}
+#endif
+
+static void kernel_exp(float *dst, const float *src, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_for(i, n) avx(storeu, &dst[i], avx_exp(avx(loadu, &src[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask, avx_exp(src_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = exp_scalar(src[i]);
+#endif
+}
+
+static float kernel_exp_sum(float *dst, const float *src, float shift,
+                            size_t n)
+{
+    size_t i = 0;
+    float sum = 0.0f;
+#ifdef avx_vect_len
+    avx_vect_t shift_v = avx(set1, shift);
+    avx_vect_t sum_v = avx(setzero);
+    avx_for(i, n)
+    {
+        avx_vect_t e = avx_exp(avx(sub, avx(loadu, &src[i]), shift_v));
+        avx(storeu, &dst[i], e);
+        sum_v = avx(add, sum_v, e);
+    }
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx_vect_t e = avx(maskz_mov, mask, avx_exp(avx(sub, src_v, shift_v)));
+        avx(mask_storeu, &dst[i], mask, e);
+        sum_v = avx(add, sum_v, e);
+        i = n;
+    }
+#endif
+    sum = avx_hsum(sum_v);
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = exp_scalar(src[i] - shift);
+        sum += dst[i];
+    }
+    return sum;
+}
+
+// The hyperbolic tangent is computed from the exponential, as (1 - e) / (1 + e)
+// with e = exp(-2|x|), except near 0 where the subtraction would cancel: its
+// Taylor series up to x^13 is used for |x| < TANH_SMALL instead.
+#define TANH_SMALL 0.4f
+#define TANH_T3 -3.33333333e-1f
+#define TANH_T5 1.33333333e-1f
+#define TANH_T7 -5.39682540e-2f
+#define TANH_T9 2.18694885e-2f
+#define TANH_T11 -8.86323552e-3f
+#define TANH_T13 3.59212803e-3f
+
+/// @brief Returns 1 / (1 + exp(-x)), with the same algorithm as the vectorized
+/// kernels.
+static inline float sigmoid_scalar(float x)
+{
+    return 1.0f / (1.0f + exp_scalar(-x));
+}
+
+/// @brief Returns tanh(x), with the same algorithm as the vectorized kernels.
+static inline float tanh_scalar(float x)
+{
+    float a = x < 0.0f ? -x : x;
+    float t;
+
+    if (a < TANH_SMALL)
+    {
+        float a2 = a * a;
+        float p = TANH_T13;
+        p = p * a2 + TANH_T11;
+        p = p * a2 + TANH_T9;
+        p = p * a2 + TANH_T7;
+        p = p * a2 + TANH_T5;
+        p = p * a2 + TANH_T3;
+        t = p * a2 * a + a;
+    }
+    else
+    {
+        float e = exp_scalar(-2.0f * a);
+        t = (1.0f - e) / (1.0f + e);
+    }
+
+    return x < 0.0f ? -t : t;
+}
+
+#ifdef avx_vect_len
+/// @brief Returns the sigmoid of each lane of x.
+static inline avx_vect_t avx_sigmoid(avx_vect_t x)
+{
+    avx_vect_t one = avx(set1, 1.0f);
+    return avx(div, one, avx(add, one, avx_exp(avx(sub, avx(setzero), x))));
+}
+
+/// @brief Returns the hyperbolic tangent of each lane of x.
+static inline avx_vect_t avx_tanh(avx_vect_t x)
+{
+    avx_vect_t zero = avx(setzero);
+    avx_vect_t one = avx(set1, 1.0f);
+    avx_vect_t a = avx(max, x, avx(sub, zero, x));
+
+    avx_vect_t e = avx_exp(avx(mul, a, avx(set1, -2.0f)));
+    avx_vect_t large = avx(div, avx(sub, one, e), avx(add, one, e));
+
+    avx_vect_t a2 = avx(mul, a, a);
+    avx_vect_t p = avx(set1, TANH_T13);
+    p = avx_fmadd(p, a2, avx(set1, TANH_T11));
+    p = avx_fmadd(p, a2, avx(set1, TANH_T9));
+    p = avx_fmadd(p, a2, avx(set1, TANH_T7));
+    p = avx_fmadd(p, a2, avx(set1, TANH_T5));
+    p = avx_fmadd(p, a2, avx(set1, TANH_T3));
+    avx_vect_t small = avx_fmadd(avx(mul, p, a2), a, a);
+
+    avx_vect_t t = avx_select(a, avx(set1, TANH_SMALL), large, small);
+    return avx_select(zero, x, avx(sub, zero, t), t);
+}
+#endif
+
+static void kernel_sigmoid(float *dst, const float *src, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_for(i, n) avx(storeu, &dst[i], avx_sigmoid(avx(loadu, &src[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask, avx_sigmoid(src_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = sigmoid_scalar(src[i]);
+#endif
+}
+
+static void kernel_tanh(float *dst, const float *src, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_for(i, n) avx(storeu, &dst[i], avx_tanh(avx(loadu, &src[i])));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask, avx_tanh(src_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = tanh_scalar(src[i]);
+#endif
+}
+
+static void kernel_clip(float *dst, const float *src, float low, float high,
+                        size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_vect_t low_v = avx(set1, low);
+    avx_vect_t high_v = avx(set1, high);
+    avx_for(i, n) avx(storeu, &dst[i],
+                      avx(min, avx(max, avx(loadu, &src[i]), low_v), high_v));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask,
+            avx(min, avx(max, src_v, low_v), high_v));
+    }
+#else
+    for (; i < n; ++i)
+    {
+        float v = src[i] > low ? src[i] : low;
+        dst[i] = v < high ? v : high;
+    }
+#endif
+}
+
+static void kernel_threshold(float *dst, const float *src, float threshold,
+                             float low, float high, size_t n)
+{
+    size_t i = 0;
+#ifdef avx_vect_len
+    avx_vect_t threshold_v = avx(set1, threshold);
+    avx_vect_t low_v = avx(set1, low);
+    avx_vect_t high_v = avx(set1, high);
+    avx_for(i, n) avx(storeu, &dst[i], avx_select(avx(loadu, &src[i]),
+                                                  threshold_v, high_v, low_v));
+#endif
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t src_v = avx(maskz_loadu, mask, &src[i]);
+        avx(mask_storeu, &dst[i], mask,
+            avx_select(src_v, threshold_v, high_v, low_v));
+    }
+#else
+    for (; i < n; ++i)
+        dst[i] = src[i] > threshold ? high : low;
+#endif
+}
+
+static float kernel_sum(const float *src, size_t n)
+{
+    size_t i = 0;
+    float sum = 0.0f;
+#ifdef avx_vect_len
+    // Four independent accumulators hide the latency of the additions.
+    avx_vect_t s0 = avx(setzero), s1 = avx(setzero);
+    avx_vect_t s2 = avx(setzero), s3 = avx(setzero);
+    for (; i + 4 * avx_vect_len <= n; i += 4 * avx_vect_len)
+    {
+        s0 = avx(add, s0, avx(loadu, &src[i]));
+        s1 = avx(add, s1, avx(loadu, &src[i + avx_vect_len]));
+        s2 = avx(add, s2, avx(loadu, &src[i + 2 * avx_vect_len]));
+        s3 = avx(add, s3, avx(loadu, &src[i + 3 * avx_vect_len]));
+    }
+    avx_for(i, n) s0 = avx(add, s0, avx(loadu, &src[i]));
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        s0 = avx(add, s0, avx(maskz_loadu, avx_tail_mask(n - i), &src[i]));
+        i = n;
+    }
+#endif
+    sum = avx_hsum(avx(add, avx(add, s0, s1), avx(add, s2, s3)));
+#endif
+    for (; i < n; ++i)
+        sum += src[i];
+    return sum;
+}
+
+static float kernel_max(const float *src, size_t n)
+{
+    size_t i = 1;
+    float max = src[0];
+#ifdef avx_vect_len
+    if (n >= avx_vect_len)
+    {
+        avx_vect_t max_v = avx(loadu, src);
+        i = avx_vect_len;
+        avx_for(i, n) max_v = avx(max, max_v, avx(loadu, &src[i]));
+#ifdef avx_tail_mask
+        // The masked-out lanes keep the values of max_v.
+        if (i < n)
+        {
+            avx_vect_t src_v =
+                avx(mask_loadu, max_v, avx_tail_mask(n - i), &src[i]);
+            max_v = avx(max, max_v, src_v);
+            i = n;
+        }
+#endif
+        max = avx_hmax(max_v);
+    }
+#endif
+    for (; i < n; ++i)
+        max = src[i] > max ? src[i] : max;
+    return max;
+}
+
+static float kernel_sum_sq_diff(const float *src, float mean, size_t n)
+{
+    size_t i = 0;
+    float sum = 0.0f;
+#ifdef avx_vect_len
+    avx_vect_t mean_v = avx(set1, mean);
+    avx_vect_t sum_v = avx(setzero);
+    avx_for(i, n)
+    {
+        avx_vect_t d = avx(sub, avx(loadu, &src[i]), mean_v);
+        sum_v = avx_fmadd(d, d, sum_v);
+    }
+#ifdef avx_tail_mask
+    if (i < n)
+    {
+        avx_mask_t mask = avx_tail_mask(n - i);
+        avx_vect_t d = avx(maskz_mov, mask,
+                           avx(sub, avx(maskz_loadu, mask, &src[i]), mean_v));
+        sum_v = avx_fmadd(d, d, sum_v);
+        i = n;
+    }
+#endif
+    sum = avx_hsum(sum_v);
+#endif
+    for (; i < n; ++i)
+        sum += (src[i] - mean) * (src[i] - mean);
+    return sum;
+}
+
+/// @brief Packs a mc×kc block of A into micro-panels of GEMM_MR rows. Inside a
+/// micro-panel, the GEMM_MR coefficients of a same column are contiguous.
+/// Missing rows of the last micro-panel are zero-filled.
+static void gemm_pack_a(size_t mc, size_t kc, const float *a, size_t lda,
+                        float *dst)
+{
+    for (size_t ir = 0; ir < mc; ir += GEMM_MR)
+    {
+        size_t mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+        for (size_t k = 0; k < kc; ++k)
+        {
+            for (size_t i = 0; i < mr; ++i)
+                dst[i] = a[(ir + i) * lda + k];
+            for (size_t i = mr; i < GEMM_MR; ++i)
+                dst[i] = 0.0f;
+            dst += GEMM_MR;
+        }
+    }
+}
+
+/// @brief Packs a kc×nc block of B into micro-panels of GEMM_NR columns. Inside
+/// a micro-panel, the GEMM_NR coefficients of a same row are contiguous.
+/// Missing columns of the last micro-panel are zero-filled.
+static void gemm_pack_b(size_t kc, size_t nc, const float *b, size_t ldb,
+                        float *dst)
+{
+    for (size_t jr = 0; jr < nc; jr += GEMM_NR)
+    {
+        size_t nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+        for (size_t k = 0; k < kc; ++k)
+        {
+            memcpy(dst, &b[k * ldb + jr], nr * sizeof(float));
+            for (size_t j = nr; j < GEMM_NR; ++j)
+                dst[j] = 0.0f;
+            dst += GEMM_NR;
+        }
+    }
+}
+
+/// @brief Computes the GEMM_MR×GEMM_NR tile a × b where a and b are packed
+/// micro-panels of depth kc, and stores it into c (or adds it to c if
+/// accumulate is non-zero). Only the top-left mr×nr corner of the tile is
+/// written.
+static inline void gemm_micro_kernel(size_t kc, const float *a, const float *b,
+                                     float *c, size_t ldc, size_t mr,
+                                     size_t nr, int accumulate)
+{
+#ifdef avx_vect_len
+    avx_vect_t c0 = avx(setzero);
+    avx_vect_t c1 = avx(setzero);
+    avx_vect_t c2 = avx(setzero);
+    avx_vect_t c3 = avx(setzero);
+    avx_vect_t c4 = avx(setzero);
+    avx_vect_t c5 = avx(setzero);
+    avx_vect_t c6 = avx(setzero);
+    avx_vect_t c7 = avx(setzero);
+
+    for (size_t k = 0; k < kc; ++k)
+    {
+        avx_vect_t b_v = avx(load, b);
+        c0 = avx_fmadd(avx(set1, a[0]), b_v, c0);
+        c1 = avx_fmadd(avx(set1, a[1]), b_v, c1);
+        c2 = avx_fmadd(avx(set1, a[2]), b_v, c2);
+        c3 = avx_fmadd(avx(set1, a[3]), b_v, c3);
+        c4 = avx_fmadd(avx(set1, a[4]), b_v, c4);
+        c5 = avx_fmadd(avx(set1, a[5]), b_v, c5);
+        c6 = avx_fmadd(avx(set1, a[6]), b_v, c6);
+        c7 = avx_fmadd(avx(set1, a[7]), b_v, c7);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if (mr == GEMM_MR && nr == GEMM_NR)
+    {
+        if (accumulate)
+        {
+            c0 = avx(add, c0, avx(loadu, c + 0 * ldc));
+            c1 = avx(add, c1, avx(loadu, c + 1 * ldc));
+            c2 = avx(add, c2, avx(loadu, c + 2 * ldc));
+            c3 = avx(add, c3, avx(loadu, c + 3 * ldc));
+            c4 = avx(add, c4, avx(loadu, c + 4 * ldc));
+            c5 = avx(add, c5, avx(loadu, c + 5 * ldc));
+            c6 = avx(add, c6, avx(loadu, c + 6 * ldc));
+            c7 = avx(add, c7, avx(loadu, c + 7 * ldc));
+        }
+        avx(storeu, c + 0 * ldc, c0);
+        avx(storeu, c + 1 * ldc, c1);
+        avx(storeu, c + 2 * ldc, c2);
+        avx(storeu, c + 3 * ldc, c3);
+        avx(storeu, c + 4 * ldc, c4);
+        avx(storeu, c + 5 * ldc, c5);
+        avx(storeu, c + 6 * ldc, c6);
+        avx(storeu, c + 7 * ldc, c7);
+        return;
+    }
+
+#ifdef avx_tail_mask
+    // Partial tile on the bottom or right border of the result: only the mr
+    // first rows are stored, each with a mask of its nr first columns.
+    avx_vect_t rows[GEMM_MR] = {c0, c1, c2, c3, c4, c5, c6, c7};
+    avx_mask_t mask = avx_tail_mask(nr);
+    for (size_t i = 0; i < mr; ++i)
+    {
+        if (accumulate)
+            rows[i] = avx(add, rows[i], avx(maskz_loadu, mask, c + i * ldc));
+        avx(mask_storeu, c + i * ldc, mask, rows[i]);
+    }
+#else
+    // Partial tile on the bottom or right border of the result.
+    float tile[GEMM_MR * GEMM_NR] __attribute__((aligned(64)));
+    avx(store, tile + 0 * GEMM_NR, c0);
+    avx(store, tile + 1 * GEMM_NR, c1);
+    avx(store, tile + 2 * GEMM_NR, c2);
+    avx(store, tile + 3 * GEMM_NR, c3);
+    avx(store, tile + 4 * GEMM_NR, c4);
+    avx(store, tile + 5 * GEMM_NR, c5);
+    avx(store, tile + 6 * GEMM_NR, c6);
+    avx(store, tile + 7 * GEMM_NR, c7);
+#endif
+#else
+    float tile[GEMM_MR * GEMM_NR] = {0};
+
+    for (size_t k = 0; k < kc; ++k)
+    {
+        for (size_t i = 0; i < GEMM_MR; ++i)
+            for (size_t j = 0; j < GEMM_NR; ++j)
+                tile[i * GEMM_NR + j] += a[i] * b[j];
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+#endif
+
+#ifndef avx_tail_mask
+    for (size_t i = 0; i < mr; ++i)
+    {
+        for (size_t j = 0; j < nr; ++j)
+        {
+            if (accumulate)
+                c[i * ldc + j] += tile[i * GEMM_NR + j];
+            else
+                c[i * ldc + j] = tile[i * GEMM_NR + j];
+        }
+    }
+#endif
+}
+
+/// @brief Computes y = a × x (+ bias) and, if act is not NULL, act = relu(y) in
+/// the same pass. Rows of a are streamed four at a time so that each load of x
+/// feeds four accumulators.
+static void kernel_dense(size_t m, size_t k, const float *a, size_t lda,
+                         const float *x, const float *bias, float *y,
+                         float *act)
+{
+#ifdef avx_vect_len
+    // Every row of a starts on a vector boundary if the stride allows it.
+    int aligned =
+        avx_is_aligned(a) && avx_is_aligned(x) && lda % avx_vect_len == 0;
+#endif
+
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4)
+    {
+        const float *a0 = &a[(i + 0) * lda];
+        const float *a1 = &a[(i + 1) * lda];
+        const float *a2 = &a[(i + 2) * lda];
+        const float *a3 = &a[(i + 3) * lda];
+
+        float y0 = 0.0f, y1 = 0.0f, y2 = 0.0f, y3 = 0.0f;
+        size_t p = 0;
+#ifdef avx_vect_len
+        avx_vect_t s0 = avx(setzero);
+        avx_vect_t s1 = avx(setzero);
+        avx_vect_t s2 = avx(setzero);
+        avx_vect_t s3 = avx(setzero);
+        if (aligned)
+            avx_for(p, k)
+            {
+                avx_vect_t x_v = avx(load, &x[p]);
+                s0 = avx_fmadd(avx(load, &a0[p]), x_v, s0);
+                s1 = avx_fmadd(avx(load, &a1[p]), x_v, s1);
+                s2 = avx_fmadd(avx(load, &a2[p]), x_v, s2);
+                s3 = avx_fmadd(avx(load, &a3[p]), x_v, s3);
+            }
+        else
+            avx_for(p, k)
+            {
+                avx_vect_t x_v = avx(loadu, &x[p]);
+                s0 = avx_fmadd(avx(loadu, &a0[p]), x_v, s0);
+                s1 = avx_fmadd(avx(loadu, &a1[p]), x_v, s1);
+                s2 = avx_fmadd(avx(loadu, &a2[p]), x_v, s2);
+                s3 = avx_fmadd(avx(loadu, &a3[p]), x_v, s3);
+            }
+#ifdef avx_tail_mask
+        if (p < k)
+        {
+            avx_mask_t mask = avx_tail_mask(k - p);
+            avx_vect_t x_v = avx(maskz_loadu, mask, &x[p]);
+            s0 = avx_fmadd(avx(maskz_loadu, mask, &a0[p]), x_v, s0);
+            s1 = avx_fmadd(avx(maskz_loadu, mask, &a1[p]), x_v, s1);
+            s2 = avx_fmadd(avx(maskz_loadu, mask, &a2[p]), x_v, s2);
+            s3 = avx_fmadd(avx(maskz_loadu, mask, &a3[p]), x_v, s3);
+            p = k;
+        }
+#endif
+        float sums[4];
+        avx_hsum4(s0, s1, s2, s3, sums);
+        y0 = sums[0];
+        y1 = sums[1];
+        y2 = sums[2];
+        y3 = sums[3];
+#endif
+        for (; p < k; ++p)
+        {
+            y0 += a0[p] * x[p];
+            y1 += a1[p] * x[p];
+            y2 += a2[p] * x[p];
+            y3 += a3[p] * x[p];
+        }
+
+        if (bias != NULL)
+        {
+            y0 += bias[i + 0];
+            y1 += bias[i + 1];
+            y2 += bias[i + 2];
+            y3 += bias[i + 3];
+        }
+
+        y[i + 0] = y0;
+        y[i + 1] = y1;
+        y[i + 2] = y2;
+        y[i + 3] = y3;
+
+        if (act != NULL)
+        {
+            act[i + 0] = y0 > 0.0f ? y0 : 0.0f;
+            act[i + 1] = y1 > 0.0f ? y1 : 0.0f;
+            act[i + 2] = y2 > 0.0f ? y2 : 0.0f;
+            act[i + 3] = y3 > 0.0f ? y3 : 0.0f;
+        }
+    }
+
+    // Remaining rows.
+    for (; i < m; ++i)
+    {
+        const float *a_row = &a[i * lda];
+        float sum = 0.0f;
+        size_t p = 0;
+#ifdef avx_vect_len
+        avx_vect_t s = avx(setzero);
+        if (aligned)
+            avx_for(p, k) s =
+                avx_fmadd(avx(load, &a_row[p]), avx(load, &x[p]), s);
+        else
+            avx_for(p, k) s =
+                avx_fmadd(avx(loadu, &a_row[p]), avx(loadu, &x[p]), s);
+#ifdef avx_tail_mask
+        if (p < k)
+        {
+            avx_mask_t mask = avx_tail_mask(k - p);
+            avx_vect_t a_v = avx(maskz_loadu, mask, &a_row[p]);
+            avx_vect_t x_v = avx(maskz_loadu, mask, &x[p]);
+            s = avx_fmadd(a_v, x_v, s);
+            p = k;
+        }
+#endif
+        sum = avx_hsum(s);
+#endif
+        for (; p < k; ++p)
+            sum += a_row[p] * x[p];
+
+        if (bias != NULL)
+            sum += bias[i];
+
+        y[i] = sum;
+        if (act != NULL)
+            act[i] = sum > 0.0f ? sum : 0.0f;
+    }
+}
+
+static void kernel_gemv(size_t m, size_t k, const float *a, size_t lda,
+                        const float *x, const float *bias, float *y)
+{
+    kernel_dense(m, k, a, lda, x, bias, y, NULL);
+}
+
+/// @brief Computes c = a × b with a packed, cache-blocked product.
+static void kernel_gemm(size_t m, size_t n, size_t k, const float *a,
+                        size_t lda, const float *b, size_t ldb, float *c,
+                        size_t ldc)
+{
+    // Packing a column vector would mostly copy padding: use the
+    // matrix-vector kernel instead, unless the column is strided.
+    if (n == 1 && ldb == 1 && ldc == 1)
+    {
+        kernel_gemv(m, k, a, lda, b, NULL, c);
+        return;
+    }
+
+    for (size_t jc = 0; jc < n; jc += GEMM_NC)
+    {
+        size_t nc = n - jc < GEMM_NC ? n - jc : GEMM_NC;
+
+        for (size_t pc = 0; pc < k; pc += GEMM_KC)
+        {
+            size_t kc = k - pc < GEMM_KC ? k - pc : GEMM_KC;
+
+            gemm_pack_b(kc, nc, &b[pc * ldb + jc], ldb, gemm_packed_b);
+
+            for (size_t ic = 0; ic < m; ic += GEMM_MC)
+            {
+                size_t mc = m - ic < GEMM_MC ? m - ic : GEMM_MC;
+
+                gemm_pack_a(mc, kc, &a[ic * lda + pc], lda, gemm_packed_a);
+
+                for (size_t jr = 0; jr < nc; jr += GEMM_NR)
+                {
+                    size_t nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+
+                    for (size_t ir = 0; ir < mc; ir += GEMM_MR)
+                    {
+                        size_t mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+
+                        gemm_micro_kernel(kc, &gemm_packed_a[ir * kc],
+                                          &gemm_packed_b[jr * kc],
+                                          &c[(ic + ir) * ldc + jc + jr], ldc,
+                                          mr, nr, pc != 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// @brief The side of the blocks a transposition is split into, so that the
+/// rows of src and dst touched by a block stay in the L1 cache.
+#define TRANSPOSE_CACHE_BLOCK 64
+
+/// @brief Transposes the rows [h0, h1) and columns [w0, w1) of src into dst,
+/// whose leading dimensions are lds and ldd.
+static inline void transpose_block(float *dst, size_t ldd, const float *src,
+                                   size_t lds, size_t h0, size_t h1, size_t w0,
+                                   size_t w1)
+{
+#if defined(avx_transpose_tile)
+    for (size_t h = h0; h < h1; h += avx_vect_len)
+    {
+        size_t rows = h1 - h < avx_vect_len ? h1 - h : avx_vect_len;
+        for (size_t w = w0; w < w1; w += avx_vect_len)
+        {
+            size_t cols = w1 - w < avx_vect_len ? w1 - w : avx_vect_len;
+            avx_transpose_tile(&src[h * lds + w], lds, &dst[w * ldd + h], ldd,
+                               rows, cols);
+        }
+    }
+#else
+    size_t h = h0;
+#if defined(avx_transpose_square)
+    for (; h + avx_vect_len <= h1; h += avx_vect_len)
+    {
+        size_t w = w0;
+        for (; w + avx_vect_len <= w1; w += avx_vect_len)
+            avx_transpose_square(&src[h * lds + w], lds, &dst[w * ldd + h],
+                                 ldd);
+
+        // Remaining columns of the row of tiles.
+        for (size_t i = h; i < h + avx_vect_len; ++i)
+            for (size_t j = w; j < w1; ++j)
+                dst[j * ldd + i] = src[i * lds + j];
+    }
+#endif
+    for (; h < h1; ++h)
+        for (size_t w = w0; w < w1; ++w)
+            dst[w * ldd + h] = src[h * lds + w];
+#endif
+}
+
+/// @brief Writes the transpose of the height×width matrix src into dst, one
+/// TRANSPOSE_CACHE_BLOCK square at a time.
+static void kernel_transpose(float *dst, size_t ldd, const float *src,
+                             size_t lds, size_t height, size_t width)
+{
+    for (size_t h = 0; h < height; h += TRANSPOSE_CACHE_BLOCK)
+    {
+        size_t h1 = height - h < TRANSPOSE_CACHE_BLOCK
+                        ? height
+                        : h + TRANSPOSE_CACHE_BLOCK;
+        for (size_t w = 0; w < width; w += TRANSPOSE_CACHE_BLOCK)
+        {
+            size_t w1 = width - w < TRANSPOSE_CACHE_BLOCK
+                            ? width
+                            : w + TRANSPOSE_CACHE_BLOCK;
+            transpose_block(dst, ldd, src, lds, h, h1, w, w1);
+        }
+    }
+}
+
+const MatKernels KERNEL_TABLE = {
+    .tier = KERNEL_TIER,
+    .fill = kernel_fill,
+    .add = kernel_add,
+    .add_rows = kernel_add_rows,
+    .sub = kernel_sub,
+    .hadamard = kernel_hadamard,
+    .scale = kernel_scale,
+    .relu = kernel_relu,
+    .relu_derivative = kernel_relu_derivative,
+    .gemm = kernel_gemm,
+    .gemv = kernel_gemv,
+    .dense = kernel_dense,
+    .gemv_s8 = kernel_gemv_s8,
+    .quantize_u8 = kernel_quantize_u8,
+    .exp = kernel_exp,
+    .exp_sum = kernel_exp_sum,
+    .sigmoid = kernel_sigmoid,
+    .tanh = kernel_tanh,
+    .clip = kernel_clip,
+    .threshold = kernel_threshold,
+    .sum = kernel_sum,
+    .max = kernel_max,
+    .sum_sq_diff = kernel_sum_sq_diff,
+    .transpose = kernel_transpose,
+};
@@ -9,7 +9,7 @@ int main(int argc, char **argv)
         errx(EXIT_FAILURE,
              "Too many parameters were given. Only 1 was expected.");
 
-    Matrix *m = mat_load_from_file(argv[1]);
+    Matrix *m = mat_mmap_file(argv[1]);
 
     mat_display(m);
 
@@ -1,41 +1,24 @@
 #include <err.h>
+#include <fcntl.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include "arena.h"
+#include "bit_matrix.h"
+#include "kernels.h"
 #include "matrix.h"
+#include "parallel.h"
+#include "utils/checksum/crc32.h"
+#include "utils/io/full_io.h"
 #include "utils/math/clamp.h"
-#include "utils/math/gcd.h"
 #include "utils/math/sigmoid.h"
 #include "utils/random/random.h"
 
-// SIMD macro handling.
-#if !defined(USE_AVX)
-#if defined(USE_AVX_512)
-#error "USE_AVX_512 was defined but USE_AVX was not."
-#elif defined(USE_AVX_2)
-#error "USE_AVX_2 was defined but USE_AVX was not."
-#endif
-#else
-#if !defined(USE_AVX_512) && !defined(USE_AVX_2)
-#error "USE_AVX was defined but neither USE_AVX_2 nor USE_AVX_512 was defined."
-#endif
-// Define AVX macros
-#include <immintrin.h>
-#if defined(USE_AVX_512)
-#define avx_vect_t __m512
-#define avx(op, ...) _mm512_##op##_ps(__VA_ARGS__)
-#define avx_vect_len 16
-#elif defined(USE_AVX_2)
-#define avx_vect_t __m256
-#define avx(op, ...) _mm256_##op##_ps(__VA_ARGS__)
-#define avx_vect_len 8
-#endif
-#define avx_for(counter, length)                                               \
-    for (; counter + avx_vect_len <= length; counter += avx_vect_len)
-#endif
-
 /// @brief A 2D matrix of single-precision floating point numbers.
 struct Matrix
 {
@@ -44,38 +27,266 @@ struct Matrix
     /// @brief Number of columns (width) of the matrix.
     size_t width;
     size_t size;
-    /// @brief The matrix elements stored in a contiguous row-major array.
+    /// @brief Number of floats between the starts of two consecutive rows
+    /// (leading dimension). It is equal to width unless rows are padded.
+    size_t stride;
+    /// @brief The matrix elements stored in a MAT_ALIGNMENT-aligned row-major
+    /// array of height × stride floats.
     float *content;
+    /// @brief The file mapping holding content if the matrix was mapped by
+    /// `mat_mmap_file`, NULL if content follows the structure in its block.
+    /// It is content itself for the matrices of `mat_create_borrowed`.
+    void *mapping;
+    /// @brief The size in bytes of the mapping, 0 if the matrix does not own
+    /// it.
+    size_t mapping_size;
+    /// @brief Number of floats of content, which bounds the shapes
+    /// `mat_resize` accepts.
+    size_t capacity;
 };
 
-static inline float *alloc_content(size_t length)
+/// @brief The offset in bytes of the coefficients of a matrix from its
+/// structure, which precedes them in the same block.
+#define CONTENT_OFFSET                                                         \
+    ((sizeof(Matrix) + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT)
+
+static inline Matrix *alloc_strided_matrix(size_t height, size_t width,
+                                           size_t stride)
 {
-    float *content = malloc(length * sizeof(float));
+    // The structure and the coefficients share a single block, taken from the
+    // active arena if any (see arena.h).
+    Matrix *m = mat_block_alloc(CONTENT_OFFSET +
+                                height * stride * sizeof(float));
 
-    if (content == NULL)
-        errx(EXIT_FAILURE, "Memory allocation failed in alloc_content.");
+    m->height = height;
+    m->width = width;
+    m->size = height * width;
+    m->stride = stride;
+    m->content = (float *)((char *)m + CONTENT_OFFSET);
+    m->mapping = NULL;
+    m->capacity = height * stride;
 
-    return content;
+    return m;
 }
 
 static inline Matrix *alloc_matrix(size_t height, size_t width)
 {
-    Matrix *m = malloc(sizeof(Matrix));
-    if (m == NULL)
-        errx(EXIT_FAILURE, "Memory allocation failed in alloc_matrix.");
+    return alloc_strided_matrix(height, width, width);
+}
 
-    m->height = height;
-    m->width = width;
-    m->size = height * width;
-    m->content = alloc_content(m->size);
+/// @brief Allocates a matrix with the same shape and stride as m.
+static inline Matrix *alloc_matrix_like(const Matrix *m)
+{
+    return alloc_strided_matrix(m->height, m->width, m->stride);
+}
 
-    return m;
+/// @brief Returns whether the rows of m are stored without padding, i.e.
+/// whether its coefficients form a single contiguous array.
+static inline int is_contiguous(const Matrix *m)
+{
+    return m->stride == m->width || m->height == 1;
+}
+
+/// @brief Whether the rows of a view follow each other in memory, so that its
+/// coefficients can be scanned at once.
+static inline int is_contiguous_view(MatView v)
+{
+    return v.stride == v.width || v.height == 1;
+}
+
+static inline float *row_ptr(const Matrix *m, size_t h)
+{
+    return m->content + h * m->stride;
+}
+
+/// @brief The number of coefficients of the ranges an element-wise operation on
+/// contiguous matrices is split into. It keeps every range aligned for the
+/// kernels.
+#define ELEMENTWISE_BLOCK 256
+
+/// @brief An element-wise operation, run over ranges of blocks (if the
+/// matrices are contiguous) or of rows by mat_parallel_for. Only the kernel
+/// matching the body is set.
+typedef struct
+{
+    Matrix *dst;
+    const Matrix *a;
+    const Matrix *b;
+    float scalar;
+    int contiguous;
+    void (*binary)(float *, const float *, const float *, size_t);
+    void (*unary)(float *, const float *, size_t);
+    void (*scale)(float *, const float *, float, size_t);
+    MatOp op;
+    MatOpParams params;
+} ElementwiseTask;
+
+/// @brief Computes the range of coefficients of the contiguous blocks
+/// [begin, end) of a task.
+static inline size_t block_range(const ElementwiseTask *t, size_t begin,
+                                 size_t end, size_t *length)
+{
+    size_t first = begin * ELEMENTWISE_BLOCK;
+    size_t last = end * ELEMENTWISE_BLOCK;
+    *length = (last < t->dst->size ? last : t->dst->size) - first;
+    return first;
+}
+
+static void binary_body(size_t begin, size_t end, void *ctx)
+{
+    const ElementwiseTask *t = ctx;
+
+    if (t->contiguous)
+    {
+        size_t length;
+        size_t i = block_range(t, begin, end, &length);
+        t->binary(t->dst->content + i, t->a->content + i, t->b->content + i,
+                  length);
+        return;
+    }
+
+    for (size_t h = begin; h < end; ++h)
+        t->binary(row_ptr(t->dst, h), row_ptr(t->a, h), row_ptr(t->b, h),
+                  t->dst->width);
+}
+
+static void unary_body(size_t begin, size_t end, void *ctx)
+{
+    const ElementwiseTask *t = ctx;
+
+    if (t->contiguous)
+    {
+        size_t length;
+        size_t i = block_range(t, begin, end, &length);
+        t->unary(t->dst->content + i, t->a->content + i, length);
+        return;
+    }
+
+    for (size_t h = begin; h < end; ++h)
+        t->unary(row_ptr(t->dst, h), row_ptr(t->a, h), t->dst->width);
+}
+
+static void scale_body(size_t begin, size_t end, void *ctx)
+{
+    const ElementwiseTask *t = ctx;
+
+    if (t->contiguous)
+    {
+        size_t length;
+        size_t i = block_range(t, begin, end, &length);
+        t->scale(t->dst->content + i, t->a->content + i, t->scalar, length);
+        return;
+    }
+
+    for (size_t h = begin; h < end; ++h)
+        t->scale(row_ptr(t->dst, h), row_ptr(t->a, h), t->scalar,
+                 t->dst->width);
+}
+
+/// @brief Applies the built-in operation of a task to n coefficients.
+static void apply_op(const ElementwiseTask *t, float *dst, const float *src,
+                     size_t n)
+{
+    const MatOpParams *p = &t->params;
+
+    switch (t->op)
+    {
+    case MAT_OP_SIGMOID:
+        mat_kernels->sigmoid(dst, src, n);
+        break;
+    case MAT_OP_RELU:
+        mat_kernels->relu(dst, src, n);
+        break;
+    case MAT_OP_TANH:
+        mat_kernels->tanh(dst, src, n);
+        break;
+    case MAT_OP_CLAMP:
+        mat_kernels->clip(dst, src, p->low, p->high, n);
+        break;
+    case MAT_OP_THRESHOLD:
+        mat_kernels->threshold(dst, src, p->threshold, p->low, p->high, n);
+        break;
+    }
+}
+
+static void apply_op_body(size_t begin, size_t end, void *ctx)
+{
+    const ElementwiseTask *t = ctx;
+
+    if (t->contiguous)
+    {
+        size_t length;
+        size_t i = block_range(t, begin, end, &length);
+        apply_op(t, t->dst->content + i, t->a->content + i, length);
+        return;
+    }
+
+    for (size_t h = begin; h < end; ++h)
+        apply_op(t, row_ptr(t->dst, h), row_ptr(t->a, h), t->dst->width);
+}
+
+/// @brief Runs an element-wise task on the thread pool, by blocks if the
+/// matrices are contiguous and by rows otherwise.
+static void run_elementwise(void (*body)(size_t, size_t, void *),
+                            ElementwiseTask *t)
+{
+    if (t->contiguous)
+        mat_parallel_for(
+            (t->dst->size + ELEMENTWISE_BLOCK - 1) / ELEMENTWISE_BLOCK,
+            ELEMENTWISE_BLOCK, body, t);
+    else
+        mat_parallel_for(t->dst->height, t->dst->width, body, t);
+}
+
+/// @brief Applies an element-wise kernel of two operands to every row, or to
+/// the whole content at once if the three matrices are contiguous.
+static void apply_binary_kernel(void (*kernel)(float *, const float *,
+                                               const float *, size_t),
+                                Matrix *dst, const Matrix *a, const Matrix *b)
+{
+    ElementwiseTask t = {
+        .dst = dst,
+        .a = a,
+        .b = b,
+        .contiguous = is_contiguous(dst) && is_contiguous(a) && is_contiguous(b),
+        .binary = kernel,
+    };
+    run_elementwise(binary_body, &t);
+}
+
+/// @brief Applies an element-wise kernel of one operand to every row, or to
+/// the whole content at once if both matrices are contiguous.
+static void apply_unary_kernel(void (*kernel)(float *, const float *, size_t),
+                               Matrix *dst, const Matrix *src)
+{
+    ElementwiseTask t = {
+        .dst = dst,
+        .a = src,
+        .contiguous = is_contiguous(dst) && is_contiguous(src),
+        .unary = kernel,
+    };
+    run_elementwise(unary_body, &t);
+}
+
+/// @brief dst = a × src, see apply_unary_kernel.
+static void apply_scale_kernel(Matrix *dst, const Matrix *src, float a)
+{
+    ElementwiseTask t = {
+        .dst = dst,
+        .a = src,
+        .scalar = a,
+        .contiguous = is_contiguous(dst) && is_contiguous(src),
+        .scale = mat_kernels->scale,
+    };
+    run_elementwise(scale_body, &t);
 }
 
 inline size_t mat_height(const Matrix *m) { return m->height; }
 
 inline size_t mat_width(const Matrix *m) { return m->width; }
 
+inline size_t mat_stride(const Matrix *m) { return m->stride; }
+
 Matrix *mat_create(size_t height, size_t width)
 {
     if (height == 0)
@@ -111,7 +322,7 @@ Matrix *mat_create_zero(size_t height, size_t width)
     return m;
 }
 
-Matrix *mat_create_filled(size_t height, size_t width, float value)
+Matrix *mat_create_padded(size_t height, size_t width)
 {
     if (height == 0)
         errx(EXIT_FAILURE,
@@ -124,22 +335,33 @@ Matrix *mat_create_filled(size_t height, size_t width, float value)
              "non-zero.",
              width);
 
-    Matrix *m = alloc_matrix(height, width);
+    // Column vectors are never padded: it would multiply their size by 16.
+    const size_t row_floats = MAT_ALIGNMENT / sizeof(float);
+    size_t stride =
+        width == 1 ? 1 : (width + row_floats - 1) / row_floats * row_floats;
 
-    float *c = m->content;
+    Matrix *m = alloc_strided_matrix(height, width, stride);
+    memset(m->content, 0, height * stride * sizeof(float));
 
-#if defined(USE_AVX)
-    avx_vect_t v = avx(set1, value);
+    return m;
+}
 
-    size_t i = 0;
-    avx_for(i, m->size) avx(storeu, &c[i], v);
+Matrix *mat_create_filled(size_t height, size_t width, float value)
+{
+    if (height == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create matrix: invalid height '%zu'. Height must be "
+             "non-zero.",
+             height);
+    if (width == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create matrix: invalid width '%zu'. Width must be "
+             "non-zero.",
+             width);
 
-    for (; i < m->size; ++i)
-        c[i] = value;
-#else
-    for (size_t i = 0; i < m->size; ++i)
-        c[i] = value;
-#endif
+    Matrix *m = alloc_matrix(height, width);
+
+    mat_kernels->fill(m->content, value, m->size);
 
     return m;
 }
@@ -164,6 +386,35 @@ Matrix *mat_create_from_arr(size_t height, size_t width, const float *content)
     return m;
 }
 
+Matrix *mat_create_borrowed(size_t height, size_t width, size_t stride,
+                            float *content)
+{
+    if (height == 0 || width == 0 || stride < width)
+        errx(EXIT_FAILURE,
+             "Failed to create matrix: invalid shape %zux%zu (stride %zu).",
+             height, width, stride);
+    if ((uintptr_t)content % MAT_ALIGNMENT != 0)
+        errx(EXIT_FAILURE,
+             "Failed to create matrix: its coefficients are not aligned on "
+             "%d bytes.",
+             MAT_ALIGNMENT);
+
+    Matrix *m = malloc(sizeof(Matrix));
+    if (m == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    m->height = height;
+    m->width = width;
+    m->size = height * width;
+    m->stride = stride;
+    m->content = content;
+    m->mapping = content;
+    m->mapping_size = 0;
+    m->capacity = height * stride;
+
+    return m;
+}
+
 Matrix *mat_create_from_2d_arr(size_t height, size_t width,
                                const float **content)
 {
@@ -256,12 +507,15 @@ Matrix *mat_create_random_normal(size_t height, size_t width, float mean,
 
 void mat_free(Matrix *matrix)
 {
-#ifdef USE_AVX
-    _mm_free(matrix->content);
-#else
-    free(matrix->content);
-#endif
-    free(matrix);
+    if (matrix->mapping != NULL)
+    {
+        if (matrix->mapping_size > 0)
+            munmap(matrix->mapping, matrix->mapping_size);
+        free(matrix);
+        return;
+    }
+
+    mat_block_free(matrix);
 }
 
 void mat_free_matrix_array(Matrix **array, size_t lentgh)
@@ -282,24 +536,94 @@ int mat_eq(Matrix *a, Matrix *b, float epsilon)
     if (a->height != b->height || a->width != b->width)
         return 0;
 
-    for (size_t i = 0; i < a->height * a->width; ++i)
-        if (fabsf(a->content[i] - b->content[i]) > epsilon)
-            return 0;
+    for (size_t h = 0; h < a->height; ++h)
+    {
+        const float *a_row = row_ptr(a, h), *b_row = row_ptr(b, h);
+        for (size_t w = 0; w < a->width; ++w)
+            if (fabsf(a_row[w] - b_row[w]) > epsilon)
+                return 0;
+    }
 
     return 1;
 }
 
 Matrix *mat_deepcopy(const Matrix *src)
 {
-    Matrix *dst = alloc_matrix(src->height, src->width);
+    Matrix *dst = alloc_matrix_like(src);
     memcpy(dst->content, src->content,
-           src->height * src->width * sizeof(float));
+           src->height * src->stride * sizeof(float));
     return dst;
 }
 
+void mat_copy(Matrix *dst, const Matrix *src)
+{
+    if (dst->height != src->height || dst->width != src->width)
+        errx(EXIT_FAILURE,
+             "Matrix copy failed: mismatched shapes (%zux%zu vs %zux%zu).",
+             dst->height, dst->width, src->height, src->width);
+
+    if (is_contiguous(dst) && is_contiguous(src))
+    {
+        memcpy(dst->content, src->content, src->size * sizeof(float));
+        return;
+    }
+
+    for (size_t h = 0; h < src->height; ++h)
+        memcpy(row_ptr(dst, h), row_ptr(src, h), src->width * sizeof(float));
+}
+
+void mat_resize(Matrix *m, size_t height, size_t width)
+{
+    if (height == 0 || width == 0)
+        errx(EXIT_FAILURE, "Matrix resize failed: the shape cannot be empty.");
+    if (width > m->stride || height * m->stride > m->capacity)
+        errx(EXIT_FAILURE,
+             "Matrix resize failed: a %zux%zu matrix does not fit in %zu rows "
+             "of %zu coefficients.",
+             height, width, m->capacity / m->stride, m->stride);
+
+    m->height = height;
+    m->width = width;
+    m->size = height * width;
+}
+
+MatView mat_view(const Matrix *m)
+{
+    return (MatView){.content = m->content,
+                     .height = m->height,
+                     .width = m->width,
+                     .stride = m->stride};
+}
+
+MatView mat_subview(MatView v, size_t h, size_t w, size_t height,
+                    size_t width)
+{
+    if (h + height > v.height || w + width > v.width)
+        errx(EXIT_FAILURE,
+             "Invalid sub-view: %zux%zu at (%zu, %zu) in a %zux%zu view.",
+             height, width, h, w, v.height, v.width);
+
+    return (MatView){.content = v.content + h * v.stride + w,
+                     .height = height,
+                     .width = width,
+                     .stride = v.stride};
+}
+
+Matrix *mat_create_from_view(MatView v)
+{
+    if (v.height == 0 || v.width == 0)
+        errx(EXIT_FAILURE, "Cannot create a matrix from an empty view.");
+
+    Matrix *m = alloc_matrix(v.height, v.width);
+    for (size_t h = 0; h < v.height; ++h)
+        memcpy(row_ptr(m, h), mat_view_row(v, h), v.width * sizeof(float));
+
+    return m;
+}
+
 inline float *mat_unsafe_coef_ptr(const Matrix *m, size_t h, size_t w)
 {
-    return m->content + h * m->width + w;
+    return m->content + h * m->stride + w;
 }
 
 inline float *mat_coef_ptr(const Matrix *m, size_t h, size_t w)
@@ -335,22 +659,8 @@ Matrix *mat_addition(const Matrix *a, const Matrix *b)
              "Matrix addition failed: mismatched widths (%zu vs %zu).",
              a->width, b->width);
 
-    Matrix *res = alloc_matrix(a->height, b->width);
-#ifdef USE_AVX
-    size_t i = 0;
-    avx_for(i, res->size)
-    {
-        avx_vect_t a_v = avx(loadu, &a->content[i]);
-        avx_vect_t b_v = avx(loadu, &b->content[i]);
-        avx_vect_t c_v = avx(add, a_v, b_v);
-        avx(storeu, &res->content[i], c_v);
-    }
-    for (; i < res->height * res->width; ++i)
-        res->content[i] = a->content[i] + b->content[i];
-#else
-    for (size_t i = 0; i < res->height * res->width; ++i)
-        res->content[i] = a->content[i] + b->content[i];
-#endif
+    Matrix *res = alloc_matrix_like(a);
+    apply_binary_kernel(mat_kernels->add, res, a, b);
     return res;
 }
 
@@ -365,21 +675,68 @@ void mat_inplace_addition(Matrix *a, const Matrix *b)
              "Matrix addition failed: mismatched widths (%zu vs %zu).",
              a->width, b->width);
 
-#ifdef USE_AVX
-    size_t i = 0;
-    avx_for(i, a->size)
+    apply_binary_kernel(mat_kernels->add, a, a, b);
+}
+
+void mat_inplace_add_column(Matrix *m, const Matrix *column)
+{
+    if (column->width != 1 || column->height != m->height)
+        errx(EXIT_FAILURE,
+             "Column addition failed: expected a %zux1 column but got a "
+             "%zux%zu matrix.",
+             m->height, column->height, column->width);
+
+    for (size_t h = 0; h < m->height; ++h)
+    {
+        float *row = row_ptr(m, h);
+        float value = *row_ptr(column, h);
+        for (size_t w = 0; w < m->width; ++w)
+            row[w] += value;
+    }
+}
+
+void mat_add_rows(Matrix *dst, const Matrix *m, const size_t *indices,
+                  size_t count)
+{
+    if (dst->size != m->width || (dst->height != 1 && dst->width != 1))
+        errx(EXIT_FAILURE,
+             "Row addition failed: expected a vector of %zu coefficients but "
+             "got a %zux%zu matrix.",
+             m->width, dst->height, dst->width);
+    if (!is_contiguous(dst))
+        errx(EXIT_FAILURE, "Row addition failed: the vector is strided.");
+
+    for (size_t i = 0; i < count; ++i)
+        if (indices[i] >= m->height)
+            errx(EXIT_FAILURE,
+                 "Row addition failed: row %zu out of bounds for a matrix of "
+                 "%zu rows.",
+                 indices[i], m->height);
+
+    mat_kernels->add_rows(dst->content, m->content, m->stride, indices, count,
+                          m->width);
+}
+
+int mat_binary_indices(const Matrix *m, size_t *indices, size_t *count)
+{
+    size_t n = 0;
+    int binary = 1;
+
+    // Branchless: the index is always written and only kept for a one, since
+    // inputs mix zeros and ones too evenly for the branches to be predicted.
+    for (size_t h = 0; h < m->height; ++h)
     {
-        avx_vect_t a_v = avx(loadu, &a->content[i]);
-        avx_vect_t b_v = avx(loadu, &b->content[i]);
-        avx_vect_t c_v = avx(add, a_v, b_v);
-        avx(storeu, &a->content[i], c_v);
+        const float *row = row_ptr(m, h);
+        for (size_t w = 0; w < m->width; ++w)
+        {
+            indices[n] = h * m->width + w;
+            n += row[w] == 1.0f;
+            binary &= (row[w] == 0.0f) | (row[w] == 1.0f);
+        }
     }
-    for (; i < a->height * a->width; ++i)
-        a->content[i] += b->content[i];
-#else
-    for (size_t i = 0; i < a->height * a->width; ++i)
-        a->content[i] += b->content[i];
-#endif
+
+    *count = n;
+    return binary;
 }
 
 Matrix *mat_subtraction(const Matrix *a, const Matrix *b)
@@ -393,22 +750,8 @@ Matrix *mat_subtraction(const Matrix *a, const Matrix *b)
              "Matrix subtraction failed: mismatched widths (%zu vs %zu).",
              a->width, b->width);
 
-    Matrix *res = alloc_matrix(a->height, b->width);
-#ifdef USE_AVX
-    size_t i = 0;
-    avx_for(i, res->size)
-    {
-        avx_vect_t a_v = avx(loadu, &a->content[i]);
-        avx_vect_t b_v = avx(loadu, &b->content[i]);
-        avx_vect_t c_v = avx(sub, a_v, b_v);
-        avx(storeu, &res->content[i], c_v);
-    }
-    for (; i < res->height * res->width; ++i)
-        res->content[i] = a->content[i] - b->content[i];
-#else
-    for (size_t i = 0; i < res->height * res->width; ++i)
-        res->content[i] = a->content[i] - b->content[i];
-#endif
+    Matrix *res = alloc_matrix_like(a);
+    apply_binary_kernel(mat_kernels->sub, res, a, b);
     return res;
 }
 
@@ -423,63 +766,38 @@ void mat_inplace_subtraction(Matrix *a, const Matrix *b)
              "Matrix subtraction failed: mismatched widths (%zu vs %zu).",
              a->width, b->width);
 
-#ifdef USE_AVX
-    size_t i = 0;
-    avx_for(i, a->size)
-    {
-        avx_vect_t a_v = avx(loadu, &a->content[i]);
-        avx_vect_t b_v = avx(loadu, &b->content[i]);
-        avx_vect_t c_v = avx(sub, a_v, b_v);
-        avx(storeu, &a->content[i], c_v);
-    }
-    for (; i < a->height * a->width; ++i)
-        a->content[i] -= b->content[i];
-#else
-    for (size_t i = 0; i < a->height * a->width; ++i)
-        a->content[i] -= b->content[i];
-#endif
+    apply_binary_kernel(mat_kernels->sub, a, a, b);
 }
 
 Matrix *mat_scalar_multiplication(const Matrix *m, float a)
 {
-    Matrix *res = alloc_matrix(m->height, m->width);
-
-#ifdef USE_AVX
-    avx_vect_t a_v = avx(set1, a);
-    size_t i = 0;
-    avx_for(i, m->size)
-    {
-        avx_vect_t m_v = avx(loadu, &m->content[i]);
-        avx_vect_t r_v = avx(mul, a_v, m_v);
-        avx(storeu, &res->content[i], r_v);
-    }
-    for (; i < m->height * m->width; ++i)
-        res->content[i] = a * m->content[i];
-#else
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        res->content[i] = a * m->content[i];
-#endif
-
+    Matrix *res = alloc_matrix_like(m);
+    apply_scale_kernel(res, m, a);
     return res;
 }
 
 void mat_inplace_scalar_multiplication(Matrix *m, float a)
 {
-#ifdef USE_AVX
-    avx_vect_t a_v = avx(set1, a);
-    size_t i = 0;
-    avx_for(i, m->size)
-    {
-        avx_vect_t m_v = avx(loadu, &m->content[i]);
-        avx_vect_t r_v = avx(mul, a_v, m_v);
-        avx(storeu, &m->content[i], r_v);
-    }
-    for (; i < m->height * m->width; ++i)
-        m->content[i] *= a;
-#else
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        m->content[i] *= a;
-#endif
+    apply_scale_kernel(m, m, a);
+}
+
+/// @brief A product split by blocks of GEMM_MR rows of a and c.
+typedef struct
+{
+    const Matrix *a;
+    const Matrix *b;
+    Matrix *c;
+} GemmTask;
+
+static void gemm_body(size_t begin, size_t end, void *ctx)
+{
+    const GemmTask *t = ctx;
+    size_t first = begin * GEMM_MR;
+    size_t last = end * GEMM_MR < t->c->height ? end * GEMM_MR : t->c->height;
+
+    mat_kernels->gemm(last - first, t->b->width, t->a->width,
+                      row_ptr(t->a, first), t->a->stride, t->b->content,
+                      t->b->stride, row_ptr(t->c, first), t->c->stride);
 }
 
 Matrix *mat_multiplication(const Matrix *a, const Matrix *b)
@@ -490,66 +808,154 @@ Matrix *mat_multiplication(const Matrix *a, const Matrix *b)
              "not match the height of the second.");
 
     Matrix *res = alloc_matrix(a->height, b->width);
-#ifdef USE_AVX
-    size_t middle_dim = a->width; // or b->height
+    mat_multiplication_into(res, a, b);
+    return res;
+}
 
-    // The transpose matrix of b.
-    Matrix *b_t = mat_transpose(b);
+void mat_multiplication_into(Matrix *dst, const Matrix *a, const Matrix *b)
+{
+    if (a->width != b->height)
+        errx(EXIT_FAILURE,
+             "Cannot multiply two matrices if the width of the first does "
+             "not match the height of the second.");
+    if (dst->height != a->height || dst->width != b->width)
+        errx(EXIT_FAILURE,
+             "Matrix multiplication failed: expected a %zux%zu destination "
+             "but got a %zux%zu matrix.",
+             a->height, b->width, dst->height, dst->width);
+
+    // Every thread packs the whole of b, which is cheap next to the product
+    // of its GEMM_MR-row blocks.
+    GemmTask t = {.a = a, .b = b, .c = dst};
+    mat_parallel_for((a->height + GEMM_MR - 1) / GEMM_MR,
+                     2 * GEMM_MR * a->width * b->width, gemm_body, &t);
+}
 
-    for (size_t h = 0; h < res->height; ++h)
-    {
-        for (size_t w = 0; w < res->width; ++w)
-        {
-            // or &a->content[h * middle_dim]
-            const float *a_row = mat_unsafe_coef_ptr(a, h, 0);
-            // or &b_t->content[w * middle_dim]
-            const float *b_col = mat_unsafe_coef_ptr(b_t, w, 0);
+/// @brief Returns the coefficients of the column matrix x as a contiguous
+/// array: its own if its rows are not padded, else those of a copy stored in
+/// *copy, which the caller frees. *copy is NULL if no copy was made.
+static const float *column_content(const Matrix *x, Matrix **copy)
+{
+    *copy = NULL;
+    if (is_contiguous(x))
+        return x->content;
+
+    // E.g. a column of a batch buffer resized to a single sample.
+    *copy = alloc_matrix(x->height, 1);
+    for (size_t h = 0; h < x->height; ++h)
+        (*copy)->content[h] = *row_ptr(x, h);
+    return (*copy)->content;
+}
 
-            avx_vect_t sum = avx(setzero);
+Matrix *mat_gemv(const Matrix *m, const Matrix *x)
+{
+    if (x->width != 1)
+        errx(EXIT_FAILURE,
+             "Matrix-vector product failed: expected a column matrix but got "
+             "a width of %zu.",
+             x->width);
+    if (m->width != x->height)
+        errx(EXIT_FAILURE,
+             "Matrix-vector product failed: mismatched dimensions (%zu vs "
+             "%zu).",
+             m->width, x->height);
 
-            size_t k = 0;
-            avx_for(k, middle_dim)
-            {
-                avx_vect_t a_v = avx(loadu, &a_row[k]);
-                avx_vect_t b_v = avx(loadu, &b_col[k]);
-                sum = avx(fmadd, a_v, b_v, sum);
-            }
-#ifdef AVX512
-            float tmp[16];
-            avx(storeu, tmp, sum);
-            float total = tmp[0] + tmp[1] + tmp[2] + tmp[3] + tmp[4] + tmp[5] +
-                          tmp[6] + tmp[7] + tmp[8] + tmp[9] + tmp[10] +
-                          tmp[11] + tmp[12] + tmp[13] + tmp[14] + tmp[15];
-#else
-            float tmp[8];
-            avx(storeu, tmp, sum);
-            float total = tmp[0] + tmp[1] + tmp[2] + tmp[3] + tmp[4] + tmp[5] +
-                          tmp[6] + tmp[7];
-#endif
-            for (; k < middle_dim; ++k)
-                total += a_row[k] * b_col[k];
-
-            res->content[h * res->width + w] = total;
-        }
-    }
+    Matrix *res = alloc_matrix(m->height, 1);
+
+    Matrix *x_copy;
+    mat_kernels->gemv(m->height, m->width, m->content, m->stride,
+                      column_content(x, &x_copy), NULL, res->content);
+    if (x_copy != NULL)
+        mat_free(x_copy);
+
+    return res;
+}
 
-    mat_free(b_t);
-#else
-    for (size_t h = 0; h < res->height; ++h)
+Matrix *mat_gemv_add_bias(const Matrix *m, const Matrix *x,
+                          const Matrix *bias)
+{
+    if (x->width != 1)
+        errx(EXIT_FAILURE,
+             "Matrix-vector product failed: expected a column matrix but got "
+             "a width of %zu.",
+             x->width);
+    if (m->width != x->height)
+        errx(EXIT_FAILURE,
+             "Matrix-vector product failed: mismatched dimensions (%zu vs "
+             "%zu).",
+             m->width, x->height);
+    if (bias->height != m->height || bias->width != 1)
+        errx(EXIT_FAILURE,
+             "Matrix-vector product failed: expected a %zu×1 bias but got "
+             "%zu×%zu.",
+             m->height, bias->height, bias->width);
+
+    Matrix *res = alloc_matrix(m->height, 1);
+
+    Matrix *x_copy, *bias_copy;
+    mat_kernels->gemv(m->height, m->width, m->content, m->stride,
+                      column_content(x, &x_copy),
+                      column_content(bias, &bias_copy), res->content);
+    if (x_copy != NULL)
+        mat_free(x_copy);
+    if (bias_copy != NULL)
+        mat_free(bias_copy);
+
+    return res;
+}
+
+void mat_dense_relu(const Matrix *m, const Matrix *x, const Matrix *bias,
+                    Matrix *pre, Matrix *act)
+{
+    if (x->width != 1 || m->width != x->height)
+        errx(EXIT_FAILURE,
+             "Dense layer failed: expected a %zu×1 input but got %zu×%zu.",
+             m->width, x->height, x->width);
+    if (bias->height != m->height || bias->width != 1)
+        errx(EXIT_FAILURE,
+             "Dense layer failed: expected a %zu×1 bias but got %zu×%zu.",
+             m->height, bias->height, bias->width);
+    if (pre->height != m->height || pre->width != 1)
+        errx(EXIT_FAILURE,
+             "Dense layer failed: expected a %zu×1 output but got %zu×%zu.",
+             m->height, pre->height, pre->width);
+    if (act != NULL && (act->height != m->height || act->width != 1))
+        errx(EXIT_FAILURE,
+             "Dense layer failed: expected a %zu×1 activation but got "
+             "%zu×%zu.",
+             m->height, act->height, act->width);
+
+    Matrix *x_copy, *bias_copy;
+    const float *x_content = column_content(x, &x_copy);
+    const float *bias_content = column_content(bias, &bias_copy);
+
+    // The kernel writes contiguous columns: padded outputs are computed in
+    // temporary ones, then copied.
+    Matrix *pre_out = is_contiguous(pre) ? pre : alloc_matrix(m->height, 1);
+    Matrix *act_out = act;
+    if (act == pre)
+        act_out = pre_out;
+    else if (act != NULL && !is_contiguous(act))
+        act_out = alloc_matrix(m->height, 1);
+
+    mat_kernels->dense(m->height, m->width, m->content, m->stride, x_content,
+                       bias_content, pre_out->content,
+                       act_out != NULL ? act_out->content : NULL);
+
+    if (pre_out != pre)
     {
-        for (size_t w = 0; w < res->width; ++w)
-        {
-            float sum = 0.0f;
-            for (size_t k = 0; k < a->width; ++k)
-            {
-                sum += *mat_unsafe_coef_ptr(a, h, k) *
-                       *mat_unsafe_coef_ptr(b, k, w);
-            }
-            *mat_unsafe_coef_ptr(res, h, w) = sum;
-        }
+        mat_copy(pre, pre_out);
+        mat_free(pre_out);
     }
-#endif
-    return res;
+    if (act_out != NULL && act_out != act && act_out != pre_out)
+    {
+        mat_copy(act, act_out);
+        mat_free(act_out);
+    }
+    if (x_copy != NULL)
+        mat_free(x_copy);
+    if (bias_copy != NULL)
+        mat_free(bias_copy);
 }
 
 Matrix *mat_hadamard(const Matrix *a, const Matrix *b)
@@ -563,22 +969,8 @@ Matrix *mat_hadamard(const Matrix *a, const Matrix *b)
              "Matrix hadamard product failed: mismatched widths (%zu vs %zu).",
              a->width, b->width);
 
-    Matrix *res = alloc_matrix(a->height, a->width);
-#ifdef USE_AVX
-    size_t i = 0;
-    avx_for(i, res->size)
-    {
-        avx_vect_t a_v = avx(loadu, &a->content[i]);
-        avx_vect_t b_v = avx(loadu, &b->content[i]);
-        avx_vect_t r_v = avx(mul, a_v, b_v);
-        avx(storeu, &res->content[i], r_v);
-    }
-    for (; i < res->height * res->width; ++i)
-        res->content[i] = a->content[i] * b->content[i];
-#else
-    for (size_t i = 0; i < a->height * a->width; ++i)
-        res->content[i] = a->content[i] * b->content[i];
-#endif
+    Matrix *res = alloc_matrix_like(a);
+    apply_binary_kernel(mat_kernels->hadamard, res, a, b);
     return res;
 }
 
@@ -593,258 +985,155 @@ void mat_inplace_hadamard(Matrix *a, const Matrix *b)
              "Matrix hadamard product failed: mismatched widths (%zu vs %zu).",
              a->width, b->width);
 
-#ifdef USE_AVX
-    size_t i = 0;
-    avx_for(i, a->size)
-    {
-        avx_vect_t a_v = avx(loadu, &a->content[i]);
-        avx_vect_t b_v = avx(loadu, &b->content[i]);
-        avx_vect_t r_v = avx(mul, a_v, b_v);
-        avx(storeu, &a->content[i], r_v);
-    }
-    for (; i < a->height * a->width; ++i)
-        a->content[i] *= b->content[i];
-#else
-    for (size_t i = 0; i < a->height * a->width; ++i)
-        a->content[i] *= b->content[i];
-#endif
+    apply_binary_kernel(mat_kernels->hadamard, a, a, b);
 }
 
 Matrix *mat_relu(Matrix *m)
 {
-    Matrix *res = alloc_matrix(m->height, m->width);
-
-    float *m_c = m->content;
-    float *r_c = res->content;
-#ifdef USE_AVX
-    avx_vect_t zero = avx(setzero);
-
-    size_t i = 0;
-    avx_for(i, m->size)
-    {
-        avx_vect_t a_v = avx(loadu, &m_c[i]);
-        avx_vect_t r_v = avx(max, a_v, zero);
-        avx(storeu, &r_c[i], r_v);
-    }
-    for (; i < m->height * m->width; ++i)
-        r_c[i] = m_c[i] > 0.0f ? m_c[i] : 0.0f;
-#else
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        r_c[i] = m_c[i] > 0.0f ? m_c[i] : 0.0f;
-#endif
+    Matrix *res = alloc_matrix_like(m);
+    apply_unary_kernel(mat_kernels->relu, res, m);
     return res;
 }
 
 void mat_inplace_relu(Matrix *m)
 {
-    float *m_c = m->content;
-#ifdef USE_AVX
-    avx_vect_t zero = avx(setzero);
-
-    size_t i = 0;
-    avx_for(i, m->size)
-    {
-        avx_vect_t a_v = avx(loadu, &m_c[i]);
-        avx_vect_t r_v = avx(max, a_v, zero);
-        avx(storeu, &m_c[i], r_v);
-    }
-    for (; i < m->height * m->width; ++i)
-        m_c[i] = m_c[i] > 0.0f ? m_c[i] : 0.0f;
-#else
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        m_c[i] = m_c[i] > 0.0f ? m_c[i] : 0.0f;
-#endif
+    apply_unary_kernel(mat_kernels->relu, m, m);
 }
 
 Matrix *mat_relu_derivative(Matrix *m)
 {
-    Matrix *res = mat_create_zero(m->height, m->width);
-
-    float *src = m->content;
-    float *dst = res->content;
-#ifdef USE_AVX
-    avx_vect_t zero = avx(setzero);
-    avx_vect_t one = avx(set1, 1.0f);
-
-    size_t i = 0;
-    avx_for(i, m->size)
-    {
-        avx_vect_t v = avx(loadu, src + i);
-        avx_vect_t mask = avx(cmp, v, zero, _CMP_GT_OQ);
-        avx_vect_t r = avx(and, mask, one);
-        avx(storeu, dst + i, r);
-    }
-    for (; i < m->height * m->width; ++i)
-        dst[i] = src[i] > 0.0f ? 1.0f : 0.0f;
-#else
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        dst[i] = src[i] > 0.0f ? 1.0f : 0.0f;
-#endif
+    Matrix *res = alloc_matrix_like(m);
+    apply_unary_kernel(mat_kernels->relu_derivative, res, m);
     return res;
 }
 
 void mat_inplace_relu_derivative(Matrix *m)
 {
-    float *c = m->content;
-#ifdef USE_AVX
-    avx_vect_t zero = avx(setzero);
-    avx_vect_t one = avx(set1, 1.0f);
-
-    size_t i = 0;
-    avx_for(i, m->size)
-    {
-        avx_vect_t v = avx(loadu, c + i);
-        avx_vect_t mask = avx(cmp, v, zero, _CMP_GT_OQ);
-        avx_vect_t r = avx(and, mask, one);
-        avx(storeu, c + i, r);
-    }
-    for (; i < m->height * m->width; ++i)
-        c[i] = c[i] > 0.0f ? 1.0f : 0.0f;
-#else
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        c[i] = c[i] > 0.0f ? 1.0f : 0.0f;
-#endif
+    apply_unary_kernel(mat_kernels->relu_derivative, m, m);
 }
 
 // HERE
 
-#if defined(USE_AVX_512)
-// static avx_vect_t _mm256_exp_ps(){}
-#error "AVX_512 is not supported yet."
-#elif defined(USE_AVX_2)
-// static avx_vect_t _mm256_exp_ps(avx_vect_t x)
-// {
-//     const avx_vect_t ln2 = avx(set1, 0.69314718056f);
-//     const avx_vect_t inv_ln2 = avx(set1, 1.44269504089f);
-
-//     // Range reduction: x = n*ln2 + r, where r in [-ln2/2, ln2/2]
-//     avx_vect_t n = avx(mul, x, inv_ln2);
-//     n = avx(round, n, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
-
-//     avx_vect_t y = avx(mul, n, ln2);
-//     avx_vect_t r = avx(sub, x, y);
-
-//     // Polynomial approximation of exp(r)
-//     const avx_vect_t c1 = avx(set1, 1.0f);
-//     const avx_vect_t c2 = avx(set1, 0.4999999403953552f);
-//     const avx_vect_t c3 = avx(set1, 0.16666594183444977f);
-//     const avx_vect_t c4 = avx(set1, 0.041657347708940506f);
-//     const avx_vect_t c5 = avx(set1, 0.008301359802305698f);
-//     const avx_vect_t c6 = avx(set1, 0.0013298822781072855f);
-
-//     avx_vect_t r2 = avx(mul, r, r);
-//     avx_vect_t poly = c6;
-//     poly = avx(fmadd, poly, r, c5);
-//     poly = avx(fmadd, poly, r, c4);
-//     poly = avx(fmadd, poly, r, c3);
-//     poly = avx(fmadd, poly, r, c2);
-//     poly = avx(fmadd, poly, r2, r);
-//     poly = avx(add, poly, c1);
-
-//     // Reconstruct exp(x) = exp(r) * 2^n
-//     __m256i pow2n = _mm256_slli_epi32(
-//         _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
-//     avx_vect_t pow2 = avx(castsi256, pow2n);
-
-//     return avx(mul, poly, pow2);
-// }
-#endif
+/// @brief Computes the softmax of src into dst (which may be src) in two
+/// passes over src and one over dst.
+static void softmax_into(Matrix *dst, const Matrix *src)
+{
+    // Shifting by the maximum does not change the result and avoids
+    // overflows.
+    float max = mat_max(src);
+
+    float sum = 0.0f;
+    if (is_contiguous(dst) && is_contiguous(src))
+        sum = mat_kernels->exp_sum(dst->content, src->content, max, src->size);
+    else
+        for (size_t h = 0; h < src->height; ++h)
+            sum += mat_kernels->exp_sum(row_ptr(dst, h), row_ptr(src, h), max,
+                                        src->width);
+
+    mat_inplace_scalar_multiplication(dst, 1.0f / sum);
+}
 
-void mat_inplace_softmax(Matrix *m)
+Matrix *mat_softmax(const Matrix *m)
 {
-    size_t n = m->height * m->width;
+    Matrix *res = alloc_matrix_like(m);
+    softmax_into(res, m);
+    return res;
+}
 
-    float max_val = m->content[0];
-    for (size_t i = 1; i < n; ++i)
-        if (m->content[i] > max_val)
-            max_val = m->content[i];
+void mat_inplace_softmax(Matrix *m) { softmax_into(m, m); }
 
-    float sum = 0.0f;
-    for (size_t i = 0; i < n; ++i)
+void mat_inplace_row_softmax(Matrix *m)
+{
+    // Each row goes through the kernels of mat_inplace_softmax on a vector.
+    for (size_t h = 0; h < m->height; ++h)
     {
-        m->content[i] = expf(m->content[i] - max_val);
-        sum += m->content[i];
+        float *row = row_ptr(m, h);
+        float max = mat_kernels->max(row, m->width);
+        float sum = mat_kernels->exp_sum(row, row, max, m->width);
+        mat_kernels->scale(row, row, 1.0f / sum, m->width);
     }
-
-    for (size_t i = 0; i < n; ++i)
-        m->content[i] /= sum;
 }
 
-void mat_inplace_toggle(Matrix *m)
+void mat_inplace_column_softmax(Matrix *m)
 {
-    for (size_t i = 0; i < m->size; ++i)
-        m->content[i] = m->content[i] < 0.5f ? 1.0f : 0.0f;
+    // The columns are made contiguous rows.
+    Matrix *columns = mat_transpose(m);
+    mat_inplace_row_softmax(columns);
+
+    mat_kernels->transpose(m->content, m->stride, columns->content,
+                           columns->stride, columns->height, columns->width);
+    mat_free(columns);
 }
 
-Matrix *mat_strip_margins(const Matrix *m)
+Matrix *mat_exp(const Matrix *m)
 {
-    // Whether an activated (<=> black <=> 1.0f) pixel has been found.
-    int found;
-    // The new coordinates (included).
-    size_t h_i = 0, h_f = m->height - 1, w_i = 0, w_f = m->width - 1;
+    Matrix *res = alloc_matrix_like(m);
+    apply_unary_kernel(mat_kernels->exp, res, m);
+    return res;
+}
 
-    found = 0;
-    while (h_i < m->height && !found)
-    {
-        for (size_t w = 0; w < m->width && !found; ++w)
-            found = *mat_coef_ptr(m, h_i, w) > 0.5f;
-        h_i++;
-    }
-    h_i--;
+void mat_inplace_exp(Matrix *m) { apply_unary_kernel(mat_kernels->exp, m, m); }
 
-    found = 0;
-    while (h_f > 0 && !found)
+void mat_inplace_toggle(Matrix *m)
+{
+    for (size_t h = 0; h < m->height; ++h)
     {
-        for (size_t w = 0; w < m->width && !found; ++w)
-            found = *mat_coef_ptr(m, h_f, w) > 0.5f;
-        h_f--;
+        float *row = row_ptr(m, h);
+        for (size_t w = 0; w < m->width; ++w)
+            row[w] = row[w] < 0.5f ? 1.0f : 0.0f;
     }
-    h_f++;
+}
 
-    found = 0;
-    while (w_i < m->width && !found)
-    {
-        for (size_t h = 0; h < m->height && !found; ++h)
-            found = *mat_coef_ptr(m, h, w_i) > 0.5f;
-        w_i++;
-    }
-    w_i--;
+MatView mat_view_strip_margins(MatView v)
+{
+    if (v.height == 0 || v.width == 0)
+        return mat_subview(v, 0, 0, 0, 0);
 
-    found = 0;
-    while (w_f > 0 && !found)
-    {
-        for (size_t h = 0; h < m->height && !found; ++h)
-            found = *mat_coef_ptr(m, h, w_f) > 0.5f;
-        w_f--;
-    }
-    w_f++;
+    // The margins are found on the packed bits, 64 columns at a time.
+    BitMatrix *bits = mat_bit_from_view(v, 0.5f);
+    size_t h, w, height, width;
+    int activated = mat_bit_strip_margins(bits, &h, &w, &height, &width);
+    mat_bit_free(bits);
 
-    if (h_i > h_f || w_i > w_f)
-        return NULL;
+    if (!activated)
+        return mat_subview(v, 0, 0, 0, 0);
 
-    Matrix *res = mat_create_zero(h_f - h_i + 1, w_f - w_i + 1);
-    for (size_t h = 0; h < res->height; ++h)
-        for (size_t w = 0; w < res->width; ++w)
-            *mat_coef_ptr(res, h, w) = *mat_coef_ptr(m, h_i + h, w_i + w);
+    return mat_subview(v, h, w, height, width);
+}
 
-    return res;
+Matrix *mat_strip_margins(const Matrix *m)
+{
+    MatView v = mat_view_strip_margins(mat_view(m));
+
+    if (v.height == 0)
+        return NULL;
+
+    return mat_create_from_view(v);
 }
 
 Matrix *mat_scale_to_28(const Matrix *m, float fill_value)
 {
+    return mat_view_scale_to_28(mat_view(m), fill_value);
+}
+
+Matrix *mat_view_scale_to_28(MatView v, float fill_value)
+{
+    if (v.height == 0 || v.width == 0)
+        errx(EXIT_FAILURE, "Cannot scale an empty view.");
+
     const size_t dim = 28;
     Matrix *res = mat_create_filled(dim, dim, fill_value);
 
     // Compute scaling factors for height and width
-    float scale_h = (float)m->height / (float)dim;
-    float scale_w = (float)m->width / (float)dim;
+    float scale_h = (float)v.height / (float)dim;
+    float scale_w = (float)v.width / (float)dim;
 
     // Use the larger scale to preserve aspect ratio
     float factor = (scale_h > scale_w) ? scale_h : scale_w;
 
     // Compute offset to center the content
-    float h_offset = ((dim * factor) - m->height) / 2.0f;
-    float w_offset = ((dim * factor) - m->width) / 2.0f;
+    float h_offset = ((dim * factor) - v.height) / 2.0f;
+    float w_offset = ((dim * factor) - v.width) / 2.0f;
 
     for (size_t h = 0; h < dim; ++h)
     {
@@ -855,15 +1144,15 @@ Matrix *mat_scale_to_28(const Matrix *m, float fill_value)
             float sw = w * factor - w_offset;
 
             // Clamp to valid source range
-            if (sh < 0 || sw < 0 || sh > m->height - 1 || sw > m->width - 1)
+            if (sh < 0 || sw < 0 || sh > v.height - 1 || sw > v.width - 1)
                 continue;
             //     sh = 0;
             // if (sw < 0)
             //     sw = 0;
-            // if (sh > m->height - 1)
-            //     sh = m->height - 1;
-            // if (sw > m->width - 1)
-            //     sw = m->width - 1;
+            // if (sh > v.height - 1)
+            //     sh = v.height - 1;
+            // if (sw > v.width - 1)
+            //     sw = v.width - 1;
 
             // Split into integer and fractional parts
             float sh_frac, sw_frac, sh_int, sw_int;
@@ -874,8 +1163,8 @@ Matrix *mat_scale_to_28(const Matrix *m, float fill_value)
             size_t iw = (size_t)sw_int;
 
             // Neighboring indices, clamped
-            size_t ih2 = (ih + 1 < m->height) ? ih + 1 : ih;
-            size_t iw2 = (iw + 1 < m->width) ? iw + 1 : iw;
+            size_t ih2 = (ih + 1 < v.height) ? ih + 1 : ih;
+            size_t iw2 = (iw + 1 < v.width) ? iw + 1 : iw;
 
             // Bilinear interpolation weights
             float w_tl = (1.0f - sh_frac) * (1.0f - sw_frac);
@@ -884,9 +1173,10 @@ Matrix *mat_scale_to_28(const Matrix *m, float fill_value)
             float w_br = sh_frac * sw_frac;
 
             // Compute interpolated pixel value
-            float pixel =
-                w_tl * mat_coef(m, ih, iw) + w_tr * mat_coef(m, ih, iw2) +
-                w_bl * mat_coef(m, ih2, iw) + w_br * mat_coef(m, ih2, iw2);
+            float pixel = w_tl * mat_view_coef(v, ih, iw) +
+                          w_tr * mat_view_coef(v, ih, iw2) +
+                          w_bl * mat_view_coef(v, ih2, iw) +
+                          w_br * mat_view_coef(v, ih2, iw2);
 
             *mat_unsafe_coef_ptr(res, h, w) = roundf(pixel);
         }
@@ -897,8 +1187,12 @@ Matrix *mat_scale_to_28(const Matrix *m, float fill_value)
 
 void mat_inplace_to_one_hot(Matrix *m)
 {
-    for (size_t i = 0; i < m->height * m->width; ++i)
-        m->content[i] = m->content[i] > 0.5f ? 1.0f : 0.0f;
+    for (size_t h = 0; h < m->height; ++h)
+    {
+        float *row = row_ptr(m, h);
+        for (size_t w = 0; w < m->width; ++w)
+            row[w] = row[w] > 0.5f ? 1.0f : 0.0f;
+    }
 }
 
 // Matrix *mat_scale_to_28(Matrix *m)
@@ -1000,185 +1294,186 @@ void mat_inplace_to_one_hot(Matrix *m)
 //     return sum / (actual->height * actual->width);
 // }
 
-#ifdef USE_AVX
-#if 0 // def USE_AVX_512
-#else
-static inline void transpose_block(const float *src, float *dst,
-                                   size_t src_width, size_t dst_width)
-{
-    avx_vect_t row0 = avx(loadu, src + 0 * src_width);
-    avx_vect_t row1 = avx(loadu, src + 1 * src_width);
-    avx_vect_t row2 = avx(loadu, src + 2 * src_width);
-    avx_vect_t row3 = avx(loadu, src + 3 * src_width);
-    avx_vect_t row4 = avx(loadu, src + 4 * src_width);
-    avx_vect_t row5 = avx(loadu, src + 5 * src_width);
-    avx_vect_t row6 = avx(loadu, src + 6 * src_width);
-    avx_vect_t row7 = avx(loadu, src + 7 * src_width);
-
-    // Step 1: unpack pairs
-    avx_vect_t t0 = avx(unpacklo, row0, row1);
-    avx_vect_t t1 = avx(unpackhi, row0, row1);
-    avx_vect_t t2 = avx(unpacklo, row2, row3);
-    avx_vect_t t3 = avx(unpackhi, row2, row3);
-    avx_vect_t t4 = avx(unpacklo, row4, row5);
-    avx_vect_t t5 = avx(unpackhi, row4, row5);
-    avx_vect_t t6 = avx(unpacklo, row6, row7);
-    avx_vect_t t7 = avx(unpackhi, row6, row7);
-
-    // Step 2: shuffle 128-bit lanes
-    avx_vect_t s0 = avx(shuffle, t0, t2, 0x4E);
-    avx_vect_t s1 = avx(shuffle, t1, t3, 0x4E);
-    avx_vect_t s2 = avx(shuffle, t4, t6, 0x4E);
-    avx_vect_t s3 = avx(shuffle, t5, t7, 0x4E);
-
-    // Step 3: final permutation
-    avx_vect_t r0 = avx(permute2f128, s0, s2, 0x20);
-    avx_vect_t r1 = avx(permute2f128, s1, s3, 0x20);
-    avx_vect_t r2 = avx(permute2f128, s0, s2, 0x31);
-    avx_vect_t r3 = avx(permute2f128, s1, s3, 0x31);
-
-    // Final interleaving step
-    avx_vect_t r4 = avx(permute2f128, s0, s2, 0x02);
-    avx_vect_t r5 = avx(permute2f128, s1, s3, 0x02);
-    avx_vect_t r6 = avx(permute2f128, s0, s2, 0x13);
-    avx_vect_t r7 = avx(permute2f128, s1, s3, 0x13);
-
-    // Store result (column-major into output row-major)
-    avx(storeu, dst + 0 * dst_width, r0);
-    avx(storeu, dst + 1 * dst_width, r1);
-    avx(storeu, dst + 2 * dst_width, r2);
-    avx(storeu, dst + 3 * dst_width, r3);
-    avx(storeu, dst + 4 * dst_width, r4);
-    avx(storeu, dst + 5 * dst_width, r5);
-    avx(storeu, dst + 6 * dst_width, r6);
-    avx(storeu, dst + 7 * dst_width, r7);
-}
-#endif
-#endif
-
-// void mat_transpose(const Matrix *m)
-// {
-//     Matrix *res = alloc_matrix(m->width, m->height);
+/// @brief The number of source rows of the ranges a transposition is split
+/// into: a multiple of the tile size of every kernel.
+#define TRANSPOSE_BLOCK 16
 
-//     const float *src = m->content;
-//     float *B = m->content;
+/// @brief A transposition split by blocks of TRANSPOSE_BLOCK rows of src,
+/// i.e. of columns of dst.
+typedef struct
+{
+    Matrix *dst;
+    const Matrix *src;
+} TransposeTask;
 
-//     const size_t block = 8;
+static void transpose_body(size_t begin, size_t end, void *ctx)
+{
+    const TransposeTask *t = ctx;
+    size_t first = begin * TRANSPOSE_BLOCK;
+    size_t last = end * TRANSPOSE_BLOCK < t->src->height
+                      ? end * TRANSPOSE_BLOCK
+                      : t->src->height;
+
+    mat_kernels->transpose(t->dst->content + first, t->dst->stride,
+                           row_ptr(t->src, first), t->src->stride,
+                           last - first, t->src->width);
+}
 
-//     size_t N8 = N - (N % block);
-//     size_t M8 = M - (M % block);
+Matrix *mat_transpose(const Matrix *m)
+{
+    Matrix *res = alloc_matrix(m->width, m->height);
+    mat_transpose_into(res, m);
+    return res;
+}
 
-//     // Process full 8x8 blocks
-//     for (size_t i = 0; i < N8; i += block)
-//     {
-//         for (size_t j = 0; j < M8; j += block)
-//         {
-//             transpose_8x8_block(&A[i * M + j], &B[j * N + i],
-//                                 M, // src row width
-//                                 N  // dst row width
-//             );
-//         }
-//     }
+void mat_transpose_into(Matrix *dst, const Matrix *m)
+{
+    if (dst->height != m->width || dst->width != m->height)
+        errx(EXIT_FAILURE,
+             "Matrix transposition failed: expected a %zux%zu destination "
+             "but got a %zux%zu matrix.",
+             m->width, m->height, dst->height, dst->width);
 
-//     // Remainder cols (scalar)
-//     for (size_t i = 0; i < N; ++i)
-//     {
-//         for (size_t j = M8; j < M; ++j)
-//         {
-//             B[j * N + i] = A[i * M + j];
-//         }
-//     }
+    // The coefficients of a contiguous vector are already in order.
+    if ((m->height == 1 || m->width == 1) && is_contiguous(m) &&
+        is_contiguous(dst))
+    {
+        memcpy(dst->content, m->content, m->size * sizeof(float));
+        return;
+    }
 
-//     // Remainder rows (scalar)
-//     for (size_t i = N8; i < N; ++i)
-//     {
-//         for (size_t j = 0; j < M8; ++j)
-//         {
-//             B[j * N + i] = A[i * M + j];
-//         }
-//     }
-// }
+    TransposeTask t = {.dst = dst, .src = m};
+    mat_parallel_for((m->height + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK,
+                     TRANSPOSE_BLOCK * m->width, transpose_body, &t);
+}
 
-Matrix *mat_transpose(const Matrix *m)
+/// @brief The number of columns mat_set_columns copies at a time.
+#define SET_COLUMNS_BLOCK 8
+
+void mat_set_columns(Matrix *m, const Matrix *const *columns)
 {
-    Matrix *res = alloc_matrix(m->width, m->height);
+    for (size_t w = 0; w < m->width; ++w)
+        if (columns[w]->width != 1 || columns[w]->height != m->height)
+            errx(EXIT_FAILURE,
+                 "Failed to set columns: expected %zux1 columns but got a "
+                 "%zux%zu matrix.",
+                 m->height, columns[w]->height, columns[w]->width);
 
-#if 0
-    // Handle blocks.
-    for (size_t h = 0; h < m->height; h += 4)
-        for (size_t w = 0; w < m->width; w += 4)
-            transpose_block(m, res, h, w);
+    // The columns are copied by blocks of a few at a time, so that each row of
+    // m is written by contiguous runs while the columns are read in order.
+    for (size_t w0 = 0; w0 < m->width; w0 += SET_COLUMNS_BLOCK)
+    {
+        size_t w1 = w0 + SET_COLUMNS_BLOCK < m->width ? w0 + SET_COLUMNS_BLOCK
+                                                      : m->width;
 
-    // Handle remaining rows.
-    for (size_t h = m->height - m->height % 4; h < m->height; ++h)
-        for (size_t w = 0; w < m->width; ++w)
-            *mat_unsafe_coef_ptr(res, w, h) = *mat_unsafe_coef_ptr(m, h, w);
+        for (size_t h = 0; h < m->height; ++h)
+        {
+            float *row = row_ptr(m, h);
+            for (size_t w = w0; w < w1; ++w)
+                row[w] = *row_ptr(columns[w], h);
+        }
+    }
+}
 
-    // Handle remaining columns.
-    for (size_t h = 0; h < m->height - m->height % 4; ++h)
-        for (size_t w = m->width - m->width % 4; w < m->width; ++w)
-            *mat_unsafe_coef_ptr(res, w, h) = *mat_unsafe_coef_ptr(m, h, w);
+/// @brief Transposes the square matrix m in place, one pair of
+/// TRANSPOSE_BLOCK×TRANSPOSE_BLOCK tiles at a time: the tiles (i, j) and
+/// (j, i) are swapped while being transposed. The ranges are rows of tiles,
+/// whose pairs (i, j) with j >= i do not overlap.
+static void inplace_transpose_body(size_t begin, size_t end, void *ctx)
+{
+    Matrix *m = ctx;
+    float tile[TRANSPOSE_BLOCK * TRANSPOSE_BLOCK];
 
-#else
-    for (size_t h = 0; h < m->height; ++h)
+    for (size_t i = begin * TRANSPOSE_BLOCK; i < end * TRANSPOSE_BLOCK;
+         i += TRANSPOSE_BLOCK)
     {
-        for (size_t w = 0; w < m->width; ++w)
+        size_t rows = m->height - i < TRANSPOSE_BLOCK ? m->height - i
+                                                      : TRANSPOSE_BLOCK;
+
+        // The diagonal tile goes through the buffer and back.
+        mat_kernels->transpose(tile, TRANSPOSE_BLOCK, row_ptr(m, i) + i,
+                               m->stride, rows, rows);
+        for (size_t h = 0; h < rows; ++h)
+            memcpy(row_ptr(m, i + h) + i, &tile[h * TRANSPOSE_BLOCK],
+                   rows * sizeof(float));
+
+        for (size_t j = i + TRANSPOSE_BLOCK; j < m->width; j += TRANSPOSE_BLOCK)
         {
-            *mat_unsafe_coef_ptr(res, w, h) = *mat_unsafe_coef_ptr(m, h, w);
+            size_t cols = m->width - j < TRANSPOSE_BLOCK ? m->width - j
+                                                         : TRANSPOSE_BLOCK;
+
+            mat_kernels->transpose(tile, TRANSPOSE_BLOCK, row_ptr(m, i) + j,
+                                   m->stride, rows, cols);
+            mat_kernels->transpose(row_ptr(m, i) + j, m->stride,
+                                   row_ptr(m, j) + i, m->stride, cols, rows);
+            for (size_t h = 0; h < cols; ++h)
+                memcpy(row_ptr(m, j + h) + i, &tile[h * TRANSPOSE_BLOCK],
+                       rows * sizeof(float));
         }
     }
-#endif
+}
 
-    return res;
+/// @brief Packs the padded rows of m together, so that its coefficients form a
+/// single array.
+static void pack_rows(Matrix *m)
+{
+    if (is_contiguous(m))
+        return;
+
+    for (size_t h = 1; h < m->height; ++h)
+        memmove(m->content + h * m->width, row_ptr(m, h),
+                m->width * sizeof(float));
+    m->stride = m->width;
 }
 
-// void mat_inplace_transpose(Matrix *m)
-// {
-//     if (m->height == m->width)
-//     {
-//         for (size_t h = 0; h < m->height; h++)
-//         {
-//             for (size_t w = h + 1; w < m->width; w++)
-//             {
-//                 size_t i = h * m->width + w;
-//                 size_t j = w * m->width + h;
-//                 float tmp = m->content[i];
-//                 m->content[i] = m->content[j];
-//                 m->content[j] = tmp;
-//             }
-//         }
-//     }
-//     else
-//     {
-//         size_t cycles = gcd(m->height, m->width);
+void mat_inplace_transpose(Matrix *m)
+{
+    size_t height = m->height;
+    size_t width = m->width;
 
-//         for (size_t i = 0; i < cycles; i++)
-//         {
-//             size_t current = i;
-//             float tmp = m->content[i];
-
-//             while (1)
-//             {
-//                 size_t r = current / m->width;
-//                 size_t c = current % m->width;
-//                 size_t next = c * m->height + r;
-
-//                 if (next == i)
-//                 {
-//                     m->content[current] = tmp;
-//                     break;
-//                 }
-
-//                 m->content[current] = m->content[next];
-//                 current = next;
-//             }
-//         }
+    if (height == width)
+    {
+        mat_parallel_for((height + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK,
+                         TRANSPOSE_BLOCK * width, inplace_transpose_body, m);
+        return;
+    }
 
-//         size_t tmp = m->height;
-//         m->height = m->width;
-//         m->width = tmp;
-//     }
-// }
+    pack_rows(m);
+    m->height = width;
+    m->width = height;
+    m->stride = height;
+
+    // The coefficients of a vector are already in order.
+    if (height == 1 || width == 1)
+        return;
+
+    // Cycle-following: the coefficient at i = h × width + w moves to
+    // w × height + h, which is i × height modulo size - 1. Each cycle is
+    // walked once, the visited coefficients being marked in a bitset.
+    size_t size = height * width;
+    uint64_t *visited = calloc((size + 63) / 64, sizeof(uint64_t));
+    if (visited == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    for (size_t start = 1; start < size - 1; ++start)
+    {
+        if (visited[start / 64] >> (start % 64) & 1)
+            continue;
+
+        float carried = m->content[start];
+        size_t i = start;
+        do
+        {
+            i = i * height % (size - 1);
+            float tmp = m->content[i];
+            m->content[i] = carried;
+            carried = tmp;
+            visited[i / 64] |= (uint64_t)1 << (i % 64);
+        } while (i != start);
+    }
+
+    free(visited);
+}
 
 // Matrix *mat_vertical_flatten(const Matrix *m)
 // {
@@ -1194,8 +1489,11 @@ Matrix *mat_transpose(const Matrix *m)
 
 void mat_inplace_vertical_flatten(Matrix *m)
 {
+    pack_rows(m);
+
     m->height *= m->width;
     m->width = 1;
+    m->stride = 1;
 }
 
 // Matrix *mat_horizontal_flatten(const Matrix *m)
@@ -1216,88 +1514,202 @@ void mat_inplace_vertical_flatten(Matrix *m)
 //     m->height = 1;
 // }
 
-Matrix *mat_normalize(const Matrix *m)
+/// @brief Returns the sum of the coefficients of m.
+float mat_sum(const Matrix *m) { return mat_view_sum(mat_view(m)); }
+
+float mat_view_sum(MatView v)
 {
-    Matrix *res = mat_create_zero(m->height, m->width);
+    if (is_contiguous_view(v))
+        return mat_kernels->sum(v.content, v.height * v.width);
 
     float sum = 0.0f;
+    for (size_t h = 0; h < v.height; ++h)
+        sum += mat_kernels->sum(mat_view_row(v, h), v.width);
+    return sum;
+}
+
+void mat_sum_columns(Matrix *dst, const Matrix *m)
+{
+    if (dst->width != 1 || dst->height != m->height)
+        errx(EXIT_FAILURE,
+             "Column sum failed: expected a %zux1 destination but got a "
+             "%zux%zu matrix.",
+             m->height, dst->height, dst->width);
 
-    for (size_t i = 0; i < m->height * m->width; ++i)
+    for (size_t h = 0; h < m->height; ++h)
+        *row_ptr(dst, h) = mat_kernels->sum(row_ptr(m, h), m->width);
+}
+
+float mat_max(const Matrix *m) { return mat_view_max(mat_view(m)); }
+
+float mat_view_max(MatView v)
+{
+    if (v.height == 0 || v.width == 0)
+        errx(EXIT_FAILURE, "Cannot compute the maximum of an empty view.");
+
+    if (is_contiguous_view(v))
+        return mat_kernels->max(v.content, v.height * v.width);
+
+    float max = mat_kernels->max(v.content, v.width);
+    for (size_t h = 1; h < v.height; ++h)
     {
-        sum += m->content[i];
+        float row_max = mat_kernels->max(mat_view_row(v, h), v.width);
+        if (row_max > max)
+            max = row_max;
     }
+    return max;
+}
+
+void mat_mean_stddev(const Matrix *m, float *mean_out, float *stddev_out)
+{
+    mat_view_mean_stddev(mat_view(m), mean_out, stddev_out);
+}
+
+void mat_view_mean_stddev(MatView v, float *mean_out, float *stddev_out)
+{
+    if (v.height == 0 || v.width == 0)
+        errx(EXIT_FAILURE, "Cannot compute the mean of an empty view.");
+
+    size_t size = v.height * v.width;
+    float mean = mat_view_sum(v) / (float)size;
+
+    float sum_sq_diff = 0.0f;
+    if (is_contiguous_view(v))
+        sum_sq_diff = mat_kernels->sum_sq_diff(v.content, mean, size);
+    else
+        for (size_t h = 0; h < v.height; ++h)
+            sum_sq_diff +=
+                mat_kernels->sum_sq_diff(mat_view_row(v, h), mean, v.width);
+
+    if (mean_out != NULL)
+        *mean_out = mean;
+    if (stddev_out != NULL)
+        *stddev_out = sqrtf(sum_sq_diff / (float)size);
+}
+
+Matrix *mat_normalize(const Matrix *m)
+{
+    float sum = mat_sum(m);
 
     if (sum == 0.0)
         errx(EXIT_FAILURE, "Cannot normalize a zero matrix.");
 
-    for (size_t i = 0; i < m->height * m->width; ++i)
-    {
-        res->content[i] = m->content[i] / sum;
-    }
-
-    return res;
+    return mat_scalar_multiplication(m, 1.0f / sum);
 }
 
 void mat_inplace_normalize(Matrix *m)
 {
-    float sum = 0.0f;
-
-    for (size_t i = 0; i < m->height * m->width; ++i)
-    {
-        sum += m->content[i];
-    }
+    float sum = mat_sum(m);
 
     if (sum == 0.0)
         errx(EXIT_FAILURE, "Cannot normalize a zero matrix.");
 
-    for (size_t i = 0; i < m->height * m->width; ++i)
+    mat_inplace_scalar_multiplication(m, 1.0f / sum);
+}
+
+/// @brief A map split by rows. Only the function matching the body is set.
+typedef struct
+{
+    Matrix *dst;
+    const Matrix *src;
+    float (*f)(float);
+    float (*f_with_indexes)(float, size_t, size_t);
+} MapTask;
+
+static void map_body(size_t begin, size_t end, void *ctx)
+{
+    const MapTask *t = ctx;
+
+    for (size_t h = begin; h < end; ++h)
     {
-        m->content[i] /= sum;
+        float *dst = row_ptr(t->dst, h);
+        const float *src = row_ptr(t->src, h);
+        for (size_t w = 0; w < t->src->width; ++w)
+            dst[w] = t->f(src[w]);
     }
 }
 
-Matrix *mat_map(const Matrix *m, float (*f)(float))
+static void map_with_indexes_body(size_t begin, size_t end, void *ctx)
 {
-    Matrix *res = mat_create_zero(m->height, m->width);
+    const MapTask *t = ctx;
 
-    for (size_t i = 0; i < m->height * m->width; ++i)
+    for (size_t h = begin; h < end; ++h)
     {
-        res->content[i] = f(m->content[i]);
+        float *dst = row_ptr(t->dst, h);
+        const float *src = row_ptr(t->src, h);
+        for (size_t w = 0; w < t->src->width; ++w)
+            dst[w] = t->f_with_indexes(src[w], h, w);
     }
+}
 
+Matrix *mat_map(const Matrix *m, float (*f)(float))
+{
+    Matrix *res = mat_create_zero(m->height, m->width);
+    MapTask t = {.dst = res, .src = m, .f = f};
+    mat_parallel_for(m->height, m->width, map_body, &t);
     return res;
 }
 
 void mat_inplace_map(Matrix *m, float (*f)(float))
 {
-    for (size_t i = 0; i < m->height * m->width; ++i)
-    {
-        m->content[i] = f(m->content[i]);
-    }
+    MapTask t = {.dst = m, .src = m, .f = f};
+    mat_parallel_for(m->height, m->width, map_body, &t);
 }
 
 Matrix *mat_map_with_indexes(const Matrix *m, float (*f)(float, size_t, size_t))
 {
     Matrix *res = mat_create_zero(m->height, m->width);
+    MapTask t = {.dst = res, .src = m, .f_with_indexes = f};
+    mat_parallel_for(m->height, m->width, map_with_indexes_body, &t);
+    return res;
+}
 
-    for (size_t h = 0; h < m->height; ++h)
-    {
-        for (size_t w = 0; w < m->width; ++w)
-            *mat_unsafe_coef_ptr(res, h, w) =
-                f(*mat_unsafe_coef_ptr(m, h, w), h, w);
-    }
+void mat_inplace_map_with_indexes(Matrix *m, float (*f)(float, size_t, size_t))
+{
+    MapTask t = {.dst = m, .src = m, .f_with_indexes = f};
+    mat_parallel_for(m->height, m->width, map_with_indexes_body, &t);
+}
+
+/// @brief Checks the operation and parameters given to mat_apply.
+static void check_op(MatOp op, MatOpParams params)
+{
+    if ((unsigned)op > MAT_OP_THRESHOLD)
+        errx(EXIT_FAILURE, "Unknown matrix operation %d.", (int)op);
+
+    if (op == MAT_OP_CLAMP && params.low > params.high)
+        errx(EXIT_FAILURE, "Cannot clamp to [%f, %f]: low is above high.",
+             params.low, params.high);
+}
+
+Matrix *mat_apply(const Matrix *m, MatOp op, MatOpParams params)
+{
+    check_op(op, params);
+
+    Matrix *res = alloc_matrix_like(m);
+    ElementwiseTask t = {
+        .dst = res,
+        .a = m,
+        .contiguous = is_contiguous(m),
+        .op = op,
+        .params = params,
+    };
+    run_elementwise(apply_op_body, &t);
 
     return res;
 }
 
-void mat_inplace_map_with_indexes(Matrix *m, float (*f)(float, size_t, size_t))
+void mat_inplace_apply(Matrix *m, MatOp op, MatOpParams params)
 {
-    for (size_t h = 0; h < m->height; ++h)
-    {
-        for (size_t w = 0; w < m->width; ++w)
-            *mat_unsafe_coef_ptr(m, h, w) =
-                f(*mat_unsafe_coef_ptr(m, h, w), h, w);
-    }
+    check_op(op, params);
+
+    ElementwiseTask t = {
+        .dst = m,
+        .a = m,
+        .contiguous = is_contiguous(m),
+        .op = op,
+        .params = params,
+    };
+    run_elementwise(apply_op_body, &t);
 }
 
 void mat_print(const Matrix *m, unsigned int precision)
@@ -1338,7 +1750,7 @@ void mat_print_n_first(const Matrix *m, size_t n, unsigned int precision)
 
     for (size_t i = 0; i < n; ++i)
     {
-        printf(fmt, m->content[i]);
+        printf(fmt, *mat_unsafe_coef_ptr(m, i / m->width, i % m->width));
         printf("  ");
     }
     printf("\n");
@@ -1378,31 +1790,127 @@ void mat_display(const Matrix *m)
     }
 }
 
+/// @brief The header of a version 2 matrix file, followed by its coefficients
+/// (see `mat_save_to_fd_v2`). Its size keeps the coefficients aligned on
+/// MAT_ALIGNMENT bytes in a mapping of the file.
+typedef struct MatFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint32_t byte_order;
+    /// @brief The CRC-32 of the header (with a zero checksum) and of the
+    /// coefficients.
+    uint32_t checksum;
+    uint64_t height;
+    uint64_t width;
+    uint64_t stride;
+    /// @brief The offset in bytes of the coefficients from the start of the
+    /// file.
+    uint64_t payload_offset;
+    uint8_t reserved[8];
+} MatFileHeader;
+
+_Static_assert(sizeof(MatFileHeader) % MAT_ALIGNMENT == 0,
+               "The coefficients of a matrix file must stay aligned.");
+
+/// @brief The magic number of version 2 matrix files. As the first 8 bytes of
+/// a legacy file, it would be a height of more than 10^18.
+static const char MAT_FILE_MAGIC[8] = {'\x93', 'W', 'S', 'M', 'A', 'T', '\r', '\n'};
+#define MAT_FILE_VERSION 2
+/// @brief Little-endian IEEE 754 single-precision floats.
+#define MAT_FILE_FLOAT32 1
+/// @brief Written in the native byte order, so that files written by a machine
+/// of the other endianness are detected.
+#define MAT_FILE_BYTE_ORDER 0x01020304u
+
+/// @brief Checks the fields of a version 2 header and returns the size in
+/// bytes of its coefficients.
+static size_t check_file_header(const MatFileHeader *header)
+{
+    if (header->version != MAT_FILE_VERSION)
+        errx(EXIT_FAILURE, "Invalid file: unsupported matrix file version %u.",
+             header->version);
+    if (header->byte_order != MAT_FILE_BYTE_ORDER)
+        errx(EXIT_FAILURE, "Invalid file: the matrix file was written on a "
+                           "machine of another endianness.");
+    if (header->dtype != MAT_FILE_FLOAT32)
+        errx(EXIT_FAILURE, "Invalid file: unsupported matrix type %u.",
+             header->dtype);
+    if (header->payload_offset != sizeof(MatFileHeader))
+        errx(EXIT_FAILURE, "Invalid file: unexpected matrix payload offset.");
+    if (header->height == 0 || header->width == 0 ||
+        header->stride < header->width ||
+        header->height > SIZE_MAX / sizeof(float) / header->stride)
+        errx(EXIT_FAILURE, "Invalid file: invalid matrix shape %zux%zu (stride "
+                           "%zu).",
+             (size_t)header->height, (size_t)header->width,
+             (size_t)header->stride);
+
+    return header->height * header->stride * sizeof(float);
+}
+
+/// @brief Returns the checksum of a version 2 file from its header and its
+/// coefficients.
+static uint32_t file_checksum(const MatFileHeader *header, const float *payload,
+                              size_t payload_size)
+{
+    MatFileHeader copy = *header;
+    copy.checksum = 0;
+
+    uint32_t crc = crc32_update(0, &copy, sizeof(copy));
+    return crc32_update(crc, payload, payload_size);
+}
+
+/// @brief Reads the rest of a version 2 file whose magic number has been read.
+static Matrix *load_v2_from_fd(int fd)
+{
+    MatFileHeader header;
+    memcpy(header.magic, MAT_FILE_MAGIC, sizeof(MAT_FILE_MAGIC));
+    if (read_all(fd, (char *)&header + sizeof(MAT_FILE_MAGIC),
+                 sizeof(header) - sizeof(MAT_FILE_MAGIC)) != 0)
+        errx(EXIT_FAILURE, "Invalid file: failed to read matrix's header.");
+
+    size_t payload_size = check_file_header(&header);
+    Matrix *res = alloc_strided_matrix(header.height, header.width,
+                                       header.stride);
+
+    if (read_all(fd, res->content, payload_size) != 0)
+        errx(EXIT_FAILURE, "Invalid file: failed to read matrix's "
+                           "coefficients.");
+
+    if (file_checksum(&header, res->content, payload_size) != header.checksum)
+        errx(EXIT_FAILURE, "Invalid file: matrix checksum mismatch.");
+
+    return res;
+}
+
 Matrix *mat_load_from_fd(int fd)
 {
-    int r_out;
-    size_t height, width;
+    // A version 2 file starts with its magic number, a legacy one with its
+    // height.
+    union
+    {
+        char magic[8];
+        size_t height;
+    } first;
 
-    r_out = read(fd, &height, sizeof(size_t));
-    if (r_out != sizeof(size_t))
+    if (read_all(fd, &first, sizeof(first)) != 0)
         errx(EXIT_FAILURE, "Invalid file: failed to read matrix's height.");
 
-    r_out = read(fd, &width, sizeof(size_t));
-    if (r_out != sizeof(size_t))
+    if (memcmp(first.magic, MAT_FILE_MAGIC, sizeof(MAT_FILE_MAGIC)) == 0)
+        return load_v2_from_fd(fd);
+
+    size_t height = first.height, width;
+    if (read_all(fd, &width, sizeof(size_t)) != 0)
         errx(EXIT_FAILURE, "Invalid file: failed to read matrix's width.");
 
     Matrix *res = alloc_matrix(height, width);
 
     // Read the matrix content.
-    for (size_t i = 0; i < res->size; ++i)
-    {
-        r_out = read(fd, &res->content[i], sizeof(float));
-        if (r_out != sizeof(float))
-            errx(EXIT_FAILURE,
-                 "Invalid file: failed to read matrix's "
-                 "%zuth coefficient.",
-                 i);
-    }
+    if (read_all(fd, res->content, res->size * sizeof(float)) != 0)
+        errx(EXIT_FAILURE,
+             "Invalid file: failed to read matrix's coefficients.");
 
     return res;
 }
@@ -1430,31 +1938,24 @@ Matrix *mat_load_from_file(const char *filename)
 
 void mat_save_to_fd(const Matrix *m, int fd)
 {
-    int w_out;
-
-    w_out = write(fd, &m->height, sizeof(size_t));
-    if (w_out != sizeof(size_t))
-        errx(EXIT_FAILURE,
-             "Failed to write file: failed to write matrix's height.");
-
-    w_out = write(fd, &m->width, sizeof(size_t));
-    if (w_out != sizeof(size_t))
+    size_t shape[2] = {m->height, m->width};
+    if (write_all(fd, shape, sizeof(shape)) != 0)
         errx(EXIT_FAILURE,
-             "Failed to write file: failed to write matrix's width.");
+             "Failed to write file: failed to write matrix's shape.");
 
-    // Write the matrix content.
-    for (size_t h = 0; h < m->height; ++h)
+    // The rows are written without their padding, at once if they have none.
+    int failed;
+    if (is_contiguous(m))
+        failed = write_all(fd, m->content, m->size * sizeof(float));
+    else
     {
-        for (size_t w = 0; w < m->width; ++w)
-        {
-            w_out = write(fd, mat_unsafe_coef_ptr(m, h, w), sizeof(float));
-            if (w_out != sizeof(float))
-                errx(EXIT_FAILURE,
-                     "Failed to write file: failed to write matrix's "
-                     "coefficient at position (h:%zu, w:%zu).",
-                     h, w);
-        }
+        failed = 0;
+        for (size_t h = 0; h < m->height && !failed; ++h)
+            failed = write_all(fd, row_ptr(m, h), m->width * sizeof(float));
     }
+    if (failed)
+        errx(EXIT_FAILURE,
+             "Failed to write file: failed to write matrix's coefficients.");
 }
 
 void mat_save_to_file(const Matrix *m, const char *filename)
@@ -1473,11 +1974,132 @@ void mat_save_to_file(const Matrix *m, const char *filename)
     fclose(file_stream);
 }
 
-size_t mat_max_h(const Matrix *m)
+void mat_save_to_fd_v2(const Matrix *m, int fd)
+{
+    MatFileHeader header = {
+        .version = MAT_FILE_VERSION,
+        .dtype = MAT_FILE_FLOAT32,
+        .byte_order = MAT_FILE_BYTE_ORDER,
+        .height = m->height,
+        .width = m->width,
+        .stride = m->stride,
+        .payload_offset = sizeof(MatFileHeader),
+    };
+    memcpy(header.magic, MAT_FILE_MAGIC, sizeof(MAT_FILE_MAGIC));
+
+    // The padding of the rows is written as zeros, so that the checksum does
+    // not depend on it.
+    size_t payload_size = m->height * m->stride * sizeof(float);
+    float *payload = (float *)row_ptr(m, 0);
+    float *packed = NULL;
+    if (m->stride != m->width)
+    {
+        packed = calloc(m->height * m->stride, sizeof(float));
+        if (packed == NULL)
+            errx(EXIT_FAILURE, "Memory allocation failed.");
+        for (size_t h = 0; h < m->height; ++h)
+            memcpy(packed + h * m->stride, row_ptr(m, h),
+                   m->width * sizeof(float));
+        payload = packed;
+    }
+
+    header.checksum = file_checksum(&header, payload, payload_size);
+
+    if (write_all(fd, &header, sizeof(header)) != 0)
+        errx(EXIT_FAILURE,
+             "Failed to write file: failed to write matrix's header.");
+    if (write_all(fd, payload, payload_size) != 0)
+        errx(EXIT_FAILURE,
+             "Failed to write file: failed to write matrix's coefficients.");
+
+    free(packed);
+}
+
+void mat_save_to_file_v2(const Matrix *m, const char *filename)
 {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+
+    mat_save_to_fd_v2(m, fd);
+
+    close(fd);
+}
+
+Matrix *mat_mmap_file(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+        errx(EXIT_FAILURE, "Failed to stat file: %s", filename);
+
+    // Legacy files are not aligned, they are read into a new matrix.
+    char magic[sizeof(MAT_FILE_MAGIC)];
+    if ((size_t)st.st_size < sizeof(MatFileHeader) ||
+        read_all(fd, magic, sizeof(magic)) != 0 ||
+        memcmp(magic, MAT_FILE_MAGIC, sizeof(magic)) != 0)
+    {
+        close(fd);
+        return mat_load_from_file(filename);
+    }
+
+    void *mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        errx(EXIT_FAILURE, "Failed to map file: %s", filename);
+
+    const MatFileHeader *header = mapping;
+    size_t payload_size = check_file_header(header);
+    if (payload_size > (size_t)st.st_size - sizeof(MatFileHeader))
+        errx(EXIT_FAILURE, "Invalid file: %s is truncated.", filename);
+
+    float *payload = (float *)((char *)mapping + sizeof(MatFileHeader));
+    if (file_checksum(header, payload, payload_size) != header->checksum)
+        errx(EXIT_FAILURE, "Invalid file: matrix checksum mismatch in %s.",
+             filename);
+
+    Matrix *m = malloc(sizeof(Matrix));
+    if (m == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    m->height = header->height;
+    m->width = header->width;
+    m->size = m->height * m->width;
+    m->stride = header->stride;
+    m->content = payload;
+    m->mapping = mapping;
+    m->mapping_size = st.st_size;
+    m->capacity = m->height * m->stride;
+
+    return m;
+}
+
+size_t mat_max_h(const Matrix *m) { return mat_view_max_h(mat_view(m)); }
+
+size_t mat_view_max_h(MatView v)
+{
+    if (v.height == 0 || v.width == 0)
+        errx(EXIT_FAILURE, "Cannot find the maximum of an empty view.");
+
+    // A column whose rows are contiguous, unlike a column resized from a wider
+    // matrix or a column of a wider view.
+    if (v.width == 1 && is_contiguous_view(v))
+    {
+        // The first row holding the maximum, found with the SIMD maximum.
+        float max = mat_kernels->max(v.content, v.height);
+        size_t max_h = 0;
+        while (max_h + 1 < v.height && v.content[max_h] != max)
+            max_h++;
+        return max_h;
+    }
+
     size_t max_h = 0;
-    for (size_t h = 1; h < m->height; ++h)
-        if (*mat_unsafe_coef_ptr(m, h, 0) > *mat_unsafe_coef_ptr(m, max_h, 0))
+    for (size_t h = 1; h < v.height; ++h)
+        if (mat_view_coef(v, h, 0) > mat_view_coef(v, max_h, 0))
             max_h = h;
 
     return max_h;
@@ -3,9 +3,74 @@
 
 #include <stdlib.h>
 
+/// @brief The alignment in bytes of the content of every matrix. It is the
+/// size of a cache line and of an AVX-512 vector.
+#define MAT_ALIGNMENT 64
+
 /// @brief A 2D matrix of single-precision floating point numbers.
 typedef struct Matrix Matrix;
 
+/// @brief A non-owning, read-only view of a rectangle of a matrix, e.g. a crop
+/// or a grid cell of an image. Views are small values meant to be passed by
+/// copy. They are only valid as long as the viewed matrix is, and they cannot
+/// be freed.
+typedef struct MatView
+{
+    /// @brief The coefficient at the top-left corner of the view.
+    const float *content;
+    /// @brief Number of rows of the view (may be 0 for an empty view).
+    size_t height;
+    /// @brief Number of columns of the view (may be 0 for an empty view).
+    size_t width;
+    /// @brief Number of floats between the starts of two consecutive rows.
+    size_t stride;
+} MatView;
+
+/// @brief The built-in element-wise operations of `mat_apply`, computed by SIMD
+/// kernels instead of a function call per coefficient.
+typedef enum MatOp
+{
+    /// @brief 1 / (1 + exp(-x)).
+    MAT_OP_SIGMOID,
+    /// @brief max(x, 0).
+    MAT_OP_RELU,
+    /// @brief tanh(x).
+    MAT_OP_TANH,
+    /// @brief min(max(x, low), high).
+    MAT_OP_CLAMP,
+    /// @brief high if x > threshold, low otherwise.
+    MAT_OP_THRESHOLD,
+} MatOp;
+
+/// @brief The parameters of a MatOp. The operations without parameters ignore
+/// them.
+typedef struct MatOpParams
+{
+    float low;
+    float high;
+    float threshold;
+} MatOpParams;
+
+/// @brief Returns the coefficient of a view at the given position, without
+/// bounds checking.
+/// @param[in] v The view.
+/// @param[in] h Row index.
+/// @param[in] w Column index.
+/// @return The coefficient at (h, w) in the view.
+static inline float mat_view_coef(MatView v, size_t h, size_t w)
+{
+    return v.content[h * v.stride + w];
+}
+
+/// @brief Returns a pointer to the first coefficient of a row of a view.
+/// @param[in] v The view.
+/// @param[in] h Row index.
+/// @return A pointer to the width coefficients of the row.
+static inline const float *mat_view_row(MatView v, size_t h)
+{
+    return v.content + h * v.stride;
+}
+
 /// @brief Returns the height (number of rows) of the given matrix.
 /// @param[in] m Pointer to the matrix.
 /// @return The number of rows in the matrix.
@@ -16,6 +81,13 @@ size_t mat_height(const Matrix *m);
 /// @return The number of columns in the matrix.
 size_t mat_width(const Matrix *m);
 
+/// @brief Returns the stride (leading dimension) of the given matrix, i.e. the
+/// number of floats between the starts of two consecutive rows. It is equal to
+/// the width unless the matrix has padded rows (see `mat_create_padded`).
+/// @param[in] m Pointer to the matrix.
+/// @return The stride of the matrix.
+size_t mat_stride(const Matrix *m);
+
 Matrix *mat_create(size_t height, size_t width);
 
 /// @brief Creates an empty matrix (initialized with zeros) on the heap.
@@ -26,6 +98,20 @@ Matrix *mat_create(size_t height, size_t width);
 /// allocation fails.
 Matrix *mat_create_zero(size_t height, size_t width);
 
+/// @brief Creates a zero-filled matrix whose rows are padded to a multiple of
+/// MAT_ALIGNMENT bytes, so that every row starts on a cache line and the SIMD
+/// kernels can use aligned loads on each of them. Column vectors are not
+/// padded. Results of element-wise operations on a padded matrix are padded
+/// too.
+/// @param[in] height Number of rows in the new matrix (must be non-zero).
+/// @param[in] width Number of columns in the new matrix (must be non-zero).
+/// @return A pointer to a newly allocated zero-filled matrix.
+/// @throw Terminates the program if height or width is zero, or if memory
+/// allocation fails.
+/// @note Rows are not contiguous: a pointer to a coefficient can only be used
+/// to access the rest of its row, see `mat_stride`.
+Matrix *mat_create_padded(size_t height, size_t width);
+
 /// @brief Creates a  matrix initialized with teh given value on the heap.
 /// @param[in] height Number of rows in the new matrix (must be non-zero).
 /// @param[in] width Number of columns in the new matrix (must be non-zero).
@@ -46,6 +132,21 @@ Matrix *mat_create_filled(size_t height, size_t width, float value);
 /// fails.
 Matrix *mat_create_from_arr(size_t height, size_t width, const float *content);
 
+/// @brief Creates a matrix whose coefficients are an existing array, e.g. a
+/// blob of a mapped file, without copying them. `mat_free` only frees the
+/// structure: the array must outlive the matrix and is freed by its owner.
+/// @param[in] height Number of rows in the matrix (must be non-zero).
+/// @param[in] width Number of columns in the matrix (must be non-zero).
+/// @param[in] stride Number of floats between the starts of two consecutive
+/// rows (at least width).
+/// @param[in] content Pointer to a MAT_ALIGNMENT-aligned row-major array of
+/// height × stride floats.
+/// @return A pointer to the new matrix structure.
+/// @throw Terminates the program if the shape is invalid, content is not
+/// aligned, or memory allocation fails.
+Matrix *mat_create_borrowed(size_t height, size_t width, size_t stride,
+                            float *content);
+
 /// @brief Creates a new matrix filled with uniformly distributed random values.
 /// Allocates a new matrix of size @p height × @p width, where each element is
 /// independently sampled from a uniform distribution in the range [`min`,
@@ -89,7 +190,8 @@ Matrix *mat_create_random_gaussian(size_t height, size_t width);
 Matrix *mat_create_random_normal(size_t height, size_t width, float mean,
                                  float stddev);
 
-/// @brief Frees a matrix and its associated memory.
+/// @brief Frees a matrix and its associated memory. A matrix created in an
+/// arena is given back to the pool of that arena (see arena.h).
 /// @param[in] matrix Pointer to the matrix to be freed.
 void mat_free(Matrix *matrix);
 
@@ -117,6 +219,49 @@ int mat_eq(Matrix *a, Matrix *b, float epsilon);
 /// @throw Terminates the program if memory allocation fails.
 Matrix *mat_deepcopy(const Matrix *src);
 
+/// @brief Copies the coefficients of a matrix into another matrix of the same
+/// shape, without allocating.
+/// @param[out] dst Pointer to the destination matrix.
+/// @param[in] src Pointer to the matrix to copy.
+/// @throw Terminates the program if the shapes mismatch.
+void mat_copy(Matrix *dst, const Matrix *src);
+
+/// @brief Changes the shape of a matrix in place, without moving or allocating
+/// anything: the rows keep their stride, so that the coefficients of the
+/// rectangle common to both shapes are kept. It lets a buffer created for the
+/// largest shape hold smaller ones, e.g. a batch of fewer samples.
+/// @param[in, out] m Pointer to the matrix.
+/// @param[in] height The new number of rows (must be non-zero).
+/// @param[in] width The new number of columns, at most the stride of m (must
+/// be non-zero).
+/// @throw Terminates the program if the shape is empty or if it does not fit
+/// in the coefficients of m.
+/// @note A matrix narrower than its stride has padded rows, see `mat_stride`.
+void mat_resize(Matrix *m, size_t height, size_t width);
+
+/// @brief Returns a view of a whole matrix.
+/// @param[in] m Pointer to the matrix.
+/// @return A view of every coefficient of m.
+MatView mat_view(const Matrix *m);
+
+/// @brief Returns a view of a rectangle of a view, without copying anything.
+/// @param[in] v The view.
+/// @param[in] h Row index of the top-left corner of the rectangle.
+/// @param[in] w Column index of the top-left corner of the rectangle.
+/// @param[in] height Number of rows of the rectangle.
+/// @param[in] width Number of columns of the rectangle.
+/// @return The view of the rectangle.
+/// @throw Terminates the program if the rectangle is not inside v.
+MatView mat_subview(MatView v, size_t h, size_t w, size_t height,
+                    size_t width);
+
+/// @brief Copies the coefficients of a view into a new matrix.
+/// @param[in] v The view to copy. It must not be empty.
+/// @return A new matrix with the shape and the coefficients of the view.
+/// @throw Terminates the program if the view is empty or if memory allocation
+/// fails.
+Matrix *mat_create_from_view(MatView v);
+
 /// @brief For internal use. More efficient because it does not check for valid
 /// parameters.
 /// @param[in] m Pointer to the matrix.
@@ -156,6 +301,44 @@ Matrix *mat_addition(const Matrix *a, const Matrix *b);
 /// @throw Terminates the program if the matrices have mismatched dimensions.
 void mat_inplace_addition(Matrix *a, const Matrix *b);
 
+/// @brief Adds a column matrix to every column of a matrix, e.g. the biases of
+/// a layer to the pre-activations of a batch of samples.
+/// @param[in, out] m Pointer to the matrix to add to.
+/// @param[in] column Pointer to the column matrix (of the height of m).
+/// @throw Terminates the program if the dimensions mismatch.
+void mat_inplace_add_column(Matrix *m, const Matrix *column);
+
+/// @brief Adds rows of a matrix to a vector. With the rows of the transposed
+/// weights of a layer, it is the product of the weights by a binary input
+/// given by the indices of its ones.
+/// @param[in, out] dst Pointer to the row or column matrix of m->width
+/// coefficients to add to.
+/// @param[in] m Pointer to the matrix whose rows are added.
+/// @param[in] indices Array of count row indices of m (repetitions allowed).
+/// @param[in] count The number of rows to add.
+/// @throw Terminates the program if the dimensions mismatch or if an index is
+/// out of bounds.
+void mat_add_rows(Matrix *dst, const Matrix *m, const size_t *indices,
+                  size_t count);
+
+/// @brief Lists the ones of a binary matrix, e.g. the active pixels of an
+/// image.
+/// @param[in] m Pointer to the matrix.
+/// @param[out] indices Array of at least height × width elements receiving the
+/// row-major indices of the coefficients equal to 1, in increasing order.
+/// @param[out] count The number of ones.
+/// @return 1 if every coefficient of m is 0 or 1, 0 otherwise (indices and
+/// count are then meaningless).
+int mat_binary_indices(const Matrix *m, size_t *indices, size_t *count);
+
+/// @brief Copies column matrices into the columns of a matrix, e.g. to gather
+/// samples into a batch.
+/// @param[in, out] m Pointer to the matrix.
+/// @param[in] columns Array of the width of m of column matrices (of the height
+/// of m).
+/// @throw Terminates the program if the dimensions mismatch.
+void mat_set_columns(Matrix *m, const Matrix *const *columns);
+
 /// @brief Computes the element-wise subtraction of two matrices.
 /// @param[in] a Pointer to the first Matrix (minuend).
 /// @param[in] b Pointer to the second Matrix (subtrahend).
@@ -189,6 +372,58 @@ void mat_inplace_scalar_multiplication(Matrix *m, float a);
 /// fails.
 Matrix *mat_multiplication(const Matrix *a, const Matrix *b);
 
+/// @brief Computes the matrix product of two matrices into an existing matrix.
+/// @param[out] dst Pointer to the a->height×b->width matrix receiving A × B.
+/// It must not share its coefficients with a or b.
+/// @param[in] a Pointer to the left matrix (A).
+/// @param[in] b Pointer to the right matrix (B).
+/// @throw Terminates the program if a->width != b->height or if dst does not
+/// have the shape of the product.
+void mat_multiplication_into(Matrix *dst, const Matrix *a, const Matrix *b);
+
+/// @brief Computes the product of a matrix and a column matrix. It is faster
+/// than `mat_multiplication` for this shape.
+/// @param[in] m Pointer to the matrix.
+/// @param[in] x Pointer to the column matrix (its height must be the width of
+/// m).
+/// @return A new column matrix representing m × x.
+/// @throw Terminates the program if x is not a column matrix, if the dimensions
+/// mismatch or if memory allocation fails.
+/// @note A column with padded rows, e.g. resized from a wider matrix, is first
+/// copied to a contiguous one.
+Matrix *mat_gemv(const Matrix *m, const Matrix *x);
+
+/// @brief Computes the product of a matrix and a column matrix and adds a bias
+/// column matrix to it, in a single pass.
+/// @param[in] m Pointer to the matrix.
+/// @param[in] x Pointer to the column matrix (its height must be the width of
+/// m).
+/// @param[in] bias Pointer to the bias column matrix (its height must be the
+/// height of m).
+/// @return A new column matrix representing m × x + bias.
+/// @throw Terminates the program if x or bias are not column matrices, if the
+/// dimensions mismatch or if memory allocation fails.
+Matrix *mat_gemv_add_bias(const Matrix *m, const Matrix *x,
+                          const Matrix *bias);
+
+/// @brief Computes the pre-activation and the ReLU activation of a dense layer
+/// in a single pass and without allocating: pre = m × x + bias and act =
+/// relu(pre).
+/// @param[in] m Pointer to the weight matrix.
+/// @param[in] x Pointer to the input column matrix (its height must be the
+/// width of m).
+/// @param[in] bias Pointer to the bias column matrix (its height must be the
+/// height of m).
+/// @param[out] pre Pointer to a column matrix of the height of m that receives
+/// m × x + bias.
+/// @param[out] act Pointer to a column matrix of the height of m that receives
+/// relu(pre), or NULL to only compute pre. It may be pre itself.
+/// @throw Terminates the program if the dimensions mismatch.
+/// @note Columns with padded rows, e.g. resized from wider matrices, go
+/// through contiguous copies.
+void mat_dense_relu(const Matrix *m, const Matrix *x, const Matrix *bias,
+                    Matrix *pre, Matrix *act);
+
 /// @brief Computes the Hadamard (element-wise) product of two matrices.
 /// @param[in] a Pointer to the first Matrix.
 /// @param[in] b Pointer to the second Matrix.
@@ -231,8 +466,42 @@ void mat_inplace_relu_derivative(Matrix *m);
 
 Matrix *mat_relu_derivative(Matrix *m);
 
+/// @brief Computes the softmax of a matrix, i.e. exp(m) / sum(exp(m)), in a
+/// single allocation.
+/// @param[in] m Pointer to the matrix.
+/// @return A new matrix whose coefficients are positive and sum to 1.
+/// @throw Terminates the program if memory allocation fails.
+/// @note The exponentials are computed with the accuracy of `mat_exp`.
+Matrix *mat_softmax(const Matrix *m);
+
+/// @brief Computes the softmax of a matrix in place (see `mat_softmax`).
+/// @param[in, out] m Pointer to the matrix.
 void mat_inplace_softmax(Matrix *m);
 
+/// @brief Replaces every row of a matrix by its softmax. Each row gives the
+/// same result as `mat_inplace_softmax` on a row matrix.
+/// @param[in, out] m Pointer to the matrix.
+void mat_inplace_row_softmax(Matrix *m);
+
+/// @brief Replaces every column of a matrix by its softmax, e.g. the outputs of
+/// a batch of samples by their probabilities. Each column gives the same
+/// result as `mat_inplace_softmax` on a column matrix.
+/// @param[in, out] m Pointer to the matrix.
+void mat_inplace_column_softmax(Matrix *m);
+
+/// @brief Computes the element-wise exponential of a matrix with a SIMD
+/// polynomial approximation. The error is at most 1 ulp for inputs in
+/// ]-87.33, 88]. Smaller inputs give 0 and larger ones exp(88).
+/// @param[in] m Pointer to the matrix.
+/// @return A new matrix of the exponentials of the coefficients of m.
+/// @throw Terminates the program if memory allocation fails.
+Matrix *mat_exp(const Matrix *m);
+
+/// @brief Computes the element-wise exponential of a matrix in place (see
+/// `mat_exp`).
+/// @param[in, out] m Pointer to the matrix.
+void mat_inplace_exp(Matrix *m);
+
 void mat_inplace_toggle(Matrix *m);
 
 /// @brief Strips zeros around the matrix.
@@ -240,8 +509,24 @@ void mat_inplace_toggle(Matrix *m);
 /// @return A new heap allocated matrix.
 Matrix *mat_strip_margins(const Matrix *m);
 
+/// @brief Returns the smallest sub-view of a view containing all of its
+/// activated coefficients (greater than 0.5), without copying anything.
+/// @param[in] v The view to strip the zeros from.
+/// @return The stripped view, or an empty view (of height and width 0) if no
+/// coefficient is activated.
+MatView mat_view_strip_margins(MatView v);
+
 Matrix *mat_scale_to_28(const Matrix *m, float fill_value);
 
+/// @brief Scales a view to a 28×28 matrix with bilinear interpolation, keeping
+/// its aspect ratio. The uncovered coefficients are set to fill_value.
+/// @param[in] v The view to scale. It must not be empty.
+/// @param[in] fill_value The value of the coefficients outside of the scaled
+/// view.
+/// @return A new 28×28 matrix.
+/// @throw Terminates the program if the view is empty.
+Matrix *mat_view_scale_to_28(MatView v, float fill_value);
+
 void mat_inplace_to_one_hot(Matrix *m);
 
 // /// @brief Computes the mean squared error (MSE) between two matrices.
@@ -252,19 +537,29 @@ void mat_inplace_to_one_hot(Matrix *m);
 // /// dimensions.
 // float mat_mean_squared_error(Matrix *actual, Matrix *expected);
 
-/// @brief Returns the transpose of a matrix as a new matrix.
+/// @brief Returns the transpose of a matrix as a new matrix. It is computed by
+/// cache-sized blocks of SIMD tiles, and contiguous vectors are simply copied.
 /// @param[in] m Pointer to the input Matrix.
 /// @return Pointer to a newly allocated Matrix containing the transpose of m.
 /// @throw Exits the program if memory allocation for the result fails.
 Matrix *mat_transpose(const Matrix *m);
 
-// /// @brief Transposes a matrix in-place. Supports both square and non-square
-// /// matrices.
-// /// @param[in, out] m Pointer to the Matrix to be transposed in-place.
-// /// @throw None. The function assumes the matrix pointer is valid and memory
-// is
-// /// properly allocated.
-// void mat_inplace_transpose(Matrix *m);
+/// @brief Transposes a matrix into an existing matrix.
+/// @param[out] dst Pointer to the m->width×m->height matrix receiving the
+/// transpose. It must not share its coefficients with m.
+/// @param[in] m Pointer to the input Matrix.
+/// @throw Exits the program if dst does not have the shape of the transpose.
+void mat_transpose_into(Matrix *dst, const Matrix *m);
+
+/// @brief Transposes a matrix in-place. Square matrices are transposed by
+/// pairs of tiles and keep their stride. The coefficients of other matrices
+/// are moved along the cycles of the permutation, after their padded rows (if
+/// any) have been packed together: the result is never padded. Vectors are
+/// only reshaped.
+/// @param[in, out] m Pointer to the Matrix to be transposed in-place.
+/// @throw Terminates the program if memory allocation fails (non-square
+/// matrices need a temporary bitset of one bit per coefficient).
+void mat_inplace_transpose(Matrix *m);
 
 // /// @brief Creates a flattened (1×N) copy of the given matrix (row vector).
 // /// @param[in] m Pointer to the input matrix.
@@ -286,6 +581,50 @@ void mat_inplace_vertical_flatten(Matrix *m);
 // /// @param[in, out] m Pointer to the Matrix to be flattened.
 // void mat_inplace_horizontal_flatten(Matrix *m);
 
+/// @brief Returns the sum of the coefficients of a matrix.
+/// @param[in] m Pointer to the matrix.
+/// @return The sum of the coefficients.
+float mat_sum(const Matrix *m);
+
+/// @brief Returns the sum of the coefficients of a view, e.g. the ink of a
+/// crop, without copying it.
+/// @param[in] v The view.
+/// @return The sum of the coefficients, 0 for an empty view.
+float mat_view_sum(MatView v);
+
+/// @brief Sums the columns of a matrix, i.e. the coefficients of each of its
+/// rows.
+/// @param[out] dst Pointer to the m->height×1 column receiving the sums.
+/// @param[in] m Pointer to the matrix.
+/// @throw Exits the program if dst is not a column of the height of m.
+void mat_sum_columns(Matrix *dst, const Matrix *m);
+
+/// @brief Returns the greatest coefficient of a matrix.
+/// @param[in] m Pointer to the matrix.
+/// @return The maximum of the coefficients.
+float mat_max(const Matrix *m);
+
+/// @brief Returns the greatest coefficient of a view.
+/// @param[in] v The view.
+/// @return The maximum of the coefficients.
+/// @throw Terminates the program if the view is empty.
+float mat_view_max(MatView v);
+
+/// @brief Computes the mean and the (population) standard deviation of the
+/// coefficients of a matrix.
+/// @param[in] m Pointer to the matrix.
+/// @param[out] mean_out Receives the mean if not NULL.
+/// @param[out] stddev_out Receives the standard deviation if not NULL.
+void mat_mean_stddev(const Matrix *m, float *mean_out, float *stddev_out);
+
+/// @brief Computes the mean and the (population) standard deviation of the
+/// coefficients of a view (see `mat_mean_stddev`).
+/// @param[in] v The view.
+/// @param[out] mean_out Receives the mean if not NULL.
+/// @param[out] stddev_out Receives the standard deviation if not NULL.
+/// @throw Terminates the program if the view is empty.
+void mat_view_mean_stddev(MatView v, float *mean_out, float *stddev_out);
+
 /// @brief Normalizes a matrix so that the sum of all its elements equals 1.
 /// @param[in] m Pointer to the input Matrix to be normalized.
 /// @return Pointer to a newly allocated Matrix containing the normalized
@@ -300,7 +639,9 @@ Matrix *mat_normalize(const Matrix *m);
 /// @note If the sum of elements is 0, this will cause division by zero.
 void mat_inplace_normalize(Matrix *m);
 
-/// @brief Applies a user-defined function element-wise to a matrix.
+/// @brief Applies a user-defined function element-wise to a matrix. The rows
+/// are shared by the threads of the matrix thread pool (see `parallel.h`), so
+/// f may be called concurrently and must not have side effects.
 /// @param[in] m Pointer to the input matrix.
 /// @param[in] f Function pointer taking a float and returning a float.
 /// @return A new matrix where each element is f(original_element).
@@ -312,11 +653,11 @@ Matrix *mat_map(const Matrix *m, float (*f)(float));
 /// @param[in] f A pointer to a function that takes a float and returns a
 /// float.
 /// @note This function directly modifies the contents of m.
-/// No new memory is allocated.
+/// No new memory is allocated. Like `mat_map`, f may be called concurrently.
 void mat_inplace_map(Matrix *m, float (*f)(float));
 
 /// @brief Applies a user-defined function element-wise to a matrix, with access
-/// to element indexes.
+/// to element indexes. Like `mat_map`, f may be called concurrently.
 /// @param[in] m Pointer to the input matrix.
 /// @param[in] f Function pointer taking (value, row_index, column_index) and
 /// returning a float.
@@ -336,9 +677,30 @@ Matrix *mat_map_with_indexes(const Matrix *m,
 /// store at that position. Signature: `float f(float value, size_t h, size_t
 /// w)`.
 /// @note This function modifies @p m directly and does not allocate new memory.
-/// Useful for applying coordinate-dependent transformations.
+/// Useful for applying coordinate-dependent transformations. Like `mat_map`,
+/// @p f may be called concurrently.
 void mat_inplace_map_with_indexes(Matrix *m, float (*f)(float, size_t, size_t));
 
+/// @brief Applies a built-in operation element-wise to a matrix. It gives the
+/// same results as `mat_map` with the matching scalar function, within the
+/// accuracy of the kernels (see `matrix/kernels.h`), several times faster.
+/// @param[in] m Pointer to the input matrix.
+/// @param[in] op The operation.
+/// @param[in] params The parameters of the operation.
+/// @return A new matrix where each element is op(original_element).
+/// @throw Terminates the program if op is unknown, if low > high for
+/// MAT_OP_CLAMP, or if memory allocation fails.
+Matrix *mat_apply(const Matrix *m, MatOp op, MatOpParams params);
+
+/// @brief Applies a built-in operation element-wise to a matrix in-place, see
+/// `mat_apply`.
+/// @param[in,out] m The matrix whose elements will be modified in place.
+/// @param[in] op The operation.
+/// @param[in] params The parameters of the operation.
+/// @throw Terminates the program if op is unknown or if low > high for
+/// MAT_OP_CLAMP.
+void mat_inplace_apply(Matrix *m, MatOp op, MatOpParams params);
+
 /// @brief Prints the contents of a matrix to stdout in a formatted 2D layout.
 /// @param[in] m Pointer to the matrix to print.
 /// @param[in] precision Number of decimal places to display for each element.
@@ -349,14 +711,57 @@ void mat_print_n_first(const Matrix *m, size_t n, unsigned int precision);
 
 void mat_display(const Matrix *m);
 
+/// @brief Reads a matrix from a file descriptor, in either the legacy format
+/// written by `mat_save_to_fd` or the version 2 format written by
+/// `mat_save_to_fd_v2`, whose checksum is verified.
+/// @param[in] fd The file descriptor to read from.
+/// @return A pointer to the newly allocated matrix.
+/// @throw Terminates the program if the file is truncated or invalid.
 Matrix *mat_load_from_fd(int fd);
 
 Matrix *mat_load_from_file(const char *filename);
 
+/// @brief Writes a matrix in the legacy format: its height and width as
+/// size_t, then its coefficients row by row, without padding.
 void mat_save_to_fd(const Matrix *m, int fd);
 
 void mat_save_to_file(const Matrix *m, const char *filename);
 
+/// @brief Writes a matrix in the version 2 format: a 64-byte header (magic
+/// number, version, element type, byte order, CRC-32, height, width, stride
+/// and payload offset) followed by the height × stride coefficients, the
+/// padding of the rows written as zeros. The coefficients are aligned on
+/// MAT_ALIGNMENT bytes in the file so that it can be mapped by
+/// `mat_mmap_file`.
+/// @param[in] m The matrix to write.
+/// @param[in] fd The file descriptor to write to.
+/// @throw Terminates the program if a write fails.
+void mat_save_to_fd_v2(const Matrix *m, int fd);
+
+void mat_save_to_file_v2(const Matrix *m, const char *filename);
+
+/// @brief Maps a version 2 matrix file in memory and returns a matrix whose
+/// coefficients are those of the mapping, without copying them. The mapping is
+/// private: modifying the matrix never modifies the file. It is unmapped by
+/// `mat_free`. Legacy files cannot be mapped and are read by
+/// `mat_load_from_file` instead.
+/// @param[in] filename The path of the file.
+/// @return A pointer to the matrix.
+/// @throw Terminates the program if the file cannot be mapped, is truncated,
+/// or its checksum does not match.
+Matrix *mat_mmap_file(const char *filename);
+
+/// @brief Returns the index of the first row holding the greatest coefficient
+/// of the first column of a matrix, e.g. the class predicted by a network.
+/// @param[in] m Pointer to the matrix.
+/// @return The row index of the maximum.
 size_t mat_max_h(const Matrix *m);
 
+/// @brief Returns the index of the first row holding the greatest coefficient
+/// of the first column of a view (see `mat_max_h`).
+/// @param[in] v The view.
+/// @return The row index of the maximum.
+/// @throw Terminates the program if the view is empty.
+size_t mat_view_max_h(MatView v);
+
 #endif
@@ -0,0 +1,154 @@
+#include <err.h>
+#include <math.h>
+#include <string.h>
+
+#include "arena.h"
+#include "kernels.h"
+#include "matrix_s8.h"
+
+/// @brief A 2D matrix of signed bytes with a scale per row.
+struct MatS8
+{
+    /// @brief Number of rows (height) of the matrix.
+    size_t height;
+    /// @brief Number of columns (width) of the matrix.
+    size_t width;
+    /// @brief Number of bytes between the starts of two consecutive rows, a
+    /// multiple of MAT_ALIGNMENT.
+    size_t stride;
+    /// @brief The matrix elements stored in a MAT_ALIGNMENT-aligned row-major
+    /// array of height × stride bytes.
+    int8_t *content;
+    /// @brief The height scales of the rows, after the coefficients.
+    float *scales;
+};
+
+/// @brief The offset in bytes of the coefficients of a matrix from its
+/// structure, which precedes them in the same block.
+#define CONTENT_OFFSET                                                         \
+    ((sizeof(MatS8) + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT)
+
+static MatS8 *alloc_matrix_s8(size_t height, size_t width)
+{
+    if (height == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create signed byte matrix: invalid height '%zu'. "
+             "Height must be non-zero.",
+             height);
+    if (width == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create signed byte matrix: invalid width '%zu'. Width "
+             "must be non-zero.",
+             width);
+
+    size_t stride = (width + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT;
+    MatS8 *m = mat_block_alloc(CONTENT_OFFSET + height * stride +
+                               height * sizeof(float));
+
+    m->height = height;
+    m->width = width;
+    m->stride = stride;
+    m->content = (int8_t *)((char *)m + CONTENT_OFFSET);
+    m->scales = (float *)((char *)m->content + height * stride);
+
+    return m;
+}
+
+size_t mat_s8_height(const MatS8 *m) { return m->height; }
+
+size_t mat_s8_width(const MatS8 *m) { return m->width; }
+
+MatS8 *mat_s8_create(size_t height, size_t width)
+{
+    MatS8 *m = alloc_matrix_s8(height, width);
+    memset(m->content, 0, height * m->stride);
+    for (size_t h = 0; h < height; h++)
+        m->scales[h] = 1.0f;
+    return m;
+}
+
+void mat_s8_free(MatS8 *m) { mat_block_free(m); }
+
+int8_t *mat_s8_row(const MatS8 *m, size_t h)
+{
+    if (h >= m->height)
+        errx(EXIT_FAILURE,
+             "Failed to get row: index '%zu' out of bounds for a signed byte "
+             "matrix of height '%zu'.",
+             h, m->height);
+
+    return m->content + h * m->stride;
+}
+
+float *mat_s8_scales(const MatS8 *m) { return m->scales; }
+
+MatS8 *mat_s8_quantize(const Matrix *src)
+{
+    size_t height = mat_height(src);
+    size_t width = mat_width(src);
+    MatS8 *dst = mat_s8_create(height, width);
+
+    for (size_t h = 0; h < height; h++)
+    {
+        const float *src_row = mat_coef_ptr(src, h, 0);
+        int8_t *dst_row = dst->content + h * dst->stride;
+
+        float max = 0.0f;
+        for (size_t w = 0; w < width; w++)
+            max = fmaxf(max, fabsf(src_row[w]));
+        // A zero row keeps a scale of 1.
+        if (max == 0.0f)
+            continue;
+
+        float scale = max / MAT_S8_MAX;
+        dst->scales[h] = scale;
+        for (size_t w = 0; w < width; w++)
+        {
+            float v = roundf(src_row[w] / scale);
+            dst_row[w] = (int8_t)fminf(fmaxf(v, -MAT_S8_MAX), MAT_S8_MAX);
+        }
+    }
+
+    return dst;
+}
+
+Matrix *mat_s8_to_matrix(const MatS8 *src)
+{
+    Matrix *dst = mat_create(src->height, src->width);
+
+    for (size_t h = 0; h < src->height; h++)
+    {
+        const int8_t *src_row = src->content + h * src->stride;
+        float *dst_row = mat_coef_ptr(dst, h, 0);
+        for (size_t w = 0; w < src->width; w++)
+            dst_row[w] = src->scales[h] * src_row[w];
+    }
+
+    return dst;
+}
+
+float mat_s8_quantize_input(uint8_t *dst, const float *x, size_t n)
+{
+    float max = n > 0 ? mat_kernels->max(x, n) : 0.0f;
+    if (max <= 0.0f)
+    {
+        memset(dst, 0, n);
+        return 0.0f;
+    }
+
+    mat_kernels->quantize_u8(dst, x, MAT_S8_MAX / max, n);
+
+    return max / MAT_S8_MAX;
+}
+
+void mat_s8_gemv(const MatS8 *a, const uint8_t *x, int32_t *y)
+{
+    // The rows are padded with zeros: with x padded the same way, the product
+    // runs over whole vectors, without remainders.
+    _Alignas(MAT_ALIGNMENT) uint8_t padded[a->stride];
+    memcpy(padded, x, a->width);
+    memset(padded + a->width, 0, a->stride - a->width);
+
+    mat_kernels->gemv_s8(a->height, a->stride, a->content, a->stride, padded,
+                         y);
+}
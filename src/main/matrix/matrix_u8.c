@@ -0,0 +1,287 @@
+#include <err.h>
+#include <math.h>
+#include <string.h>
+
+#include "arena.h"
+#include "matrix_u8.h"
+
+/// @brief A 2D matrix of bytes.
+struct MatU8
+{
+    /// @brief Number of rows (height) of the matrix.
+    size_t height;
+    /// @brief Number of columns (width) of the matrix.
+    size_t width;
+    /// @brief Number of bytes between the starts of two consecutive rows, a
+    /// multiple of MAT_ALIGNMENT.
+    size_t stride;
+    /// @brief The matrix elements stored in a MAT_ALIGNMENT-aligned row-major
+    /// array of height × stride bytes.
+    uint8_t *content;
+};
+
+/// @brief The offset in bytes of the coefficients of a matrix from its
+/// structure, which precedes them in the same block.
+#define CONTENT_OFFSET                                                         \
+    ((sizeof(MatU8) + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT)
+
+static MatU8 *alloc_matrix_u8(size_t height, size_t width)
+{
+    if (height == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create byte matrix: invalid height '%zu'. Height must "
+             "be non-zero.",
+             height);
+    if (width == 0)
+        errx(EXIT_FAILURE,
+             "Failed to create byte matrix: invalid width '%zu'. Width must be "
+             "non-zero.",
+             width);
+
+    size_t stride = (width + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT;
+    MatU8 *m = mat_block_alloc(CONTENT_OFFSET + height * stride);
+
+    m->height = height;
+    m->width = width;
+    m->stride = stride;
+    m->content = (uint8_t *)m + CONTENT_OFFSET;
+
+    return m;
+}
+
+size_t mat_u8_height(const MatU8 *m) { return m->height; }
+
+size_t mat_u8_width(const MatU8 *m) { return m->width; }
+
+size_t mat_u8_stride(const MatU8 *m) { return m->stride; }
+
+MatU8 *mat_u8_create(size_t height, size_t width)
+{
+    MatU8 *m = alloc_matrix_u8(height, width);
+    memset(m->content, 0, height * m->stride);
+    return m;
+}
+
+MatU8 *mat_u8_create_filled(size_t height, size_t width, uint8_t value)
+{
+    MatU8 *m = alloc_matrix_u8(height, width);
+    memset(m->content, value, height * m->stride);
+    return m;
+}
+
+void mat_u8_free(MatU8 *m) { mat_block_free(m); }
+
+uint8_t *mat_u8_row(const MatU8 *m, size_t h)
+{
+    if (h >= m->height)
+        errx(EXIT_FAILURE,
+             "Failed to get row: index '%zu' out of bounds for a byte matrix "
+             "of height '%zu'.",
+             h, m->height);
+
+    return m->content + h * m->stride;
+}
+
+uint8_t *mat_u8_coef_ptr(const MatU8 *m, size_t h, size_t w)
+{
+    if (h >= m->height || w >= m->width)
+        errx(EXIT_FAILURE,
+             "Failed to get coefficient: index (%zu, %zu) out of bounds for a "
+             "byte matrix of shape (%zu, %zu).",
+             h, w, m->height, m->width);
+
+    return m->content + h * m->stride + w;
+}
+
+uint8_t mat_u8_coef(const MatU8 *m, size_t h, size_t w)
+{
+    return *mat_u8_coef_ptr(m, h, w);
+}
+
+int mat_u8_eq(const MatU8 *a, const MatU8 *b)
+{
+    if (a->height != b->height || a->width != b->width)
+        return 0;
+
+    for (size_t h = 0; h < a->height; h++)
+        if (memcmp(a->content + h * a->stride, b->content + h * b->stride,
+                   a->width) != 0)
+            return 0;
+
+    return 1;
+}
+
+MatU8 *mat_u8_from_matrix(const Matrix *src)
+{
+    size_t height = mat_height(src);
+    size_t width = mat_width(src);
+    MatU8 *dst = alloc_matrix_u8(height, width);
+
+    for (size_t h = 0; h < height; h++)
+    {
+        const float *src_row = mat_coef_ptr(src, h, 0);
+        uint8_t *dst_row = dst->content + h * dst->stride;
+        for (size_t w = 0; w < width; w++)
+        {
+            float v = floorf(src_row[w] + 0.5f);
+            dst_row[w] = v <= 0.0f ? 0 : v >= 255.0f ? 255 : (uint8_t)v;
+        }
+    }
+
+    return dst;
+}
+
+Matrix *mat_u8_to_matrix(const MatU8 *src)
+{
+    Matrix *dst = mat_create_padded(src->height, src->width);
+
+    for (size_t h = 0; h < src->height; h++)
+    {
+        const uint8_t *src_row = src->content + h * src->stride;
+        float *dst_row = mat_coef_ptr(dst, h, 0);
+        for (size_t w = 0; w < src->width; w++)
+            dst_row[w] = src_row[w];
+    }
+
+    return dst;
+}
+
+/// @brief Blurs one row of a byte image horizontally into floats, repeating
+/// the border pixels.
+static void blur_row(const uint8_t *src, float *dst, size_t width,
+                     const float *kernel, size_t kernel_size)
+{
+    long m = (kernel_size - 1) / 2;
+
+    for (size_t y = 0; y < width; y++)
+    {
+        float acc = 0.0f;
+        for (long i = -m; i <= m; i++)
+        {
+            long x = (long)y + i;
+            x = x < 0 ? 0 : x >= (long)width ? (long)width - 1 : x;
+            acc += kernel[m + i] * (float)src[x];
+        }
+        dst[y] = acc;
+    }
+}
+
+MatU8 *mat_u8_adaptive_threshold(const MatU8 *src, const float *kernel,
+                                 size_t kernel_size, float c,
+                                 uint8_t max_value)
+{
+    if (kernel_size % 2 == 0)
+        errx(EXIT_FAILURE,
+             "Failed to threshold: the kernel size '%zu' must be odd.",
+             kernel_size);
+
+    size_t height = src->height;
+    size_t width = src->width;
+    long m = (kernel_size - 1) / 2;
+
+    // Ring of the horizontally blurred rows: row r lives in slot
+    // r % kernel_size, which is unique within a vertical window.
+    float *rows = malloc(kernel_size * width * sizeof(float));
+    float *acc = malloc(width * sizeof(float));
+    if (rows == NULL || acc == NULL)
+        errx(EXIT_FAILURE, "Failed to threshold: memory allocation failed.");
+
+    MatU8 *dst = alloc_matrix_u8(height, width);
+    size_t next_row = 0; // The next row to blur horizontally.
+
+    for (size_t x = 0; x < height; x++)
+    {
+        size_t last = x + m < height ? x + m : height - 1;
+        for (; next_row <= last; next_row++)
+            blur_row(src->content + next_row * src->stride,
+                     rows + (next_row % kernel_size) * width, width, kernel,
+                     kernel_size);
+
+        memset(acc, 0, width * sizeof(float));
+        for (long i = -m; i <= m; i++)
+        {
+            long r = (long)x + i;
+            r = r < 0 ? 0 : r >= (long)height ? (long)height - 1 : r;
+            const float *row = rows + (r % kernel_size) * width;
+            float weight = kernel[m + i];
+            for (size_t y = 0; y < width; y++)
+                acc[y] += weight * row[y];
+        }
+
+        const uint8_t *src_row = src->content + x * src->stride;
+        uint8_t *dst_row = dst->content + x * dst->stride;
+        for (size_t y = 0; y < width; y++)
+            dst_row[y] = (float)src_row[y] > acc[y] - c ? max_value : 0;
+    }
+
+    free(rows);
+    free(acc);
+    return dst;
+}
+
+/// @brief Applies a separable minimum or maximum filter. The border pixels
+/// being repeated, the extremum over a window clamped to the image is the
+/// same as over the extended window.
+static MatU8 *extremum_filter(const MatU8 *src, size_t kernel_size,
+                              int maximum)
+{
+    if (kernel_size == 0)
+        errx(EXIT_FAILURE, "Failed to filter: the kernel size must be "
+                           "non-zero.");
+
+    size_t height = src->height;
+    size_t width = src->width;
+    size_t before = kernel_size / 2;
+    size_t after = kernel_size - before - 1;
+
+    // Horizontal pass.
+    MatU8 *tmp = alloc_matrix_u8(height, width);
+    for (size_t x = 0; x < height; x++)
+    {
+        const uint8_t *src_row = src->content + x * src->stride;
+        uint8_t *tmp_row = tmp->content + x * tmp->stride;
+        for (size_t y = 0; y < width; y++)
+        {
+            size_t lo = y < before ? 0 : y - before;
+            size_t hi = y + after < width ? y + after : width - 1;
+            uint8_t e = src_row[lo];
+            for (size_t i = lo + 1; i <= hi; i++)
+                e = maximum ? (src_row[i] > e ? src_row[i] : e)
+                            : (src_row[i] < e ? src_row[i] : e);
+            tmp_row[y] = e;
+        }
+    }
+
+    // Vertical pass, a whole row at a time.
+    MatU8 *dst = alloc_matrix_u8(height, width);
+    for (size_t x = 0; x < height; x++)
+    {
+        size_t lo = x < before ? 0 : x - before;
+        size_t hi = x + after < height ? x + after : height - 1;
+        uint8_t *dst_row = dst->content + x * dst->stride;
+        memcpy(dst_row, tmp->content + lo * tmp->stride, width);
+        for (size_t r = lo + 1; r <= hi; r++)
+        {
+            const uint8_t *row = tmp->content + r * tmp->stride;
+            if (maximum)
+                for (size_t y = 0; y < width; y++)
+                    dst_row[y] = row[y] > dst_row[y] ? row[y] : dst_row[y];
+            else
+                for (size_t y = 0; y < width; y++)
+                    dst_row[y] = row[y] < dst_row[y] ? row[y] : dst_row[y];
+        }
+    }
+
+    mat_u8_free(tmp);
+    return dst;
+}
+
+MatU8 *mat_u8_max_filter(const MatU8 *src, size_t kernel_size)
+{
+    return extremum_filter(src, kernel_size, 1);
+}
+
+MatU8 *mat_u8_min_filter(const MatU8 *src, size_t kernel_size)
+{
+    return extremum_filter(src, kernel_size, 0);
+}
@@ -0,0 +1,131 @@
+#ifndef MATRIX_U8_H
+#define MATRIX_U8_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "matrix.h"
+
+/// @brief A 2D matrix of bytes, used for the grayscale and binary images of
+/// the vision pipeline. Pixels take one byte instead of the four of a float
+/// Matrix, so every pass over an image moves four times less memory.
+typedef struct MatU8 MatU8;
+
+/// @brief Returns the height (number of rows) of the given matrix.
+/// @param[in] m Pointer to the matrix.
+/// @return The number of rows in the matrix.
+size_t mat_u8_height(const MatU8 *m);
+
+/// @brief Returns the width (number of columns) of the given matrix.
+/// @param[in] m Pointer to the matrix.
+/// @return The number of columns in the matrix.
+size_t mat_u8_width(const MatU8 *m);
+
+/// @brief Returns the stride of the given matrix, i.e. the number of bytes
+/// between the starts of two consecutive rows. Rows are padded to a multiple
+/// of MAT_ALIGNMENT bytes.
+/// @param[in] m Pointer to the matrix.
+/// @return The stride of the matrix.
+size_t mat_u8_stride(const MatU8 *m);
+
+/// @brief Creates a zero-filled byte matrix whose rows are padded to a
+/// multiple of MAT_ALIGNMENT bytes.
+/// @param[in] height Number of rows in the new matrix (must be non-zero).
+/// @param[in] width Number of columns in the new matrix (must be non-zero).
+/// @return A pointer to a newly allocated zero-filled matrix.
+/// @throw Terminates the program if height or width is zero, or if memory
+/// allocation fails.
+MatU8 *mat_u8_create(size_t height, size_t width);
+
+/// @brief Creates a byte matrix initialized with the given value.
+/// @param[in] height Number of rows in the new matrix (must be non-zero).
+/// @param[in] width Number of columns in the new matrix (must be non-zero).
+/// @param[in] value The value of every coefficient.
+/// @return A pointer to a newly allocated matrix.
+/// @throw Terminates the program if height or width is zero, or if memory
+/// allocation fails.
+MatU8 *mat_u8_create_filled(size_t height, size_t width, uint8_t value);
+
+/// @brief Frees a byte matrix. Like matrices, byte matrices created while a
+/// matrix arena is active return to it (see `matrix/arena.h`).
+/// @param[in] m Pointer to the matrix to free.
+void mat_u8_free(MatU8 *m);
+
+/// @brief Returns a pointer to the first coefficient of a row.
+/// @param[in] m Pointer to the matrix.
+/// @param[in] h Row index.
+/// @return A pointer to the width coefficients of the row.
+/// @throw Terminates the program if h is out of bounds.
+uint8_t *mat_u8_row(const MatU8 *m, size_t h);
+
+/// @brief Returns the coefficient at the given position.
+/// @param[in] m Pointer to the matrix.
+/// @param[in] h Row index.
+/// @param[in] w Column index.
+/// @return The coefficient at (h, w).
+/// @throw Terminates the program if the indices are out of bounds.
+uint8_t mat_u8_coef(const MatU8 *m, size_t h, size_t w);
+
+/// @brief Returns a pointer to the coefficient at the given position.
+/// @param[in] m Pointer to the matrix.
+/// @param[in] h Row index.
+/// @param[in] w Column index.
+/// @return A pointer to the coefficient at (h, w).
+/// @throw Terminates the program if the indices are out of bounds.
+uint8_t *mat_u8_coef_ptr(const MatU8 *m, size_t h, size_t w);
+
+/// @brief Checks whether two byte matrices have the same shape and
+/// coefficients.
+/// @param[in] a Pointer to the first matrix.
+/// @param[in] b Pointer to the second matrix.
+/// @return 1 if they are equal, 0 otherwise.
+int mat_u8_eq(const MatU8 *a, const MatU8 *b);
+
+/// @brief Converts a float matrix to a byte matrix. Coefficients are rounded
+/// to the nearest integer (halves upwards) and clamped to [0, 255].
+/// @param[in] src Pointer to the matrix to convert.
+/// @return A newly allocated byte matrix of the same shape.
+MatU8 *mat_u8_from_matrix(const Matrix *src);
+
+/// @brief Converts a byte matrix to a padded float matrix (see
+/// `mat_create_padded`), for the stages that need float arithmetic.
+/// @param[in] src Pointer to the byte matrix to convert.
+/// @return A newly allocated float matrix of the same shape.
+Matrix *mat_u8_to_matrix(const MatU8 *src);
+
+/// @brief Adaptive thresholding against a separable blur of the image: a
+/// pixel is set to max_value if it is greater than its blurred value minus c,
+/// and to 0 otherwise. The image is blurred horizontally then vertically with
+/// the same kernel, repeating the border pixels. The blur is computed in
+/// floats with the same operations, in the same order, as `gaussian_blur`, so
+/// the result is identical to the float pipeline. Only kernel_size rows of
+/// blurred values are kept in memory at a time.
+/// @param[in] src Pointer to the image to threshold.
+/// @param[in] kernel The normalized 1D blur kernel.
+/// @param[in] kernel_size The size of the kernel (must be odd).
+/// @param[in] c The constant subtracted from the blurred value.
+/// @param[in] max_value The value of the pixels above the threshold.
+/// @return A newly allocated thresholded image.
+/// @throw Terminates the program if the kernel size is even.
+MatU8 *mat_u8_adaptive_threshold(const MatU8 *src, const float *kernel,
+                                 size_t kernel_size, float c,
+                                 uint8_t max_value);
+
+/// @brief Replaces every pixel with the maximum of its kernel_size ×
+/// kernel_size neighbourhood, whose anchor is at kernel_size / 2. Border
+/// pixels are repeated outside the image.
+/// @param[in] src Pointer to the image.
+/// @param[in] kernel_size The size of the neighbourhood (must be non-zero).
+/// @return A newly allocated filtered image.
+/// @throw Terminates the program if kernel_size is zero.
+MatU8 *mat_u8_max_filter(const MatU8 *src, size_t kernel_size);
+
+/// @brief Replaces every pixel with the minimum of its kernel_size ×
+/// kernel_size neighbourhood, see `mat_u8_max_filter`.
+/// @param[in] src Pointer to the image.
+/// @param[in] kernel_size The size of the neighbourhood (must be non-zero).
+/// @return A newly allocated filtered image.
+/// @throw Terminates the program if kernel_size is zero.
+MatU8 *mat_u8_min_filter(const MatU8 *src, size_t kernel_size);
+
+#endif
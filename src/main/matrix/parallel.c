@@ -0,0 +1,213 @@
+#include "parallel.h"
+
+#include <err.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/// @brief The number of ranges per thread a loop is split into, so that a
+/// thread that finishes early picks up the work of a slower one.
+#define CHUNKS_PER_THREAD 4
+
+/// @brief The persistent thread pool. The workers sleep on wake until the
+/// generation changes, then pick chunks of the current loop through
+/// next_chunk until none is left, and the last one to finish signals done.
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t *workers;
+    size_t worker_count;
+    size_t running;
+    unsigned long generation;
+    int stop;
+
+    MatParallelBody body;
+    void *ctx;
+    size_t n;
+    size_t chunk_count;
+    atomic_size_t next_chunk;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+/// @brief Held by the thread running a parallel loop: the pool runs one loop
+/// at a time, the other threads run theirs alone.
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/// @brief Whether the current thread is running a chunk of a parallel loop,
+/// in which case nested loops are not parallelized.
+static _Thread_local int in_parallel_loop = 0;
+
+/// @brief The number of threads, the calling one included.
+static size_t thread_count = 1;
+
+static size_t parallel_threshold = MAT_PARALLEL_DEFAULT_THRESHOLD;
+
+/// @brief Returns the number of threads set by MAT_THREADS_ENV_VAR, or the
+/// number of online CPUs.
+static size_t default_thread_count()
+{
+    const char *value = getenv(MAT_THREADS_ENV_VAR);
+
+    if (value != NULL && value[0] != '\0')
+    {
+        char *end;
+        unsigned long count = strtoul(value, &end, 10);
+        if (*end != '\0' || count == 0)
+            errx(EXIT_FAILURE,
+                 "%s=%s: expected a positive number of threads.",
+                 MAT_THREADS_ENV_VAR, value);
+        return count;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (size_t)cpus : 1;
+}
+
+/// @brief Runs the chunks of the current loop until none is left.
+static void run_chunks()
+{
+    in_parallel_loop = 1;
+
+    size_t chunk;
+    while ((chunk = atomic_fetch_add(&pool.next_chunk, 1)) < pool.chunk_count)
+        pool.body(chunk * pool.n / pool.chunk_count,
+                  (chunk + 1) * pool.n / pool.chunk_count, pool.ctx);
+
+    in_parallel_loop = 0;
+}
+
+static void *worker_main(void *arg)
+{
+    (void)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;)
+    {
+        while (pool.generation == seen && !pool.stop)
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        if (pool.stop)
+            break;
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        run_chunks();
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.running == 0)
+            pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    return NULL;
+}
+
+/// @brief Joins and frees the workers, if any.
+static void stop_pool()
+{
+    if (pool.workers == NULL)
+        return;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (size_t i = 0; i < pool.worker_count; ++i)
+        pthread_join(pool.workers[i], NULL);
+
+    free(pool.workers);
+    pool.workers = NULL;
+    pool.worker_count = 0;
+    pool.generation = 0;
+    pool.stop = 0;
+}
+
+/// @brief Starts the thread_count - 1 workers.
+static void start_pool()
+{
+    static int registered = 0;
+    if (!registered)
+    {
+        atexit(stop_pool);
+        registered = 1;
+    }
+
+    size_t worker_count = mat_thread_count() - 1;
+    pool.workers = malloc(worker_count * sizeof(pthread_t));
+    if (pool.workers == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    for (size_t i = 0; i < worker_count; ++i)
+        if (pthread_create(&pool.workers[i], NULL, worker_main, NULL) != 0)
+            errx(EXIT_FAILURE, "Failed to start the matrix thread pool.");
+
+    pool.worker_count = worker_count;
+}
+
+/// @brief Sets the default number of threads once at startup. The pool itself
+/// is only started by the first parallel loop.
+__attribute__((constructor)) static void parallel_init()
+{
+    thread_count = default_thread_count();
+}
+
+size_t mat_thread_count() { return thread_count; }
+
+void mat_set_thread_count(size_t count)
+{
+    stop_pool();
+    thread_count = count == 0 ? default_thread_count() : count;
+}
+
+size_t mat_parallel_threshold() { return parallel_threshold; }
+
+void mat_set_parallel_threshold(size_t work) { parallel_threshold = work; }
+
+void mat_parallel_for(size_t n, size_t cost, MatParallelBody body, void *ctx)
+{
+    if (n == 0)
+        return;
+
+    size_t threads = mat_thread_count();
+
+    if (n < 2 || threads < 2 || in_parallel_loop ||
+        (cost != 0 && n < parallel_threshold / cost) ||
+        (cost == 0 && parallel_threshold != 0) ||
+        pthread_mutex_trylock(&submit_lock) != 0)
+    {
+        body(0, n, ctx);
+        return;
+    }
+
+    if (pool.workers == NULL)
+        start_pool();
+
+    size_t chunk_count = threads * CHUNKS_PER_THREAD;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.body = body;
+    pool.ctx = ctx;
+    pool.n = n;
+    pool.chunk_count = chunk_count < n ? chunk_count : n;
+    atomic_store(&pool.next_chunk, 0);
+    pool.running = pool.worker_count;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    run_chunks();
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.running > 0)
+        pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&submit_lock);
+}
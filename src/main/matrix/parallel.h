@@ -0,0 +1,57 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+/// @brief The environment variable that sets the number of threads used by
+/// the matrix library. It is read once at startup; by default, every online
+/// CPU is used.
+#define MAT_THREADS_ENV_VAR "MAT_THREADS"
+
+/// @brief The default amount of work (roughly, in floating point operations)
+/// under which a loop runs on the calling thread only: waking up the pool
+/// costs a few microseconds.
+#define MAT_PARALLEL_DEFAULT_THRESHOLD (1 << 18)
+
+/// @brief The body of a parallel loop, called on a range [begin, end) of its
+/// iterations with the context given to `mat_parallel_for`.
+typedef void (*MatParallelBody)(size_t begin, size_t end, void *ctx);
+
+/// @brief Returns the number of threads used by the matrix library, the
+/// calling one included.
+/// @return The number of threads (at least 1).
+size_t mat_thread_count();
+
+/// @brief Changes the number of threads used by the matrix library. The
+/// running pool is stopped, and a new one is started by the next parallel
+/// loop.
+/// @param[in] count The number of threads, the calling one included, or 0 to
+/// go back to the default (see MAT_THREADS_ENV_VAR).
+/// @note This function is not thread-safe and should only be called when no
+/// matrix operation is running, e.g. in tests and benchmarks.
+void mat_set_thread_count(size_t count);
+
+/// @brief Returns the amount of work under which a loop is not parallelized.
+/// @return The threshold.
+size_t mat_parallel_threshold();
+
+/// @brief Changes the amount of work under which a loop is not parallelized.
+/// @param[in] work The new threshold (0 parallelizes every loop).
+/// @note This function is not thread-safe, see `mat_set_thread_count`.
+void mat_set_parallel_threshold(size_t work);
+
+/// @brief Runs body over the iterations [0, n), split into contiguous ranges
+/// shared by the threads of a persistent pool, and returns once all of them
+/// are done. The calling thread takes part in the loop. The loop runs on the
+/// calling thread alone if n × cost is under the threshold, if the pool has a
+/// single thread, if it is called from within a parallel loop or if another
+/// thread is already running one.
+/// @param[in] n The number of iterations.
+/// @param[in] cost The amount of work of one iteration.
+/// @param[in] body The function applied to each range of iterations. The
+/// ranges never overlap, so it may write to the outputs of its own iterations
+/// without synchronization.
+/// @param[in] ctx The context given to body.
+void mat_parallel_for(size_t n, size_t cost, MatParallelBody body, void *ctx);
+
+#endif
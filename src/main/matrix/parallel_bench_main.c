@@ -0,0 +1,140 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/bench.h"
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "matrix/simd.h"
+#include "utils/random/random.h"
+
+/// @brief The thread counts compared.
+static const size_t THREADS[] = {1, 2, 4, 8};
+
+#define THREAD_COUNTS (sizeof(THREADS) / sizeof(THREADS[0]))
+
+static Matrix *a, *b, *big, *other;
+
+/// @brief A function with a fixed point, so that the coefficients mapped
+/// again and again stay normal numbers.
+static float contract(float x) { return 0.5f * x + 0.25f; }
+
+static void run_gemm(void *ctx)
+{
+    (void)ctx;
+    mat_free(mat_multiplication(a, b));
+}
+
+static void run_transpose(void *ctx)
+{
+    (void)ctx;
+    mat_free(mat_transpose(big));
+}
+
+static void run_add(void *ctx)
+{
+    (void)ctx;
+    mat_inplace_addition(big, other);
+}
+
+static void run_exp(void *ctx)
+{
+    (void)ctx;
+    mat_free(mat_exp(other));
+}
+
+static void run_map(void *ctx)
+{
+    (void)ctx;
+    mat_inplace_map(big, contract);
+}
+
+#define GEMM_FLOPS (2.0 * 128 * 784 * 64)
+#define IMAGE_BYTES (1024.0 * 1024 * sizeof(float))
+
+/// @brief The operations timed, on the shapes of a mini-batch of the OCR
+/// network (gemm) and of a 1024×1024 image (the others), with their work:
+/// the floating point operations of the product, the bytes read and written
+/// by the others.
+static const struct
+{
+    const char *name;
+    const char *shape;
+    void (*run)(void *);
+    double work;
+    BenchUnit unit;
+} OPERATIONS[] = {
+    {"gemm", "128x784x64", run_gemm, GEMM_FLOPS, BenchFlops},
+    {"transpose", "1024x1024", run_transpose, 2 * IMAGE_BYTES, BenchBytes},
+    {"add", "1024x1024", run_add, 3 * IMAGE_BYTES, BenchBytes},
+    {"exp", "1024x1024", run_exp, 2 * IMAGE_BYTES, BenchBytes},
+    {"map", "1024x1024", run_map, 2 * IMAGE_BYTES, BenchBytes},
+};
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE, "Usage: %s [--format table|csv|json] [--samples N]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    BenchConfig config = BENCH_DEFAULT_CONFIG;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else
+            usage(argv[0]);
+    }
+
+    rand_seed();
+
+    a = mat_create_random_uniform(128, 784, -1.0f, 1.0f);
+    b = mat_create_random_uniform(784, 64, -1.0f, 1.0f);
+    big = mat_create_random_uniform(1024, 1024, -1.0f, 1.0f);
+    other = mat_create_random_uniform(1024, 1024, -1.0f, 1.0f);
+
+    BenchReport report;
+    bench_report_begin(&report, stdout, format);
+
+    for (size_t o = 0; o < sizeof(OPERATIONS) / sizeof(OPERATIONS[0]); ++o)
+    {
+        for (size_t t = 0; t < THREAD_COUNTS; ++t)
+        {
+            // The warmup of the measure also starts the thread pool.
+            mat_set_thread_count(THREADS[t]);
+
+            BenchResult res;
+            bench_measure(&config, OPERATIONS[o].run, NULL, OPERATIONS[o].work,
+                          OPERATIONS[o].unit, &res);
+            res.name = OPERATIONS[o].name;
+            res.shape = OPERATIONS[o].shape;
+            res.variant = simd_tier_name(simd_tier());
+            res.threads = THREADS[t];
+            bench_report_add(&report, &res);
+        }
+    }
+
+    bench_report_end(&report);
+
+    mat_set_thread_count(0);
+    mat_free(a);
+    mat_free(b);
+    mat_free(big);
+    mat_free(other);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/// @brief The instruction sets the matrix kernels are compiled for, from the
+/// least to the most capable.
+typedef enum SimdTier
+{
+    /// Portable C code.
+    SimdScalar,
+
+    /// 128-bit SSE vectors (SSE4.2 and below).
+    SimdSse42,
+
+    /// 256-bit AVX2 vectors with fused multiply-add.
+    SimdAvx2,
+
+    /// 512-bit AVX-512F vectors, with the byte operations of AVX-512BW.
+    SimdAvx512
+} SimdTier;
+
+/// @brief The environment variable that forces the tier used by the matrix
+/// library. It accepts the names returned by `simd_tier_name` and is read once
+/// at startup. It is meant for A/B benchmarking.
+#define SIMD_ENV_VAR "MAT_SIMD"
+
+/// @brief Returns the most capable tier supported by the running CPU (and
+/// operating system), using cpuid.
+/// @return The best supported tier.
+SimdTier simd_detect_tier();
+
+/// @brief Returns the tier currently used by the matrix library.
+/// @return The active tier.
+SimdTier simd_tier();
+
+/// @brief Changes the tier used by the matrix library.
+/// @param[in] tier The tier to use.
+/// @return 0 on success, or -1 if the running CPU does not support the tier.
+/// @note This function is not thread-safe and should only be called when no
+/// matrix operation is running, e.g. in tests and benchmarks.
+int simd_set_tier(SimdTier tier);
+
+/// @brief Returns the name of a tier ("scalar", "sse4.2", "avx2" or
+/// "avx512").
+/// @param[in] tier The tier.
+/// @return A static string.
+const char *simd_tier_name(SimdTier tier);
+
+#endif
@@ -0,0 +1,166 @@
+#include <err.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/bench.h"
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "matrix/simd.h"
+#include "utils/math/sigmoid.h"
+#include "utils/random/random.h"
+
+/// @brief The matrices every operation is applied to. Their sizes are not
+/// multiples of 16 so that the remainder handling is part of the measure.
+#define HEIGHT 509
+#define WIDTH 783
+
+/// @brief The operands shared by all the benchmarked operations.
+static Matrix *a, *b, *c, *x;
+
+static Matrix *op_addition() { return mat_addition(a, b); }
+static Matrix *op_subtraction() { return mat_subtraction(a, b); }
+static Matrix *op_hadamard() { return mat_hadamard(a, b); }
+static Matrix *op_scalar() { return mat_scalar_multiplication(a, 0.5f); }
+static Matrix *op_relu() { return mat_relu(a); }
+static Matrix *op_relu_derivative() { return mat_relu_derivative(a); }
+static Matrix *op_transpose() { return mat_transpose(a); }
+static Matrix *op_multiplication() { return mat_multiplication(a, c); }
+static Matrix *op_gemv() { return mat_gemv(a, x); }
+static Matrix *op_exp() { return mat_exp(a); }
+static Matrix *op_softmax() { return mat_softmax(a); }
+
+// The built-in operations of mat_apply, against mat_map with the equivalent
+// scalar function.
+static const MatOpParams PARAMS = {.low = -0.5f, .high = 0.5f};
+
+static float clamp_f(float x)
+{
+    return x < -0.5f ? -0.5f : x > 0.5f ? 0.5f : x;
+}
+static float threshold_f(float x) { return x > 0.0f ? 0.5f : -0.5f; }
+
+static Matrix *op_sigmoid_map() { return mat_map(a, sigmoid); }
+static Matrix *op_sigmoid() { return mat_apply(a, MAT_OP_SIGMOID, PARAMS); }
+static Matrix *op_tanh_map() { return mat_map(a, tanhf); }
+static Matrix *op_tanh() { return mat_apply(a, MAT_OP_TANH, PARAMS); }
+static Matrix *op_clamp_map() { return mat_map(a, clamp_f); }
+static Matrix *op_clamp() { return mat_apply(a, MAT_OP_CLAMP, PARAMS); }
+static Matrix *op_threshold_map() { return mat_map(a, threshold_f); }
+static Matrix *op_threshold()
+{
+    return mat_apply(a, MAT_OP_THRESHOLD, PARAMS);
+}
+
+/// @brief A benchmarked operation and the work of one call: its floating
+/// point operations, or the bytes it reads and writes for the data movement
+/// ones.
+typedef struct Operation
+{
+    const char *name;
+    Matrix *(*run)();
+    double work;
+    BenchUnit unit;
+} Operation;
+
+static void run_operation(void *ctx)
+{
+    const Operation *op = ctx;
+    mat_free(op->run());
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE, "Usage: %s [--format table|csv|json] [--samples N]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    BenchConfig config = BENCH_DEFAULT_CONFIG;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else
+            usage(argv[0]);
+    }
+
+    rand_seed();
+
+    a = mat_create_random_uniform(HEIGHT, WIDTH, -1.0f, 1.0f);
+    b = mat_create_random_uniform(HEIGHT, WIDTH, -1.0f, 1.0f);
+    c = mat_create_random_uniform(WIDTH, 61, -1.0f, 1.0f);
+    x = mat_create_random_uniform(WIDTH, 1, -1.0f, 1.0f);
+
+    const double size = (double)HEIGHT * WIDTH;
+    const Operation ops[] = {
+        {"addition", op_addition, size, BenchFlops},
+        {"subtraction", op_subtraction, size, BenchFlops},
+        {"hadamard", op_hadamard, size, BenchFlops},
+        {"scalar_mult", op_scalar, size, BenchFlops},
+        {"relu", op_relu, size, BenchFlops},
+        {"relu_deriv", op_relu_derivative, size, BenchFlops},
+        {"transpose", op_transpose, 2.0 * size * sizeof(float), BenchBytes},
+        {"multiplication", op_multiplication, 2.0 * size * 61, BenchFlops},
+        {"gemv", op_gemv, 2.0 * size, BenchFlops},
+        {"exp", op_exp, size, BenchFlops},
+        {"softmax", op_softmax, size, BenchFlops},
+        {"sigmoid_map", op_sigmoid_map, size, BenchFlops},
+        {"sigmoid", op_sigmoid, size, BenchFlops},
+        {"tanh_map", op_tanh_map, size, BenchFlops},
+        {"tanh", op_tanh, size, BenchFlops},
+        {"clamp_map", op_clamp_map, size, BenchFlops},
+        {"clamp", op_clamp, size, BenchFlops},
+        {"threshold_map", op_threshold_map, size, BenchFlops},
+        {"threshold", op_threshold, size, BenchFlops},
+    };
+    const size_t op_count = sizeof(ops) / sizeof(ops[0]);
+
+    char shape[32];
+    snprintf(shape, sizeof(shape), "%dx%d", HEIGHT, WIDTH);
+
+    SimdTier active = simd_tier(), best = simd_detect_tier();
+
+    BenchReport report;
+    bench_report_begin(&report, stdout, format);
+
+    for (size_t i = 0; i < op_count; ++i)
+    {
+        for (SimdTier tier = SimdScalar; tier <= best; tier++)
+        {
+            simd_set_tier(tier);
+
+            BenchResult res;
+            bench_measure(&config, run_operation, (void *)&ops[i],
+                          ops[i].work, ops[i].unit, &res);
+            res.name = ops[i].name;
+            res.shape = shape;
+            res.variant = simd_tier_name(tier);
+            res.threads = mat_thread_count();
+            bench_report_add(&report, &res);
+        }
+    }
+
+    bench_report_end(&report);
+    simd_set_tier(active);
+
+    mat_free(a);
+    mat_free(b);
+    mat_free(c);
+    mat_free(x);
+
+    return EXIT_SUCCESS;
+}
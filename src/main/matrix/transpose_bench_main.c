@@ -0,0 +1,119 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/bench.h"
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "matrix/simd.h"
+#include "utils/random/random.h"
+
+/// @brief The shapes measured: the input layer of the OCR network in both
+/// directions, a large grayscale image, and a square matrix for the tiled
+/// in-place transposition.
+static const size_t SHAPES[][2] = {
+    {784, 128}, {128, 784}, {4000, 3000}, {1024, 1024}, {784, 1},
+};
+
+static Matrix *m;
+
+/// @brief The previous implementation of mat_transpose: one coefficient at a
+/// time, in the order of the rows of the source.
+static void run_legacy(void *ctx)
+{
+    (void)ctx;
+    size_t height = mat_height(m), width = mat_width(m);
+    Matrix *res = mat_create(width, height);
+
+    for (size_t h = 0; h < height; ++h)
+        for (size_t w = 0; w < width; ++w)
+            *mat_unsafe_coef_ptr(res, w, h) = *mat_unsafe_coef_ptr(m, h, w);
+
+    mat_free(res);
+}
+
+static void run_transpose(void *ctx)
+{
+    (void)ctx;
+    mat_free(mat_transpose(m));
+}
+
+static void run_inplace(void *ctx)
+{
+    (void)ctx;
+    mat_inplace_transpose(m);
+}
+
+static BenchConfig config;
+static BenchReport report;
+
+/// @brief Measures a transposition of m, which reads and writes each of its
+/// coefficients once.
+static void bench(const char *name, const char *variant, size_t threads,
+                  const char *shape, void (*run)(void *))
+{
+    double bytes = 2.0 * (double)mat_height(m) * (double)mat_width(m) *
+                   sizeof(float);
+
+    BenchResult res;
+    bench_measure(&config, run, NULL, bytes, BenchBytes, &res);
+    res.name = name;
+    res.shape = shape;
+    res.variant = variant;
+    res.threads = threads;
+    bench_report_add(&report, &res);
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE, "Usage: %s [--format table|csv|json] [--samples N]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    config = BENCH_DEFAULT_CONFIG;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else
+            usage(argv[0]);
+    }
+
+    rand_seed();
+
+    const char *tier = simd_tier_name(simd_tier());
+    size_t threads = mat_thread_count();
+    bench_report_begin(&report, stdout, format);
+
+    for (size_t s = 0; s < sizeof(SHAPES) / sizeof(SHAPES[0]); ++s)
+    {
+        m = mat_create_random_uniform(SHAPES[s][0], SHAPES[s][1], -1.0f, 1.0f);
+
+        char shape[32];
+        snprintf(shape, sizeof(shape), "%zux%zu", SHAPES[s][0], SHAPES[s][1]);
+
+        bench("mat_transpose", "legacy", 1, shape, run_legacy);
+        bench("mat_transpose", tier, threads, shape, run_transpose);
+        bench("mat_inplace_transpose", tier, threads, shape, run_inplace);
+
+        mat_free(m);
+    }
+
+    bench_report_end(&report);
+
+    return EXIT_SUCCESS;
+}
@@ -8,6 +8,7 @@
 #include <unistd.h>
 
 #include "dataset.h"
+#include "utils/io/full_io.h"
 #include "utils/random/shuffle_array.h"
 
 struct Dataset
@@ -251,6 +252,12 @@ void ds_save_to_file(Dataset *ds, char *filename)
     }
 }
 
+/// @brief The number of pixels of a sample of a compressed file.
+#define COMPRESSED_PIXELS (28 * 28)
+/// @brief The size in bytes of a sample of a compressed file: its class, then
+/// its pixels, one bit each, from the most significant bit of each byte.
+#define COMPRESSED_SAMPLE_SIZE (1 + COMPRESSED_PIXELS / 8)
+
 Dataset *ds_load_from_compressed_file(char *filename)
 {
     FILE *file_stream = fopen(filename, "rb");
@@ -259,16 +266,24 @@ Dataset *ds_load_from_compressed_file(char *filename)
 
     int fd = fileno(file_stream);
 
-    int r;
-    size_t size;
-    char class;
-    char buff;
-    Matrix *m;
-    float *c;
+    // The whole file is read at once.
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+        errx(EXIT_FAILURE, "Failed to stat file %s", filename);
+    size_t file_size = st.st_size;
 
-    r = read(fd, &size, sizeof(size_t));
-    if (r != sizeof(size_t))
+    unsigned char *file = malloc(file_size);
+    if (file == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed");
+    if (read_all(fd, file, file_size) != 0)
+        errx(EXIT_FAILURE, "Failed to read file %s", filename);
+
+    size_t size;
+    if (file_size < sizeof(size_t))
         errx(EXIT_FAILURE, "Failed to read dataset size");
+    memcpy(&size, file, sizeof(size_t));
+    if (size > (file_size - sizeof(size_t)) / COMPRESSED_SAMPLE_SIZE)
+        errx(EXIT_FAILURE, "Failed to read class");
 
     Dataset *ds = malloc(sizeof(Dataset));
     if (ds == NULL)
@@ -279,34 +294,21 @@ Dataset *ds_load_from_compressed_file(char *filename)
     ds->max_size = size;
     ds->size = size;
 
-    for (size_t i = 0; i < size; ++i)
+    const unsigned char *sample = file + sizeof(size_t);
+    for (size_t i = 0; i < size; ++i, sample += COMPRESSED_SAMPLE_SIZE)
     {
-        r = read(fd, &class, sizeof(char));
-        if (r != sizeof(char))
-            errx(EXIT_FAILURE, "Failed to read class");
+        char class = (char)sample[0];
+        const unsigned char *bits = sample + 1;
 
-        m = mat_create(784, 1);
-        c = mat_coef_ptr(m, 0, 0);
-        for (size_t j = 0; j < 784; j += 8)
-        {
-            r = read(fd, &buff, sizeof(char));
-            if (r != sizeof(char))
-                errx(EXIT_FAILURE, "Failed to read class");
-
-            c[j + 0] = (buff & (1 << 7)) == 0 ? 0.0f : 1.0f;
-            c[j + 1] = (buff & (1 << 6)) == 0 ? 0.0f : 1.0f;
-            c[j + 2] = (buff & (1 << 5)) == 0 ? 0.0f : 1.0f;
-            c[j + 3] = (buff & (1 << 4)) == 0 ? 0.0f : 1.0f;
-            c[j + 4] = (buff & (1 << 3)) == 0 ? 0.0f : 1.0f;
-            c[j + 5] = (buff & (1 << 2)) == 0 ? 0.0f : 1.0f;
-            c[j + 6] = (buff & (1 << 1)) == 0 ? 0.0f : 1.0f;
-            c[j + 7] = (buff & (1 << 0)) == 0 ? 0.0f : 1.0f;
-        }
+        Matrix *m = mat_create(COMPRESSED_PIXELS, 1);
+        float *c = mat_coef_ptr(m, 0, 0);
+        for (size_t j = 0; j < COMPRESSED_PIXELS; j++)
+            c[j] = (bits[j / 8] >> (7 - j % 8)) & 1 ? 1.0f : 0.0f;
 
-        mat_inplace_vertical_flatten(m);
         ds->content[i] = td_create(m, class);
     }
 
+    free(file);
     fclose(file_stream);
 
     return ds;
@@ -314,44 +316,36 @@ Dataset *ds_load_from_compressed_file(char *filename)
 
 void ds_save_to_compressed_file(Dataset *ds, const char *filename)
 {
-    FILE *file_stream = fopen(filename, "wb");
-    if (file_stream == NULL)
-        errx(EXIT_FAILURE, "Failed to open file for writing: %s", filename);
-
-    int fd = fileno(file_stream);
-
-    ssize_t w = write(fd, &ds->size, sizeof(size_t));
-    if (w != sizeof(size_t))
-        errx(EXIT_FAILURE, "Failed to write dataset size");
+    // The whole file is built in memory and written at once.
+    size_t file_size = sizeof(size_t) + ds->size * COMPRESSED_SAMPLE_SIZE;
+    unsigned char *file = calloc(file_size, 1);
+    if (file == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed");
+    memcpy(file, &ds->size, sizeof(size_t));
 
-    for (size_t i = 0; i < ds->size; ++i)
+    unsigned char *sample = file + sizeof(size_t);
+    for (size_t i = 0; i < ds->size; ++i, sample += COMPRESSED_SAMPLE_SIZE)
     {
         Training_Data *td = ds->content[i];
-        Matrix *m = td->input;
-        float *c = mat_coef_ptr(m, 0, 0);
+        const float *c = mat_coef_ptr(td->input, 0, 0);
 
-        char class = (char)td->expected_class;
+        sample[0] = (unsigned char)td->expected_class;
+        unsigned char *bits = sample + 1;
+        for (size_t j = 0; j < COMPRESSED_PIXELS; j++)
+            bits[j / 8] |= (c[j] > 0.5f) << (7 - j % 8);
+    }
 
-        w = write(fd, &class, sizeof(char));
-        if (w != sizeof(char))
-            errx(EXIT_FAILURE, "Failed to write class byte");
+    FILE *file_stream = fopen(filename, "wb");
+    if (file_stream == NULL)
+        errx(EXIT_FAILURE, "Failed to open file for writing: %s", filename);
 
-        unsigned char buff;
-        for (size_t j = 0; j < 28 * 28; j += 8)
-        {
-            buff = 0;
-            for (int b = 0; b < 8; b++)
-            {
-                buff <<= 1;
-                buff |= (c[j + b] > 0.5f);
-            }
-            w = write(fd, &buff, 1);
-            if (w != sizeof(buff))
-                errx(EXIT_FAILURE, "Failed to write compressed pixel block");
-        }
-    }
+    int fd = fileno(file_stream);
+
+    if (write_all(fd, file, file_size) != 0)
+        errx(EXIT_FAILURE, "Failed to write compressed dataset");
 
     fclose(file_stream);
+    free(file);
 }
 
 inline void ds_shuffle(Dataset *dataset)
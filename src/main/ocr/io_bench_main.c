@@ -0,0 +1,353 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench/bench.h"
+#include "dataset.h"
+#include "matrix/matrix.h"
+#include "neural_network.h"
+#include "utils/random/random.h"
+
+/// @brief The dataset measured by default.
+#define DEFAULT_DATASET "./assets/ocr/dataset/grid.dataset"
+
+/// @brief The files written by the benchmark, in the current directory.
+#define NET_FILE "io_bench.nn"
+#define PREVIOUS_NET_FILE "io_bench_previous.nn"
+#define DATASET_FILE "io_bench.dataset"
+#define PREVIOUS_DATASET_FILE "io_bench_previous.dataset"
+
+static Neural_Network *net;
+static Dataset *ds;
+
+/// @brief Reads a value of a legacy file with a single read, or exits.
+static void read_value(int fd, void *value, size_t size)
+{
+    if (read(fd, value, size) != (ssize_t)size)
+        errx(EXIT_FAILURE, "Failed to read file.");
+}
+
+/// @brief Writes a value with a single write, or exits.
+static void write_value(int fd, const void *value, size_t size)
+{
+    if (write(fd, value, size) != (ssize_t)size)
+        errx(EXIT_FAILURE, "Failed to write file.");
+}
+
+/// @brief Reads a matrix of a legacy network file as the previous
+/// implementation did: one read per coefficient.
+static Matrix *previous_read_matrix(int fd)
+{
+    size_t height, width;
+    read_value(fd, &height, sizeof(size_t));
+    read_value(fd, &width, sizeof(size_t));
+
+    float *content = calloc(height * width, sizeof(float));
+    if (content == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    for (size_t j = 0; j < height * width; j++)
+        read_value(fd, &content[j], sizeof(float));
+
+    Matrix *m = mat_create_from_arr(height, width, content);
+    free(content);
+    return m;
+}
+
+/// @brief The previous implementation of the legacy net_load_from_file: one
+/// read per layer height and per coefficient. It returns the first weights,
+/// which are enough to check the load.
+static Matrix *previous_net_load(const char *filename)
+{
+    FILE *file_stream = fopen(filename, "r");
+    if (file_stream == NULL)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+    int fd = fileno(file_stream);
+
+    size_t layer_number;
+    read_value(fd, &layer_number, sizeof(size_t));
+    size_t heights[layer_number];
+    for (size_t i = 0; i < layer_number; i++)
+        read_value(fd, &heights[i], sizeof(size_t));
+
+    Matrix *first = NULL;
+    for (size_t i = 1; i < 2 * layer_number - 1; i++)
+    {
+        Matrix *m = previous_read_matrix(fd);
+        if (first == NULL)
+            first = m;
+        else
+            mat_free(m);
+    }
+    // The previous implementation transposed the first weights as well.
+    mat_free(mat_transpose(first));
+
+    fclose(file_stream);
+    return first;
+}
+
+static void previous_write_matrix(int fd, const Matrix *m)
+{
+    size_t height = mat_height(m), width = mat_width(m);
+    write_value(fd, &height, sizeof(size_t));
+    write_value(fd, &width, sizeof(size_t));
+    for (size_t h = 0; h < height; h++)
+        for (size_t w = 0; w < width; w++)
+            write_value(fd, mat_coef_ptr(m, h, w), sizeof(float));
+}
+
+/// @brief The previous implementation of net_save_to_file: one write per
+/// layer height and per coefficient.
+static void previous_net_save(const char *filename)
+{
+    FILE *file_stream = fopen(filename, "w");
+    if (file_stream == NULL)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+    int fd = fileno(file_stream);
+
+    size_t layer_number = net_layer_number(net);
+    write_value(fd, &layer_number, sizeof(size_t));
+    for (size_t i = 0; i < layer_number; i++)
+    {
+        size_t height = net_layer_height(net, i);
+        write_value(fd, &height, sizeof(size_t));
+    }
+    for (size_t i = 1; i < layer_number; i++)
+        previous_write_matrix(fd, net_layer_weights(net, i));
+    for (size_t i = 1; i < layer_number; i++)
+        previous_write_matrix(fd, net_layer_biases(net, i));
+
+    fclose(file_stream);
+}
+
+/// @brief The previous implementation of ds_load_from_compressed_file: one
+/// read per class and per byte of pixels.
+static Dataset *previous_ds_load(const char *filename)
+{
+    FILE *file_stream = fopen(filename, "rb");
+    if (file_stream == NULL)
+        errx(EXIT_FAILURE, "Failed to open file %s", filename);
+    int fd = fileno(file_stream);
+
+    size_t size;
+    read_value(fd, &size, sizeof(size_t));
+
+    Dataset *res = ds_create_empty();
+    for (size_t i = 0; i < size; ++i)
+    {
+        char class;
+        read_value(fd, &class, sizeof(char));
+
+        Matrix *m = mat_create(784, 1);
+        float *c = mat_coef_ptr(m, 0, 0);
+        for (size_t j = 0; j < 784; j += 8)
+        {
+            char buff;
+            read_value(fd, &buff, sizeof(char));
+            for (int b = 0; b < 8; b++)
+                c[j + b] = (buff & (1 << (7 - b))) == 0 ? 0.0f : 1.0f;
+        }
+
+        ds_add_tuple(res, td_create(m, class));
+    }
+
+    fclose(file_stream);
+    return res;
+}
+
+/// @brief The previous implementation of ds_save_to_compressed_file: one
+/// write per class and per byte of pixels.
+static void previous_ds_save(const char *filename)
+{
+    FILE *file_stream = fopen(filename, "wb");
+    if (file_stream == NULL)
+        errx(EXIT_FAILURE, "Failed to open file for writing: %s", filename);
+    int fd = fileno(file_stream);
+
+    size_t size = ds_size(ds);
+    write_value(fd, &size, sizeof(size_t));
+    for (size_t i = 0; i < size; ++i)
+    {
+        Training_Data *td = ds_get_data(ds, i);
+        const float *c = mat_coef_ptr(td->input, 0, 0);
+
+        char class = (char)td->expected_class;
+        write_value(fd, &class, sizeof(char));
+
+        for (size_t j = 0; j < 784; j += 8)
+        {
+            unsigned char buff = 0;
+            for (int b = 0; b < 8; b++)
+                buff = (buff << 1) | (c[j + b] > 0.5f);
+            write_value(fd, &buff, 1);
+        }
+    }
+
+    fclose(file_stream);
+}
+
+static void run_previous_net_load(void *ctx)
+{
+    (void)ctx;
+    mat_free(previous_net_load(NET_FILE));
+}
+static void run_net_load(void *ctx)
+{
+    (void)ctx;
+    net_free(net_load_from_file(NET_FILE));
+}
+static void run_previous_net_save(void *ctx)
+{
+    (void)ctx;
+    previous_net_save(PREVIOUS_NET_FILE);
+}
+static void run_net_save(void *ctx)
+{
+    (void)ctx;
+    net_save_to_file(net, NET_FILE);
+}
+static void run_previous_ds_load(void *ctx)
+{
+    (void)ctx;
+    ds_free(previous_ds_load(DATASET_FILE));
+}
+static void run_ds_load(void *ctx)
+{
+    (void)ctx;
+    ds_free(ds_load_from_compressed_file(DATASET_FILE));
+}
+static void run_previous_ds_save(void *ctx)
+{
+    (void)ctx;
+    previous_ds_save(PREVIOUS_DATASET_FILE);
+}
+static void run_ds_save(void *ctx)
+{
+    (void)ctx;
+    ds_save_to_compressed_file(ds, DATASET_FILE);
+}
+
+static long file_size(const char *filename)
+{
+    struct stat st;
+    if (stat(filename, &st) == -1)
+        errx(EXIT_FAILURE, "Failed to stat file: %s", filename);
+    return (long)st.st_size;
+}
+
+static BenchConfig config;
+static BenchReport report;
+
+/// @brief Measures the previous and the bulk versions of an operation on a
+/// file of size bytes.
+static void bench_pair(const char *name, const char *shape,
+                       void (*previous)(void *), void (*bulk)(void *),
+                       long size)
+{
+    void (*runs[2])(void *) = {previous, bulk};
+    const char *variants[2] = {"previous", "bulk"};
+    for (size_t i = 0; i < 2; i++)
+    {
+        BenchResult res;
+        bench_measure(&config, runs[i], NULL, (double)size, BenchBytes, &res);
+        res.name = name;
+        res.shape = shape;
+        res.variant = variants[i];
+        res.threads = 1;
+        bench_report_add(&report, &res);
+    }
+}
+
+/// @brief Exits if two files differ.
+static void check_same_files(const char *a, const char *b)
+{
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    if (fa == NULL || fb == NULL)
+        errx(EXIT_FAILURE, "Failed to open %s or %s.", a, b);
+
+    int ca, cb;
+    do
+    {
+        ca = getc(fa);
+        cb = getc(fb);
+        if (ca != cb)
+            errx(EXIT_FAILURE, "%s and %s differ.", a, b);
+    } while (ca != EOF);
+
+    fclose(fa);
+    fclose(fb);
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE, "Usage: %s [--format table|csv|json] [--samples N] "
+                       "[dataset]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    config = BENCH_DEFAULT_CONFIG;
+    const char *dataset = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else if (argv[i][0] != '-' && dataset == NULL)
+            dataset = argv[i];
+        else
+            usage(argv[0]);
+    }
+
+    rand_seed();
+    net = net_create_empty(3, (size_t[]){784, 128, 26});
+    ds = ds_load_from_compressed_file(
+        (char *)(dataset != NULL ? dataset : DEFAULT_DATASET));
+
+    char ds_shape[32];
+    snprintf(ds_shape, sizeof(ds_shape), "%zu", ds_size(ds));
+
+    // Both versions write the files first, which are checked before any
+    // measure.
+    run_previous_net_save(NULL);
+    run_net_save(NULL);
+    check_same_files(NET_FILE, PREVIOUS_NET_FILE);
+    run_previous_ds_save(NULL);
+    run_ds_save(NULL);
+    check_same_files(DATASET_FILE, PREVIOUS_DATASET_FILE);
+
+    long net_size = file_size(NET_FILE), ds_file_size = file_size(DATASET_FILE);
+
+    bench_report_begin(&report, stdout, format);
+    bench_pair("net_save", "784x128x26", run_previous_net_save, run_net_save,
+               net_size);
+    bench_pair("net_load", "784x128x26", run_previous_net_load, run_net_load,
+               net_size);
+    bench_pair("ds_save", ds_shape, run_previous_ds_save, run_ds_save,
+               ds_file_size);
+    bench_pair("ds_load", ds_shape, run_previous_ds_load, run_ds_load,
+               ds_file_size);
+    bench_report_end(&report);
+
+    unlink(NET_FILE);
+    unlink(PREVIOUS_NET_FILE);
+    unlink(DATASET_FILE);
+    unlink(PREVIOUS_DATASET_FILE);
+    ds_free(ds);
+    net_free(net);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "neural_network.h"
+
+/// @brief Converts a neural network file, in either format, to the version 2
+/// format, or back to the legacy format with `--legacy`.
+int main(int argc, char **argv)
+{
+    int legacy = argc == 4 && strcmp(argv[3], "--legacy") == 0;
+    if (argc != 3 && !legacy)
+        errx(EXIT_FAILURE, "Usage: %s input.nn output.nn [--legacy]",
+             argv[0]);
+
+    Neural_Network *net = net_load_from_file(argv[1]);
+
+    if (legacy)
+        net_save_to_file(net, argv[2]);
+    else
+        net_save_to_file_v2(net, argv[2]);
+
+    printf("%s -> %s (%s format)\n", argv[1], argv[2],
+           legacy ? "legacy" : "version 2");
+
+    net_free(net);
+
+    return EXIT_SUCCESS;
+}
@@ -1,12 +1,21 @@
 #include <err.h>
+#include <fcntl.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "dataset.h"
+#include "matrix/bit_matrix.h"
+#include "matrix/parallel.h"
 #include "neural_network.h"
+#include "utils/checksum/crc32.h"
+#include "utils/io/full_io.h"
 #include "utils/math/sigmoid.h"
 #include "utils/random/shuffle_array.h"
 
@@ -21,6 +30,20 @@ struct Neural_Network
     Matrix **biases;
     /// @brief Array of weight matrices, one per layer (first element is NULL).
     Matrix **weights;
+    /// @brief The transpose of the weights of the first layer, built by the
+    /// first pass on a sparse binary input (see input_weights_transpose) and
+    /// then kept up to date by net_update, NULL until then. Its rows are the
+    /// weights of each input, so that the product by a binary input is the sum
+    /// of the rows of its ones.
+    Matrix *input_weights_t;
+    /// @brief Guards the build of input_weights_t by concurrent passes on the
+    /// same network, e.g. the connections of the OCR server.
+    pthread_mutex_t input_weights_lock;
+    /// @brief The mapping of the version 2 file holding the coefficients of
+    /// the weights and biases, NULL if they were allocated.
+    void *mapping;
+    /// @brief The size in bytes of the mapping.
+    size_t mapping_size;
 };
 
 size_t net_layer_number(const Neural_Network *net) { return net->layer_number; }
@@ -33,6 +56,24 @@ size_t net_layer_height(const Neural_Network *net, size_t layer_id)
     return *(net->layer_heights + layer_id);
 }
 
+const Matrix *net_layer_weights(const Neural_Network *net, size_t layer)
+{
+    if (layer == 0 || layer >= net->layer_number)
+        errx(EXIT_FAILURE, "net_layer_weights: layer %zu does not exist",
+             layer);
+
+    return net->weights[layer];
+}
+
+const Matrix *net_layer_biases(const Neural_Network *net, size_t layer)
+{
+    if (layer == 0 || layer >= net->layer_number)
+        errx(EXIT_FAILURE, "net_layer_biases: layer %zu does not exist",
+             layer);
+
+    return net->biases[layer];
+}
+
 Neural_Network *net_create_empty(size_t layer_number, size_t *layer_heights)
 {
     // Check if arguments are valid.
@@ -85,6 +126,9 @@ Neural_Network *net_create_empty(size_t layer_number, size_t *layer_heights)
         // Use zero initialization for biases.
         net->biases[i] = mat_create_filled(layer_heights[i], 1, 0.01f);
     }
+    net->input_weights_t = NULL;
+    pthread_mutex_init(&net->input_weights_lock, NULL);
+    net->mapping = NULL;
 
     return net;
 }
@@ -94,9 +138,219 @@ void net_free(Neural_Network *net)
     free(net->layer_heights);
     mat_free_matrix_array(net->weights, net->layer_number);
     mat_free_matrix_array(net->biases, net->layer_number);
+    if (net->input_weights_t != NULL)
+    {
+        // The transpose borrows a block of its own, see
+        // input_weights_transpose.
+        float *content = mat_unsafe_coef_ptr(net->input_weights_t, 0, 0);
+        mat_free(net->input_weights_t);
+        free(content);
+    }
+    pthread_mutex_destroy(&net->input_weights_lock);
+    // The matrices only borrowed the coefficients of the mapping.
+    if (net->mapping != NULL)
+        munmap(net->mapping, net->mapping_size);
     free(net);
 }
 
+/// @brief The header of a version 2 network file (see `net_save_to_file_v2`).
+typedef struct NetFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint32_t byte_order;
+    /// @brief The CRC-32 of the header (with a zero checksum) and of the rest
+    /// of the file.
+    uint32_t checksum;
+    uint64_t layer_number;
+    /// @brief The size in bytes of the file.
+    uint64_t file_size;
+    uint8_t reserved[24];
+} NetFileHeader;
+
+_Static_assert(sizeof(NetFileHeader) == MAT_ALIGNMENT,
+               "The header of a network file must keep it aligned.");
+
+/// @brief An entry of the table of the matrices of a version 2 network file:
+/// the weights of layers 1 to layer_number - 1, then their biases.
+typedef struct NetFileBlob
+{
+    /// @brief The offset in bytes of the coefficients from the start of the
+    /// file, a multiple of MAT_ALIGNMENT.
+    uint64_t offset;
+    uint64_t height;
+    uint64_t width;
+    uint64_t stride;
+} NetFileBlob;
+
+/// @brief The magic number of version 2 network files. As the first 8 bytes of
+/// a legacy file, it would be a layer number of more than 10^18.
+static const char NET_FILE_MAGIC[8] = {'\x93', 'W', 'S', 'N', 'E', 'T', '\r', '\n'};
+#define NET_FILE_VERSION 2
+/// @brief Little-endian IEEE 754 single-precision floats.
+#define NET_FILE_FLOAT32 1
+/// @brief Written in the native byte order, so that files written by a machine
+/// of the other endianness are detected.
+#define NET_FILE_BYTE_ORDER 0x01020304u
+/// @brief The largest layer number and layer height accepted from a file,
+/// which keep the sizes computed from them far from overflowing.
+#define NET_FILE_MAX_LAYERS 1024
+#define NET_FILE_MAX_HEIGHT ((size_t)1 << 20)
+
+/// @brief Rounds a size up to a multiple of MAT_ALIGNMENT.
+static size_t align_up(size_t size)
+{
+    return (size + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT;
+}
+
+/// @brief Returns the offset in bytes of the first matrix of a version 2 file,
+/// after its header, its layer heights and its table.
+static size_t file_blobs_offset(size_t layer_number)
+{
+    return align_up(sizeof(NetFileHeader) + layer_number * sizeof(uint64_t) +
+                    2 * (layer_number - 1) * sizeof(NetFileBlob));
+}
+
+/// @brief Returns the checksum of a version 2 file from its content.
+static uint32_t file_checksum(const char *file, size_t size)
+{
+    NetFileHeader header;
+    memcpy(&header, file, sizeof(header));
+    header.checksum = 0;
+
+    uint32_t crc = crc32_update(0, &header, sizeof(header));
+    return crc32_update(crc, file + sizeof(header), size - sizeof(header));
+}
+
+/// @brief Returns a matrix of a version 2 file mapped at file, of size bytes,
+/// after checking its table entry against the expected shape.
+static Matrix *borrow_blob(char *file, size_t size, const NetFileBlob *blob,
+                           size_t height, size_t width, const char *filename)
+{
+    if (blob->height != height || blob->width != width ||
+        blob->stride < width || blob->stride > NET_FILE_MAX_HEIGHT)
+        errx(EXIT_FAILURE, "Invalid file %s: unexpected matrix shape.",
+             filename);
+    if (blob->offset % MAT_ALIGNMENT != 0 || blob->offset > size ||
+        height * blob->stride * sizeof(float) > size - blob->offset)
+        errx(EXIT_FAILURE, "Invalid file %s: matrix out of the file.",
+             filename);
+
+    return mat_create_borrowed(height, width, blob->stride,
+                               (float *)(file + blob->offset));
+}
+
+/// @brief Maps a version 2 network file, whose descriptor is fd, and uses its
+/// matrices in place.
+static Neural_Network *map_v2(int fd, const char *filename)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+        errx(EXIT_FAILURE, "Failed to stat file: %s", filename);
+    size_t size = st.st_size;
+    if (size < sizeof(NetFileHeader))
+        errx(EXIT_FAILURE, "Invalid file %s: truncated header.", filename);
+
+    // Private and writable: the training of the network copies the pages it
+    // modifies instead of writing them to the file.
+    char *file =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (file == MAP_FAILED)
+        errx(EXIT_FAILURE, "Failed to map file: %s", filename);
+
+    const NetFileHeader *header = (const NetFileHeader *)file;
+    if (header->version != NET_FILE_VERSION)
+        errx(EXIT_FAILURE, "Invalid file %s: unsupported version %u.",
+             filename, header->version);
+    if (header->byte_order != NET_FILE_BYTE_ORDER)
+        errx(EXIT_FAILURE, "Invalid file %s: written on a machine of another "
+                           "endianness.",
+             filename);
+    if (header->dtype != NET_FILE_FLOAT32)
+        errx(EXIT_FAILURE, "Invalid file %s: unsupported element type %u.",
+             filename, header->dtype);
+    if (header->file_size != size)
+        errx(EXIT_FAILURE, "Invalid file %s: expected %zu bytes, got %zu.",
+             filename, (size_t)header->file_size, size);
+    if (header->layer_number < 2 || header->layer_number > NET_FILE_MAX_LAYERS)
+        errx(EXIT_FAILURE, "Invalid file %s: invalid layer number %zu.",
+             filename, (size_t)header->layer_number);
+    size_t layer_number = header->layer_number;
+    if (file_blobs_offset(layer_number) > size)
+        errx(EXIT_FAILURE, "Invalid file %s: truncated table.", filename);
+    if (file_checksum(file, size) != header->checksum)
+        errx(EXIT_FAILURE, "Invalid file %s: checksum mismatch.", filename);
+
+    const uint64_t *heights =
+        (const uint64_t *)(file + sizeof(NetFileHeader));
+    const NetFileBlob *blobs = (const NetFileBlob *)(heights + layer_number);
+
+    Neural_Network *net = malloc(sizeof(Neural_Network));
+    if (net == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    net->layer_number = layer_number;
+    net->layer_heights = calloc(layer_number, sizeof(size_t));
+    net->weights = calloc(layer_number, sizeof(Matrix *));
+    net->biases = calloc(layer_number, sizeof(Matrix *));
+    if (net->layer_heights == NULL || net->weights == NULL ||
+        net->biases == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    for (size_t i = 0; i < layer_number; i++)
+    {
+        if (heights[i] == 0 || heights[i] > NET_FILE_MAX_HEIGHT)
+            errx(EXIT_FAILURE, "Invalid file %s: invalid %zuth layer height.",
+                 filename, i);
+        net->layer_heights[i] = heights[i];
+    }
+
+    for (size_t i = 1; i < layer_number; i++)
+    {
+        net->weights[i] =
+            borrow_blob(file, size, &blobs[i - 1], net->layer_heights[i],
+                        net->layer_heights[i - 1], filename);
+        net->biases[i] =
+            borrow_blob(file, size, &blobs[layer_number - 2 + i],
+                        net->layer_heights[i], 1, filename);
+    }
+    net->input_weights_t = NULL;
+    pthread_mutex_init(&net->input_weights_lock, NULL);
+    net->mapping = file;
+    net->mapping_size = size;
+
+    return net;
+}
+
+/// @brief Reads a matrix of a legacy file: its shape, then its coefficients
+/// at once.
+static Matrix *read_legacy_matrix(int fd, const char *filename,
+                                  const char *kind, size_t layer)
+{
+    size_t shape[2];
+    if (read_all(fd, shape, sizeof(shape)) != 0)
+        errx(EXIT_FAILURE,
+             "Invalid file %s: failed to read %zuth %s matrix's shape.",
+             filename, layer, kind);
+
+    size_t height = shape[0], width = shape[1];
+    if (height == 0 || height > NET_FILE_MAX_HEIGHT || width == 0 ||
+        width > NET_FILE_MAX_HEIGHT)
+        errx(EXIT_FAILURE,
+             "Invalid file %s: invalid %zuth %s matrix's shape %zux%zu.",
+             filename, layer, kind, height, width);
+
+    Matrix *m = mat_create(height, width);
+    if (read_all(fd, mat_coef_ptr(m, 0, 0), height * width * sizeof(float)) !=
+        0)
+        errx(EXIT_FAILURE,
+             "Invalid file %s: failed to read %zuth %s matrix's "
+             "coefficients.",
+             filename, layer, kind);
+
+    return m;
+}
+
 Neural_Network *net_load_from_file(char *filename)
 {
     FILE *file_stream = fopen(filename, "r");
@@ -108,19 +362,34 @@ Neural_Network *net_load_from_file(char *filename)
         errx(EXIT_FAILURE, "Failed to open file descriptor of file %s.",
              filename);
 
+    // A version 2 file starts with its magic number, a legacy one with its
+    // layer number.
+    union
+    {
+        char magic[8];
+        size_t layer_number;
+    } first;
+
+    if (read_all(fd, &first, sizeof(first)) != 0)
+        errx(EXIT_FAILURE, "Invalid file %s: failed to read layer_number.",
+             filename);
+
+    if (memcmp(first.magic, NET_FILE_MAGIC, sizeof(NET_FILE_MAGIC)) == 0)
+    {
+        Neural_Network *net = map_v2(fd, filename);
+        fclose(file_stream);
+        return net;
+    }
+
     Neural_Network *net = malloc(sizeof(Neural_Network));
     if (net == NULL)
         errx(EXIT_FAILURE,
              "Failed to allocate memory for net_load_from_file (net).");
-
-    // The number of bytes read has read.
-    ssize_t r_out;
-
-    // Read the layer number.
-    r_out = read(fd, &net->layer_number, sizeof(size_t));
-    if (r_out != sizeof(size_t))
-        errx(EXIT_FAILURE, "Invalid file %s: failed to read layer_number.",
-             filename);
+    net->layer_number = first.layer_number;
+    net->mapping = NULL;
+    if (net->layer_number < 2 || net->layer_number > NET_FILE_MAX_LAYERS)
+        errx(EXIT_FAILURE, "Invalid file %s: invalid layer number %zu.",
+             filename, net->layer_number);
 
     // Allocate the necessary arrays.
     net->layer_heights = calloc(net->layer_number, sizeof(size_t));
@@ -139,100 +408,109 @@ Neural_Network *net_load_from_file(char *filename)
         errx(EXIT_FAILURE,
              "Failed to allocate memory for net_load_from_file (net->biases).");
 
-    // Read the height of the layers.
-    for (size_t i = 0; i < net->layer_number; i++)
-    {
-        r_out = read(fd, &net->layer_heights[i], sizeof(size_t));
-        if (r_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Invalid file %s: failed to read %zuth layer's height.",
-                 filename, i);
-    }
+    // Read the height of the layers at once.
+    if (read_all(fd, net->layer_heights,
+                 net->layer_number * sizeof(size_t)) != 0)
+        errx(EXIT_FAILURE, "Invalid file %s: failed to read layers' heights.",
+             filename);
 
-    // Read the weights.
+    // Read the weights, then the biases.
     net->weights[0] = NULL;
     for (size_t i = 1; i < net->layer_number; i++)
-    {
-        size_t height, width;
+        net->weights[i] = read_legacy_matrix(fd, filename, "weight", i);
 
-        r_out = read(fd, &height, sizeof(size_t));
-        if (r_out != sizeof(size_t))
-            errx(
-                1,
-                "Invalid file %s: failed to read %zuth weight matrix's height.",
-                filename, i);
+    net->biases[0] = NULL;
+    for (size_t i = 1; i < net->layer_number; i++)
+        net->biases[i] = read_legacy_matrix(fd, filename, "bias", i);
 
-        r_out = read(fd, &width, sizeof(size_t));
-        if (r_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Invalid file %s: failed to read %zuth weight matrix's width.",
-                 filename, i);
+    net->input_weights_t = NULL;
+    pthread_mutex_init(&net->input_weights_lock, NULL);
 
-        float *content = calloc(height * width, sizeof(float));
-        if (content == NULL)
-            errx(EXIT_FAILURE,
-                 "Failed to allocate memory for net_load_from_file (content).");
+    fclose(file_stream);
 
-        // Read the matrix content.
-        for (size_t j = 0; j < height * width; j++)
-        {
-            r_out = read(fd, &content[j], sizeof(float));
-            if (r_out != sizeof(float))
-                errx(EXIT_FAILURE,
-                     "Invalid file %s: failed to read %zuth weight matrix's "
-                     "%zuth coefficient.",
-                     filename, i, j);
-        }
+    return net;
+}
 
-        net->weights[i] = mat_create_from_arr(height, width, content);
-        free(content);
-    }
+int net_file_checksum(const char *filename, uint32_t *checksum)
+{
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
 
-    // Read the biases.
-    net->biases[0] = NULL;
-    for (size_t i = 1; i < net->layer_number; i++)
+    // The checksum of a version 2 file is in its header.
+    NetFileHeader header;
+    if (read_all(fd, &header, sizeof(header)) == 0 &&
+        memcmp(header.magic, NET_FILE_MAGIC, sizeof(NET_FILE_MAGIC)) == 0)
     {
-        size_t height, width;
-
-        r_out = read(fd, &height, sizeof(size_t));
-        if (r_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Invalid file %s: failed to read %zuth bias matrix's height.",
-                 filename, i);
+        *checksum = header.checksum;
+        close(fd);
+        return 0;
+    }
 
-        r_out = read(fd, &width, sizeof(size_t));
-        if (r_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Invalid file %s: failed to read %zuth bias matrix's width.",
-                 filename, i);
+    // A legacy file has none: its whole content is hashed.
+    uint32_t crc = 0;
+    char buffer[1 << 16];
+    ssize_t r;
+    if (lseek(fd, 0, SEEK_SET) == -1)
+        r = -1;
+    else
+        while ((r = read(fd, buffer, sizeof(buffer))) > 0)
+            crc = crc32_update(crc, buffer, r);
+    close(fd);
+
+    if (r == -1)
+        return -1;
+    *checksum = crc;
+    return 0;
+}
 
-        float *content = calloc(height * width, sizeof(float));
-        if (content == NULL)
-            errx(EXIT_FAILURE,
-                 "Failed to allocate memory for net_load_from_file (content).");
+/// @brief Returns the size in bytes of a matrix in a legacy file: its shape,
+/// then its coefficients.
+static size_t legacy_matrix_size(const Matrix *m)
+{
+    return 2 * sizeof(size_t) + mat_height(m) * mat_width(m) * sizeof(float);
+}
 
-        // Read the matrix content.
-        for (size_t j = 0; j < height * width; j++)
-        {
-            r_out = read(fd, &content[j], sizeof(float));
-            if (r_out != sizeof(float))
-                errx(EXIT_FAILURE,
-                     "Invalid file %s: failed to read %zuth bias matrix's "
-                     "%zuth coefficient.",
-                     filename, i, j);
-        }
+/// @brief Writes a matrix in the legacy format at dst and returns the end of
+/// what was written.
+static char *write_legacy_matrix(char *dst, const Matrix *m)
+{
+    size_t shape[2] = {mat_height(m), mat_width(m)};
+    memcpy(dst, shape, sizeof(shape));
+    dst += sizeof(shape);
 
-        net->biases[i] = mat_create_from_arr(height, width, content);
-        free(content);
+    for (size_t h = 0; h < mat_height(m); h++)
+    {
+        memcpy(dst, mat_coef_ptr(m, h, 0), mat_width(m) * sizeof(float));
+        dst += mat_width(m) * sizeof(float);
     }
 
-    fclose(file_stream);
-
-    return net;
+    return dst;
 }
 
 void net_save_to_file(const Neural_Network *net, char *filename)
 {
+    // The whole file is built in memory and written at once.
+    size_t size = (1 + net->layer_number) * sizeof(size_t);
+    for (size_t i = 1; i < net->layer_number; i++)
+        size += legacy_matrix_size(net->weights[i]) +
+                legacy_matrix_size(net->biases[i]);
+
+    char *file = malloc(size);
+    if (file == NULL)
+        errx(EXIT_FAILURE,
+             "Failed to allocate memory for net_save_to_file (file).");
+
+    char *p = file;
+    memcpy(p, &net->layer_number, sizeof(size_t));
+    p += sizeof(size_t);
+    memcpy(p, net->layer_heights, net->layer_number * sizeof(size_t));
+    p += net->layer_number * sizeof(size_t);
+    for (size_t i = 1; i < net->layer_number; i++)
+        p = write_legacy_matrix(p, net->weights[i]);
+    for (size_t i = 1; i < net->layer_number; i++)
+        p = write_legacy_matrix(p, net->biases[i]);
+
     FILE *file_stream = fopen(filename, "w");
     if (file_stream == NULL)
         errx(EXIT_FAILURE, "Failed to open file: %s", filename);
@@ -242,103 +520,192 @@ void net_save_to_file(const Neural_Network *net, char *filename)
         errx(EXIT_FAILURE, "Failed to open file descriptor of file %s.",
              filename);
 
-    // The number of bytes write has written.
-    ssize_t w_out;
+    if (write_all(fd, file, size) != 0)
+        errx(EXIT_FAILURE, "Failed to write file %s.", filename);
 
-    // Write the layer number.
-    w_out = write(fd, &net->layer_number, sizeof(size_t));
-    if (w_out != sizeof(size_t))
-        errx(EXIT_FAILURE,
-             "Failed to write file %s: failed to write net->layer_number.",
-             filename);
+    fclose(file_stream);
+    free(file);
+}
 
-    // Write the height of the layers.
-    for (size_t i = 0; i < net->layer_number; i++)
+void net_save_to_file_v2(const Neural_Network *net, const char *filename)
+{
+    size_t layer_number = net->layer_number;
+
+    // The layout of the file: the matrices follow the table, in its order.
+    NetFileBlob blobs[2 * (layer_number - 1)];
+    const Matrix *matrices[2 * (layer_number - 1)];
+    size_t size = file_blobs_offset(layer_number);
+    for (size_t i = 0; i < 2 * (layer_number - 1); i++)
     {
-        w_out = write(fd, &net->layer_heights[i], sizeof(size_t));
-        if (w_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Failed to write file %s: failed to write %zuth layer's "
-                 "height.",
-                 filename, i);
+        const Matrix *m = i < layer_number - 1
+                              ? net->weights[i + 1]
+                              : net->biases[i - (layer_number - 1) + 1];
+        matrices[i] = m;
+        blobs[i] = (NetFileBlob){
+            .offset = size,
+            .height = mat_height(m),
+            .width = mat_width(m),
+            .stride = mat_stride(m),
+        };
+        size += align_up(mat_height(m) * mat_stride(m) * sizeof(float));
     }
 
-    // Write the weights.
-    for (size_t i = 1; i < net->layer_number; i++)
+    // The whole file is built in memory, the padding being zeros, and written
+    // at once.
+    char *file = calloc(size, 1);
+    if (file == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    NetFileHeader header = {
+        .version = NET_FILE_VERSION,
+        .dtype = NET_FILE_FLOAT32,
+        .byte_order = NET_FILE_BYTE_ORDER,
+        .layer_number = layer_number,
+        .file_size = size,
+    };
+    memcpy(header.magic, NET_FILE_MAGIC, sizeof(NET_FILE_MAGIC));
+
+    uint64_t *heights = (uint64_t *)(file + sizeof(NetFileHeader));
+    for (size_t i = 0; i < layer_number; i++)
+        heights[i] = net->layer_heights[i];
+    memcpy(heights + layer_number, blobs, sizeof(blobs));
+
+    for (size_t i = 0; i < 2 * (layer_number - 1); i++)
     {
-        size_t write_buff;
+        const Matrix *m = matrices[i];
+        float *dst = (float *)(file + blobs[i].offset);
+        for (size_t h = 0; h < mat_height(m); h++)
+            memcpy(dst + h * blobs[i].stride, mat_coef_ptr(m, h, 0),
+                   mat_width(m) * sizeof(float));
+    }
 
-        write_buff = mat_height(net->weights[i]);
-        w_out = write(fd, &write_buff, sizeof(size_t));
-        if (w_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Failed to write file %s: failed to write %zuth weight "
-                 "matrix's height.",
-                 filename, i);
+    memcpy(file, &header, sizeof(header));
+    header.checksum = file_checksum(file, size);
+    memcpy(file, &header, sizeof(header));
 
-        write_buff = mat_width(net->weights[i]);
-        w_out = write(fd, &write_buff, sizeof(size_t));
-        if (w_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Failed to write file %s: failed to write %zuth weight "
-                 "matrix's width.",
-                 filename, i);
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+    if (write_all(fd, file, size) != 0)
+        errx(EXIT_FAILURE, "Failed to write file %s.", filename);
+    close(fd);
 
-        // Write the matrix content.
-        for (size_t h = 0; h < mat_height(net->weights[i]); h++)
-        {
-            for (size_t w = 0; w < mat_width(net->weights[i]); w++)
-            {
-                w_out = write(fd, mat_coef_ptr(net->weights[i], h, w),
-                              sizeof(float));
-                if (w_out != sizeof(float))
-                    errx(
-                        1,
-                        "Failed to write file %s: failed to write %zuth weight "
-                        "matrix's coefficient at position (h:%zu, w:%zu).",
-                        filename, i, h, w);
-            }
-        }
-    }
+    free(file);
+}
 
-    // Write the biases.
-    for (size_t i = 1; i < net->layer_number; i++)
+/// @brief The largest fraction of ones of binary inputs for which the first
+/// layer sums the weights of their ones rather than multiplying by the dense
+/// weights: past it, the vectorized product is as fast and the packing is pure
+/// overhead.
+#define SPARSE_INPUT_MAX_DENSITY 0.25f
+
+/// @brief Returns whether inputs whose sum is sum, their number of ones if they
+/// are binary, are sparse enough for the first layer to only go through their
+/// weights. The sum stays a float: inputs that are not binary may have any
+/// sum, which the packing then rejects.
+static int is_sparse_input(float sum, size_t size)
+{
+    return sum <= SPARSE_INPUT_MAX_DENSITY * (float)size;
+}
+
+/// @brief Returns the transpose of the weights of the first layer, built on the
+/// first call, so that loading a network copies none of its weights. Its
+/// coefficients are allocated on the heap rather than in the active arena, if
+/// any: the transpose lives as long as the network.
+static const Matrix *input_weights_transpose(const Neural_Network *net)
+{
+    // The network is only logically const: the transpose is a cache.
+    Neural_Network *cache = (Neural_Network *)net;
+
+    pthread_mutex_lock(&cache->input_weights_lock);
+    if (cache->input_weights_t == NULL)
     {
-        size_t write_buff;
+        size_t height = mat_width(net->weights[1]);
+        size_t width = mat_height(net->weights[1]);
+        float *content = aligned_alloc(
+            MAT_ALIGNMENT, align_up(height * width * sizeof(float)));
+        if (content == NULL)
+            errx(EXIT_FAILURE, "Memory allocation failed.");
 
-        write_buff = mat_height(net->biases[i]);
-        w_out = write(fd, &write_buff, sizeof(size_t));
-        if (w_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Failed to write file %s: failed to write %zuth bias matrix's "
-                 "height.",
-                 filename, i);
+        Matrix *t = mat_create_borrowed(height, width, width, content);
+        mat_transpose_into(t, net->weights[1]);
+        cache->input_weights_t = t;
+    }
+    pthread_mutex_unlock(&cache->input_weights_lock);
 
-        write_buff = mat_width(net->biases[i]);
-        w_out = write(fd, &write_buff, sizeof(size_t));
-        if (w_out != sizeof(size_t))
-            errx(EXIT_FAILURE,
-                 "Failed to write file %s: failed to write %zuth bias matrix's "
-                 "width.",
-                 filename, i);
+    return net->input_weights_t;
+}
 
-        // Write the matrix content.
-        for (size_t h = 0; h < mat_height(net->biases[i]); h++)
-        {
-            for (size_t w = 0; w < mat_width(net->biases[i]); w++)
-            {
-                w_out = write(fd, mat_coef_ptr(net->biases[i], h, w),
-                              sizeof(float));
-                if (w_out != sizeof(float))
-                    errx(EXIT_FAILURE,
-                         "Failed to write file %s: failed to write %zuth bias "
-                         "matrix's coefficient at position (h:%zu, w:%zu).",
-                         filename, i, h, w);
-            }
-        }
+/// @brief Computes the pre-activations of the first layer for a sparse binary
+/// input column, as the biases plus the transposed weights of its ones.
+/// @return 1 on success, or 0 if the input is not binary or too dense.
+static int binary_input_forward(const Neural_Network *net,
+                                const Matrix *input, Matrix *pre)
+{
+    // mat_add_rows only sums into a contiguous column.
+    if (mat_height(input) != net->layer_heights[0] || mat_width(input) != 1 ||
+        mat_stride(pre) != 1)
+        return 0;
+
+    // The sum of a binary input is its number of ones: a dense input is not
+    // even scanned.
+    size_t indices[net->layer_heights[0]], count;
+    if (!is_sparse_input(mat_sum(input), net->layer_heights[0]) ||
+        !mat_binary_indices(input, indices, &count))
+        return 0;
+
+    mat_copy(pre, net->biases[1]);
+    mat_add_rows(pre, input_weights_transpose(net), indices, count);
+    return 1;
+}
+
+void net_dense_forward(const Neural_Network *net, size_t layer,
+                       const Matrix *input, Matrix *pre, Matrix *act)
+{
+    if (layer == 0 || layer >= net->layer_number)
+        errx(EXIT_FAILURE, "net_dense_forward: layer %zu does not exist",
+             layer);
+
+    // The pixels of a sparse binary image select the weights to sum.
+    if (layer == 1 && binary_input_forward(net, input, pre))
+    {
+        if (act != pre)
+            mat_copy(act, pre);
+        if (layer < net->layer_number - 1)
+            mat_inplace_relu(act);
+        else
+            mat_inplace_softmax(act);
+        return;
     }
 
-    fclose(file_stream);
+    if (layer < net->layer_number - 1)
+    {
+        mat_dense_relu(net->weights[layer], input, net->biases[layer], pre,
+                       act);
+        return;
+    }
+
+    // The softmax of the output layer needs the whole pre-activation vector.
+    mat_dense_relu(net->weights[layer], input, net->biases[layer], pre, NULL);
+    if (act != pre)
+        mat_copy(act, pre);
+    mat_inplace_softmax(act);
+}
+
+/// @brief Computes the forward pass into the preallocated layers_results and
+/// layers_activations, whose first elements are ignored.
+static void feed_forward_into(const Neural_Network *net, const Matrix *input,
+                              Matrix *layers_results[net_layer_number(net)],
+                              Matrix *layers_activations[net_layer_number(net)])
+{
+    const Matrix *prev_activation = input;
+
+    for (size_t i = 1; i < net->layer_number; i++)
+    {
+        net_dense_forward(net, i, prev_activation, layers_results[i],
+                          layers_activations[i]);
+        prev_activation = layers_activations[i];
+    }
 }
 
 Matrix *net_feed_forward(const Neural_Network *net, Matrix *input,
@@ -357,41 +724,32 @@ Matrix *net_feed_forward(const Neural_Network *net, Matrix *input,
         errx(EXIT_FAILURE, "layers_results and layers_activations have to be "
                            "null at the same time");
 
-    // Whether layers_results and layers_activations should be filled.
-    int out_params = layers_results != NULL;
-    if (out_params)
+    if (layers_results != NULL)
     {
         layers_results[0] = NULL;
         layers_activations[0] = mat_deepcopy(input);
-    }
+        for (size_t i = 1; i < net->layer_number; i++)
+        {
+            layers_results[i] = mat_create(net->layer_heights[i], 1);
+            layers_activations[i] = mat_create(net->layer_heights[i], 1);
+        }
+
+        feed_forward_into(net, input, layers_results, layers_activations);
 
-    Matrix *prev_activation = mat_deepcopy(input);
+        return mat_deepcopy(layers_activations[net->layer_number - 1]);
+    }
 
+    // Without the intermediate results, each layer is computed in place in a
+    // single vector.
+    Matrix *prev_activation = NULL;
     for (size_t i = 1; i < net->layer_number; i++)
     {
-        // Compute the result between layer i - 1 and i.
-
-        // The activation vector (column matrix) after the ith layer.
-        Matrix *curr_activation =
-            mat_multiplication(net->weights[i], prev_activation);
-        mat_inplace_addition(curr_activation, net->biases[i]);
-
-        // Store the result column matrix before the application of the
-        // activation function.
-        if (out_params)
-            layers_results[i] = mat_deepcopy(curr_activation);
-
-        if (i == net->layer_number - 1)
-            mat_inplace_softmax(curr_activation);
-        else
-            mat_inplace_relu(curr_activation);
-
-        // Store the activation column matrix.
-        if (out_params)
-            layers_activations[i] = mat_deepcopy(curr_activation);
-
-        mat_free(prev_activation);
+        Matrix *curr_activation = mat_create(net->layer_heights[i], 1);
+        net_dense_forward(net, i, i == 1 ? input : prev_activation,
+                          curr_activation, curr_activation);
 
+        if (prev_activation != NULL)
+            mat_free(prev_activation);
         prev_activation = curr_activation;
     }
 
@@ -471,65 +829,461 @@ void net_update(Neural_Network *net, Matrix **nabla_w, Matrix **nabla_b,
         mat_inplace_subtraction(net->weights[i], nabla_w[i]);
         mat_inplace_subtraction(net->biases[i], nabla_b[i]);
     }
+
+    if (net->input_weights_t != NULL)
+        mat_transpose_into(net->input_weights_t, net->weights[1]);
 }
 
-void net_train(Neural_Network *net, Dataset *dataset, size_t epochs,
-               size_t batch_size, float learning_rate)
+struct Net_Workspace
 {
-    for (size_t epoch = 0; epoch < epochs; epoch++)
+    size_t layer_number;
+    /// @brief Copy of the layer heights of the network.
+    size_t *layer_heights;
+    size_t max_batch_size;
+    /// @brief Number of samples of the loaded batch, i.e. of columns of the
+    /// batch matrices.
+    size_t batch_size;
+    /// @brief The activations of each layer, the first one being the inputs.
+    Matrix **activations;
+    /// @brief The transposes of the activations of each layer but the last
+    /// one, for the weight gradients (last element is NULL).
+    Matrix **activations_t;
+    /// @brief The pre-activations of each layer (first element is NULL).
+    Matrix **results;
+    /// @brief The errors of each layer (first element is NULL).
+    Matrix **deltas;
+    /// @brief The transposes of the weights of each layer but the first one,
+    /// for the back propagation of the errors (first two elements are NULL).
+    Matrix **weights_t;
+    /// @brief The gradients of the batch (first elements are NULL).
+    Matrix **nabla_w;
+    Matrix **nabla_b;
+    /// @brief The transposed pre-activations of the output layer, whose rows
+    /// are the outputs of each sample for the softmax.
+    Matrix *outputs_t;
+    /// @brief The expected outputs of the batch.
+    Matrix *expected;
+    /// @brief The inputs of the batch packed into bits if sparse_input is
+    /// set, with one row per sample, and its transpose.
+    BitMatrix *input_bits;
+    BitMatrix *input_bits_t;
+    /// @brief Whether the inputs of the batch are binary and sparse enough
+    /// for the first layer to go through input_bits.
+    int sparse_input;
+    /// @brief The transposed pre-activations, then errors, of the first layer
+    /// of a binary batch.
+    Matrix *first_t;
+    /// @brief The transposed weight gradient of the first layer of a binary
+    /// batch.
+    Matrix *input_nabla_w_t;
+    /// @brief The columns of the samples of a batch of a dataset.
+    const Matrix **inputs;
+    const Matrix **targets;
+};
+
+static Matrix **create_matrix_array(size_t length)
+{
+    Matrix **array = calloc(length, sizeof(Matrix *));
+    if (array == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in "
+                           "net_workspace_create.");
+    return array;
+}
+
+/// @brief Frees the matrices of an array, then the array itself.
+static void free_matrix_array(Matrix **array, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+        if (array[i] != NULL)
+            mat_free(array[i]);
+    free(array);
+}
+
+Net_Workspace *net_workspace_create(const Neural_Network *net,
+                                    size_t max_batch_size)
+{
+    if (max_batch_size == 0)
+        errx(EXIT_FAILURE,
+             "net_workspace_create: the batch size cannot be 0");
+
+    Net_Workspace *ws = malloc(sizeof(Net_Workspace));
+    if (ws == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in "
+                           "net_workspace_create.");
+
+    size_t n = net->layer_number;
+    const size_t *heights = net->layer_heights;
+
+    ws->layer_number = n;
+    ws->layer_heights = malloc(n * sizeof(size_t));
+    ws->inputs = malloc(max_batch_size * sizeof(Matrix *));
+    ws->targets = malloc(max_batch_size * sizeof(Matrix *));
+    if (ws->layer_heights == NULL || ws->inputs == NULL || ws->targets == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in "
+                           "net_workspace_create.");
+    memcpy(ws->layer_heights, heights, n * sizeof(size_t));
+
+    ws->max_batch_size = max_batch_size;
+    ws->batch_size = max_batch_size;
+    ws->activations = create_matrix_array(n);
+    ws->activations_t = create_matrix_array(n);
+    ws->results = create_matrix_array(n);
+    ws->deltas = create_matrix_array(n);
+    ws->weights_t = create_matrix_array(n);
+    ws->nabla_w = create_matrix_array(n);
+    ws->nabla_b = create_matrix_array(n);
+    ws->outputs_t = mat_create(max_batch_size, heights[n - 1]);
+    ws->expected = mat_create(heights[n - 1], max_batch_size);
+    ws->input_bits = mat_bit_create(max_batch_size, heights[0]);
+    ws->input_bits_t = mat_bit_create(heights[0], max_batch_size);
+    ws->sparse_input = 0;
+    ws->first_t = mat_create(max_batch_size, heights[1]);
+    ws->input_nabla_w_t = mat_create(heights[0], heights[1]);
+
+    for (size_t i = 0; i < n; i++)
     {
-        ds_shuffle(dataset);
+        ws->activations[i] = mat_create(heights[i], max_batch_size);
+        if (i < n - 1)
+            ws->activations_t[i] = mat_create(max_batch_size, heights[i]);
+    }
 
-        for (size_t batch = 0; batch < ds_size(dataset) / batch_size; batch++)
+    for (size_t i = 1; i < n; i++)
+    {
+        ws->results[i] = mat_create(heights[i], max_batch_size);
+        ws->deltas[i] = mat_create(heights[i], max_batch_size);
+        if (i > 1)
+            ws->weights_t[i] = mat_create(heights[i - 1], heights[i]);
+        ws->nabla_w[i] = mat_create(heights[i], heights[i - 1]);
+        ws->nabla_b[i] = mat_create(heights[i], 1);
+    }
+
+    return ws;
+}
+
+void net_workspace_free(Net_Workspace *ws)
+{
+    size_t n = ws->layer_number;
+
+    free_matrix_array(ws->activations, n);
+    free_matrix_array(ws->activations_t, n);
+    free_matrix_array(ws->results, n);
+    free_matrix_array(ws->deltas, n);
+    free_matrix_array(ws->weights_t, n);
+    free_matrix_array(ws->nabla_w, n);
+    free_matrix_array(ws->nabla_b, n);
+    mat_free(ws->outputs_t);
+    mat_free(ws->expected);
+    mat_bit_free(ws->input_bits);
+    mat_bit_free(ws->input_bits_t);
+    mat_free(ws->first_t);
+    mat_free(ws->input_nabla_w_t);
+    free(ws->layer_heights);
+    free(ws->inputs);
+    free(ws->targets);
+    free(ws);
+}
+
+size_t net_workspace_max_batch_size(const Net_Workspace *ws)
+{
+    return ws->max_batch_size;
+}
+
+/// @brief Resizes the batch matrices of a workspace to batch_size columns (or
+/// rows for the transposed ones).
+static void workspace_set_batch_size(Net_Workspace *ws, size_t batch_size)
+{
+    if (batch_size == 0 || batch_size > ws->max_batch_size)
+        errx(EXIT_FAILURE,
+             "Net_Workspace: a batch of %zu samples does not fit in a "
+             "workspace of %zu samples.",
+             batch_size, ws->max_batch_size);
+
+    if (batch_size == ws->batch_size)
+        return;
+
+    size_t n = ws->layer_number;
+    const size_t *heights = ws->layer_heights;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        mat_resize(ws->activations[i], heights[i], batch_size);
+        if (i < n - 1)
+            mat_resize(ws->activations_t[i], batch_size, heights[i]);
+        if (i == 0)
+            continue;
+        mat_resize(ws->results[i], heights[i], batch_size);
+        mat_resize(ws->deltas[i], heights[i], batch_size);
+    }
+    mat_resize(ws->outputs_t, batch_size, heights[n - 1]);
+    mat_resize(ws->expected, heights[n - 1], batch_size);
+    mat_resize(ws->first_t, batch_size, heights[1]);
+
+    ws->batch_size = batch_size;
+}
+
+void net_workspace_load(Net_Workspace *ws, const Matrix *const *inputs,
+                        const Matrix *const *expected, size_t batch_size)
+{
+    workspace_set_batch_size(ws, batch_size);
+
+    mat_set_columns(ws->activations[0], inputs);
+    // The sum of binary inputs is their number of ones: a dense batch is not
+    // even packed.
+    ws->sparse_input =
+        is_sparse_input(mat_sum(ws->activations[0]),
+                        mat_height(ws->activations[0]) * batch_size) &&
+        mat_bit_pack_columns(ws->input_bits, ws->activations[0]) &&
+        mat_bit_pack(ws->input_bits_t, ws->activations[0]);
+    if (expected != NULL)
+        mat_set_columns(ws->expected, expected);
+}
+
+/// @brief Loads the samples first to first + batch_size - 1 of a dataset into
+/// a workspace.
+static void workspace_load_dataset(Net_Workspace *ws, Dataset *dataset,
+                                   size_t first, size_t batch_size)
+{
+    workspace_set_batch_size(ws, batch_size);
+
+    for (size_t i = 0; i < batch_size; i++)
+    {
+        Training_Data *td = ds_get_data(dataset, first + i);
+        ws->inputs[i] = td->input;
+        ws->targets[i] = td->expected;
+    }
+
+    net_workspace_load(ws, ws->inputs, ws->targets, batch_size);
+}
+
+/// @brief Checks that a workspace was created for the layers of a network.
+static void check_workspace(const Neural_Network *net, const Net_Workspace *ws)
+{
+    int same = ws->layer_number == net->layer_number;
+    for (size_t i = 0; same && i < net->layer_number; i++)
+        same = ws->layer_heights[i] == net->layer_heights[i];
+
+    if (!same)
+        errx(EXIT_FAILURE, "Net_Workspace: the workspace was created for "
+                           "another network shape.");
+}
+
+const Matrix *net_feed_forward_workspace(const Neural_Network *net,
+                                         Net_Workspace *ws)
+{
+    check_workspace(net, ws);
+
+    size_t last = net->layer_number - 1;
+
+    for (size_t i = 1; i <= last; i++)
+    {
+        if (i == 1 && ws->sparse_input)
         {
-            Matrix **nabla_w = calloc(net->layer_number, sizeof(Matrix *));
-            Matrix **nabla_b = calloc(net->layer_number, sizeof(Matrix *));
-            for (size_t i = 1; i < net->layer_number; i++)
-            {
-                nabla_w[i] = mat_create_zero(mat_height(net->weights[i]),
-                                             mat_width(net->weights[i]));
-                nabla_b[i] = mat_create_zero(mat_height(net->biases[i]),
-                                             mat_width(net->biases[i]));
-            }
+            // Each sample sums the weights of its ones.
+            mat_bit_multiplication(ws->first_t, ws->input_bits,
+                                   input_weights_transpose(net));
+            mat_transpose_into(ws->results[1], ws->first_t);
+        }
+        else
+        {
+            mat_multiplication_into(ws->results[i], net->weights[i],
+                                    ws->activations[i - 1]);
+        }
+        mat_inplace_add_column(ws->results[i], net->biases[i]);
+
+        if (i < last)
+        {
+            mat_copy(ws->activations[i], ws->results[i]);
+            mat_inplace_relu(ws->activations[i]);
+            continue;
+        }
+
+        // The softmax of each sample is computed on a contiguous row.
+        mat_transpose_into(ws->outputs_t, ws->results[i]);
+        mat_inplace_row_softmax(ws->outputs_t);
+        mat_transpose_into(ws->activations[i], ws->outputs_t);
+    }
+
+    return ws->activations[last];
+}
+
+void net_back_propagation_workspace(const Neural_Network *net,
+                                    Net_Workspace *ws)
+{
+    check_workspace(net, ws);
+
+    size_t last = net->layer_number - 1;
+
+    // delta = (act[L - 1] - expected)
+    mat_copy(ws->deltas[last], ws->activations[last]);
+    mat_inplace_subtraction(ws->deltas[last], ws->expected);
 
-            for (size_t i = 0; i < batch_size; i++)
+    // The sum over the samples of delta × (act)^T is the product of the errors
+    // of the batch by its transposed activations.
+    for (size_t i = last; i > 0; --i)
+    {
+        if (i == 1 && ws->sparse_input)
+        {
+            // The gradient of the weights of an input sums the errors of the
+            // samples where it is 1: nabla_w^T = act[0] × delta^T
+            mat_transpose_into(ws->first_t, ws->deltas[1]);
+            mat_bit_multiplication(ws->input_nabla_w_t, ws->input_bits_t,
+                                   ws->first_t);
+            mat_transpose_into(ws->nabla_w[1], ws->input_nabla_w_t);
+        }
+        else
+        {
+            // nabla_w = delta × (act[i - 1])^T
+            mat_transpose_into(ws->activations_t[i - 1],
+                               ws->activations[i - 1]);
+            mat_multiplication_into(ws->nabla_w[i], ws->deltas[i],
+                                    ws->activations_t[i - 1]);
+        }
+
+        // nabla_b = the sum of the columns of delta
+        mat_sum_columns(ws->nabla_b[i], ws->deltas[i]);
+
+        if (i == 1)
+            break;
+
+        // delta = ((net.weights[i])^T × delta) ⊙ relu'(res[i - 1])
+        mat_transpose_into(ws->weights_t[i], net->weights[i]);
+        mat_multiplication_into(ws->deltas[i - 1], ws->weights_t[i],
+                                ws->deltas[i]);
+        mat_inplace_relu_derivative(ws->results[i - 1]);
+        mat_inplace_hadamard(ws->deltas[i - 1], ws->results[i - 1]);
+    }
+}
+
+Matrix *net_workspace_nabla_w(Net_Workspace *ws, size_t layer)
+{
+    if (layer == 0 || layer >= ws->layer_number)
+        errx(EXIT_FAILURE, "net_workspace_nabla_w: layer %zu does not exist",
+             layer);
+    return ws->nabla_w[layer];
+}
+
+Matrix *net_workspace_nabla_b(Net_Workspace *ws, size_t layer)
+{
+    if (layer == 0 || layer >= ws->layer_number)
+        errx(EXIT_FAILURE, "net_workspace_nabla_b: layer %zu does not exist",
+             layer);
+    return ws->nabla_b[layer];
+}
+
+void net_update_workspace(Neural_Network *net, Net_Workspace *ws,
+                          float learning_rate)
+{
+    check_workspace(net, ws);
+    net_update(net, ws->nabla_w, ws->nabla_b, ws->batch_size, learning_rate);
+}
+
+/// @brief A mini-batch split into shards, each going through its own
+/// workspace in a parallel loop over the shards.
+typedef struct
+{
+    const Neural_Network *net;
+    Dataset *dataset;
+    Net_Workspace **workspaces;
+    size_t shard_count;
+    /// @brief The index in the dataset of the first sample of the batch.
+    size_t first;
+    size_t batch_size;
+} TrainTask;
+
+static void train_shard_body(size_t begin, size_t end, void *ctx)
+{
+    const TrainTask *t = ctx;
+
+    for (size_t shard = begin; shard < end; shard++)
+    {
+        size_t first = shard * t->batch_size / t->shard_count;
+        size_t last = (shard + 1) * t->batch_size / t->shard_count;
+
+        Net_Workspace *ws = t->workspaces[shard];
+        workspace_load_dataset(ws, t->dataset, t->first + first, last - first);
+        net_feed_forward_workspace(t->net, ws);
+        net_back_propagation_workspace(t->net, ws);
+    }
+}
+
+/// @brief Sums the gradients of the shards into those of the first one by a
+/// pairwise tree: the shards i and i + step are added at each level. The order
+/// of the additions only depends on the number of shards.
+static void reduce_shard_gradients(Net_Workspace **workspaces,
+                                   size_t shard_count)
+{
+    for (size_t step = 1; step < shard_count; step *= 2)
+    {
+        for (size_t i = 0; i + step < shard_count; i += 2 * step)
+        {
+            Net_Workspace *dst = workspaces[i], *src = workspaces[i + step];
+            for (size_t j = 1; j < dst->layer_number; j++)
             {
-                Training_Data *td =
-                    ds_get_data(dataset, batch * batch_size + i);
-                Matrix **layers_results =
-                    calloc(net->layer_number, sizeof(Matrix *));
-                Matrix **layers_activations =
-                    calloc(net->layer_number, sizeof(Matrix *));
-                Matrix **delta_nabla_w =
-                    calloc(net->layer_number, sizeof(Matrix *));
-                Matrix **delta_nabla_b =
-                    calloc(net->layer_number, sizeof(Matrix *));
-
-                mat_free(net_feed_forward(net, td->input, layers_results,
-                                          layers_activations));
-
-                net_back_propagation(net, td->expected, layers_results,
-                                     layers_activations, delta_nabla_w,
-                                     delta_nabla_b);
-
-                for (size_t j = 1; j < net->layer_number; j++)
-                {
-                    mat_inplace_addition(nabla_w[j], delta_nabla_w[j]);
-                    mat_inplace_addition(nabla_b[j], delta_nabla_b[j]);
-                }
-
-                mat_free_matrix_array(layers_results, net->layer_number);
-                mat_free_matrix_array(layers_activations, net->layer_number);
-                mat_free_matrix_array(delta_nabla_w, net->layer_number);
-                mat_free_matrix_array(delta_nabla_b, net->layer_number);
+                mat_inplace_addition(dst->nabla_w[j], src->nabla_w[j]);
+                mat_inplace_addition(dst->nabla_b[j], src->nabla_b[j]);
             }
+        }
+    }
+}
+
+void net_train_parallel(Neural_Network *net, Dataset *dataset, size_t epochs,
+                        size_t batch_size, float learning_rate,
+                        size_t shard_count)
+{
+    if (batch_size == 0)
+        errx(EXIT_FAILURE, "net_train: the batch size cannot be 0");
+    if (shard_count == 0)
+        errx(EXIT_FAILURE, "net_train: the number of shards cannot be 0");
+
+    // Every shard has at least one sample.
+    if (shard_count > batch_size)
+        shard_count = batch_size;
+
+    Net_Workspace **workspaces = malloc(shard_count * sizeof(Net_Workspace *));
+    if (workspaces == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in net_train.");
+    for (size_t i = 0; i < shard_count; i++)
+        workspaces[i] = net_workspace_create(
+            net, (batch_size + shard_count - 1) / shard_count);
+
+    size_t parameters = 0;
+    for (size_t i = 1; i < net->layer_number; i++)
+        parameters += net->layer_heights[i] * net->layer_heights[i - 1];
 
-            net_update(net, nabla_w, nabla_b, batch_size, learning_rate);
+    TrainTask t = {.net = net,
+                   .dataset = dataset,
+                   .workspaces = workspaces,
+                   .shard_count = shard_count,
+                   .batch_size = batch_size};
 
-            mat_free_matrix_array(nabla_w, net->layer_number);
-            mat_free_matrix_array(nabla_b, net->layer_number);
+    for (size_t epoch = 0; epoch < epochs; epoch++)
+    {
+        ds_shuffle(dataset);
+
+        for (size_t batch = 0; batch < ds_size(dataset) / batch_size; batch++)
+        {
+            // The forward and backward passes of a sample take about 6
+            // floating point operations per weight.
+            t.first = batch * batch_size;
+            mat_parallel_for(shard_count,
+                             6 * parameters * (batch_size / shard_count),
+                             train_shard_body, &t);
+
+            reduce_shard_gradients(workspaces, shard_count);
+            net_update(net, workspaces[0]->nabla_w, workspaces[0]->nabla_b,
+                       batch_size, learning_rate);
         }
     }
+
+    for (size_t i = 0; i < shard_count; i++)
+        net_workspace_free(workspaces[i]);
+    free(workspaces);
+}
+
+void net_train(Neural_Network *net, Dataset *dataset, size_t epochs,
+               size_t batch_size, float learning_rate)
+{
+    net_train_parallel(net, dataset, epochs, batch_size, learning_rate, 1);
 }
 
 char net_decode_letter(Neural_Network *net, Matrix *input, float **out_chances)
@@ -546,6 +1300,112 @@ char net_decode_letter(Neural_Network *net, Matrix *input, float **out_chances)
     return letter;
 }
 
+Matrix *net_feed_forward_batch(const Neural_Network *net, const Matrix *inputs)
+{
+    if (mat_height(inputs) != net->layer_heights[0])
+        errx(EXIT_FAILURE,
+             "net_feed_forward_batch: expected input height %zu but got %zu",
+             net->layer_heights[0], mat_height(inputs));
+
+    // Sparse binary inputs only sum the weights of their ones.
+    BitMatrix *bits = NULL;
+    int sparse = is_sparse_input(mat_sum(inputs),
+                                 mat_height(inputs) * mat_width(inputs));
+    if (sparse)
+    {
+        bits = mat_bit_create(mat_width(inputs), mat_height(inputs));
+        sparse = mat_bit_pack_columns(bits, inputs);
+    }
+
+    // Each layer is a single product of its weights by the activations of the
+    // whole batch, instead of one matrix-vector product per sample.
+    Matrix *activations = NULL;
+    for (size_t i = 1; i < net->layer_number; i++)
+    {
+        Matrix *curr;
+        if (i == 1 && sparse)
+        {
+            Matrix *curr_t =
+                mat_create(mat_width(inputs), net->layer_heights[1]);
+            mat_bit_multiplication(curr_t, bits,
+                                   input_weights_transpose(net));
+            curr = mat_transpose(curr_t);
+            mat_free(curr_t);
+        }
+        else
+        {
+            curr = mat_multiplication(
+                net->weights[i], activations == NULL ? inputs : activations);
+        }
+        mat_inplace_add_column(curr, net->biases[i]);
+
+        if (i < net->layer_number - 1)
+            mat_inplace_relu(curr);
+        else
+            mat_inplace_column_softmax(curr);
+
+        if (activations != NULL)
+            mat_free(activations);
+        activations = curr;
+    }
+
+    if (bits != NULL)
+        mat_bit_free(bits);
+
+    return activations;
+}
+
+void net_decode_letters(const Neural_Network *net, const Matrix *inputs,
+                        char *out_letters, float *out_confidences)
+{
+    Matrix *res = net_feed_forward_batch(net, inputs);
+
+    for (size_t w = 0; w < mat_width(res); w++)
+    {
+        // The first row of the greatest probability, as mat_max_h.
+        size_t best = 0;
+        for (size_t h = 1; h < mat_height(res); h++)
+            if (*mat_unsafe_coef_ptr(res, h, w) >
+                *mat_unsafe_coef_ptr(res, best, w))
+                best = h;
+
+        out_letters[w] = 'a' + best;
+        if (out_confidences != NULL)
+            out_confidences[w] = *mat_unsafe_coef_ptr(res, best, w);
+    }
+
+    mat_free(res);
+}
+
+void net_decode_letter_array(const Neural_Network *net, Matrix **inputs,
+                             size_t count, char *out_letters)
+{
+    const Matrix **present = malloc(count * sizeof(Matrix *));
+    char *letters = malloc(count * sizeof(char));
+    if (present == NULL || letters == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed in "
+                           "net_decode_letter_array.");
+
+    size_t batch_size = 0;
+    for (size_t i = 0; i < count; i++)
+        if (inputs[i] != NULL)
+            present[batch_size++] = inputs[i];
+
+    if (batch_size > 0)
+    {
+        Matrix *batch = mat_create(net->layer_heights[0], batch_size);
+        mat_set_columns(batch, present);
+        net_decode_letters(net, batch, letters, NULL);
+        mat_free(batch);
+    }
+
+    for (size_t i = 0, w = 0; i < count; i++)
+        out_letters[i] = inputs[i] != NULL ? letters[w++] : '?';
+
+    free(present);
+    free(letters);
+}
+
 void net_print(Neural_Network *net, unsigned int precision)
 {
     printf("/---------[WEIGHTS]----------\n");
@@ -4,6 +4,7 @@
 #include "dataset.h"
 #include "matrix/matrix.h"
 #include <stddef.h>
+#include <stdint.h>
 
 /// @brief Represents a fully connected neural network.
 typedef struct Neural_Network Neural_Network;
@@ -22,6 +23,21 @@ size_t net_layer_number(const Neural_Network *net);
 /// exist.
 size_t net_layer_height(const Neural_Network *net, size_t layer_id);
 
+/// @brief Retrieves the weights of a layer of a neural network.
+/// @param[in] net Pointer to the Neural_Network structure.
+/// @param[in] layer Index of the layer (from 1 to layer_number - 1).
+/// @return The weight matrix of the layer, of the height of the layer and of
+/// the height of the previous layer as width.
+/// @throw Exits the program with an error if the layer does not exist.
+const Matrix *net_layer_weights(const Neural_Network *net, size_t layer);
+
+/// @brief Retrieves the biases of a layer of a neural network.
+/// @param[in] net Pointer to the Neural_Network structure.
+/// @param[in] layer Index of the layer (from 1 to layer_number - 1).
+/// @return The bias column of the layer.
+/// @throw Exits the program with an error if the layer does not exist.
+const Matrix *net_layer_biases(const Neural_Network *net, size_t layer);
+
 /// @brief Creates a new neural network with randomly initialized weights and
 /// biases.
 /// @param[in] layer_number Number of layers in the network (must be at least
@@ -39,22 +55,69 @@ Neural_Network *net_create_empty(size_t layer_number, size_t *layer_heights);
 /// @note The layer_heights array is also freed by this function.
 void net_free(Neural_Network *net);
 
-/// @brief Loads a neural network from a binary file.
+/// @brief Loads a neural network from a binary file, in either the legacy
+/// format written by `net_save_to_file` or the version 2 format written by
+/// `net_save_to_file_v2`. A version 2 file is mapped in memory by a single
+/// `mmap` and its weights and biases are those of the mapping, without copies.
+/// The mapping is private: training the network never modifies the file. It
+/// is unmapped by `net_free`. In both formats, the transposed weights of the
+/// first layer used by the sparse binary inputs are only built by the first
+/// pass on such an input.
 /// @param[in] filename Path to the file containing the serialized neural
 /// network.
 /// @return Pointer to a newly allocated Neural_Network structure with weights
 /// and biases loaded from the file.
-/// @throws Exits the program if the file cannot be opened, memory allocation
-/// fails, or the file contents are invalid.
+/// @throws Exits the program if the file cannot be opened or mapped, memory
+/// allocation fails, or the file contents are invalid (including a checksum
+/// mismatch of a version 2 file).
 Neural_Network *net_load_from_file(char *filename);
 
-/// @brief Saves a neural network to a binary file.
+/// @brief Returns a checksum that identifies the content of a network file:
+/// the CRC-32 stored in the header of a version 2 file, which is not read any
+/// further, or the CRC-32 of the whole content of a legacy file.
+/// @param[in] filename Path to the network file.
+/// @param[out] checksum Receives the checksum.
+/// @return 0 on success, or -1 if the file cannot be read.
+int net_file_checksum(const char *filename, uint32_t *checksum);
+
+/// @brief Saves a neural network to a binary file in the legacy format: the
+/// layer number, the layer heights, then the shape and the coefficients of
+/// each weight matrix and of each bias matrix.
 /// @param[in] net Pointer to the Neural_Network to be saved.
 /// @param[in] filename Path to the file where the network will be written.
 /// @throw Exits the program if the file cannot be opened or if writing fails at
 /// any point.
 void net_save_to_file(const Neural_Network *net, char *filename);
 
+/// @brief Saves a neural network to a binary file in the version 2 format: a
+/// 64-byte header (magic number, version, element type, byte order, CRC-32 of
+/// the file, layer number and file size), the layer heights, a table of the
+/// offset, height, width and stride of each weight and bias matrix, then their
+/// coefficients, each matrix starting on a MAT_ALIGNMENT-byte boundary so that
+/// `net_load_from_file` can use them in place.
+/// @param[in] net Pointer to the Neural_Network to be saved.
+/// @param[in] filename Path to the file where the network will be written.
+/// @throw Exits the program if the file cannot be opened or written.
+void net_save_to_file_v2(const Neural_Network *net, const char *filename);
+
+/// @brief Computes the forward pass of one layer of a neural network in a
+/// single pass over its weights, without allocating: pre = W × input + b, then
+/// act = relu(pre) for a hidden layer or act = softmax(pre) for the output
+/// layer. A sparse binary input of the first layer, such as a thin-stroked
+/// letter image, only goes through the weights of its ones.
+/// @param[in] net Pointer to the Neural_Network.
+/// @param[in] layer Index of the layer to compute (from 1 to layer_number - 1).
+/// @param[in] input Column matrix of the activations of the previous layer.
+/// @param[out] pre Column matrix of the height of the layer that receives the
+/// pre-activation values.
+/// @param[out] act Column matrix of the height of the layer that receives the
+/// activation values. It may be pre itself when the pre-activation values are
+/// not needed.
+/// @throw Exits the program if the layer does not exist or if the dimensions
+/// mismatch.
+void net_dense_forward(const Neural_Network *net, size_t layer,
+                       const Matrix *input, Matrix *pre, Matrix *act);
+
 /// @brief Computes the forward pass of a neural network on a given input.
 /// @param[in] net Pointer to the Neural_Network to use for the forward pass.
 /// @param[in] input Column matrix representing the input; it is not freed by
@@ -104,7 +167,97 @@ void net_back_propagation(Neural_Network *net, Matrix *expected,
 void net_update(Neural_Network *net, Matrix **nabla_w, Matrix **nabla_b,
                 size_t batch_size, float learning_rate);
 
+/// @brief The buffers of the forward and backward passes of a neural network
+/// on mini-batches of up to a maximum number of samples: the activations,
+/// pre-activations and errors of every layer, with one column per sample, and
+/// the gradients of the batch. Once it is created, the passes that use it do
+/// not allocate anything. A batch of sparse binary inputs is also packed into
+/// bits, and its first layer only goes through the weights of the ones of
+/// each input.
+typedef struct Net_Workspace Net_Workspace;
+
+/// @brief Creates the workspace of a neural network.
+/// @param[in] net Pointer to the Neural_Network. The workspace can be used by
+/// any network of the same layer heights.
+/// @param[in] max_batch_size The maximum number of samples of a batch (must be
+/// non-zero).
+/// @return Pointer to a newly allocated Net_Workspace.
+/// @throw Exits the program if max_batch_size is 0 or if memory allocation
+/// fails.
+Net_Workspace *net_workspace_create(const Neural_Network *net,
+                                    size_t max_batch_size);
+
+/// @brief Frees a workspace and all of its buffers.
+/// @param[in, out] ws Pointer to the Net_Workspace to be freed.
+void net_workspace_free(Net_Workspace *ws);
+
+/// @brief Returns the maximum number of samples of a batch of a workspace.
+size_t net_workspace_max_batch_size(const Net_Workspace *ws);
+
+/// @brief Copies a batch of samples into a workspace, one column per sample.
+/// @param[in, out] ws Pointer to the Net_Workspace.
+/// @param[in] inputs Array of batch_size column matrices of the height of the
+/// input layer.
+/// @param[in] expected Array of batch_size column matrices of the height of
+/// the output layer, or NULL if the batch is only fed forward.
+/// @param[in] batch_size The number of samples, at most the maximum batch size
+/// of the workspace (must be non-zero).
+/// @throw Exits the program if batch_size is out of range or if a sample does
+/// not have the expected shape.
+void net_workspace_load(Net_Workspace *ws, const Matrix *const *inputs,
+                        const Matrix *const *expected, size_t batch_size);
+
+/// @brief Computes the forward pass of the batch loaded in a workspace, one
+/// matrix product per layer, without allocating.
+/// @param[in] net Pointer to the Neural_Network.
+/// @param[in, out] ws Pointer to the Net_Workspace holding the batch.
+/// @return The matrix of the workspace whose columns are the outputs of the
+/// network for each sample, as returned by `net_feed_forward`. It is
+/// overwritten by the next pass.
+/// @throw Exits the program if the layer heights of the network and of the
+/// workspace differ.
+const Matrix *net_feed_forward_workspace(const Neural_Network *net,
+                                         Net_Workspace *ws);
+
+/// @brief Computes the gradients of the batch loaded in a workspace, summed
+/// over its samples, without allocating. It is `net_back_propagation` with one
+/// column per sample.
+/// @param[in] net Pointer to the Neural_Network.
+/// @param[in, out] ws Pointer to the Net_Workspace, whose batch went through
+/// `net_feed_forward_workspace` with net and was loaded with expected outputs.
+/// The pre-activations of the hidden layers are overwritten.
+/// @throw Exits the program if the layer heights of the network and of the
+/// workspace differ.
+void net_back_propagation_workspace(const Neural_Network *net,
+                                    Net_Workspace *ws);
+
+/// @brief Returns the gradient of the weights of a layer computed by
+/// `net_back_propagation_workspace`.
+/// @param[in] ws Pointer to the Net_Workspace.
+/// @param[in] layer The layer, from 1 to the number of layers - 1.
+/// @return The matrix of the workspace holding the gradient.
+/// @throw Exits the program if the layer does not exist.
+Matrix *net_workspace_nabla_w(Net_Workspace *ws, size_t layer);
+
+/// @brief Returns the gradient of the biases of a layer computed by
+/// `net_back_propagation_workspace` (see `net_workspace_nabla_w`).
+Matrix *net_workspace_nabla_b(Net_Workspace *ws, size_t layer);
+
+/// @brief Updates a neural network with the gradients of a workspace, as
+/// `net_update` with the size of the loaded batch. The gradients are scaled in
+/// place.
+/// @param[in, out] net Pointer to the Neural_Network to update.
+/// @param[in, out] ws Pointer to the Net_Workspace holding the gradients.
+/// @param[in] learning_rate Scalar to scale the gradient updates.
+void net_update_workspace(Neural_Network *net, Net_Workspace *ws,
+                          float learning_rate);
+
 /// @brief Trains a neural network using mini-batch stochastic gradient descent.
+/// Each mini-batch goes through the network at once, as a matrix with one
+/// column per sample: its gradients are products of the batch errors by the
+/// batch activations, computed in a Net_Workspace created once for the
+/// training.
+/// The samples left after the last full mini-batch of an epoch are skipped.
 /// @param[in, out] net Pointer to the Neural_Network to train; its weights and
 /// biases are updated.
 /// @param[in] training_data Array of pointers to Training_Data containing
@@ -114,10 +267,34 @@ void net_update(Neural_Network *net, Matrix **nabla_w, Matrix **nabla_b,
 /// dataset.
 /// @param[in] batch_size Number of samples per mini-batch.
 /// @param[in] learning_rate Scalar to scale the gradient updates.
-/// @throw Exits the program if any memory allocation fails during training.
+/// @throw Exits the program if batch_size is 0 or if any memory allocation
+/// fails during training.
 void net_train(Neural_Network *net, Dataset *dataset, size_t epochs,
                size_t batch_size, float learning_rate);
 
+/// @brief Trains a neural network like `net_train`, with each mini-batch split
+/// into shards of consecutive samples that go through their own Net_Workspace
+/// in parallel, on the threads of the matrix thread pool (see
+/// `mat_thread_count`). The gradients of the shards are then summed by a
+/// pairwise tree before the update.
+/// @param[in, out] net Pointer to the Neural_Network to train.
+/// @param[in] dataset The training samples, shuffled at every epoch.
+/// @param[in] epochs Number of times to iterate over the entire training
+/// dataset.
+/// @param[in] batch_size Number of samples per mini-batch.
+/// @param[in] learning_rate Scalar to scale the gradient updates.
+/// @param[in] shard_count The number of shards of a mini-batch, usually the
+/// number of threads of the pool. It is capped to batch_size.
+/// @throw Exits the program if batch_size or shard_count is 0, or if any
+/// memory allocation fails during training.
+/// @note The order of every floating point operation only depends on
+/// shard_count, not on the number of threads running the shards: for a given
+/// seed and shard_count, the trained network is always the same. With a single
+/// shard, it is `net_train`.
+void net_train_parallel(Neural_Network *net, Dataset *dataset, size_t epochs,
+                        size_t batch_size, float learning_rate,
+                        size_t shard_count);
+
 /// @brief Returns the letter associated to the given image (represented as a
 /// matrix).
 /// @param net The OCR neural network.
@@ -129,6 +306,43 @@ void net_train(Neural_Network *net, Dataset *dataset, size_t epochs,
 /// @return The guessed letter.
 char net_decode_letter(Neural_Network *net, Matrix *input, float **out_chances);
 
+/// @brief Computes the forward pass of a neural network on a batch of inputs,
+/// one matrix product per layer. If the inputs are sparse and binary, the
+/// first layer only sums the weights of their ones (see
+/// `mat_bit_multiplication`).
+/// @param[in] net Pointer to the Neural_Network.
+/// @param[in] inputs Matrix whose columns are the inputs (its height must be
+/// the height of the input layer).
+/// @return A new matrix of the height of the output layer whose columns are
+/// the outputs of the network for each input, as returned by
+/// `net_feed_forward`.
+/// @throw Exits the program if the input height does not match the network's
+/// input layer.
+Matrix *net_feed_forward_batch(const Neural_Network *net, const Matrix *inputs);
+
+/// @brief Returns the letters associated to a batch of images in a single
+/// forward pass (see `net_decode_letter`).
+/// @param net The OCR neural network.
+/// @param inputs The images to decode, one per column, each prepared as the
+/// input of `net_decode_letter`.
+/// @param out_letters Array of the width of inputs that receives the guessed
+/// letters.
+/// @param out_confidences If not null, array of the width of inputs that
+/// receives the chance of each guessed letter.
+void net_decode_letters(const Neural_Network *net, const Matrix *inputs,
+                        char *out_letters, float *out_confidences);
+
+/// @brief Decodes an array of images, some of which may be missing, in a
+/// single forward pass (see `net_decode_letters`).
+/// @param net The OCR neural network.
+/// @param inputs Array of count images prepared as the input of
+/// `net_decode_letter`, or NULL for the images that could not be read.
+/// @param count The number of images.
+/// @param out_letters Array of count letters that receives the guessed
+/// letters, and '?' for the missing images.
+void net_decode_letter_array(const Neural_Network *net, Matrix **inputs,
+                             size_t count, char *out_letters);
+
 /// @brief Prints all weights and biases of the given neural network. Displays
 /// each weight and bias matrix in a readable format using `mat_print()`. The
 /// output is grouped and labeled for clarity.
@@ -0,0 +1,192 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "neural_network.h"
+#include "ocr_client.h"
+#include "ocr_protocol.h"
+#include "utils/io/full_io.h"
+
+struct OcrClient
+{
+    /// @brief The connected socket.
+    int fd;
+};
+
+int ocr_server_socket_path(char *path, size_t size)
+{
+    const char *env = getenv(OCR_SERVER_SOCKET_ENV);
+    if (env != NULL && env[0] != '\0')
+        return (size_t)snprintf(path, size, "%s", env) < size ? 0 : -1;
+
+    // A directory of the user, unlike /tmp where anyone could answer in place
+    // of the server.
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir == NULL || runtime_dir[0] != '/')
+        return -1;
+    return (size_t)snprintf(path, size, "%s/%s", runtime_dir,
+                            OCR_SERVER_SOCKET_NAME) < size
+               ? 0
+               : -1;
+}
+
+void ocr_model_name(const char *model_path, char *name)
+{
+    const char *base = strrchr(model_path, '/');
+    base = base != NULL ? base + 1 : model_path;
+
+    const char *dot = strrchr(base, '.');
+    size_t length = dot != NULL && dot != base ? (size_t)(dot - base)
+                                               : strlen(base);
+    if (length >= OCR_MODEL_NAME_SIZE)
+        length = OCR_MODEL_NAME_SIZE - 1;
+
+    memcpy(name, base, length);
+    name[length] = '\0';
+}
+
+int ocr_model_id(const char *model_path, OcrModelId *id)
+{
+    ocr_model_name(model_path, id->name);
+    return net_file_checksum(model_path, &id->checksum);
+}
+
+OcrClient *ocr_client_connect(const char *socket_path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+        return NULL;
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return NULL;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    OcrClient *client = malloc(sizeof(OcrClient));
+    if (client == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    client->fd = fd;
+
+    return client;
+}
+
+void ocr_client_close(OcrClient *client)
+{
+    close(client->fd);
+    free(client);
+}
+
+int ocr_client_decode_letters(OcrClient *client, const OcrModelId *model,
+                              const Matrix *inputs, char *out_letters,
+                              float *out_confidences)
+{
+    size_t count = mat_width(inputs), height = mat_height(inputs);
+    if (count > OCR_MAX_BATCH ||
+        memchr(model->name, '\0', OCR_MODEL_NAME_SIZE) == NULL)
+        return -1;
+
+    OcrRequest request = {
+        .magic = OCR_PROTOCOL_MAGIC,
+        .version = OCR_PROTOCOL_VERSION,
+        .count = count,
+        .input_height = height,
+        .model_checksum = model->checksum,
+    };
+    strcpy(request.model, model->name);
+
+    // The images are sent one after the other: the rows of the transpose.
+    Matrix *images = mat_transpose(inputs);
+    int failed =
+        send_all(client->fd, &request, sizeof(request)) != 0 ||
+        send_all(client->fd, mat_coef_ptr(images, 0, 0),
+                 count * height * sizeof(float)) != 0;
+    mat_free(images);
+
+    OcrResponse response;
+    if (failed || read_all(client->fd, &response, sizeof(response)) != 0 ||
+        response.magic != OCR_PROTOCOL_MAGIC || response.status != OcrOk ||
+        response.count != count)
+        return -1;
+
+    float *confidences = malloc(count * sizeof(float));
+    if (confidences == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    failed = read_all(client->fd, out_letters, count) != 0 ||
+             read_all(client->fd, confidences, count * sizeof(float)) != 0;
+    if (!failed && out_confidences != NULL)
+        memcpy(out_confidences, confidences, count * sizeof(float));
+    free(confidences);
+
+    return failed ? -1 : 0;
+}
+
+int ocr_client_decode_letter_array(OcrClient *client, const OcrModelId *model,
+                                   Matrix **inputs, size_t count,
+                                   char *out_letters)
+{
+    const Matrix **present = malloc(count * sizeof(Matrix *));
+    char *letters = malloc(count * sizeof(char));
+    if (present == NULL || letters == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    size_t batch_size = 0;
+    for (size_t i = 0; i < count; i++)
+        if (inputs[i] != NULL)
+            present[batch_size++] = inputs[i];
+
+    // Batches larger than a request are split.
+    int failed = 0;
+    for (size_t begin = 0; begin < batch_size && !failed;
+         begin += OCR_MAX_BATCH)
+    {
+        size_t n = batch_size - begin < OCR_MAX_BATCH ? batch_size - begin
+                                                      : OCR_MAX_BATCH;
+        Matrix *batch = mat_create(mat_height(present[begin]), n);
+        mat_set_columns(batch, present + begin);
+        failed = ocr_client_decode_letters(client, model, batch,
+                                           letters + begin, NULL) != 0;
+        mat_free(batch);
+    }
+
+    if (!failed)
+        for (size_t i = 0, w = 0; i < count; i++)
+            out_letters[i] = inputs[i] != NULL ? letters[w++] : '?';
+
+    free(present);
+    free(letters);
+
+    return failed ? -1 : 0;
+}
+
+void ocr_decode_letter_array(const char *model_path, Matrix **inputs,
+                             size_t count, char *out_letters)
+{
+    char socket_path[OCR_SOCKET_PATH_SIZE];
+    OcrModelId model;
+    OcrClient *client = NULL;
+    if (ocr_server_socket_path(socket_path, sizeof(socket_path)) == 0 &&
+        ocr_model_id(model_path, &model) == 0)
+        client = ocr_client_connect(socket_path);
+    if (client != NULL)
+    {
+        int failed = ocr_client_decode_letter_array(client, &model, inputs,
+                                                    count, out_letters);
+        ocr_client_close(client);
+        if (!failed)
+            return;
+    }
+
+    // No server, or one without this file of the model: it is loaded here.
+    Neural_Network *net = net_load_from_file((char *)model_path);
+    net_decode_letter_array(net, inputs, count, out_letters);
+    net_free(net);
+}
@@ -0,0 +1,100 @@
+#ifndef OCR_CLIENT_H
+#define OCR_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "matrix/matrix.h"
+#include "ocr_protocol.h"
+
+/// @brief The size of a buffer for the path of a socket, its NUL included: the
+/// size of sun_path on Linux.
+#define OCR_SOCKET_PATH_SIZE 108
+
+/// @brief A connection to an `ocr_server` (see ocr_protocol.h).
+typedef struct OcrClient OcrClient;
+
+/// @brief Identifies a model of the server: the name of its file, and the
+/// checksum of its content, so that a server that loaded another file of the
+/// same name is not used.
+typedef struct OcrModelId
+{
+    char name[OCR_MODEL_NAME_SIZE];
+    uint32_t checksum;
+} OcrModelId;
+
+/// @brief Writes the path of the socket of the server: the value of
+/// OCR_SERVER_SOCKET_ENV if it is set, else OCR_SERVER_SOCKET_NAME in
+/// $XDG_RUNTIME_DIR, which only its user can access.
+/// @param[out] path A buffer of size bytes, which receives the path.
+/// @param[in] size The size of the buffer.
+/// @return 0 on success, or -1 if neither variable is set or the path does not
+/// fit: no server is then used.
+int ocr_server_socket_path(char *path, size_t size);
+
+/// @brief Writes the name under which the server knows the model of a file:
+/// its file name without directory and extension.
+/// @param[in] model_path The path of the model file.
+/// @param[out] name A buffer of OCR_MODEL_NAME_SIZE bytes, which receives the
+/// name, truncated if needed.
+void ocr_model_name(const char *model_path, char *name);
+
+/// @brief Computes the identity of the model of a file: its name (see
+/// `ocr_model_name`) and its checksum (see `net_file_checksum`).
+/// @param[in] model_path The path of the model file.
+/// @param[out] id Receives the identity.
+/// @return 0 on success, or -1 if the file cannot be read.
+int ocr_model_id(const char *model_path, OcrModelId *id);
+
+/// @brief Connects to a server.
+/// @param[in] socket_path The path of the socket of the server.
+/// @return The connection, or NULL if no server listens on the socket.
+OcrClient *ocr_client_connect(const char *socket_path);
+
+/// @brief Closes a connection.
+/// @param[in] client The connection to close.
+void ocr_client_close(OcrClient *client);
+
+/// @brief Decodes a batch of images with a model of the server, in a single
+/// request (see `net_decode_letters`).
+/// @param[in] client The connection.
+/// @param[in] model The identity of the model (see `ocr_model_id`).
+/// @param[in] inputs The images to decode, one per column, at most
+/// OCR_MAX_BATCH.
+/// @param[out] out_letters Array of the width of inputs that receives the
+/// guessed letters.
+/// @param[out] out_confidences If not NULL, array of the width of inputs that
+/// receives the chance of each guessed letter.
+/// @return 0 on success, or -1 if the connection failed or the server refused
+/// the request, e.g. because it loaded another file of the model, in which case
+/// the connection should be closed.
+int ocr_client_decode_letters(OcrClient *client, const OcrModelId *model,
+                              const Matrix *inputs, char *out_letters,
+                              float *out_confidences);
+
+/// @brief Decodes an array of images, some of which may be missing, with a
+/// model of the server (see `net_decode_letter_array`).
+/// @param[in] client The connection.
+/// @param[in] model The identity of the model (see `ocr_model_id`).
+/// @param[in] inputs Array of count images, or NULL for the missing ones.
+/// @param[in] count The number of images.
+/// @param[out] out_letters Array of count letters that receives the guessed
+/// letters, and '?' for the missing images.
+/// @return 0 on success, or -1 on a failure (see
+/// `ocr_client_decode_letters`).
+int ocr_client_decode_letter_array(OcrClient *client, const OcrModelId *model,
+                                   Matrix **inputs, size_t count,
+                                   char *out_letters);
+
+/// @brief Decodes an array of images with the model of a file: by the server
+/// if one listens on `ocr_server_socket_path` and loaded the same file of the
+/// model, else by loading the model in the calling process.
+/// @param[in] model_path The path of the model file.
+/// @param[in] inputs Array of count images, or NULL for the missing ones.
+/// @param[in] count The number of images.
+/// @param[out] out_letters Array of count letters that receives the guessed
+/// letters, and '?' for the missing images.
+void ocr_decode_letter_array(const char *model_path, Matrix **inputs,
+                             size_t count, char *out_letters);
+
+#endif
@@ -71,9 +71,11 @@ int main(void)
 
 
 
+        BitMatrix *bits = mat_bit_from_view(mat_view(res), 0.0f);
+
         size_t nb_words;
         BoundingBox **words_boxes =
-            get_bounding_box_words(res, remaining_box, 5, 20, 4, &nb_words);
+            get_bounding_box_words(bits, remaining_box, 5, 20, 4, &nb_words);
 
         free(remaining_box);
 
@@ -81,7 +83,8 @@ int main(void)
 
         size_t *word_nb_letters;
         BoundingBox ***letters_boxes = get_bounding_box_letters(
-            res, words_boxes, nb_words, 0, &word_nb_letters);
+            bits, words_boxes, nb_words, 0, &word_nb_letters);
+        mat_bit_free(bits);
 
         extract_letters(res, letters_boxes, nb_words, word_nb_letters);
 
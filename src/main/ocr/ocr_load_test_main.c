@@ -0,0 +1,205 @@
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dataset.h"
+#include "neural_network.h"
+#include "ocr_client.h"
+#include "ocr_protocol.h"
+
+/// @brief The model requested by default.
+#define DEFAULT_MODEL "./assets/ocr/model/grid.nn"
+
+/// @brief The dataset whose images are requested.
+#define DATASET "./assets/ocr/dataset/grid.dataset"
+
+/// @brief The number of distinct batches the clients cycle through.
+#define BATCH_COUNT 16
+
+/// @brief The number of loads timed for the in-process baseline.
+#define BASELINE_LOADS 50
+
+typedef struct Client
+{
+    size_t id;
+    /// @brief The latency of each request, in seconds.
+    double *latencies;
+    size_t mismatches;
+} Client;
+
+static OcrModelId model;
+static char socket_path[OCR_SOCKET_PATH_SIZE];
+static size_t requests, batch_size;
+static Matrix *batches[BATCH_COUNT];
+static char *expected[BATCH_COUNT];
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1E-9;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/// @brief Returns the value below which lie p percent of the sorted values.
+static double percentile(const double *sorted, size_t count, double p)
+{
+    size_t i = (size_t)(p / 100 * (double)(count - 1) + 0.5);
+    return sorted[i];
+}
+
+/// @brief Sends the requests of a client on its own connection.
+static void *run_client(void *arg)
+{
+    Client *client = arg;
+    OcrClient *connection = ocr_client_connect(socket_path);
+    if (connection == NULL)
+        errx(EXIT_FAILURE, "No server listens on %s.", socket_path);
+
+    char *letters = malloc(batch_size);
+    if (letters == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    for (size_t r = 0; r < requests; r++)
+    {
+        size_t b = (client->id + r) % BATCH_COUNT;
+        double start = now_s();
+        if (ocr_client_decode_letters(connection, &model, batches[b], letters,
+                                      NULL) != 0)
+            errx(EXIT_FAILURE, "The server refused the request of model '%s'.",
+                 model.name);
+        client->latencies[r] = now_s() - start;
+        client->mismatches += memcmp(letters, expected[b], batch_size) != 0;
+    }
+
+    free(letters);
+    ocr_client_close(connection);
+
+    return NULL;
+}
+
+/// @brief Measures the latency and throughput of a running `ocr_server`: each
+/// client sends its requests on its own connection, one after the other, and
+/// the letters are checked against a decoding in this process. The time a
+/// process takes to load the model and decode a batch itself is printed for
+/// comparison.
+int main(int argc, char **argv)
+{
+    if (argc > 5)
+        errx(EXIT_FAILURE, "Usage: %s [model.nn] [clients] [requests] [batch]",
+             argv[0]);
+
+    const char *model_path = argc > 1 ? argv[1] : DEFAULT_MODEL;
+    size_t client_count = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    requests = argc > 3 ? strtoul(argv[3], NULL, 10) : 1000;
+    batch_size = argc > 4 ? strtoul(argv[4], NULL, 10) : 64;
+    if (client_count == 0 || requests == 0 || batch_size == 0 ||
+        batch_size > OCR_MAX_BATCH)
+        errx(EXIT_FAILURE, "Invalid clients, requests or batch size.");
+
+    if (ocr_server_socket_path(socket_path, sizeof(socket_path)) != 0)
+        errx(EXIT_FAILURE, "No socket path: set %s or XDG_RUNTIME_DIR.",
+             OCR_SERVER_SOCKET_ENV);
+    if (ocr_model_id(model_path, &model) != 0)
+        errx(EXIT_FAILURE, "Failed to read file: %s", model_path);
+
+    Dataset *ds = ds_load_from_compressed_file(DATASET);
+    if (ds_size(ds) < batch_size)
+        errx(EXIT_FAILURE, "The dataset has fewer than %zu images.",
+             batch_size);
+
+    // The batches are consecutive images of the dataset, decoded here first to
+    // check the letters of the server.
+    Neural_Network *net = net_load_from_file((char *)model_path);
+    const Matrix **columns = malloc(batch_size * sizeof(Matrix *));
+    if (columns == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    for (size_t b = 0; b < BATCH_COUNT; b++)
+    {
+        size_t first = b * (ds_size(ds) - batch_size) / BATCH_COUNT;
+        for (size_t i = 0; i < batch_size; i++)
+            columns[i] = ds_get_data(ds, first + i)->input;
+        batches[b] = mat_create(mat_height(columns[0]), batch_size);
+        mat_set_columns(batches[b], columns);
+
+        expected[b] = malloc(batch_size);
+        if (expected[b] == NULL)
+            errx(EXIT_FAILURE, "Memory allocation failed.");
+        net_decode_letters(net, batches[b], expected[b], NULL);
+    }
+    free(columns);
+    net_free(net);
+
+    // What every decoding cost without the server.
+    char *letters = malloc(batch_size);
+    if (letters == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    double baseline_start = now_s();
+    for (size_t i = 0; i < BASELINE_LOADS; i++)
+    {
+        Neural_Network *loaded = net_load_from_file((char *)model_path);
+        net_decode_letters(loaded, batches[i % BATCH_COUNT], letters, NULL);
+        net_free(loaded);
+    }
+    double baseline = (now_s() - baseline_start) / BASELINE_LOADS;
+    free(letters);
+
+    Client *clients = calloc(client_count, sizeof(Client));
+    pthread_t *threads = malloc(client_count * sizeof(pthread_t));
+    double *latencies = malloc(client_count * requests * sizeof(double));
+    if (clients == NULL || threads == NULL || latencies == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    double start = now_s();
+    for (size_t c = 0; c < client_count; c++)
+    {
+        clients[c].id = c;
+        clients[c].latencies = latencies + c * requests;
+        if (pthread_create(&threads[c], NULL, run_client, &clients[c]) != 0)
+            errx(EXIT_FAILURE, "Failed to start a client thread.");
+    }
+    size_t mismatches = 0;
+    for (size_t c = 0; c < client_count; c++)
+    {
+        pthread_join(threads[c], NULL);
+        mismatches += clients[c].mismatches;
+    }
+    double duration = now_s() - start;
+
+    size_t total = client_count * requests;
+    qsort(latencies, total, sizeof(double), compare_doubles);
+
+    printf("%zu clients x %zu requests of %zu letters to model '%s'\n",
+           client_count, requests, batch_size, model.name);
+    printf("latency: p50 %.3f ms, p99 %.3f ms\n",
+           percentile(latencies, total, 50) * 1E3,
+           percentile(latencies, total, 99) * 1E3);
+    printf("throughput: %.0f requests/s, %.0f letters/s\n", total / duration,
+           total * batch_size / duration);
+    printf("without the server (load and decode): %.3f ms per batch\n",
+           baseline * 1E3);
+
+    free(latencies);
+    free(threads);
+    free(clients);
+    for (size_t b = 0; b < BATCH_COUNT; b++)
+    {
+        mat_free(batches[b]);
+        free(expected[b]);
+    }
+    ds_free(ds);
+
+    if (mismatches != 0)
+        errx(EXIT_FAILURE, "%zu responses differ from the local decoding.",
+             mismatches);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#ifndef OCR_PROTOCOL_H
+#define OCR_PROTOCOL_H
+
+#include <stdint.h>
+
+/// @brief The binary protocol of `ocr_server`, spoken over a Unix domain
+/// socket, so in the native byte order. A connection carries any number of
+/// requests, each answered by a response before the next one is read.
+///
+/// A request is an OcrRequest followed by count images of input_height
+/// floats, one image after the other, each prepared as the input of
+/// `net_decode_letter`. A response is an OcrResponse followed, if its status
+/// is OcrOk, by count letters (one byte each) then count confidences (floats).
+
+/// @brief The environment variable that sets the path of the socket of the
+/// server, used by both the server and its clients.
+#define OCR_SERVER_SOCKET_ENV "OCR_SERVER_SOCKET"
+
+/// @brief The name of the socket in $XDG_RUNTIME_DIR, the private runtime
+/// directory of the user, when OCR_SERVER_SOCKET_ENV is not set. Without
+/// either variable, no server is used.
+#define OCR_SERVER_SOCKET_NAME "word-search-ocr.sock"
+
+/// @brief The first field of every request and response ("OCRP").
+#define OCR_PROTOCOL_MAGIC 0x5052434Fu
+#define OCR_PROTOCOL_VERSION 2
+
+/// @brief The size of the model name of a request, its NUL included.
+#define OCR_MODEL_NAME_SIZE 32
+
+/// @brief The largest number of images of a request.
+#define OCR_MAX_BATCH 4096
+
+/// @brief The status of a response.
+typedef enum OcrStatus
+{
+    /// The images were decoded.
+    OcrOk,
+
+    /// The request is malformed (magic, version or batch size); the server
+    /// closes the connection after the response.
+    OcrBadRequest,
+
+    /// The server did not load the model of the request.
+    OcrUnknownModel,
+
+    /// The images do not have the height of the input layer of the model.
+    OcrBadShape,
+
+    /// The server loaded a model of this name from a file of another checksum.
+    OcrModelMismatch
+} OcrStatus;
+
+/// @brief The header of a request.
+typedef struct OcrRequest
+{
+    uint32_t magic;
+    uint32_t version;
+    /// @brief The number of images, from 1 to OCR_MAX_BATCH.
+    uint32_t count;
+    /// @brief The number of floats of each image.
+    uint32_t input_height;
+    /// @brief The checksum of the model file (see `net_file_checksum`), which
+    /// must match the one of the file loaded by the server.
+    uint32_t model_checksum;
+    uint32_t reserved;
+    /// @brief The NUL-terminated name of the model, the name of its file
+    /// without directory and extension (e.g. "grid" for
+    /// assets/ocr/model/grid.nn).
+    char model[OCR_MODEL_NAME_SIZE];
+} OcrRequest;
+
+/// @brief The header of a response.
+typedef struct OcrResponse
+{
+    uint32_t magic;
+    /// @brief An OcrStatus.
+    uint32_t status;
+    /// @brief The number of letters that follow, 0 on an error.
+    uint32_t count;
+    uint32_t reserved;
+} OcrResponse;
+
+#endif
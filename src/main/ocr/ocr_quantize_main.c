@@ -0,0 +1,177 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "bench/bench.h"
+#include "dataset.h"
+#include "neural_network.h"
+#include "quantized_network.h"
+
+/// @brief The dataset the quantized network is evaluated on by default.
+#define DEFAULT_DATASET "./assets/ocr/dataset/grid.dataset"
+
+static long file_size(const char *filename)
+{
+    struct stat st;
+    if (stat(filename, &st) == -1)
+        errx(EXIT_FAILURE, "Failed to stat file: %s", filename);
+    return (long)st.st_size;
+}
+
+/// @brief The inputs of a dataset as the columns of a matrix.
+static Matrix *dataset_batch(Dataset *ds)
+{
+    const Matrix **columns = malloc(ds_size(ds) * sizeof(Matrix *));
+    if (columns == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    for (size_t i = 0; i < ds_size(ds); i++)
+        columns[i] = ds_get_data(ds, i)->input;
+
+    Matrix *batch = mat_create(mat_height(columns[0]), ds_size(ds));
+    mat_set_columns(batch, columns);
+    free(columns);
+
+    return batch;
+}
+
+/// @brief The networks and the samples decoded by the benchmarked calls.
+typedef struct Decoding
+{
+    Neural_Network *net;
+    const Quantized_Network *qnet;
+    Dataset *ds;
+    const Matrix *batch;
+    char *letters;
+} Decoding;
+
+/// @brief Decodes the dataset one sample at a time with the float network.
+static void run_net_single(void *ctx)
+{
+    Decoding *d = ctx;
+    for (size_t i = 0; i < ds_size(d->ds); i++)
+        net_decode_letter(d->net, ds_get_data(d->ds, i)->input, NULL);
+}
+
+/// @brief Decodes the dataset one sample at a time with the quantized
+/// network.
+static void run_qnet_single(void *ctx)
+{
+    Decoding *d = ctx;
+    for (size_t i = 0; i < ds_size(d->ds); i++)
+        qnet_decode_letter(d->qnet, ds_get_data(d->ds, i)->input, NULL);
+}
+
+static void run_net_batch(void *ctx)
+{
+    Decoding *d = ctx;
+    net_decode_letters(d->net, d->batch, d->letters, NULL);
+}
+
+static void run_qnet_batch(void *ctx)
+{
+    Decoding *d = ctx;
+    qnet_decode_letters(d->qnet, d->batch, d->letters, NULL);
+}
+
+static BenchConfig config;
+static BenchReport report;
+
+/// @brief Measures the float and the quantized versions of a decoding of the
+/// whole dataset, and returns the speedup of the quantized one at the median.
+static double bench_pair(const char *name, const char *shape,
+                         void (*fp32)(void *), void (*int8)(void *),
+                         Decoding *d)
+{
+    void (*runs[2])(void *) = {fp32, int8};
+    const char *variants[2] = {"fp32", "int8"};
+    double throughputs[2];
+    for (size_t i = 0; i < 2; i++)
+    {
+        BenchResult res;
+        bench_measure(&config, runs[i], d, (double)ds_size(d->ds), BenchItems,
+                      &res);
+        res.name = name;
+        res.shape = shape;
+        res.variant = variants[i];
+        res.threads = 1;
+        bench_report_add(&report, &res);
+        throughputs[i] = res.throughput;
+    }
+    return throughputs[1] / throughputs[0];
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3 || argc > 4)
+        errx(EXIT_FAILURE, "Usage: %s model.nn output.qnn [dataset]", argv[0]);
+
+    Neural_Network *net = net_load_from_file(argv[1]);
+    Quantized_Network *quantized = qnet_quantize(net);
+    qnet_save_to_file(quantized, argv[2]);
+    qnet_free(quantized);
+
+    // The network is evaluated as it was saved.
+    Quantized_Network *qnet = qnet_load_from_file(argv[2]);
+
+    long net_size = file_size(argv[1]), qnet_size = file_size(argv[2]);
+    printf("model: %ld bytes (fp32) -> %ld bytes (int8), %.2fx smaller\n",
+           net_size, qnet_size, (double)net_size / (double)qnet_size);
+
+    Dataset *ds =
+        ds_load_from_compressed_file(argc == 4 ? argv[3] : DEFAULT_DATASET);
+    Matrix *batch = dataset_batch(ds);
+    size_t n = ds_size(ds);
+
+    char *net_letters = malloc(n), *qnet_letters = malloc(n);
+    if (net_letters == NULL || qnet_letters == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    net_decode_letters(net, batch, net_letters, NULL);
+    qnet_decode_letters(qnet, batch, qnet_letters, NULL);
+
+    size_t net_hits = 0, qnet_hits = 0, agreements = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        char expected = 'a' + ds_get_data(ds, i)->expected_class;
+        net_hits += net_letters[i] == expected;
+        qnet_hits += qnet_letters[i] == expected;
+        agreements += net_letters[i] == qnet_letters[i];
+    }
+
+    double net_accuracy = 100.0 * net_hits / n;
+    double qnet_accuracy = 100.0 * qnet_hits / n;
+    printf("accuracy on %zu samples: %.2f%% (fp32) -> %.2f%% (int8), "
+           "delta %+.2f points, %.2f%% identical predictions\n",
+           n, net_accuracy, qnet_accuracy, qnet_accuracy - net_accuracy,
+           100.0 * agreements / n);
+
+    // The throughputs are in samples per second.
+    char shape[32];
+    snprintf(shape, sizeof(shape), "%zu", n);
+    Decoding d = {
+        .net = net,
+        .qnet = qnet,
+        .ds = ds,
+        .batch = batch,
+        .letters = net_letters,
+    };
+    config = BENCH_DEFAULT_CONFIG;
+    printf("\n");
+    bench_report_begin(&report, stdout, BenchTable);
+    double single = bench_pair("decode_letter", shape, run_net_single,
+                               run_qnet_single, &d);
+    double batched = bench_pair("decode_letters", shape, run_net_batch,
+                                run_qnet_batch, &d);
+    bench_report_end(&report);
+    printf("\nint8 speedup at the median: %.2fx single, %.2fx batch\n", single,
+           batched);
+
+    free(net_letters);
+    free(qnet_letters);
+    mat_free(batch);
+    ds_free(ds);
+    qnet_free(qnet);
+    net_free(net);
+
+    return EXIT_SUCCESS;
+}
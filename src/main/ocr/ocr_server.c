@@ -0,0 +1,380 @@
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "neural_network.h"
+#include "ocr_client.h"
+#include "ocr_protocol.h"
+#include "ocr_server.h"
+#include "utils/io/full_io.h"
+
+/// @brief The number of connections waiting to be accepted.
+#define LISTEN_BACKLOG 64
+
+/// @brief The largest image height of a request, which keeps the size of its
+/// images far from overflowing.
+#define MAX_INPUT_HEIGHT (1 << 20)
+
+/// @brief The size of the chunks in which the images of a refused request are
+/// read and dropped.
+#define DISCARD_CHUNK_SIZE 16384
+
+/// @brief How long the server waits before accepting again when it runs out
+/// of file descriptors or memory, in milliseconds.
+#define ACCEPT_BACKOFF_MS 100
+
+/// @brief A model loaded by the server.
+typedef struct OcrModel
+{
+    OcrModelId id;
+    Neural_Network *net;
+} OcrModel;
+
+struct OcrServer
+{
+    char *socket_path;
+    /// @brief The lock file of the socket, locked as long as the server runs.
+    int lock_fd;
+    int listen_fd;
+    /// @brief A pipe whose read end becomes readable when the server stops,
+    /// polled along with the sockets.
+    int stop_pipe[2];
+    OcrModel *models;
+    size_t model_count;
+    /// @brief The number of open connections, guarded by lock.
+    size_t connections;
+    pthread_mutex_t lock;
+    /// @brief Signaled when the last connection closes.
+    pthread_cond_t idle;
+};
+
+/// @brief A connection served by its own thread.
+typedef struct Connection
+{
+    OcrServer *server;
+    int fd;
+} Connection;
+
+OcrServer *ocr_server_create(const char *socket_path,
+                             char *const *model_paths, size_t model_count)
+{
+    OcrServer *server = calloc(1, sizeof(OcrServer));
+    if (server == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    server->models = calloc(model_count, sizeof(OcrModel));
+    server->socket_path = strdup(socket_path);
+    if (server->models == NULL || server->socket_path == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    server->model_count = model_count;
+    for (size_t i = 0; i < model_count; i++)
+    {
+        OcrModel *model = &server->models[i];
+        if (ocr_model_id(model_paths[i], &model->id) != 0)
+            errx(EXIT_FAILURE, "Failed to read file: %s", model_paths[i]);
+        for (size_t j = 0; j < i; j++)
+            if (strcmp(server->models[j].id.name, model->id.name) == 0)
+                errx(EXIT_FAILURE, "Two models are named '%s'.",
+                     model->id.name);
+        model->net = net_load_from_file(model_paths[i]);
+    }
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+        errx(EXIT_FAILURE, "Socket path too long: %s", socket_path);
+    strcpy(addr.sun_path, socket_path);
+
+    // The lock file, never removed, is held by the running server: two servers
+    // cannot both find the socket stale and replace each other's.
+    char lock_path[sizeof(addr.sun_path) + 5];
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", socket_path);
+    server->lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (server->lock_fd == -1)
+        errx(EXIT_FAILURE, "Failed to open %s: %s", lock_path,
+             strerror(errno));
+    if (flock(server->lock_fd, LOCK_EX | LOCK_NB) == -1)
+        errx(EXIT_FAILURE, "A server already listens on %s.", socket_path);
+
+    // A socket file left by a server that did not stop is replaced, but
+    // nothing else is removed.
+    struct stat st;
+    if (lstat(socket_path, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+            errx(EXIT_FAILURE, "%s exists and is not a socket.", socket_path);
+        unlink(socket_path);
+    }
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server->listen_fd == -1)
+        errx(EXIT_FAILURE, "Failed to create socket: %s", strerror(errno));
+
+    // Only the user of the server can connect to its socket.
+    mode_t mask = umask(0077);
+    int bound =
+        bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    umask(mask);
+    if (!bound || listen(server->listen_fd, LISTEN_BACKLOG) == -1)
+        errx(EXIT_FAILURE, "Failed to listen on %s: %s", socket_path,
+             strerror(errno));
+
+    if (pipe(server->stop_pipe) == -1)
+        errx(EXIT_FAILURE, "Failed to create pipe: %s", strerror(errno));
+
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->idle, NULL);
+
+    return server;
+}
+
+/// @brief Waits until fd is readable and returns 0, or returns -1 once the
+/// server is stopped.
+static int wait_readable(OcrServer *server, int fd)
+{
+    struct pollfd fds[2] = {
+        {.fd = fd, .events = POLLIN},
+        {.fd = server->stop_pipe[0], .events = POLLIN},
+    };
+
+    while (poll(fds, 2, -1) == -1)
+        if (errno != EINTR)
+            return -1;
+
+    return fds[1].revents != 0 ? -1 : 0;
+}
+
+/// @brief Reads exactly size bytes from a connection, or returns -1 if it is
+/// closed or the server is stopped.
+static int receive(OcrServer *server, int fd, void *buffer, size_t size)
+{
+    char *p = buffer;
+    while (size > 0)
+    {
+        if (wait_readable(server, fd) != 0)
+            return -1;
+        ssize_t r = read(fd, p, size);
+        if (r <= 0)
+            return -1;
+        p += r;
+        size -= r;
+    }
+    return 0;
+}
+
+/// @brief Reads and drops size bytes from a connection, so that the next
+/// request can be read, without allocating them. Returns -1 like `receive`.
+static int discard(OcrServer *server, int fd, size_t size)
+{
+    char chunk[DISCARD_CHUNK_SIZE];
+    while (size > 0)
+    {
+        size_t n = size < sizeof(chunk) ? size : sizeof(chunk);
+        if (receive(server, fd, chunk, n) != 0)
+            return -1;
+        size -= n;
+    }
+    return 0;
+}
+
+static int respond_error(int fd, OcrStatus status)
+{
+    OcrResponse response = {.magic = OCR_PROTOCOL_MAGIC, .status = status};
+    return send_all(fd, &response, sizeof(response));
+}
+
+/// @brief Returns the model of a request, or NULL if it was not loaded.
+static const OcrModel *find_model(const OcrServer *server,
+                                  const OcrRequest *request)
+{
+    for (size_t i = 0; i < server->model_count; i++)
+        if (strcmp(server->models[i].id.name, request->model) == 0)
+            return &server->models[i];
+    return NULL;
+}
+
+/// @brief Reads the images of a request and sends its response. Returns -1 if
+/// the connection must be closed.
+static int serve_request(OcrServer *server, int fd, const OcrRequest *request)
+{
+    size_t count = request->count, height = request->input_height;
+    if (request->magic != OCR_PROTOCOL_MAGIC ||
+        request->version != OCR_PROTOCOL_VERSION || count == 0 ||
+        count > OCR_MAX_BATCH || height == 0 || height > MAX_INPUT_HEIGHT ||
+        memchr(request->model, '\0', OCR_MODEL_NAME_SIZE) == NULL)
+    {
+        respond_error(fd, OcrBadRequest);
+        return -1;
+    }
+
+    // The request is checked before its images are allocated: their size is
+    // then bounded by the models, not by the client.
+    const OcrModel *model = find_model(server, request);
+    OcrStatus status =
+        model == NULL                                  ? OcrUnknownModel
+        : model->id.checksum != request->model_checksum ? OcrModelMismatch
+        : net_layer_height(model->net, 0) != height     ? OcrBadShape
+                                                        : OcrOk;
+    size_t images_size = count * height * sizeof(float);
+    if (status != OcrOk)
+    {
+        // The images are still read, so that the next request can be.
+        if (discard(server, fd, images_size) != 0)
+            return -1;
+        return respond_error(fd, status);
+    }
+
+    Matrix *images = mat_create(count, height);
+    if (receive(server, fd, mat_coef_ptr(images, 0, 0), images_size) != 0)
+    {
+        mat_free(images);
+        return -1;
+    }
+
+    // The images are the columns of the batch.
+    Matrix *inputs = mat_transpose(images);
+    mat_free(images);
+
+    // The response is built in memory and sent at once.
+    OcrResponse header = {
+        .magic = OCR_PROTOCOL_MAGIC,
+        .status = OcrOk,
+        .count = count,
+    };
+    size_t size = sizeof(header) + count + count * sizeof(float);
+    char *response = malloc(size);
+    float *confidences = malloc(count * sizeof(float));
+    if (response == NULL || confidences == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    memcpy(response, &header, sizeof(header));
+    net_decode_letters(model->net, inputs, response + sizeof(header),
+                       confidences);
+    memcpy(response + sizeof(header) + count, confidences,
+           count * sizeof(float));
+
+    int failed = send_all(fd, response, size);
+
+    free(confidences);
+    free(response);
+    mat_free(inputs);
+
+    return failed;
+}
+
+static void *serve_connection(void *arg)
+{
+    Connection *connection = arg;
+    OcrServer *server = connection->server;
+    int fd = connection->fd;
+    free(connection);
+
+    OcrRequest request;
+    while (receive(server, fd, &request, sizeof(request)) == 0)
+        if (serve_request(server, fd, &request) != 0)
+            break;
+
+    close(fd);
+
+    pthread_mutex_lock(&server->lock);
+    if (--server->connections == 0)
+        pthread_cond_broadcast(&server->idle);
+    pthread_mutex_unlock(&server->lock);
+
+    return NULL;
+}
+
+/// @brief Waits for ms milliseconds and returns 0, or returns -1 once the
+/// server is stopped.
+static int wait_stop(OcrServer *server, int ms)
+{
+    struct pollfd fds = {.fd = server->stop_pipe[0], .events = POLLIN};
+    int ready;
+    while ((ready = poll(&fds, 1, ms)) == -1)
+        if (errno != EINTR)
+            return -1;
+    return ready == 0 ? 0 : -1;
+}
+
+int ocr_server_run(OcrServer *server)
+{
+    while (wait_readable(server, server->listen_fd) == 0)
+    {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            // The pending connection keeps the socket readable: accepting at
+            // once would spin until a connection closes and frees a slot.
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+                errno == ENOMEM)
+            {
+                if (wait_stop(server, ACCEPT_BACKOFF_MS) != 0)
+                    break;
+                continue;
+            }
+
+            return -1;
+        }
+
+        Connection *connection = malloc(sizeof(Connection));
+        if (connection == NULL)
+            errx(EXIT_FAILURE, "Memory allocation failed.");
+        connection->server = server;
+        connection->fd = fd;
+
+        pthread_mutex_lock(&server->lock);
+        server->connections++;
+        pthread_mutex_unlock(&server->lock);
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serve_connection, connection) != 0)
+            errx(EXIT_FAILURE, "Failed to start a connection thread.");
+        pthread_detach(thread);
+    }
+
+    return 0;
+}
+
+void ocr_server_stop(OcrServer *server)
+{
+    // The byte is never read: the pipe stays readable.
+    char byte = 0;
+    ssize_t w = write(server->stop_pipe[1], &byte, 1);
+    (void)w;
+}
+
+void ocr_server_free(OcrServer *server)
+{
+    pthread_mutex_lock(&server->lock);
+    while (server->connections > 0)
+        pthread_cond_wait(&server->idle, &server->lock);
+    pthread_mutex_unlock(&server->lock);
+
+    close(server->listen_fd);
+    unlink(server->socket_path);
+    close(server->lock_fd);
+    close(server->stop_pipe[0]);
+    close(server->stop_pipe[1]);
+
+    for (size_t i = 0; i < server->model_count; i++)
+        net_free(server->models[i].net);
+    free(server->models);
+    free(server->socket_path);
+
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->idle);
+    free(server);
+}
@@ -0,0 +1,46 @@
+#ifndef OCR_SERVER_H
+#define OCR_SERVER_H
+
+#include <stddef.h>
+
+/// @brief An OCR inference server: it loads its models once, then decodes the
+/// batches of letters of its clients over a Unix domain socket (see
+/// ocr_protocol.h). Each connection is served by its own thread.
+typedef struct OcrServer OcrServer;
+
+/// @brief Loads the models and listens on a socket, which only the user of the
+/// process can connect to. The server holds a lock on the file of the socket
+/// path followed by ".lock" as long as it runs, so that a stale socket file,
+/// left by a server that did not stop, is replaced, but not the socket of a
+/// running server.
+/// @param[in] socket_path The path of the socket.
+/// @param[in] model_paths The paths of the model files. Each model is known by
+/// the name of its file, and only serves the requests that give the checksum
+/// of this file (see `ocr_model_id`).
+/// @param[in] model_count The number of models.
+/// @return The server, which does not serve until `ocr_server_run`.
+/// @throw Terminates the program if a model cannot be loaded, two models have
+/// the same name, another server runs on the socket, something other than a
+/// socket exists at its path, or the socket cannot be created.
+OcrServer *ocr_server_create(const char *socket_path,
+                             char *const *model_paths, size_t model_count);
+
+/// @brief Accepts and serves connections until `ocr_server_stop`. When it runs
+/// out of file descriptors or memory, it waits a little before accepting
+/// again.
+/// @param[in] server The server.
+/// @return 0 once stopped, or -1 if accepting failed otherwise, with errno set.
+int ocr_server_run(OcrServer *server);
+
+/// @brief Makes `ocr_server_run` return, and the connections close after
+/// their current request. It is async-signal-safe, so that it can be called
+/// from a signal handler.
+/// @param[in] server The server.
+void ocr_server_stop(OcrServer *server);
+
+/// @brief Waits for the connections to close, then removes the socket and
+/// frees the models.
+/// @param[in] server The stopped server.
+void ocr_server_free(OcrServer *server);
+
+#endif
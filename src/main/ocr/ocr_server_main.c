@@ -0,0 +1,62 @@
+#include <err.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ocr_client.h"
+#include "ocr_protocol.h"
+#include "ocr_server.h"
+
+static OcrServer *server;
+
+static void stop(int signal)
+{
+    (void)signal;
+    ocr_server_stop(server);
+}
+
+/// @brief Loads the given models once, then decodes the letters of the
+/// clients on the socket of `ocr_server_socket_path` until SIGINT or SIGTERM.
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        errx(EXIT_FAILURE, "Usage: %s model.nn [model.nn...]", argv[0]);
+
+    char socket_path[OCR_SOCKET_PATH_SIZE];
+    if (ocr_server_socket_path(socket_path, sizeof(socket_path)) != 0)
+        errx(EXIT_FAILURE,
+             "No socket path: set %s, or XDG_RUNTIME_DIR for the default one.",
+             OCR_SERVER_SOCKET_ENV);
+    server = ocr_server_create(socket_path, argv + 1, argc - 1);
+
+    struct sigaction action = {.sa_handler = stop};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    for (int i = 1; i < argc; i++)
+    {
+        OcrModelId id;
+        ocr_model_id(argv[i], &id);
+        printf("Loaded model '%s' from %s (checksum %08x)\n", id.name, argv[i],
+               id.checksum);
+    }
+    printf("Listening on %s\n", socket_path);
+    fflush(stdout);
+
+    int failed = ocr_server_run(server);
+    if (failed)
+    {
+        fprintf(stderr, "Failed to accept a connection: %s\n",
+                strerror(errno));
+        // The connections close after their current request.
+        ocr_server_stop(server);
+    }
+
+    printf("Stopping...\n");
+    ocr_server_free(server);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
 
 #include "dataset.h"
 #include "matrix/matrix.h"
+#include "matrix/parallel.h"
 #include "neural_network.h"
 #include "utils/random/random.h"
 
@@ -85,7 +86,7 @@ int main()
 
         print_info(net, epoch, ds_test, ds_grid);
 
-        net_save_to_file(net, "ocr_real.nn");
+        net_save_to_file_v2(net, "ocr_real.nn");
     }
 
     net_free(net);
@@ -141,12 +142,14 @@ int main()
 
     while (accuracy < 0.90f)
     {
-        net_train(net, ds_train, EPOCH_STEP, 64, 0.01);
+        // One shard of each mini-batch per thread of the matrix library.
+        net_train_parallel(net, ds_train, EPOCH_STEP, 64, 0.01,
+                           mat_thread_count());
         epoch += EPOCH_STEP;
 
         accuracy = print_info(net, epoch, ds_test);
 
-        net_save_to_file(net, "ocr_grid.nn");
+        net_save_to_file_v2(net, "ocr_grid.nn");
     }
 
     net_free(net);
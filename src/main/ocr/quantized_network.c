@@ -0,0 +1,422 @@
+#include <err.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "matrix/matrix_s8.h"
+#include "matrix/parallel.h"
+#include "quantized_network.h"
+#include "utils/checksum/crc32.h"
+#include "utils/io/full_io.h"
+
+/// @brief Represents a quantized fully connected neural network.
+struct Quantized_Network
+{
+    /// @brief Number of layers in the network (must be at least 2).
+    size_t layer_number;
+    /// @brief Array of layer heights (number of neurons per layer).
+    size_t *layer_heights;
+    /// @brief The greatest layer height, which bounds the buffers of a pass.
+    size_t max_height;
+    /// @brief Array of bias columns, one per layer (first element is NULL).
+    Matrix **biases;
+    /// @brief Array of quantized weights, one per layer (first element is
+    /// NULL).
+    MatS8 **weights;
+};
+
+/// @brief The header of a quantized network file.
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    /// @brief QNET_FILE_BYTE_ORDER in the byte order of the writer.
+    uint32_t byte_order;
+    uint64_t layer_number;
+    /// @brief The CRC-32 of the header, with this field set to 0, followed by
+    /// the rest of the file.
+    uint32_t checksum;
+    uint32_t reserved;
+} QnetFileHeader;
+
+static const char QNET_FILE_MAGIC[8] = {'\x93', 'W', 'S', 'Q', 'N', 'E', 'T', '\n'};
+#define QNET_FILE_VERSION 1
+#define QNET_FILE_BYTE_ORDER 0x01020304u
+
+/// @brief Allocates a quantized network of the given shape, without its
+/// layers.
+static Quantized_Network *alloc_qnet(size_t layer_number,
+                                     const size_t *layer_heights)
+{
+    if (layer_number < 2)
+        errx(EXIT_FAILURE,
+             "Invalid given layer_number. Expected greater or equal to 2 and "
+             "got %zu.",
+             layer_number);
+
+    Quantized_Network *qnet = malloc(sizeof(Quantized_Network));
+    if (qnet == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    qnet->layer_number = layer_number;
+    qnet->layer_heights = malloc(layer_number * sizeof(size_t));
+    qnet->biases = calloc(layer_number, sizeof(Matrix *));
+    qnet->weights = calloc(layer_number, sizeof(MatS8 *));
+    if (qnet->layer_heights == NULL || qnet->biases == NULL ||
+        qnet->weights == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    qnet->max_height = 0;
+    for (size_t i = 0; i < layer_number; i++)
+    {
+        if (layer_heights[i] == 0)
+            errx(EXIT_FAILURE, "Invalid layer %zu: its height is zero.", i);
+        qnet->layer_heights[i] = layer_heights[i];
+        if (layer_heights[i] > qnet->max_height)
+            qnet->max_height = layer_heights[i];
+    }
+
+    return qnet;
+}
+
+Quantized_Network *qnet_quantize(const Neural_Network *net)
+{
+    size_t n = net_layer_number(net);
+    size_t heights[n];
+    for (size_t i = 0; i < n; i++)
+        heights[i] = net_layer_height(net, i);
+
+    Quantized_Network *qnet = alloc_qnet(n, heights);
+    for (size_t i = 1; i < n; i++)
+    {
+        qnet->weights[i] = mat_s8_quantize(net_layer_weights(net, i));
+        qnet->biases[i] = mat_deepcopy(net_layer_biases(net, i));
+    }
+
+    return qnet;
+}
+
+void qnet_free(Quantized_Network *qnet)
+{
+    for (size_t i = 1; i < qnet->layer_number; i++)
+    {
+        mat_s8_free(qnet->weights[i]);
+        mat_free(qnet->biases[i]);
+    }
+    free(qnet->weights);
+    free(qnet->biases);
+    free(qnet->layer_heights);
+    free(qnet);
+}
+
+size_t qnet_layer_number(const Quantized_Network *qnet)
+{
+    return qnet->layer_number;
+}
+
+size_t qnet_layer_height(const Quantized_Network *qnet, size_t layer_id)
+{
+    if (layer_id >= qnet->layer_number)
+        errx(EXIT_FAILURE, "qnet_layer_height: layer %zu does not exist",
+             layer_id);
+
+    return qnet->layer_heights[layer_id];
+}
+
+/// @brief Returns the size in bytes of the file of a network, header
+/// excluded.
+static size_t payload_size(size_t layer_number, const size_t *layer_heights)
+{
+    size_t size = layer_number * sizeof(uint64_t);
+    for (size_t i = 1; i < layer_number; i++)
+        size += layer_heights[i] * (2 * sizeof(float) + layer_heights[i - 1]);
+    return size;
+}
+
+/// @brief Returns the checksum of a file from its header and its payload.
+static uint32_t file_checksum(const QnetFileHeader *header,
+                              const char *payload, size_t size)
+{
+    QnetFileHeader copy = *header;
+    copy.checksum = 0;
+
+    uint32_t crc = crc32_update(0, &copy, sizeof(copy));
+    return crc32_update(crc, payload, size);
+}
+
+void qnet_save_to_file(const Quantized_Network *qnet, const char *filename)
+{
+    size_t size = payload_size(qnet->layer_number, qnet->layer_heights);
+    char *payload = malloc(size);
+    if (payload == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+
+    // The whole file is built in memory, then written at once.
+    char *p = payload;
+    for (size_t i = 0; i < qnet->layer_number; i++)
+    {
+        uint64_t height = qnet->layer_heights[i];
+        memcpy(p, &height, sizeof(height));
+        p += sizeof(height);
+    }
+    for (size_t i = 1; i < qnet->layer_number; i++)
+    {
+        size_t height = qnet->layer_heights[i];
+        size_t width = qnet->layer_heights[i - 1];
+
+        memcpy(p, mat_s8_scales(qnet->weights[i]), height * sizeof(float));
+        p += height * sizeof(float);
+        memcpy(p, mat_coef_ptr(qnet->biases[i], 0, 0), height * sizeof(float));
+        p += height * sizeof(float);
+        for (size_t h = 0; h < height; h++)
+        {
+            memcpy(p, mat_s8_row(qnet->weights[i], h), width);
+            p += width;
+        }
+    }
+
+    QnetFileHeader header = {
+        .version = QNET_FILE_VERSION,
+        .byte_order = QNET_FILE_BYTE_ORDER,
+        .layer_number = qnet->layer_number,
+    };
+    memcpy(header.magic, QNET_FILE_MAGIC, sizeof(QNET_FILE_MAGIC));
+    header.checksum = file_checksum(&header, payload, size);
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+
+    if (write_all(fd, &header, sizeof(header)) != 0 ||
+        write_all(fd, payload, size) != 0)
+        errx(EXIT_FAILURE, "Failed to write file %s.", filename);
+
+    close(fd);
+    free(payload);
+}
+
+Quantized_Network *qnet_load_from_file(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        errx(EXIT_FAILURE, "Failed to open file: %s", filename);
+
+    QnetFileHeader header;
+    if (read_all(fd, &header, sizeof(header)) != 0 ||
+        memcmp(header.magic, QNET_FILE_MAGIC, sizeof(QNET_FILE_MAGIC)) != 0)
+        errx(EXIT_FAILURE, "Invalid file %s: not a quantized network.",
+             filename);
+    if (header.version != QNET_FILE_VERSION)
+        errx(EXIT_FAILURE,
+             "Invalid file %s: unsupported quantized network version %u.",
+             filename, header.version);
+    if (header.byte_order != QNET_FILE_BYTE_ORDER)
+        errx(EXIT_FAILURE,
+             "Invalid file %s: the network was written on a machine of "
+             "another endianness.",
+             filename);
+    if (header.layer_number < 2 || header.layer_number > 1024)
+        errx(EXIT_FAILURE, "Invalid file %s: invalid number of layers %zu.",
+             filename, (size_t)header.layer_number);
+
+    size_t n = header.layer_number;
+    uint64_t raw_heights[n];
+    if (read_all(fd, raw_heights, sizeof(raw_heights)) != 0)
+        errx(EXIT_FAILURE, "Invalid file %s: failed to read layer heights.",
+             filename);
+
+    size_t heights[n];
+    for (size_t i = 0; i < n; i++)
+    {
+        if (raw_heights[i] == 0 || raw_heights[i] > (1 << 20))
+            errx(EXIT_FAILURE, "Invalid file %s: invalid layer height.",
+                 filename);
+        heights[i] = raw_heights[i];
+    }
+
+    // The heights are read again from the payload for the checksum.
+    size_t size = payload_size(n, heights);
+    char *payload = malloc(size);
+    if (payload == NULL)
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    memcpy(payload, raw_heights, sizeof(raw_heights));
+    if (read_all(fd, payload + sizeof(raw_heights),
+                 size - sizeof(raw_heights)) != 0)
+        errx(EXIT_FAILURE, "Invalid file %s: truncated quantized network.",
+             filename);
+    close(fd);
+
+    if (file_checksum(&header, payload, size) != header.checksum)
+        errx(EXIT_FAILURE, "Invalid file %s: checksum mismatch.", filename);
+
+    Quantized_Network *qnet = alloc_qnet(n, heights);
+    const char *p = payload + sizeof(raw_heights);
+    for (size_t i = 1; i < n; i++)
+    {
+        size_t height = heights[i], width = heights[i - 1];
+
+        qnet->weights[i] = mat_s8_create(height, width);
+        memcpy(mat_s8_scales(qnet->weights[i]), p, height * sizeof(float));
+        p += height * sizeof(float);
+        qnet->biases[i] = mat_create_from_arr(height, 1, (const float *)p);
+        p += height * sizeof(float);
+        for (size_t h = 0; h < height; h++)
+        {
+            memcpy(mat_s8_row(qnet->weights[i], h), p, width);
+            p += width;
+        }
+    }
+
+    free(payload);
+
+    return qnet;
+}
+
+/// @brief Computes the outputs of the last layer of a quantized network
+/// before the softmax.
+/// @param[in] input The values of the input layer.
+/// @param[out] logits The values of the output layer.
+static void forward_logits(const Quantized_Network *qnet, const float *input,
+                           float *logits)
+{
+    size_t last = qnet->layer_number - 1;
+    uint8_t quantized[qnet->max_height];
+    int32_t products[qnet->max_height];
+    float activations[qnet->max_height];
+
+    const float *x = input;
+    for (size_t i = 1; i <= last; i++)
+    {
+        const MatS8 *weights = qnet->weights[i];
+        const float *scales = mat_s8_scales(weights);
+        const float *biases = mat_coef_ptr(qnet->biases[i], 0, 0);
+        float *y = i == last ? logits : activations;
+
+        // y = (scales × x_scale) ⊙ (W × x) + b, then the ReLU.
+        float x_scale =
+            mat_s8_quantize_input(quantized, x, qnet->layer_heights[i - 1]);
+        mat_s8_gemv(weights, quantized, products);
+        for (size_t h = 0; h < qnet->layer_heights[i]; h++)
+        {
+            float v = (float)products[h] * (scales[h] * x_scale) + biases[h];
+            y[h] = i == last ? v : fmaxf(v, 0.0f);
+        }
+
+        x = y;
+    }
+}
+
+/// @brief Copies a column of a matrix into a contiguous array.
+static void gather_column(float *dst, const Matrix *m, size_t w)
+{
+    const float *src = mat_coef_ptr(m, 0, w);
+    size_t height = mat_height(m), stride = mat_stride(m);
+    for (size_t h = 0; h < height; h++)
+        dst[h] = src[h * stride];
+}
+
+static void check_input_height(const Quantized_Network *qnet, const Matrix *m)
+{
+    if (mat_height(m) != qnet->layer_heights[0])
+        errx(EXIT_FAILURE,
+             "Quantized forward pass failed: expected input height %zu but "
+             "got %zu.",
+             qnet->layer_heights[0], mat_height(m));
+}
+
+Matrix *qnet_feed_forward(const Quantized_Network *qnet, const Matrix *input)
+{
+    check_input_height(qnet, input);
+
+    float x[qnet->layer_heights[0]];
+    gather_column(x, input, 0);
+
+    Matrix *res = mat_create(qnet->layer_heights[qnet->layer_number - 1], 1);
+    forward_logits(qnet, x, mat_coef_ptr(res, 0, 0));
+    mat_inplace_softmax(res);
+
+    return res;
+}
+
+/// @brief Returns the letter of the greatest logit and, if confidence is not
+/// NULL, its softmax probability.
+static char decode_logits(const float *logits, size_t count, float *confidence)
+{
+    size_t best = 0;
+    for (size_t h = 1; h < count; h++)
+        if (logits[h] > logits[best])
+            best = h;
+
+    if (confidence != NULL)
+    {
+        float sum = 0.0f;
+        for (size_t h = 0; h < count; h++)
+            sum += expf(logits[h] - logits[best]);
+        *confidence = 1.0f / sum;
+    }
+
+    return 'a' + best;
+}
+
+char qnet_decode_letter(const Quantized_Network *qnet, const Matrix *input,
+                        float *out_confidence)
+{
+    check_input_height(qnet, input);
+
+    size_t outputs = qnet->layer_heights[qnet->layer_number - 1];
+    float x[qnet->layer_heights[0]], logits[outputs];
+    gather_column(x, input, 0);
+    forward_logits(qnet, x, logits);
+
+    return decode_logits(logits, outputs, out_confidence);
+}
+
+/// @brief The decoding of a batch, split by samples.
+typedef struct
+{
+    const Quantized_Network *qnet;
+    /// @brief The transposed inputs, one sample per row.
+    const Matrix *samples;
+    char *letters;
+    float *confidences;
+} DecodeTask;
+
+static void decode_body(size_t begin, size_t end, void *ctx)
+{
+    const DecodeTask *t = ctx;
+    size_t outputs = t->qnet->layer_heights[t->qnet->layer_number - 1];
+    float logits[outputs];
+
+    for (size_t w = begin; w < end; w++)
+    {
+        forward_logits(t->qnet, mat_coef_ptr(t->samples, w, 0), logits);
+        t->letters[w] = decode_logits(
+            logits, outputs, t->confidences ? &t->confidences[w] : NULL);
+    }
+}
+
+void qnet_decode_letters(const Quantized_Network *qnet, const Matrix *inputs,
+                         char *out_letters, float *out_confidences)
+{
+    check_input_height(qnet, inputs);
+
+    // A sample costs about one multiply-add per weight.
+    size_t cost = 0;
+    for (size_t i = 1; i < qnet->layer_number; i++)
+        cost += qnet->layer_heights[i] * qnet->layer_heights[i - 1];
+
+    // The samples are transposed into contiguous rows at once, rather than
+    // gathered from the columns one coefficient per cache line.
+    Matrix *samples = mat_transpose(inputs);
+
+    DecodeTask t = {.qnet = qnet,
+                    .samples = samples,
+                    .letters = out_letters,
+                    .confidences = out_confidences};
+    mat_parallel_for(mat_width(inputs), cost, decode_body, &t);
+
+    mat_free(samples);
+}
@@ -0,0 +1,90 @@
+#ifndef QUANTIZED_NETWORK_H
+#define QUANTIZED_NETWORK_H
+
+#include <stddef.h>
+
+#include "matrix/matrix.h"
+#include "neural_network.h"
+
+/// @brief A fully connected neural network quantized for inference: the
+/// weights of every layer are signed bytes with a scale per row (see
+/// `matrix/matrix_s8.h`), and each layer multiplies them by its input
+/// quantized to bytes, with one scale per sample. The biases, the ReLU and the
+/// softmax stay in floats. Its inputs and hidden activations must be
+/// non-negative, like the binary images of the OCR and the outputs of ReLU
+/// layers.
+typedef struct Quantized_Network Quantized_Network;
+
+/// @brief Quantizes the weights of a neural network, row by row.
+/// @param[in] net Pointer to the Neural_Network to quantize.
+/// @return Pointer to a newly allocated Quantized_Network, independent from
+/// net.
+Quantized_Network *qnet_quantize(const Neural_Network *net);
+
+/// @brief Frees a quantized network.
+/// @param[in] qnet Pointer to the Quantized_Network to free.
+void qnet_free(Quantized_Network *qnet);
+
+/// @brief Retrieves the number of layers in a quantized network.
+/// @param[in] qnet Pointer to the Quantized_Network.
+/// @return The number of layers in the network.
+size_t qnet_layer_number(const Quantized_Network *qnet);
+
+/// @brief Retrieves the height (number of neurons) of a layer of a quantized
+/// network.
+/// @param[in] qnet Pointer to the Quantized_Network.
+/// @param[in] layer_id Index of the layer to query (0-based).
+/// @return The number of neurons in the specified layer.
+/// @throw Exits the program with an error if the layer does not exist.
+size_t qnet_layer_height(const Quantized_Network *qnet, size_t layer_id);
+
+/// @brief Loads a quantized network from a file written by
+/// `qnet_save_to_file`.
+/// @param[in] filename Path to the file.
+/// @return Pointer to the loaded Quantized_Network.
+/// @throw Exits the program with an error if the file cannot be read, is not
+/// a quantized network or fails its checksum.
+Quantized_Network *qnet_load_from_file(const char *filename);
+
+/// @brief Saves a quantized network to a file: a 32-byte header (magic
+/// number, version, byte order, number of layers and a CRC-32 of the whole
+/// file), the heights of the layers as 64-bit integers, then for each layer
+/// the scales of its rows and its biases as floats and its weights as signed
+/// bytes, row by row. It is about four times smaller than the file of the
+/// float network.
+/// @param[in] qnet Pointer to the Quantized_Network to save.
+/// @param[in] filename Path to the file.
+/// @throw Exits the program with an error if the file cannot be written.
+void qnet_save_to_file(const Quantized_Network *qnet, const char *filename);
+
+/// @brief Computes the forward pass of a quantized network on a single input.
+/// @param[in] qnet Pointer to the Quantized_Network.
+/// @param[in] input Column matrix of the input, of the height of the input
+/// layer.
+/// @return A newly allocated column matrix of the probabilities of the output
+/// layer.
+/// @throw Exits the program with an error if the input height mismatches.
+Matrix *qnet_feed_forward(const Quantized_Network *qnet, const Matrix *input);
+
+/// @brief Decodes a letter image with a quantized network (see
+/// `net_decode_letter`).
+/// @param[in] qnet Pointer to the Quantized_Network, whose output layer has
+/// one neuron per letter.
+/// @param[in] input Column matrix of the image.
+/// @param[out] out_confidence If not NULL, receives the probability of the
+/// decoded letter.
+/// @return The decoded letter, from 'a'.
+char qnet_decode_letter(const Quantized_Network *qnet, const Matrix *input,
+                        float *out_confidence);
+
+/// @brief Decodes a batch of letter images with a quantized network, split
+/// between the threads of the matrix library.
+/// @param[in] qnet Pointer to the Quantized_Network.
+/// @param[in] inputs Matrix whose columns are the images.
+/// @param[out] out_letters Receives one letter per column of inputs.
+/// @param[out] out_confidences If not NULL, receives the probability of each
+/// decoded letter.
+void qnet_decode_letters(const Quantized_Network *qnet, const Matrix *inputs,
+                         char *out_letters, float *out_confidences);
+
+#endif
@@ -0,0 +1,118 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/bench.h"
+#include "dataset.h"
+#include "matrix/parallel.h"
+#include "neural_network.h"
+
+/// @brief The dataset trained on by default.
+#define DEFAULT_DATASET "./assets/ocr/dataset/grid.dataset"
+
+/// @brief The mini-batch size and learning rate of ocr_train.
+#define BATCH_SIZE 64
+#define LEARNING_RATE 0.01f
+
+/// @brief An epoch of net_train_parallel, the benchmarked call.
+typedef struct Training
+{
+    Neural_Network *net;
+    Dataset *ds;
+    size_t threads;
+} Training;
+
+static void run_epoch(void *ctx)
+{
+    Training *t = ctx;
+    net_train_parallel(t->net, t->ds, 1, BATCH_SIZE, LEARNING_RATE,
+                       t->threads);
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE,
+         "Usage: %s [--format table|csv|json] [--samples N] [dataset "
+         "[max_threads]]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    BenchConfig config = BENCH_DEFAULT_CONFIG;
+    const char *positional[2] = {DEFAULT_DATASET, NULL};
+    size_t positional_count = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else if (argv[i][0] != '-' && positional_count < 2)
+            positional[positional_count++] = argv[i];
+        else
+            usage(argv[0]);
+    }
+
+    Dataset *ds = ds_load_from_compressed_file((char *)positional[0]);
+
+    size_t max_threads = mat_thread_count();
+    if (positional[1] != NULL)
+    {
+        char *end;
+        max_threads = strtoul(positional[1], &end, 10);
+        if (*end != '\0' || max_threads == 0)
+            errx(EXIT_FAILURE, "%s: expected a positive number of threads.",
+                 positional[1]);
+    }
+
+    // The samples of an epoch: the last incomplete mini-batch is dropped.
+    size_t samples = ds_size(ds) / BATCH_SIZE * BATCH_SIZE;
+    char variant[32];
+    snprintf(variant, sizeof(variant), "batch%d", BATCH_SIZE);
+
+    BenchReport report;
+    bench_report_begin(&report, stdout, format);
+
+    // The scaling curve: powers of two up to max_threads, and max_threads.
+    for (size_t threads = 1; threads <= max_threads;
+         threads = threads * 2 > max_threads && threads < max_threads
+                       ? max_threads
+                       : threads * 2)
+    {
+        // A fixed seed, so that every run trains the same network.
+        srand(42);
+        Training t = {
+            .net = net_create_empty(3, (size_t[]){784, 128, 26}),
+            .ds = ds,
+            .threads = threads,
+        };
+        mat_set_thread_count(threads);
+
+        BenchResult res;
+        bench_measure(&config, run_epoch, &t, (double)samples, BenchItems,
+                      &res);
+        res.name = "net_train_parallel";
+        res.shape = "784x128x26";
+        res.variant = variant;
+        res.threads = threads;
+        bench_report_add(&report, &res);
+
+        net_free(t.net);
+    }
+
+    bench_report_end(&report);
+    ds_free(ds);
+
+    return EXIT_SUCCESS;
+}
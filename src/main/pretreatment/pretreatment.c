@@ -14,7 +14,7 @@ uint8_t pixel_to_grayscale(Pixel *pixel)
 
 Matrix *image_to_grayscale(ImageData *img)
 {
-    Matrix *grayscaled_pixels = mat_create_zero(img->height, img->width);
+    Matrix *grayscaled_pixels = mat_create_padded(img->height, img->width);
     for (size_t h = 0; h < img->height; h++)
     {
         for (size_t w = 0; w < img->width; w++)
@@ -80,7 +80,7 @@ Matrix *convolve_horizontally(const Matrix *src, const float *kernel,
     int m = (kernel_size - 1) / 2;
     size_t height = mat_height(src);
     size_t width = mat_width(src);
-    Matrix *dst = mat_create_zero(height, width);
+    Matrix *dst = mat_create_padded(height, width);
 
     for (size_t x = 0; x < height; x++)
         for (size_t y = 0; y < width; y++)
@@ -121,7 +121,7 @@ Matrix *convolve_vertically(const Matrix *src, const float *kernel,
     int m = (kernel_size - 1) / 2;
     size_t height = mat_height(src);
     size_t width = mat_width(src);
-    Matrix *dst = mat_create_zero(height, width);
+    Matrix *dst = mat_create_padded(height, width);
 
     for (size_t x = 0; x < height; x++)
         for (size_t y = 0; y < width; y++)
@@ -195,12 +195,9 @@ Matrix *adaptative_gaussian_thresholding(const Matrix *src, float max_value,
         return NULL;
     }
 
-    int status_export = export_matrix(blurred, GAUSSIAN_BLURRED_FILENAME);
-    if (status_export != 0)
-        fprintf(stderr, "step export : failed to export gaussian blur\n");
     size_t height = mat_height(src);
     size_t width = mat_width(src);
-    Matrix *dest = mat_create_zero(height, width);
+    Matrix *dest = mat_create_padded(height, width);
 
     for (size_t h = 0; h < height; h++)
     {
@@ -243,7 +240,7 @@ Matrix *morph_transformation_1d(const Matrix *src, size_t kernel_size,
     int anchor = kernel_size / 2; // handles even kernels
     size_t height = mat_height(src);
     size_t width = mat_width(src);
-    Matrix *dst = mat_create_zero(height, width);
+    Matrix *dst = mat_create_padded(height, width);
 
     for (size_t x = 0; x < height; x++)
         for (size_t y = 0; y < width; y++)
@@ -362,3 +359,117 @@ Matrix *morph_transform(Matrix *src, size_t kernel_size,
         return NULL;
     }
 }
+
+MatU8 *image_to_grayscale_u8(ImageData *img)
+{
+    MatU8 *grayscaled_pixels = mat_u8_create(img->height, img->width);
+    for (size_t h = 0; h < img->height; h++)
+    {
+        uint8_t *row = mat_u8_row(grayscaled_pixels, h);
+        for (size_t w = 0; w < img->width; w++)
+            row[w] = pixel_to_grayscale(&img->pixels[h * img->width + w]);
+    }
+    return grayscaled_pixels;
+}
+
+MatU8 *adaptative_gaussian_thresholding_u8(const MatU8 *src, uint8_t max_value,
+                                           size_t kernel_size, float sigma,
+                                           float c)
+{
+    if (kernel_size % 2 == 0)
+    {
+        fprintf(stderr, "The kernel size must be an odd number\n");
+        return NULL;
+    }
+    if (sigma <= 0)
+    {
+        fprintf(stderr, "Sigma must be positive\n");
+        return NULL;
+    }
+    if (src == NULL)
+    {
+        fprintf(stderr, "The source matrix is NULL\n");
+        return NULL;
+    }
+
+    float *kernel = gaussian_kernel_1d(sigma, kernel_size);
+    MatU8 *dest =
+        mat_u8_adaptive_threshold(src, kernel, kernel_size, c, max_value);
+    free(kernel);
+    return dest;
+}
+
+MatU8 *morph_transform_u8(const MatU8 *src, size_t kernel_size,
+                          enum MorphTransform transform)
+{
+    if (src == NULL)
+    {
+        fprintf(stderr, "morph_transform_u8: The source matrix is NULL\n");
+        return NULL;
+    }
+
+    // As in morph_transformation_1d, the text is dark on a light background:
+    // an erosion keeps the maximum of the neighbourhood and a dilation the
+    // minimum.
+    switch (transform)
+    {
+    case Erosion:
+        return mat_u8_max_filter(src, kernel_size);
+
+    case Dilation:
+        return mat_u8_min_filter(src, kernel_size);
+
+    case Opening:
+        MatU8 *eroded = mat_u8_max_filter(src, kernel_size);
+        MatU8 *opened = mat_u8_min_filter(eroded, kernel_size);
+        mat_u8_free(eroded);
+        return opened;
+
+    case Closing:
+        MatU8 *dilated = mat_u8_min_filter(src, kernel_size);
+        MatU8 *closed = mat_u8_max_filter(dilated, kernel_size);
+        mat_u8_free(dilated);
+        return closed;
+
+    default:
+        fprintf(stderr, "Invalid MorphTransform type\n");
+        return NULL;
+    }
+}
+
+BitMatrix *morph_transform_bit(const BitMatrix *src, size_t kernel_size,
+                               enum MorphTransform transform)
+{
+    if (src == NULL)
+    {
+        fprintf(stderr, "morph_transform_bit: The source matrix is NULL\n");
+        return NULL;
+    }
+
+    // The set bits are the white pixels: an erosion of the dark text is an
+    // OR and a dilation an AND.
+    switch (transform)
+    {
+    case Erosion:
+        return mat_bit_max_filter(src, kernel_size);
+
+    case Dilation:
+        return mat_bit_min_filter(src, kernel_size);
+
+    case Opening:
+        BitMatrix *eroded = mat_bit_max_filter(src, kernel_size);
+        BitMatrix *opened = mat_bit_min_filter(eroded, kernel_size);
+        mat_bit_free(eroded);
+        return opened;
+
+    case Closing:
+        BitMatrix *dilated = mat_bit_min_filter(src, kernel_size);
+        BitMatrix *closed = mat_bit_max_filter(dilated, kernel_size);
+        mat_bit_free(dilated);
+        return closed;
+
+    default:
+        fprintf(stderr, "Invalid MorphTransform type\n");
+        return NULL;
+    }
+}
@@ -6,7 +6,9 @@
 #define PRETREATMENT_H
 
 #include "image_loader/image_loading.h"
+#include "matrix/bit_matrix.h"
 #include "matrix/matrix.h"
+#include "matrix/matrix_u8.h"
 
 /// @brief Orientation of a line or object.
 typedef enum Orientation
@@ -42,7 +44,8 @@ typedef enum MorphTransform
 ///
 /// @param[in] img Pointer to the input image data (RGB).
 /// @return A newly allocated matrix containing grayscale values.
-///         Each element is in the range [0, 255].
+///         Each element is in the range [0, 255]. Its rows are padded (see
+///         mat_create_padded).
 /// @see pixel_to_grayscale
 Matrix *image_to_grayscale(ImageData *img);
 
@@ -121,6 +124,52 @@ Matrix *dilation(const Matrix *src, size_t kernel_size);
 Matrix *morph_transform(Matrix *src, size_t kernel_size,
                         enum MorphTransform transform);
 
+/// @brief Converts an ImageData to a grayscale byte matrix, see
+/// @ref image_to_grayscale.
+/// @param[in] img Pointer to the input image data (RGB).
+/// @return A newly allocated byte matrix containing the grayscale values.
+MatU8 *image_to_grayscale_u8(ImageData *img);
+
+/// @brief Byte version of @ref adaptative_gaussian_thresholding. The blur is
+/// computed in floats and fused with the comparison, so it is neither kept
+/// nor exported; the result is identical to the float version.
+/// @param[in] src Pointer to the input grayscale image.
+/// @param[in] max_value Value assigned to pixels that pass the threshold.
+/// @param[in] kernel_size Size of the Gaussian kernel (must be odd).
+/// @param[in] sigma Standard deviation of the Gaussian kernel (must be > 0).
+/// @param[in] c Constant subtracted from the local mean to determine the
+/// threshold.
+/// @return Pointer to a newly allocated thresholded image, or NULL if sigma
+/// or kernel_size is invalid or if @p src is NULL.
+MatU8 *adaptative_gaussian_thresholding_u8(const MatU8 *src, uint8_t max_value,
+                                           size_t kernel_size, float sigma,
+                                           float c);
+
+/// @brief Byte version of @ref morph_transform. It gives the same result as
+/// the float version on the same image.
+/// @param[in] src Pointer to the source image. Must not be NULL.
+/// @param[in] kernel_size Size of the kernel. Even kernel sizes are supported.
+/// @param[in] transform Type of morphological transformation (Erosion,
+/// Dilation, Opening, Closing).
+/// @return Pointer to a newly allocated transformed image, or NULL on failure.
+/// @note Caller is responsible for freeing the returned matrix using
+/// mat_u8_free().
+MatU8 *morph_transform_u8(const MatU8 *src, size_t kernel_size,
+                          enum MorphTransform transform);
+
+/// @brief Bit version of @ref morph_transform, for binary images whose set
+/// bits are the white pixels. Erosions and dilations are ORs and ANDs of 64
+/// pixels at a time.
+/// @param[in] src Pointer to the source image. Must not be NULL.
+/// @param[in] kernel_size Size of the kernel. Even kernel sizes are supported.
+/// @param[in] transform Type of morphological transformation (Erosion,
+/// Dilation, Opening, Closing).
+/// @return Pointer to a newly allocated transformed image, or NULL on failure.
+/// @note Caller is responsible for freeing the returned matrix using
+/// mat_bit_free().
+BitMatrix *morph_transform_bit(const BitMatrix *src, size_t kernel_size,
+                               enum MorphTransform transform);
+
 /// ============= internal functions ===============
 
 /// @brief Converts a Pixel to grayscale using Rec.709 luminance weights.
@@ -0,0 +1,211 @@
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/bench.h"
+#include "image_loader/image_loading.h"
+#include "matrix/matrix.h"
+#include "matrix/matrix_u8.h"
+#include "pretreatment/pretreatment.h"
+#include "rotation/rotation.h"
+
+/// @brief The rotation angle of the rotation stage, in degrees.
+#define ANGLE 7.0f
+
+/// @brief The images benchmarked when none is given on the command line.
+static const char *sample_images[] = {
+    "assets/sample_images/level_1_image_1.png",
+    "assets/sample_images/level_1_image_2.png",
+    "assets/sample_images/level_2_image_1.png",
+    "assets/sample_images/level_2_image_2.png",
+    "assets/sample_images/level_3_image_1.png",
+    "assets/sample_images/level_3_image_2.png",
+};
+
+static Matrix *grayscale(const void *in)
+{
+    return image_to_grayscale((ImageData *)in);
+}
+static MatU8 *grayscale_u8(const void *in)
+{
+    return image_to_grayscale_u8((ImageData *)in);
+}
+static Matrix *threshold(const void *in)
+{
+    return adaptative_gaussian_thresholding(in, 255, 11, 7, 4);
+}
+static MatU8 *threshold_u8(const void *in)
+{
+    return adaptative_gaussian_thresholding_u8(in, 255, 11, 7, 4);
+}
+static Matrix *rotation(const void *in) { return rotate_matrix(in, ANGLE); }
+static MatU8 *rotation_u8(const void *in)
+{
+    return rotate_matrix_u8(in, ANGLE);
+}
+static Matrix *closing(const void *in)
+{
+    return morph_transform((Matrix *)in, 2, Closing);
+}
+static MatU8 *closing_u8(const void *in)
+{
+    return morph_transform_u8(in, 2, Closing);
+}
+static Matrix *opening(const void *in)
+{
+    return morph_transform((Matrix *)in, 2, Opening);
+}
+static MatU8 *opening_u8(const void *in)
+{
+    return morph_transform_u8(in, 2, Opening);
+}
+
+/// @brief The stages of the pretreatment, each applied to the result of the
+/// previous one (the loaded image for the first), in both pixel types.
+static const struct Stage
+{
+    const char *name;
+    Matrix *(*run)(const void *in);
+    MatU8 *(*run_u8)(const void *in);
+} STAGES[] = {
+    {"grayscale", grayscale, grayscale_u8},
+    {"threshold", threshold, threshold_u8},
+    {"rotation", rotation, rotation_u8},
+    {"closing", closing, closing_u8},
+    {"opening", opening, opening_u8},
+};
+
+/// @brief A stage applied to an input, the benchmarked call.
+typedef struct Call
+{
+    const struct Stage *stage;
+    const void *in;
+} Call;
+
+static void run_float(void *ctx)
+{
+    Call *c = ctx;
+    mat_free(c->stage->run(c->in));
+}
+
+static void run_u8(void *ctx)
+{
+    Call *c = ctx;
+    mat_u8_free(c->stage->run_u8(c->in));
+}
+
+static BenchConfig config;
+static BenchReport report;
+
+static void measure(const char *stage, const char *shape, const char *variant,
+                    void (*run)(void *), Call *call, double bytes)
+{
+    BenchResult res;
+    bench_measure(&config, run, call, bytes, BenchBytes, &res);
+    res.name = stage;
+    res.shape = shape;
+    res.variant = variant;
+    res.threads = 1;
+    bench_report_add(&report, &res);
+}
+
+/// @brief Measures every stage on an image in both pixel types, and checks
+/// that both give the same images.
+static void bench_image(const char *path)
+{
+    ImageData *img = load_image(path);
+    if (img == NULL)
+        errx(EXIT_FAILURE, "Failed to load '%s'", path);
+
+    char shape[32];
+    snprintf(shape, sizeof(shape), "%zux%zu", img->height, img->width);
+
+    // Every stage reads and writes at least one image of its type.
+    double pixels = (double)img->height * img->width;
+
+    const void *in = img, *in_u8 = img;
+    Matrix *previous = NULL;
+    MatU8 *previous_u8 = NULL;
+    for (size_t i = 0; i < sizeof(STAGES) / sizeof(STAGES[0]); i++)
+    {
+        const struct Stage *stage = &STAGES[i];
+
+        Call call = {.stage = stage, .in = in};
+        measure(stage->name, shape, "float", run_float, &call,
+                2.0 * pixels * sizeof(float));
+        Call call_u8 = {.stage = stage, .in = in_u8};
+        measure(stage->name, shape, "u8", run_u8, &call_u8, 2.0 * pixels);
+
+        Matrix *result = stage->run(in);
+        MatU8 *result_u8 = stage->run_u8(in_u8);
+
+        MatU8 *converted = mat_u8_from_matrix(result);
+        if (!mat_u8_eq(converted, result_u8))
+            fprintf(stderr, "%s: the %s stage differs between pixel types.\n",
+                    path, stage->name);
+        mat_u8_free(converted);
+
+        if (previous != NULL)
+        {
+            mat_free(previous);
+            mat_u8_free(previous_u8);
+        }
+        previous = result;
+        previous_u8 = result_u8;
+        in = result;
+        in_u8 = result_u8;
+    }
+
+    mat_free(previous);
+    mat_u8_free(previous_u8);
+    free_image(img);
+}
+
+static void usage(const char *program)
+{
+    errx(EXIT_FAILURE,
+         "Usage: %s [--format table|csv|json] [--samples N] [images...]",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BenchTable;
+    config = BENCH_DEFAULT_CONFIG;
+
+    const char *images[argc];
+    size_t image_count = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (bench_parse_format(argv[++i], &format) != 0)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+        {
+            config.samples = strtoul(argv[++i], NULL, 10);
+            if (config.samples == 0)
+                usage(argv[0]);
+        }
+        else if (argv[i][0] != '-')
+            images[image_count++] = argv[i];
+        else
+            usage(argv[0]);
+    }
+
+    bench_report_begin(&report, stdout, format);
+
+    if (image_count > 0)
+        for (size_t i = 0; i < image_count; i++)
+            bench_image(images[i]);
+    else
+        for (size_t i = 0; i < sizeof(sample_images) / sizeof(*sample_images);
+             i++)
+            bench_image(sample_images[i]);
+
+    bench_report_end(&report);
+
+    return EXIT_SUCCESS;
+}
@@ -424,6 +424,44 @@ int export_matrix(Matrix *src, const char *filename)
     return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+int export_matrix_u8(const MatU8 *src, const char *filename)
+{
+    size_t height = mat_u8_height(src);
+    size_t width = mat_u8_width(src);
+    GdkPixbuf *pixbuf =
+        gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+    if (pixbuf == NULL)
+        return EXIT_FAILURE;
+
+    // The gray levels are written straight into the pixbuf, without an
+    // intermediate ImageData.
+    guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
+    int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+    for (size_t h = 0; h < height; h++)
+    {
+        const uint8_t *row = mat_u8_row(src, h);
+        guchar *dst = pixels + h * rowstride;
+        for (size_t w = 0; w < width; w++)
+        {
+            dst[3 * w] = row[w];
+            dst[3 * w + 1] = row[w];
+            dst[3 * w + 2] = row[w];
+        }
+    }
+
+    int success = save_pixbuf_to_png(pixbuf, (char *)filename);
+    g_object_unref(pixbuf);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int export_bit_matrix(const BitMatrix *src, const char *filename)
+{
+    MatU8 *image = mat_bit_to_u8(src, 0, 255);
+    int status = export_matrix_u8(image, filename);
+    mat_u8_free(image);
+    return status;
+}
+
 int draw_highlighting_line(cairo_t *cr, int xs, int xf, int ys, int yf, float r,
                            float g, float b)
 {
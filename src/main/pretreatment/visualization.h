@@ -1,6 +1,8 @@
 #include "image_loader/image_loading.h"
 #include "location/hough_lines_legacy.h"
 #include "location/location.h"
+#include "matrix/bit_matrix.h"
+#include "matrix/matrix_u8.h"
 #include <cairo.h>
 
 /// @brief Draws a filled circular point on a Cairo surface.
@@ -132,6 +134,19 @@ int draw_2d_boundingboxes_on_img(BoundingBox ***boxes, size_t nb_boxes,
 /// @return 0 on success, or EXIT_FAILURE if the export fails.
 int export_matrix(Matrix *src, const char *filename);
 
+/// @brief Exports a byte matrix as a PNG image file.
+/// @param[in] src Pointer to the source image. Must not be NULL.
+/// @param[in] filename Path where the PNG image will be saved.
+/// @return 0 on success, or EXIT_FAILURE if the export fails.
+int export_matrix_u8(const MatU8 *src, const char *filename);
+
+/// @brief Exports a binary image as a black and white PNG image file.
+/// @param[in] src Pointer to the source image, whose set bits are the white
+/// pixels. Must not be NULL.
+/// @param[in] filename Path where the PNG image will be saved.
+/// @return 0 on success, or EXIT_FAILURE if the export fails.
+int export_bit_matrix(const BitMatrix *src, const char *filename);
+
 /// @brief Converts a grayscale matrix to an RGB image.
 /// @param[in] matrix Pointer to the input grayscale matrix (values 0.0–255.0).
 /// @return Pointer to a newly allocated ImageData containing RGB pixels or NULL
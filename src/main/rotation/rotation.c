@@ -52,6 +52,50 @@ Matrix *rotate_matrix(const Matrix *src, float angle)
     return rotated;
 }
 
+MatU8 *rotate_matrix_u8(const MatU8 *src, float angle)
+{
+    if (src == NULL)
+    {
+        fprintf(stderr, "rotate_matrix_u8: src matrix is NULL\n");
+        return NULL;
+    }
+
+    size_t w = mat_u8_width(src);
+    size_t h = mat_u8_height(src);
+
+    float cos_angle = cosd(angle);
+    float sin_angle = sind(angle);
+
+    size_t nw =
+        (size_t)(fabs((float)w * cos_angle) + fabs((float)h * sin_angle) + 0.5);
+    size_t nh =
+        (size_t)(fabs((float)h * cos_angle) + fabs((float)w * sin_angle) + 0.5);
+
+    MatU8 *rotated = mat_u8_create_filled(nh, nw, 255);
+
+    float cx = (float)w / 2.0f;
+    float cy = (float)h / 2.0f;
+    float ncx = (float)nw / 2.0f;
+    float ncy = (float)nh / 2.0f;
+
+    for (size_t y = 0; y < nh; y++)
+    {
+        uint8_t *row = mat_u8_row(rotated, y);
+        for (size_t x = 0; x < nw; x++)
+        {
+            float tx = ((float)x - ncx) * cos_angle -
+                       ((float)y - ncy) * sin_angle + cx;
+            float ty = ((float)x - ncx) * sin_angle +
+                       ((float)y - ncy) * cos_angle + cy;
+
+            if (tx >= 0.0f && tx < (float)w && ty >= 0.0f && ty < (float)h)
+                row[x] = mat_u8_row(src, (size_t)ty)[(size_t)tx];
+        }
+    }
+
+    return rotated;
+}
+
 ImageData *rotate_image(ImageData *img, float angle)
 {
     int w = img->width;
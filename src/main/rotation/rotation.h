@@ -3,6 +3,7 @@
 
 #include "image_loader/image_loading.h"
 #include "matrix/matrix.h"
+#include "matrix/matrix_u8.h"
 
 /// @brief Rotates a grayscale matrix by a given angle.
 ///
@@ -15,6 +16,13 @@
 /// @return Pointer to a new matrix with the rotated data, or NULL on failure.
 Matrix *rotate_matrix(const Matrix *src, float angle);
 
+/// @brief Byte version of @ref rotate_matrix, which gives the same result on
+/// the same image.
+/// @param[in] src Pointer to the source image. Must not be NULL.
+/// @param[in] angle Rotation angle in degrees.
+/// @return Pointer to a new image with the rotated data, or NULL on failure.
+MatU8 *rotate_matrix_u8(const MatU8 *src, float angle);
+
 /**
  * @brief Rotates a full color image by a specified angle.
  *
@@ -0,0 +1,47 @@
+#include "crc32.h"
+
+/// @brief The reversed polynomial of the IEEE CRC-32.
+#define CRC32_POLYNOMIAL 0xEDB88320u
+
+/// @brief Slicing-by-8 tables: table[0] is the classic byte-wise table, and
+/// table[k][b] is the CRC of the byte b followed by k zero bytes, so that 8
+/// bytes are processed with 8 independent lookups.
+static uint32_t table[8][256];
+
+__attribute__((constructor)) static void crc32_init()
+{
+    for (uint32_t b = 0; b < 256; ++b)
+    {
+        uint32_t crc = b;
+        for (int i = 0; i < 8; ++i)
+            crc = crc & 1 ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+        table[0][b] = crc;
+    }
+
+    for (int k = 1; k < 8; ++k)
+        for (uint32_t b = 0; b < 256; ++b)
+            table[k][b] =
+                (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    crc = ~crc;
+
+    for (; size >= 8; size -= 8, bytes += 8)
+    {
+        uint32_t low = crc ^ ((uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+                              (uint32_t)bytes[2] << 16 |
+                              (uint32_t)bytes[3] << 24);
+        crc = table[7][low & 0xFF] ^ table[6][low >> 8 & 0xFF] ^
+              table[5][low >> 16 & 0xFF] ^ table[4][low >> 24] ^
+              table[3][bytes[4]] ^ table[2][bytes[5]] ^ table[1][bytes[6]] ^
+              table[0][bytes[7]];
+    }
+
+    for (; size > 0; --size, ++bytes)
+        crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xFF];
+
+    return ~crc;
+}
@@ -0,0 +1,16 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Updates a CRC-32 (the IEEE 802.3 one, as in zlib and PNG) with the
+/// given bytes. Checksums can be computed in several calls:
+/// crc32_update(crc32_update(0, a, n), b, m) is the CRC of a followed by b.
+/// @param[in] crc The CRC of the previous bytes, or 0 for the first call.
+/// @param[in] data The bytes to add.
+/// @param[in] size The number of bytes.
+/// @return The CRC of the previous bytes followed by data.
+uint32_t crc32_update(uint32_t crc, const void *data, size_t size);
+
+#endif
@@ -0,0 +1,46 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "full_io.h"
+
+int read_all(int fd, void *buffer, size_t size)
+{
+    char *p = buffer;
+    while (size > 0)
+    {
+        ssize_t r = read(fd, p, size);
+        if (r <= 0)
+            return -1;
+        p += r;
+        size -= r;
+    }
+    return 0;
+}
+
+int write_all(int fd, const void *buffer, size_t size)
+{
+    const char *p = buffer;
+    while (size > 0)
+    {
+        ssize_t w = write(fd, p, size);
+        if (w <= 0)
+            return -1;
+        p += w;
+        size -= w;
+    }
+    return 0;
+}
+
+int send_all(int fd, const void *buffer, size_t size)
+{
+    const char *p = buffer;
+    while (size > 0)
+    {
+        ssize_t w = send(fd, p, size, MSG_NOSIGNAL);
+        if (w <= 0)
+            return -1;
+        p += w;
+        size -= w;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef FULL_IO_H
+#define FULL_IO_H
+
+#include <stddef.h>
+
+/// @brief Reads exactly size bytes from a file descriptor, retrying the short
+/// reads of read(2).
+/// @param[in] fd The file descriptor to read from.
+/// @param[out] buffer The buffer of at least size bytes to fill.
+/// @param[in] size The number of bytes to read.
+/// @return 0 on success, or -1 on an error or at the end of the file.
+int read_all(int fd, void *buffer, size_t size);
+
+/// @brief Writes exactly size bytes to a file descriptor, retrying the short
+/// writes of write(2).
+/// @param[in] fd The file descriptor to write to.
+/// @param[in] buffer The bytes to write.
+/// @param[in] size The number of bytes to write.
+/// @return 0 on success, or -1 on an error.
+int write_all(int fd, const void *buffer, size_t size);
+
+/// @brief Sends exactly size bytes to a connected socket like `write_all`,
+/// but returns -1 instead of raising SIGPIPE if the peer closed it.
+/// @param[in] fd The socket to send to.
+/// @param[in] buffer The bytes to send.
+/// @param[in] size The number of bytes to send.
+/// @return 0 on success, or -1 on an error.
+int send_all(int fd, const void *buffer, size_t size);
+
+#endif
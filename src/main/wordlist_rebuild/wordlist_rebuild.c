@@ -1,12 +1,14 @@
 #include "wordlist_rebuild.h"
 
 #include <dirent.h>
+#include <err.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "image_loader/image_loading.h"
+#include "matrix/arena.h"
 #include "matrix/matrix.h"
-#include "ocr/neural_network.h"
+#include "ocr/ocr_client.h"
 #include "pretreatment/pretreatment.h"
 
 #define MAX_PATH 2048
@@ -33,51 +35,49 @@ static int count_words(const char *folder)
     return total;
 }
 
-static char read_letter(const char *path, Neural_Network *net)
+/// @brief Loads a letter image as an input of the OCR network, or returns NULL
+/// if it cannot be read or is empty.
+static Matrix *load_letter_input(const char *path)
 {
     ImageData *img = load_image(path);
     if (img == NULL)
     {
-        return '?';
+        return NULL;
     }
 
     Matrix *mat = image_to_grayscale(img);
     free_image(img);
     if (mat == NULL)
     {
-        return '?';
+        return NULL;
     }
 
     Matrix *tmp = adaptative_gaussian_thresholding(mat, 1.0f, 11, 10, 5);
     mat_free(mat);
     if (tmp == NULL)
     {
-        return '?';
+        return NULL;
     }
     mat = tmp;
 
     mat_inplace_toggle(mat);
-    tmp = mat_strip_margins(mat);
-    mat_free(mat);
-    if (tmp == NULL)
+
+    // The margins are stripped without copying: only the scaled letter is
+    // allocated.
+    MatView glyph = mat_view_strip_margins(mat_view(mat));
+    if (glyph.height == 0)
     {
-        return '?';
+        mat_free(mat);
+        return NULL;
     }
-    mat = tmp;
 
-    tmp = mat_scale_to_28(mat, 0.0f);
+    tmp = mat_view_scale_to_28(glyph, 0.0f);
     mat_free(mat);
-    if (tmp == NULL)
-    {
-        return '?';
-    }
     mat = tmp;
 
     mat_inplace_vertical_flatten(mat);
-    char c = net_decode_letter(net, mat, NULL);
-    mat_free(mat);
 
-    return c;
+    return mat;
 }
 
 Wordlist *wordlist_rebuild_from_folder(const char *folder,
@@ -95,16 +95,9 @@ Wordlist *wordlist_rebuild_from_folder(const char *folder,
         return NULL;
     }
 
-    Neural_Network *net = net_load_from_file((char *)model_path);
-    if (net == NULL)
-    {
-        return NULL;
-    }
-
     Wordlist *wl = malloc(sizeof(Wordlist));
     if (wl == NULL)
     {
-        net_free(net);
         return NULL;
     }
 
@@ -116,10 +109,21 @@ Wordlist *wordlist_rebuild_from_folder(const char *folder,
         free(wl->words);
         free(wl->lengths);
         free(wl);
-        net_free(net);
         return NULL;
     }
 
+    // The letters have similar sizes: their matrices are recycled by the
+    // arena.
+    MatArena *arena = mat_arena_create();
+    mat_arena_begin(arena);
+
+    // The letters of every word are loaded first, then they are all decoded in
+    // a single forward pass, by the OCR server if one runs, and copied to their
+    // words.
+    size_t letter_count = 0, letter_capacity = 0;
+    Matrix **inputs = NULL;
+    char **targets = NULL;
+
     for (int w = 0; w < total_words; w++)
     {
         char path[MAX_PATH];
@@ -165,12 +169,48 @@ Wordlist *wordlist_rebuild_from_folder(const char *folder,
                 continue;
             }
 
-            wl->words[w][l] = read_letter(file, net);
+            if (letter_count == letter_capacity)
+            {
+                letter_capacity = letter_capacity ? 2 * letter_capacity : 64;
+                inputs = realloc(inputs, letter_capacity * sizeof(Matrix *));
+                targets = realloc(targets, letter_capacity * sizeof(char *));
+                if (inputs == NULL || targets == NULL)
+                {
+                    errx(EXIT_FAILURE, "Memory allocation failed.");
+                }
+            }
+
+            inputs[letter_count] = load_letter_input(file);
+            targets[letter_count] = &wl->words[w][l];
+            letter_count++;
         }
         wl->words[w][letters] = '\0';
     }
 
-    net_free(net);
+    char *letters = malloc(letter_count + 1);
+    if (letters == NULL)
+    {
+        errx(EXIT_FAILURE, "Memory allocation failed.");
+    }
+
+    ocr_decode_letter_array(model_path, inputs, letter_count, letters);
+
+    for (size_t i = 0; i < letter_count; i++)
+    {
+        *targets[i] = letters[i];
+        if (inputs[i] != NULL)
+        {
+            mat_free(inputs[i]);
+        }
+    }
+
+    free(letters);
+    free(inputs);
+    free(targets);
+
+    mat_arena_end();
+    mat_arena_free(arena);
+
     return wl;
 }
 
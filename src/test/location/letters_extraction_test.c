@@ -0,0 +1,36 @@
+#include <criterion/criterion.h>
+
+#include "location/letters_extraction.h"
+#include "matrix/arena.h"
+
+/// @brief Returns the number of matrix heap allocations made by a run of the
+/// pipeline on an image.
+static size_t run_heap_allocations(const char *image)
+{
+    Point **points;
+    size_t h_points, w_points;
+
+    size_t allocations = mat_heap_allocations();
+    cr_assert_eq(
+        locate_and_extract_letters_png(image, &points, &h_points, &w_points),
+        EXIT_SUCCESS);
+    allocations = mat_heap_allocations() - allocations;
+
+    free_points(points, h_points);
+    return allocations;
+}
+
+Test(letters_extraction, steady_state_allocations_test)
+{
+    const char *image = "assets/sample_images/level_1_image_1.png";
+
+    // The image-sized matrices of the first run are recycled by the next ones.
+    size_t first = run_heap_allocations(image);
+    size_t second = run_heap_allocations(image);
+    size_t third = run_heap_allocations(image);
+
+    cr_assert_eq(second, third, "2nd run: %zu heap allocations, 3rd: %zu",
+                 second, third);
+    cr_assert_lt(second, first, "1st run: %zu heap allocations, 2nd: %zu",
+                 first, second);
+}
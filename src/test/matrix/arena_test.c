@@ -0,0 +1,125 @@
+#include <criterion/criterion.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "matrix/arena.h"
+#include "matrix/matrix.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+Test(arena, arena_recycles_freed_matrices_test)
+{
+    MatArena *arena = mat_arena_create();
+    mat_arena_begin(arena);
+
+    Matrix *a = mat_create_zero(28, 28);
+    Matrix *b = mat_create_zero(28, 28);
+    mat_free(a);
+    mat_free(b);
+
+    size_t allocations = mat_heap_allocations();
+    cr_assert_eq(mat_arena_heap_allocations(arena), 2);
+
+    for (size_t i = 0; i < 100; i++)
+    {
+        a = mat_create_filled(28, 28, (float)i);
+        b = mat_scalar_multiplication(a, 2.0f);
+        cr_assert_float_eq(mat_coef(b, 27, 27), 2.0f * (float)i, 1E-6f);
+        mat_free(a);
+        mat_free(b);
+    }
+
+    cr_assert_eq(mat_heap_allocations(), allocations);
+    cr_assert_eq(mat_arena_heap_allocations(arena), 2);
+
+    mat_arena_end();
+    mat_arena_free(arena);
+}
+
+Test(arena, arena_size_classes_random_test)
+{
+    rand_seed();
+
+    MatArena *arena = mat_arena_create();
+    mat_arena_begin(arena);
+
+    REPEAT
+    {
+        size_t height = rand() % 100 + 1;
+        size_t width = rand() % 100 + 1;
+
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *copy = mat_deepcopy(m);
+
+        // A recycled block must be large enough for the matrix.
+        mat_inplace_scalar_multiplication(copy, 1.0f);
+        cr_assert(mat_eq(m, copy, 0.0f));
+        cr_assert_eq((uintptr_t)mat_coef_ptr(copy, 0, 0) % MAT_ALIGNMENT, 0);
+
+        mat_free(m);
+        mat_free(copy);
+    }
+
+    mat_arena_end();
+    mat_arena_free(arena);
+}
+
+Test(arena, arena_reset_test)
+{
+    MatArena *arena = mat_arena_create();
+
+    mat_arena_begin(arena);
+    for (size_t i = 0; i < 10; i++)
+        mat_create_zero(16, 16); // Dropped by mat_arena_reset.
+    mat_arena_end();
+
+    size_t allocations = mat_arena_heap_allocations(arena);
+    cr_assert_eq(allocations, 10);
+
+    mat_arena_reset(arena);
+
+    mat_arena_begin(arena);
+    Matrix *m[10];
+    for (size_t i = 0; i < 10; i++)
+        m[i] = mat_create_zero(16, 16);
+    mat_arena_end();
+
+    cr_assert_eq(mat_arena_heap_allocations(arena), allocations);
+
+    // A matrix outlives its scope and goes back to its arena.
+    for (size_t i = 0; i < 10; i++)
+        mat_free(m[i]);
+
+    mat_arena_free(arena);
+}
+
+Test(arena, arena_nested_scopes_test)
+{
+    MatArena *outer = mat_arena_create();
+    MatArena *inner = mat_arena_create();
+
+    mat_arena_begin(outer);
+    Matrix *a = mat_create_zero(8, 8);
+
+    mat_arena_begin(inner);
+    Matrix *b = mat_create_zero(8, 8);
+    mat_arena_end();
+
+    Matrix *c = mat_create_zero(8, 8);
+    mat_arena_end();
+
+    size_t allocations = mat_heap_allocations();
+    Matrix *d = mat_create_zero(8, 8); // On the heap.
+    cr_assert_eq(mat_heap_allocations(), allocations + 1);
+
+    cr_assert_eq(mat_arena_heap_allocations(outer), 2);
+    cr_assert_eq(mat_arena_heap_allocations(inner), 1);
+
+    mat_free(a);
+    mat_free(b);
+    mat_free(c);
+    mat_free(d);
+
+    mat_arena_free(inner);
+    mat_arena_free(outer);
+}
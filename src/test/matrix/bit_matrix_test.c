@@ -0,0 +1,248 @@
+#include <criterion/criterion.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "matrix/bit_matrix.h"
+#include "matrix/matrix_u8.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+/// @brief Returns a random black and white image, with about one white pixel
+/// out of density.
+static MatU8 *random_binary_image(size_t height, size_t width, int density)
+{
+    MatU8 *m = mat_u8_create(height, width);
+    for (size_t h = 0; h < height; h++)
+        for (size_t w = 0; w < width; w++)
+            *mat_u8_coef_ptr(m, h, w) = rand() % density == 0 ? 255 : 0;
+    return m;
+}
+
+Test(bit_matrix, mat_bit_conversions_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 50 + 1;
+        size_t width = rand() % 200 + 1;
+
+        MatU8 *m = random_binary_image(height, width, 2);
+        BitMatrix *b = mat_bit_from_u8(m, 127);
+
+        size_t count = 0;
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+            {
+                cr_assert_eq(mat_bit_get(b, h, w),
+                             mat_u8_coef(m, h, w) == 255);
+                count += mat_u8_coef(m, h, w) == 255;
+            }
+        cr_assert_eq(mat_bit_popcount(b), count);
+
+        MatU8 *back = mat_bit_to_u8(b, 0, 255);
+        cr_assert(mat_u8_eq(m, back));
+
+        Matrix *f = mat_bit_to_matrix(b, 0.0f, 1.0f);
+        BitMatrix *from_view = mat_bit_from_view(mat_view(f), 0.5f);
+        cr_assert(mat_bit_eq(b, from_view));
+
+        mat_u8_free(m);
+        mat_u8_free(back);
+        mat_free(f);
+        mat_bit_free(b);
+        mat_bit_free(from_view);
+    }
+}
+
+Test(bit_matrix, mat_bit_filters_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 40 + 1;
+        size_t width = rand() % 200 + 1;
+        size_t kernel_size = rand() % 6 + 1;
+
+        MatU8 *m = random_binary_image(height, width, 3);
+        BitMatrix *b = mat_bit_from_u8(m, 127);
+
+        MatU8 *max = mat_u8_max_filter(m, kernel_size);
+        MatU8 *min = mat_u8_min_filter(m, kernel_size);
+        BitMatrix *max_bits = mat_bit_max_filter(b, kernel_size);
+        BitMatrix *min_bits = mat_bit_min_filter(b, kernel_size);
+
+        MatU8 *max_back = mat_bit_to_u8(max_bits, 0, 255);
+        MatU8 *min_back = mat_bit_to_u8(min_bits, 0, 255);
+        cr_assert(mat_u8_eq(max, max_back));
+        cr_assert(mat_u8_eq(min, min_back));
+
+        mat_u8_free(m);
+        mat_u8_free(max);
+        mat_u8_free(min);
+        mat_u8_free(max_back);
+        mat_u8_free(min_back);
+        mat_bit_free(b);
+        mat_bit_free(max_bits);
+        mat_bit_free(min_bits);
+    }
+}
+
+Test(bit_matrix, mat_bit_histograms_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 40 + 1;
+        size_t width = rand() % 200 + 1;
+
+        MatU8 *m = random_binary_image(height, width, 2);
+        BitMatrix *b = mat_bit_from_u8(m, 127);
+
+        size_t h = rand() % height;
+        size_t w = rand() % width;
+        size_t rect_height = rand() % (height - h) + 1;
+        size_t rect_width = rand() % (width - w) + 1;
+
+        size_t rows[rect_height];
+        size_t columns[rect_width];
+        mat_bit_row_histogram(b, h, w, rect_height, rect_width, rows);
+        mat_bit_column_histogram(b, h, w, rect_height, rect_width, columns);
+
+        size_t expected_columns[rect_width];
+        for (size_t j = 0; j < rect_width; j++)
+            expected_columns[j] = 0;
+
+        for (size_t i = 0; i < rect_height; i++)
+        {
+            size_t expected_row = 0;
+            for (size_t j = 0; j < rect_width; j++)
+            {
+                int set = mat_u8_coef(m, h + i, w + j) == 255;
+                expected_row += set;
+                expected_columns[j] += set;
+            }
+            cr_assert_eq(rows[i], expected_row);
+            cr_assert_eq(mat_bit_row_popcount(b, h + i, w, rect_width),
+                         expected_row);
+        }
+        for (size_t j = 0; j < rect_width; j++)
+            cr_assert_eq(columns[j], expected_columns[j]);
+
+        mat_u8_free(m);
+        mat_bit_free(b);
+    }
+}
+
+Test(bit_matrix, mat_bit_strip_margins_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 40 + 1;
+        size_t width = rand() % 200 + 1;
+
+        // Sparse images, so that the margins are often non-empty.
+        MatU8 *m = random_binary_image(height, width, 200);
+        BitMatrix *b = mat_bit_from_u8(m, 127);
+
+        size_t h_i = height, h_f = 0, w_i = width, w_f = 0;
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                if (mat_u8_coef(m, h, w) == 255)
+                {
+                    h_i = h < h_i ? h : h_i;
+                    h_f = h + 1 > h_f ? h + 1 : h_f;
+                    w_i = w < w_i ? w : w_i;
+                    w_f = w + 1 > w_f ? w + 1 : w_f;
+                }
+
+        size_t h, w, rect_height, rect_width;
+        int found = mat_bit_strip_margins(b, &h, &w, &rect_height, &rect_width);
+        cr_assert_eq(found, h_f > 0);
+        if (found)
+        {
+            cr_assert_eq(h, h_i);
+            cr_assert_eq(w, w_i);
+            cr_assert_eq(rect_height, h_f - h_i);
+            cr_assert_eq(rect_width, w_f - w_i);
+        }
+
+        mat_u8_free(m);
+        mat_bit_free(b);
+    }
+}
+
+Test(bit_matrix, mat_bit_multiplication_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t rows = rand() % 40 + 1;
+        size_t inputs = rand() % 200 + 1;
+        size_t width = rand() % 70 + 1;
+
+        // Binary inputs, one per column, and a few unused packed rows.
+        Matrix *x = mat_create_random_uniform(inputs, rows, 0.0f, 1.0f);
+        mat_inplace_to_one_hot(x);
+        BitMatrix *bits = mat_bit_create(rows + 3, inputs);
+        cr_assert(mat_bit_pack_columns(bits, x));
+        for (size_t r = 0; r < rows; r++)
+            for (size_t i = 0; i < inputs; i++)
+                cr_assert_eq(mat_bit_get(bits, r, i),
+                             mat_coef(x, i, r) == 1.0f);
+
+        Matrix *x_t = mat_transpose(x);
+        Matrix *b = mat_create_random_uniform(inputs, width, -1.0f, 1.0f);
+        Matrix *d = mat_create_random_uniform(rows, width, -1.0f, 1.0f);
+
+        Matrix *product = mat_create(rows, width);
+        mat_bit_multiplication(product, bits, b);
+        Matrix *expected = mat_multiplication(x_t, b);
+        cr_assert(mat_eq(product, expected, 1E-4f));
+
+        // The top-left corner of a larger bit matrix.
+        BitMatrix *bits_t = mat_bit_create(inputs + 5, rows + 70);
+        cr_assert(mat_bit_pack(bits_t, x));
+        Matrix *t_product = mat_create(inputs, width);
+        mat_bit_multiplication(t_product, bits_t, d);
+        Matrix *t_expected = mat_multiplication(x, d);
+        cr_assert(mat_eq(t_product, t_expected, 1E-4f));
+
+        // The same sums, from the indices of the ones of the first input.
+        size_t indices[inputs], count;
+        Matrix *column = mat_create(inputs, 1);
+        for (size_t i = 0; i < inputs; i++)
+            *mat_coef_ptr(column, i, 0) = mat_coef(x, i, 0);
+        cr_assert(mat_binary_indices(column, indices, &count));
+        Matrix *sum = mat_create_zero(1, width);
+        mat_add_rows(sum, b, indices, count);
+        for (size_t w = 0; w < width; w++)
+            cr_assert_float_eq(mat_coef(sum, 0, w), mat_coef(expected, 0, w),
+                               1E-4f);
+
+        // Other values are not packed.
+        *mat_coef_ptr(x, rand() % inputs, rand() % rows) = 0.5f;
+        cr_assert(!mat_bit_pack_columns(bits, x));
+        cr_assert(!mat_bit_pack(bits_t, x));
+        *mat_coef_ptr(column, rand() % inputs, 0) = 2.0f;
+        cr_assert(!mat_binary_indices(column, indices, &count));
+
+        mat_free(x);
+        mat_free(x_t);
+        mat_free(b);
+        mat_free(d);
+        mat_free(product);
+        mat_free(expected);
+        mat_free(t_product);
+        mat_free(t_expected);
+        mat_free(column);
+        mat_free(sum);
+        mat_bit_free(bits);
+        mat_bit_free(bits_t);
+    }
+}
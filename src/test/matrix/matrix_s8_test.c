@@ -0,0 +1,114 @@
+#include <criterion/criterion.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "matrix/matrix.h"
+#include "matrix/matrix_s8.h"
+#include "matrix/simd.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+Test(matrix_s8, mat_s8_quantize_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 50 + 1;
+        size_t width = rand() % 300 + 1;
+
+        Matrix *m = mat_create_random_uniform(height, width, -2.0f, 2.0f);
+        // A zero row keeps a scale of 1.
+        size_t zero_row = rand() % height;
+        for (size_t w = 0; w < width; w++)
+            *mat_coef_ptr(m, zero_row, w) = 0.0f;
+
+        MatS8 *q = mat_s8_quantize(m);
+        cr_assert_eq(mat_s8_height(q), height);
+        cr_assert_eq(mat_s8_width(q), width);
+        cr_assert_eq((uintptr_t)mat_s8_row(q, 0) % MAT_ALIGNMENT, 0);
+        cr_assert_eq(mat_s8_scales(q)[zero_row], 1.0f);
+
+        Matrix *back = mat_s8_to_matrix(q);
+        for (size_t h = 0; h < height; h++)
+        {
+            float scale = mat_s8_scales(q)[h];
+            for (size_t w = 0; w < width; w++)
+            {
+                int8_t v = mat_s8_row(q, h)[w];
+                cr_assert_neq(v, -MAT_S8_MAX - 1);
+                cr_assert_leq(fabsf(mat_coef(back, h, w) - mat_coef(m, h, w)),
+                              scale * 0.5f + 1E-6f);
+            }
+        }
+
+        mat_free(back);
+        mat_s8_free(q);
+        mat_free(m);
+    }
+}
+
+Test(matrix_s8, mat_s8_quantize_input_test)
+{
+    float x[6] = {0.0f, -1.0f, 0.5f, 2.0f, 1.0f, 0.01f};
+    uint8_t q[6];
+
+    float scale = mat_s8_quantize_input(q, x, 6);
+    cr_assert_float_eq(scale, 2.0f / MAT_S8_MAX, 1E-7f);
+
+    uint8_t expected[6] = {0, 0, 32, 127, 64, 1};
+    for (size_t i = 0; i < 6; i++)
+        cr_assert_eq(q[i], expected[i], "expected %u but got %u at %zu",
+                     expected[i], q[i], i);
+
+    float zeros[3] = {0.0f, -1.0f, 0.0f};
+    cr_assert_eq(mat_s8_quantize_input(q, zeros, 3), 0.0f);
+    for (size_t i = 0; i < 3; i++)
+        cr_assert_eq(q[i], 0);
+}
+
+Test(matrix_s8, mat_s8_gemv_tiers_random_test)
+{
+    rand_seed();
+    SimdTier initial = simd_tier();
+
+    REPEAT
+    {
+        size_t height = rand() % 40 + 1;
+        size_t width = rand() % 300 + 1;
+
+        // The extreme coefficients, which must not saturate.
+        MatS8 *a = mat_s8_create(height, width);
+        uint8_t x[width];
+        for (size_t w = 0; w < width; w++)
+            x[w] = rand() % 4 ? rand() % (MAT_S8_MAX + 1) : MAT_S8_MAX;
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                mat_s8_row(a, h)[w] = rand() % 4 ? rand() % 255 - 127
+                                                 : -MAT_S8_MAX;
+
+        int32_t expected[height];
+        for (size_t h = 0; h < height; h++)
+        {
+            expected[h] = 0;
+            for (size_t w = 0; w < width; w++)
+                expected[h] += (int32_t)x[w] * mat_s8_row(a, h)[w];
+        }
+
+        for (SimdTier tier = SimdScalar; tier <= simd_detect_tier(); tier++)
+        {
+            simd_set_tier(tier);
+            int32_t y[height];
+            mat_s8_gemv(a, x, y);
+            for (size_t h = 0; h < height; h++)
+                cr_assert_eq(y[h], expected[h],
+                             "%s: expected %d but got %d at %zu",
+                             simd_tier_name(tier), expected[h], y[h], h);
+        }
+
+        mat_s8_free(a);
+    }
+
+    simd_set_tier(initial);
+}
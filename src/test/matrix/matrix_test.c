@@ -1,8 +1,10 @@
 #include <criterion/criterion.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "matrix/matrix.h"
+#include "matrix/simd.h"
 #include "test_settings.h"
 #include "utils/random/random.h"
 
@@ -80,6 +82,70 @@ Test(matrix, mat_create_filled_random_test)
     }
 }
 
+Test(matrix, mat_create_padded_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 50 + 1;
+        size_t width = rand() % 100 + 2;
+
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *p = mat_create_padded(height, width);
+
+        cr_assert_eq(mat_height(p), height);
+        cr_assert_eq(mat_width(p), width);
+        cr_assert(mat_stride(p) >= width);
+        cr_assert_eq(mat_stride(p) * sizeof(float) % MAT_ALIGNMENT, 0);
+
+        for (size_t h = 0; h < height; h++)
+        {
+            cr_assert_eq((uintptr_t)mat_coef_ptr(p, h, 0) % MAT_ALIGNMENT, 0);
+            for (size_t w = 0; w < width; w++)
+            {
+                cr_assert_eq(mat_coef(p, h, w), 0.0f);
+                *mat_coef_ptr(p, h, w) = mat_coef(m, h, w);
+            }
+        }
+        cr_assert(mat_eq(m, p, 0.0f));
+
+        // Padded and contiguous operands can be mixed.
+        Matrix *b = mat_create_random_uniform(width, 3, -1.0f, 1.0f);
+        Matrix *x = mat_create_random_uniform(width, 1, -1.0f, 1.0f);
+        Matrix *expected[] = {
+            mat_addition(m, m),    mat_hadamard(m, m),
+            mat_relu(m),           mat_scalar_multiplication(m, 2.0f),
+            mat_transpose(m),      mat_multiplication(m, b),
+            mat_gemv(m, x),        mat_deepcopy(m),
+        };
+        Matrix *actual[] = {
+            mat_addition(p, m),    mat_hadamard(m, p),
+            mat_relu(p),           mat_scalar_multiplication(p, 2.0f),
+            mat_transpose(p),      mat_multiplication(p, b),
+            mat_gemv(p, x),        mat_deepcopy(p),
+        };
+
+        for (size_t i = 0; i < sizeof(actual) / sizeof(actual[0]); i++)
+        {
+            cr_assert(mat_eq(expected[i], actual[i], 1E-5f),
+                      "operation %zu differs on a %zux%zu padded matrix", i,
+                      height, width);
+            mat_free(expected[i]);
+            mat_free(actual[i]);
+        }
+
+        mat_inplace_vertical_flatten(p);
+        cr_assert_eq(mat_height(p), height * width);
+        cr_assert_eq(mat_width(p), 1);
+        for (size_t i = 0; i < height * width; i++)
+            cr_assert_eq(mat_coef(p, i, 0), mat_coef(m, i / width, i % width));
+
+        mat_free(m);
+        mat_free(p);
+        mat_free(b);
+        mat_free(x);
+    }
+}
+
 Test(matrix, mat_create_from_arr_test)
 {
     Matrix *m = mat_create_from_arr(3, 2, (float[]){0, 1, 2, 3, 4, 5});
@@ -254,6 +320,132 @@ Test(matrix, mat_multiplication_random_test)
     }
 }
 
+Test(matrix, mat_multiplication_network_shapes_test)
+{
+    // Shapes used by the OCR network, including depths larger than a GEMM
+    // block and widths that are not a multiple of the register tile.
+    size_t shapes[][3] = {{128, 784, 1},  {26, 128, 1},  {128, 26, 1},
+                          {128, 1, 784},  {26, 1, 128},  {128, 784, 64},
+                          {26, 128, 64},  {128, 64, 784}, {1, 1, 1},
+                          {7, 513, 19}};
+
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++)
+    {
+        size_t l_dim = shapes[s][0];
+        size_t m_dim = shapes[s][1];
+        size_t r_dim = shapes[s][2];
+
+        Matrix *m1 = mat_create_random_uniform(l_dim, m_dim, -1.0f, 1.0f);
+        Matrix *m2 = mat_create_random_uniform(m_dim, r_dim, -1.0f, 1.0f);
+
+        Matrix *res = mat_multiplication(m1, m2);
+
+        cr_assert_eq(mat_height(res), l_dim);
+        cr_assert_eq(mat_width(res), r_dim);
+
+        for (size_t i = 0; i < l_dim; i++)
+        {
+            for (size_t j = 0; j < r_dim; j++)
+            {
+                float expected = 0.0f;
+                for (size_t k = 0; k < m_dim; k++)
+                    expected += mat_coef(m1, i, k) * mat_coef(m2, k, j);
+
+                cr_assert_float_eq(mat_coef(res, i, j), expected,
+                                   epsilon(expected), "expected %f but got %f",
+                                   expected, mat_coef(res, i, j));
+            }
+        }
+
+        mat_free(m1);
+        mat_free(m2);
+        mat_free(res);
+    }
+}
+
+Test(matrix, mat_gemv_add_bias_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 300 + 1;
+        size_t width = rand() % 900 + 1;
+
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *x = mat_create_random_uniform(width, 1, 0.0f, 1.0f);
+        Matrix *bias = mat_create_random_uniform(height, 1, -1.0f, 1.0f);
+
+        Matrix *res = mat_gemv(m, x);
+        Matrix *res_bias = mat_gemv_add_bias(m, x, bias);
+
+        cr_assert_eq(mat_height(res), height);
+        cr_assert_eq(mat_width(res), 1);
+        cr_assert_eq(mat_height(res_bias), height);
+        cr_assert_eq(mat_width(res_bias), 1);
+
+        for (size_t h = 0; h < height; h++)
+        {
+            float expected = 0.0f;
+            for (size_t w = 0; w < width; w++)
+                expected += mat_coef(m, h, w) * mat_coef(x, w, 0);
+
+            cr_assert_float_eq(mat_coef(res, h, 0), expected,
+                               epsilon(expected), "expected %f but got %f",
+                               expected, mat_coef(res, h, 0));
+
+            expected += mat_coef(bias, h, 0);
+            cr_assert_float_eq(mat_coef(res_bias, h, 0), expected,
+                               epsilon(expected), "expected %f but got %f",
+                               expected, mat_coef(res_bias, h, 0));
+        }
+
+        mat_free(m);
+        mat_free(x);
+        mat_free(bias);
+        mat_free(res);
+        mat_free(res_bias);
+    }
+}
+
+Test(matrix, mat_gemv_resized_column_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 30 + 1;
+        size_t width = rand() % 90 + 2;
+
+        // Columns resized from wider matrices keep the stride of their rows.
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *x = mat_create_random_uniform(width, 4, 0.0f, 1.0f);
+        Matrix *bias = mat_create_random_uniform(height, 3, -1.0f, 1.0f);
+        mat_resize(x, width, 1);
+        mat_resize(bias, height, 1);
+
+        Matrix *expected = mat_multiplication(m, x);
+        Matrix *res = mat_gemv(m, x);
+        Matrix *res_bias = mat_gemv_add_bias(m, x, bias);
+
+        for (size_t h = 0; h < height; h++)
+        {
+            float e = mat_coef(expected, h, 0);
+            cr_assert_float_eq(mat_coef(res, h, 0), e, epsilon(e),
+                               "expected %f but got %f", e,
+                               mat_coef(res, h, 0));
+
+            e += mat_coef(bias, h, 0);
+            cr_assert_float_eq(mat_coef(res_bias, h, 0), e, epsilon(e),
+                               "expected %f but got %f", e,
+                               mat_coef(res_bias, h, 0));
+        }
+
+        mat_free(m);
+        mat_free(x);
+        mat_free(bias);
+        mat_free(expected);
+        mat_free(res);
+        mat_free(res_bias);
+    }
+}
+
 Test(matrix, mat_hadamard_random_test)
 {
     REPEAT
@@ -347,6 +539,129 @@ Test(matrix, mat_relu_derivative_random_test)
     }
 }
 
+Test(matrix, mat_element_wise_tails_test)
+{
+    // Every length from 1 to 3 vectors of 16 floats, so that every possible
+    // remainder of every tier (including the masked tails of AVX-512) is
+    // exercised.
+    for (SimdTier tier = SimdScalar; tier <= simd_detect_tier(); tier++)
+    {
+        simd_set_tier(tier);
+
+        for (size_t width = 1; width <= 48; width++)
+        {
+            Matrix *a = mat_create_random_uniform(1, width, -1.0f, 1.0f);
+            Matrix *b = mat_create_random_uniform(1, width, -1.0f, 1.0f);
+
+            Matrix *sum = mat_addition(a, b);
+            Matrix *diff = mat_subtraction(a, b);
+            Matrix *prod = mat_hadamard(a, b);
+            Matrix *scaled = mat_scalar_multiplication(a, 3.0f);
+            Matrix *relu = mat_relu(a);
+            Matrix *relu_der = mat_relu_derivative(a);
+            Matrix *filled = mat_create_filled(1, width, 2.5f);
+
+            for (size_t w = 0; w < width; w++)
+            {
+                float x = mat_coef(a, 0, w), y = mat_coef(b, 0, w);
+
+                cr_assert_float_eq(mat_coef(sum, 0, w), x + y, epsilon(x + y),
+                                   "%s: width %zu", simd_tier_name(tier),
+                                   width);
+                cr_assert_float_eq(mat_coef(diff, 0, w), x - y, epsilon(x - y),
+                                   "%s: width %zu", simd_tier_name(tier),
+                                   width);
+                cr_assert_float_eq(mat_coef(prod, 0, w), x * y, epsilon(x * y),
+                                   "%s: width %zu", simd_tier_name(tier),
+                                   width);
+                cr_assert_float_eq(mat_coef(scaled, 0, w), 3.0f * x,
+                                   epsilon(3.0f * x), "%s: width %zu",
+                                   simd_tier_name(tier), width);
+                cr_assert_eq(mat_coef(relu, 0, w), x > 0.0f ? x : 0.0f,
+                             "%s: width %zu", simd_tier_name(tier), width);
+                cr_assert_eq(mat_coef(relu_der, 0, w), x > 0.0f ? 1.0f : 0.0f,
+                             "%s: width %zu", simd_tier_name(tier), width);
+                cr_assert_eq(mat_coef(filled, 0, w), 2.5f, "%s: width %zu",
+                             simd_tier_name(tier), width);
+            }
+
+            mat_inplace_addition(a, b);
+            for (size_t w = 0; w < width; w++)
+                cr_assert_eq(mat_coef(a, 0, w), mat_coef(sum, 0, w),
+                             "%s: width %zu", simd_tier_name(tier), width);
+
+            mat_free(a);
+            mat_free(b);
+            mat_free(sum);
+            mat_free(diff);
+            mat_free(prod);
+            mat_free(scaled);
+            mat_free(relu);
+            mat_free(relu_der);
+            mat_free(filled);
+        }
+    }
+}
+
+Test(matrix, mat_transpose_random_test)
+{
+    REPEAT
+    {
+        // Sizes around the 16×16 tiles of AVX-512, including partial tiles.
+        size_t height = rand() % 70 + 1;
+        size_t width = rand() % 70 + 1;
+
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+
+        for (SimdTier tier = SimdScalar; tier <= simd_detect_tier(); tier++)
+        {
+            simd_set_tier(tier);
+            Matrix *res = mat_transpose(m);
+
+            cr_assert_eq(mat_height(res), width);
+            cr_assert_eq(mat_width(res), height);
+
+            for (size_t h = 0; h < height; h++)
+                for (size_t w = 0; w < width; w++)
+                    cr_assert_eq(mat_coef(res, w, h), mat_coef(m, h, w),
+                                 "%s: %zux%zu at (%zu, %zu)",
+                                 simd_tier_name(tier), height, width, h, w);
+
+            mat_free(res);
+        }
+
+        mat_free(m);
+    }
+}
+
+Test(matrix, mat_inplace_transpose_random_test)
+{
+    REPEAT
+    {
+        // Square, rectangular and vector shapes, padded or not.
+        size_t height = rand() % 70 + 1;
+        size_t width = rand() % 4 == 0 ? height : (size_t)rand() % 70 + 1;
+        if (rand() % 8 == 0)
+            width = 1;
+
+        Matrix *m = rand() % 2 ? mat_create_padded(height, width)
+                               : mat_create_zero(height, width);
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                *mat_coef_ptr(m, h, w) = rand_f_uniform_nm(-1.0f, 1.0f);
+
+        Matrix *expected = mat_transpose(m);
+        float *content = mat_coef_ptr(m, 0, 0);
+        mat_inplace_transpose(m);
+
+        cr_assert_eq(mat_coef_ptr(m, 0, 0), content);
+        cr_assert(mat_eq(m, expected, 0.0f), "%zux%zu", height, width);
+
+        mat_free(m);
+        mat_free(expected);
+    }
+}
+
 Test(matrix, mat_inplace_softmax_random_test)
 {
     REPEAT
@@ -486,6 +801,213 @@ Test(matrix, mat_strip_margins_failure_test)
     mat_free(m);
 }
 
+Test(matrix, mat_dense_relu_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 150 + 1;
+        size_t width = rand() % 300 + 1;
+
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *x = mat_create_random_uniform(width, 1, -1.0f, 1.0f);
+        Matrix *bias = mat_create_random_uniform(height, 1, -1.0f, 1.0f);
+
+        Matrix *expected_pre = mat_gemv_add_bias(m, x, bias);
+        Matrix *expected_act = mat_relu(expected_pre);
+
+        Matrix *pre = mat_create(height, 1);
+        Matrix *act = mat_create(height, 1);
+        mat_dense_relu(m, x, bias, pre, act);
+
+        cr_assert(mat_eq(expected_pre, pre, 0.0f));
+        cr_assert(mat_eq(expected_act, act, 0.0f));
+
+        // In place.
+        mat_dense_relu(m, x, bias, pre, pre);
+        cr_assert(mat_eq(expected_act, pre, 0.0f));
+
+        mat_free(act);
+        mat_free(pre);
+        mat_free(expected_act);
+        mat_free(expected_pre);
+        mat_free(bias);
+        mat_free(x);
+        mat_free(m);
+    }
+}
+
+Test(matrix, mat_dense_relu_resized_column_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 30 + 2;
+        size_t width = rand() % 90 + 2;
+
+        // Columns resized from wider matrices keep the stride of their rows.
+        Matrix *m = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *x = mat_create_random_uniform(width, 4, -1.0f, 1.0f);
+        Matrix *bias = mat_create_random_uniform(height, 3, -1.0f, 1.0f);
+        Matrix *pre = mat_create_zero(height, 4);
+        Matrix *act = mat_create_zero(height, 2);
+        mat_resize(x, width, 1);
+        mat_resize(bias, height, 1);
+        mat_resize(pre, height, 1);
+        mat_resize(act, height, 1);
+
+        Matrix *expected_pre = mat_multiplication(m, x);
+        mat_inplace_addition(expected_pre, bias);
+        Matrix *expected_act = mat_relu(expected_pre);
+
+        mat_dense_relu(m, x, bias, pre, act);
+        cr_assert(mat_eq(expected_pre, pre, 1E-5f));
+        cr_assert(mat_eq(expected_act, act, 1E-5f));
+
+        // The padding of the rows is left untouched.
+        for (size_t h = 0; h < height; h++)
+        {
+            cr_assert_eq(mat_coef_ptr(pre, h, 0)[1], 0.0f);
+            cr_assert_eq(mat_coef_ptr(act, h, 0)[1], 0.0f);
+        }
+
+        // In place.
+        mat_dense_relu(m, x, bias, pre, pre);
+        cr_assert(mat_eq(expected_act, pre, 1E-5f));
+
+        mat_free(expected_act);
+        mat_free(expected_pre);
+        mat_free(act);
+        mat_free(pre);
+        mat_free(bias);
+        mat_free(x);
+        mat_free(m);
+    }
+}
+
+Test(matrix, mat_subview_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 100 + 1;
+        size_t width = rand() % 100 + 1;
+        size_t h = rand() % height, w = rand() % width;
+        size_t sub_height = rand() % (height - h) + 1;
+        size_t sub_width = rand() % (width - w) + 1;
+
+        Matrix *m = rand() % 2 ? mat_create_padded(height, width)
+                               : mat_create_zero(height, width);
+        for (size_t i = 0; i < height; i++)
+            for (size_t j = 0; j < width; j++)
+                *mat_coef_ptr(m, i, j) = rand_f_uniform_nm(-1.0f, 1.0f);
+
+        MatView v = mat_subview(mat_view(m), h, w, sub_height, sub_width);
+        Matrix *copy = mat_create_from_view(v);
+
+        cr_assert_eq(mat_height(copy), sub_height);
+        cr_assert_eq(mat_width(copy), sub_width);
+        for (size_t i = 0; i < sub_height; i++)
+        {
+            for (size_t j = 0; j < sub_width; j++)
+            {
+                cr_assert_eq(mat_view_coef(v, i, j), mat_coef(m, h + i, w + j));
+                cr_assert_eq(mat_coef(copy, i, j), mat_coef(m, h + i, w + j));
+            }
+        }
+
+        mat_free(copy);
+        mat_free(m);
+    }
+}
+
+Test(matrix, mat_view_reductions_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 100 + 1;
+        size_t width = rand() % 100 + 1;
+        size_t h = rand() % height, w = rand() % width;
+        size_t sub_height = rand() % (height - h) + 1;
+        size_t sub_width = rand() % (width - w) + 1;
+
+        Matrix *m = rand() % 2 ? mat_create_padded(height, width)
+                               : mat_create_zero(height, width);
+        for (size_t i = 0; i < height; i++)
+            for (size_t j = 0; j < width; j++)
+                *mat_coef_ptr(m, i, j) = rand_f_uniform_nm(-1.0f, 1.0f);
+
+        // The reductions of a view are those of its copy.
+        MatView v = mat_subview(mat_view(m), h, w, sub_height, sub_width);
+        Matrix *copy = mat_create_from_view(v);
+
+        cr_assert_float_eq(mat_view_sum(v), mat_sum(copy), 1E-3f);
+        cr_assert_eq(mat_view_max(v), mat_max(copy));
+        cr_assert_eq(mat_view_max_h(v), mat_max_h(copy));
+
+        float mean, stddev, copy_mean, copy_stddev;
+        mat_view_mean_stddev(v, &mean, &stddev);
+        mat_mean_stddev(copy, &copy_mean, &copy_stddev);
+        cr_assert_float_eq(mean, copy_mean, 1E-5f);
+        cr_assert_float_eq(stddev, copy_stddev, 1E-5f);
+
+        mat_free(copy);
+        mat_free(m);
+    }
+}
+
+Test(matrix, mat_max_h_resized_column_test)
+{
+    // A column resized from a wider matrix keeps the stride of its rows.
+    Matrix *m = mat_create_zero(20, 4);
+    mat_resize(m, 20, 1);
+    *mat_coef_ptr(m, 7, 0) = 5.0f;
+
+    cr_assert_eq(mat_max_h(m), 7);
+
+    mat_free(m);
+}
+
+Test(matrix, mat_view_strip_margins_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 60 + 2;
+        size_t width = rand() % 60 + 2;
+        size_t h = rand() % height, w = rand() % width;
+        size_t box_height = rand() % (height - h) + 1;
+        size_t box_width = rand() % (width - w) + 1;
+
+        // Activated corners of the box, noise inside.
+        Matrix *m = mat_create_padded(height, width);
+        for (size_t i = h; i < h + box_height; i++)
+            for (size_t j = w; j < w + box_width; j++)
+                *mat_coef_ptr(m, i, j) = (float)(rand() % 2);
+        *mat_coef_ptr(m, h, w) = 1.0f;
+        *mat_coef_ptr(m, h + box_height - 1, w + box_width - 1) = 1.0f;
+
+        MatView v = mat_view_strip_margins(mat_view(m));
+
+        cr_assert_eq(v.height, box_height);
+        cr_assert_eq(v.width, box_width);
+        cr_assert_eq(v.content, mat_coef_ptr(m, h, w));
+
+        // Scaling the view or a copy of it gives the same letter.
+        Matrix *stripped = mat_strip_margins(m);
+        Matrix *expected = mat_scale_to_28(stripped, 0.0f);
+        Matrix *actual = mat_view_scale_to_28(v, 0.0f);
+        cr_assert(mat_eq(expected, actual, 0.0f));
+
+        mat_free(actual);
+        mat_free(expected);
+        mat_free(stripped);
+        mat_free(m);
+    }
+
+    Matrix *m = mat_create_zero(5, 5);
+    MatView v = mat_view_strip_margins(mat_view(m));
+    cr_assert_eq(v.height, 0);
+    cr_assert_eq(v.width, 0);
+    mat_free(m);
+}
+
 Test(matrix, mat_normalize_random_test)
 {
     REPEAT
@@ -585,6 +1107,15 @@ Test(matrix, mat_save_and_load_random_test)
         Matrix *original =
             mat_create_random_uniform(height, width, -1E3f, 1E3f);
 
+        // The padding of the rows is not saved.
+        if (rand() % 2)
+        {
+            Matrix *padded = mat_create_padded(height, width);
+            mat_copy(padded, original);
+            mat_free(original);
+            original = padded;
+        }
+
         mat_save_to_file(original, "./save_and_load_random_test.matrix");
         Matrix *m = mat_load_from_file("./save_and_load_random_test.matrix");
 
@@ -605,4 +1136,70 @@ Test(matrix, mat_save_and_load_random_test)
         mat_free(m);
         mat_free(original);
     }
-}
\ No newline at end of file
+}
+
+Test(matrix, mat_mmap_file_legacy_test)
+{
+    float arr[9] = {0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f};
+    Matrix *expected = mat_create_from_arr(3, 3, arr);
+
+    Matrix *m = mat_mmap_file("./src/test/matrix/test_load_1.matrix");
+
+    cr_assert(mat_eq(m, expected, 0.0f));
+
+    mat_free(m);
+    mat_free(expected);
+}
+
+Test(matrix, mat_save_and_mmap_v2_random_test)
+{
+    REPEAT
+    {
+        size_t height = rand() % 200 + 1;
+        size_t width = rand() % 200 + 1;
+
+        Matrix *original =
+            mat_create_random_uniform(height, width, -1E3f, 1E3f);
+        Matrix *padded = mat_create_padded(height, width);
+        mat_copy(padded, original);
+
+        mat_save_to_file_v2(rand() % 2 ? padded : original,
+                            "./save_and_load_v2_test.matrix");
+
+        Matrix *loaded = mat_load_from_file("./save_and_load_v2_test.matrix");
+        Matrix *mapped = mat_mmap_file("./save_and_load_v2_test.matrix");
+
+        cr_assert(mat_eq(loaded, original, 0.0f));
+        cr_assert(mat_eq(mapped, original, 0.0f));
+        cr_assert_eq(
+            (uintptr_t)mat_unsafe_coef_ptr(mapped, 0, 0) % MAT_ALIGNMENT, 0);
+
+        // The mapping is private, the file is left untouched.
+        mat_inplace_scalar_multiplication(mapped, 2.0f);
+        mat_free(mapped);
+        mapped = mat_mmap_file("./save_and_load_v2_test.matrix");
+        cr_assert(mat_eq(mapped, original, 0.0f));
+
+        mat_free(mapped);
+        mat_free(loaded);
+        mat_free(padded);
+        mat_free(original);
+    }
+}
+
+Test(matrix, mat_mmap_file_corrupted_test, .exit_code = EXIT_FAILURE)
+{
+    Matrix *m = mat_create_random_uniform(10, 10, -1.0f, 1.0f);
+    mat_save_to_file_v2(m, "./save_and_load_v2_test.matrix");
+    mat_free(m);
+
+    // Flips a bit of the last coefficient.
+    FILE *file = fopen("./save_and_load_v2_test.matrix", "r+b");
+    fseek(file, -1, SEEK_END);
+    int byte = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(byte ^ 1, file);
+    fclose(file);
+
+    mat_free(mat_mmap_file("./save_and_load_v2_test.matrix"));
+}
@@ -0,0 +1,143 @@
+#include <criterion/criterion.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "matrix/matrix.h"
+#include "matrix/matrix_u8.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+static MatU8 *random_image(size_t height, size_t width)
+{
+    MatU8 *m = mat_u8_create(height, width);
+    for (size_t h = 0; h < height; h++)
+        for (size_t w = 0; w < width; w++)
+            *mat_u8_coef_ptr(m, h, w) = rand() % 256;
+    return m;
+}
+
+static size_t clamp_index(long i, size_t length)
+{
+    return i < 0 ? 0 : i >= (long)length ? length - 1 : (size_t)i;
+}
+
+Test(matrix_u8, mat_u8_conversions_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 100 + 1;
+        size_t width = rand() % 100 + 1;
+
+        MatU8 *m = random_image(height, width);
+        cr_assert_eq(mat_u8_stride(m) % MAT_ALIGNMENT, 0);
+        cr_assert_eq((uintptr_t)mat_u8_row(m, 0) % MAT_ALIGNMENT, 0);
+
+        Matrix *f = mat_u8_to_matrix(m);
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                cr_assert_eq(mat_coef(f, h, w), mat_u8_coef(m, h, w));
+
+        MatU8 *back = mat_u8_from_matrix(f);
+        cr_assert(mat_u8_eq(m, back));
+
+        mat_free(f);
+        mat_u8_free(m);
+        mat_u8_free(back);
+    }
+
+    // Rounding and saturation.
+    float values[] = {-3.0f, 0.49f, 0.5f, 254.5f, 300.0f};
+    uint8_t expected[] = {0, 0, 1, 255, 255};
+    Matrix *f = mat_create_from_arr(1, 5, values);
+    MatU8 *m = mat_u8_from_matrix(f);
+    for (size_t w = 0; w < 5; w++)
+        cr_assert_eq(mat_u8_coef(m, 0, w), expected[w]);
+    mat_free(f);
+    mat_u8_free(m);
+}
+
+Test(matrix_u8, mat_u8_extremum_filters_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 60 + 1;
+        size_t width = rand() % 60 + 1;
+        size_t kernel_size = rand() % 6 + 1;
+        long before = kernel_size / 2;
+
+        MatU8 *m = random_image(height, width);
+        MatU8 *max = mat_u8_max_filter(m, kernel_size);
+        MatU8 *min = mat_u8_min_filter(m, kernel_size);
+
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+            {
+                uint8_t expected_max = 0;
+                uint8_t expected_min = 255;
+                for (long i = -before; i < (long)kernel_size - before; i++)
+                    for (long j = -before; j < (long)kernel_size - before; j++)
+                    {
+                        uint8_t v = mat_u8_coef(m, clamp_index(h + i, height),
+                                                clamp_index(w + j, width));
+                        expected_max = v > expected_max ? v : expected_max;
+                        expected_min = v < expected_min ? v : expected_min;
+                    }
+                cr_assert_eq(mat_u8_coef(max, h, w), expected_max);
+                cr_assert_eq(mat_u8_coef(min, h, w), expected_min);
+            }
+
+        mat_u8_free(m);
+        mat_u8_free(max);
+        mat_u8_free(min);
+    }
+}
+
+Test(matrix_u8, mat_u8_adaptive_threshold_random_test)
+{
+    rand_seed();
+
+    REPEAT
+    {
+        size_t height = rand() % 60 + 1;
+        size_t width = rand() % 60 + 1;
+        size_t kernel_size = 2 * (rand() % 6) + 1;
+        long m = kernel_size / 2;
+
+        float kernel[kernel_size];
+        for (size_t i = 0; i < kernel_size; i++)
+            kernel[i] = 1.0f / kernel_size;
+
+        MatU8 *src = random_image(height, width);
+        MatU8 *dst = mat_u8_adaptive_threshold(src, kernel, kernel_size, 5.0f,
+                                               255);
+
+        // Separable blur, in the same order as the float pipeline.
+        Matrix *tmp = mat_create_zero(height, width);
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                for (long i = -m; i <= m; i++)
+                    *mat_coef_ptr(tmp, h, w) +=
+                        kernel[m + i] *
+                        mat_u8_coef(src, h, clamp_index(w + i, width));
+
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+            {
+                float blurred = 0.0f;
+                for (long i = -m; i <= m; i++)
+                    blurred += kernel[m + i] *
+                               mat_coef(tmp, clamp_index(h + i, height), w);
+                uint8_t expected =
+                    mat_u8_coef(src, h, w) > blurred - 5.0f ? 255 : 0;
+                cr_assert_eq(mat_u8_coef(dst, h, w), expected);
+            }
+
+        mat_free(tmp);
+        mat_u8_free(src);
+        mat_u8_free(dst);
+    }
+}
@@ -0,0 +1,100 @@
+#include <criterion/criterion.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+static void count_body(size_t begin, size_t end, void *ctx)
+{
+    atomic_int *counts = ctx;
+    for (size_t i = begin; i < end; i++)
+        atomic_fetch_add(&counts[i], 1);
+}
+
+static void nested_body(size_t begin, size_t end, void *ctx)
+{
+    atomic_int *counts = ctx;
+    for (size_t i = begin; i < end; i++)
+        mat_parallel_for(10, 1, count_body, &counts[10 * i]);
+}
+
+Test(parallel, mat_parallel_for_covers_every_iteration_test)
+{
+    mat_set_thread_count(4);
+    mat_set_parallel_threshold(0);
+
+    for (size_t n = 1; n < 100; n++)
+    {
+        atomic_int counts[1000] = {0};
+
+        mat_parallel_for(n, 1, count_body, counts);
+        for (size_t i = 0; i < n; i++)
+            cr_assert_eq(atomic_load(&counts[i]), 1);
+
+        mat_parallel_for(n, 1, nested_body, counts);
+        for (size_t i = 0; i < 10 * n; i++)
+            cr_assert_eq(atomic_load(&counts[i]), 1 + (i < n));
+    }
+
+    mat_set_parallel_threshold(MAT_PARALLEL_DEFAULT_THRESHOLD);
+    mat_set_thread_count(0);
+}
+
+static float affine(float x) { return 3.0f * x - 1.0f; }
+
+static float with_indexes(float x, size_t h, size_t w)
+{
+    return x + (float)h - 2.0f * (float)w;
+}
+
+Test(parallel, parallel_operations_match_single_thread_random_test)
+{
+    rand_seed();
+    mat_set_parallel_threshold(0);
+
+    REPEAT
+    {
+        size_t height = rand() % 100 + 1;
+        size_t width = rand() % 100 + 1;
+        size_t depth = rand() % 100 + 1;
+
+        Matrix *a = mat_create_random_uniform(height, depth, -1.0f, 1.0f);
+        Matrix *b = mat_create_random_uniform(depth, width, -1.0f, 1.0f);
+        Matrix *c = mat_create_random_uniform(height, depth, -1.0f, 1.0f);
+        Matrix *padded = mat_create_padded(height, depth);
+        mat_copy(padded, c);
+
+        Matrix *results[2][7];
+        for (size_t run = 0; run < 2; run++)
+        {
+            mat_set_thread_count(run == 0 ? 1 : 3);
+
+            results[run][0] = mat_multiplication(a, b);
+            results[run][1] = mat_transpose(a);
+            results[run][2] = mat_addition(a, c);
+            results[run][3] = mat_hadamard(a, padded);
+            results[run][4] = mat_scalar_multiplication(padded, 0.5f);
+            results[run][5] = mat_map(a, affine);
+            results[run][6] = mat_map_with_indexes(padded, with_indexes);
+        }
+
+        for (size_t i = 0; i < 7; i++)
+        {
+            cr_assert(mat_eq(results[0][i], results[1][i], 0.0f),
+                      "Operation %zu differs with 3 threads.", i);
+            mat_free(results[0][i]);
+            mat_free(results[1][i]);
+        }
+
+        mat_free(a);
+        mat_free(b);
+        mat_free(c);
+        mat_free(padded);
+    }
+
+    mat_set_parallel_threshold(MAT_PARALLEL_DEFAULT_THRESHOLD);
+    mat_set_thread_count(0);
+}
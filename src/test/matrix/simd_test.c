@@ -0,0 +1,351 @@
+#include <criterion/criterion.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "matrix/matrix.h"
+#include "matrix/simd.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+void simd_setup(void)
+{
+    unsigned int seed = rand_seed();
+    printf("[INFO] Starting simd testsuite with seed %u (best tier: %s).\n",
+           seed, simd_tier_name(simd_detect_tier()));
+}
+
+/// @brief Asserts that a and b have the same shape and coefficients.
+static void assert_mat_eq(const Matrix *a, const Matrix *b, const char *op,
+                          SimdTier tier)
+{
+    cr_assert_eq(mat_height(a), mat_height(b));
+    cr_assert_eq(mat_width(a), mat_width(b));
+
+    for (size_t h = 0; h < mat_height(a); h++)
+    {
+        for (size_t w = 0; w < mat_width(a); w++)
+        {
+            float expected = mat_coef(a, h, w);
+            float actual = mat_coef(b, h, w);
+            cr_assert_float_eq(actual, expected, epsilon(expected),
+                               "%s (%s): expected %f but got %f at (%zu, %zu)",
+                               op, simd_tier_name(tier), expected, actual, h,
+                               w);
+        }
+    }
+}
+
+Test(simd, simd_set_tier_test, .init = simd_setup)
+{
+    SimdTier best = simd_detect_tier();
+
+    cr_assert_eq(simd_set_tier(SimdScalar), 0);
+    cr_assert_eq(simd_tier(), SimdScalar);
+
+    for (SimdTier tier = SimdScalar; tier <= SimdAvx512; tier++)
+    {
+        if (tier <= best)
+        {
+            cr_assert_eq(simd_set_tier(tier), 0);
+            cr_assert_eq(simd_tier(), tier);
+        }
+        else
+        {
+            cr_assert_eq(simd_set_tier(tier), -1);
+            cr_assert_eq(simd_tier(), best);
+        }
+    }
+}
+
+Test(simd, simd_tiers_match_scalar_random_test, .init = simd_setup)
+{
+    SimdTier best = simd_detect_tier();
+
+    REPEAT
+    {
+        // Odd sizes so that the remainder loops are exercised.
+        size_t height = rand() % 70 + 1;
+        size_t width = rand() % 300 + 1;
+        size_t depth = rand() % 300 + 1;
+
+        Matrix *a = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *b = mat_create_random_uniform(height, width, -1.0f, 1.0f);
+        Matrix *c = mat_create_random_uniform(width, depth, -1.0f, 1.0f);
+        Matrix *x = mat_create_random_uniform(width, 1, -1.0f, 1.0f);
+        Matrix *bias = mat_create_random_uniform(height, 1, -1.0f, 1.0f);
+        float s = rand_f_uniform_nm(-2.0f, 2.0f);
+
+        simd_set_tier(SimdScalar);
+        Matrix *expected[] = {
+            mat_create_filled(height, width, s),
+            mat_addition(a, b),
+            mat_subtraction(a, b),
+            mat_hadamard(a, b),
+            mat_scalar_multiplication(a, s),
+            mat_relu(a),
+            mat_relu_derivative(a),
+            mat_multiplication(a, c),
+            mat_gemv_add_bias(a, x, bias),
+        };
+        const char *names[] = {
+            "fill", "addition",  "subtraction",    "hadamard", "scalar",
+            "relu", "relu_der.", "multiplication", "gemv",
+        };
+
+        for (SimdTier tier = SimdSse42; tier <= best; tier++)
+        {
+            simd_set_tier(tier);
+            Matrix *actual[] = {
+                mat_create_filled(height, width, s),
+                mat_addition(a, b),
+                mat_subtraction(a, b),
+                mat_hadamard(a, b),
+                mat_scalar_multiplication(a, s),
+                mat_relu(a),
+                mat_relu_derivative(a),
+                mat_multiplication(a, c),
+                mat_gemv_add_bias(a, x, bias),
+            };
+
+            for (size_t i = 0; i < sizeof(actual) / sizeof(actual[0]); i++)
+            {
+                assert_mat_eq(expected[i], actual[i], names[i], tier);
+                mat_free(actual[i]);
+            }
+        }
+
+        for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+            mat_free(expected[i]);
+        mat_free(a);
+        mat_free(b);
+        mat_free(c);
+        mat_free(x);
+        mat_free(bias);
+    }
+
+    simd_set_tier(best);
+}
+
+/// @brief Returns the distance in units in the last place between two positive
+/// floats.
+static uint32_t ulp_distance(float a, float b)
+{
+    uint32_t ua, ub;
+    memcpy(&ua, &a, sizeof(float));
+    memcpy(&ub, &b, sizeof(float));
+    return ua > ub ? ua - ub : ub - ua;
+}
+
+Test(simd, simd_exp_ulp_test, .init = simd_setup)
+{
+    SimdTier best = simd_detect_tier();
+
+    // An odd number of points so that the remainders are exercised.
+    const size_t n = 200003;
+    const float min = -87.33f, max = 88.0f;
+    Matrix *x = mat_create(n, 1);
+    for (size_t i = 0; i < n; i++)
+        *mat_coef_ptr(x, i, 0) = min + (max - min) * (float)i / (float)(n - 1);
+
+    for (SimdTier tier = SimdScalar; tier <= best; tier++)
+    {
+        simd_set_tier(tier);
+        Matrix *res = mat_exp(x);
+
+        uint32_t max_ulp = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            float xi = mat_coef(x, i, 0);
+            float expected = (float)exp((double)xi);
+            uint32_t ulp = ulp_distance(mat_coef(res, i, 0), expected);
+            cr_assert_leq(ulp, 2, "exp(%.9g) (%s): expected %.9g but got %.9g",
+                          xi, simd_tier_name(tier), expected,
+                          mat_coef(res, i, 0));
+            if (ulp > max_ulp)
+                max_ulp = ulp;
+        }
+        printf("[INFO] exp (%s): max error of %u ulp.\n", simd_tier_name(tier),
+               max_ulp);
+
+        mat_free(res);
+    }
+
+    // Underflows and overflows.
+    Matrix *edges = mat_create_from_arr(
+        5, 1, (float[]){-1000.0f, -87.34f, -INFINITY, 89.0f, INFINITY});
+    for (SimdTier tier = SimdScalar; tier <= best; tier++)
+    {
+        simd_set_tier(tier);
+        Matrix *res = mat_exp(edges);
+        cr_assert_eq(mat_coef(res, 0, 0), 0.0f);
+        cr_assert_eq(mat_coef(res, 1, 0), 0.0f);
+        cr_assert_eq(mat_coef(res, 2, 0), 0.0f);
+        cr_assert(isfinite(mat_coef(res, 3, 0)));
+        cr_assert(isfinite(mat_coef(res, 4, 0)));
+        mat_free(res);
+    }
+
+    mat_free(edges);
+    mat_free(x);
+    simd_set_tier(best);
+}
+
+static float clamp_ref(float x)
+{
+    return x < -0.5f ? -0.5f : x > 2.0f ? 2.0f : x;
+}
+
+static float threshold_ref(float x) { return x > 0.25f ? 3.0f : -1.0f; }
+
+static float relu_ref(float x) { return x > 0.0f ? x : 0.0f; }
+
+Test(simd, simd_apply_test, .init = simd_setup)
+{
+    SimdTier best = simd_detect_tier();
+
+    // An odd number of points, which does not hit 0, so that the remainders
+    // are exercised and the signs of the results are well-defined.
+    const size_t n = 100003;
+    const float min = -20.0f, max = 19.9f;
+    Matrix *x = mat_create(n, 1);
+    for (size_t i = 0; i < n; i++)
+        *mat_coef_ptr(x, i, 0) = min + (max - min) * (float)i / (float)(n - 1);
+
+    MatOpParams params = {.low = -0.5f, .high = 2.0f, .threshold = 0.0f};
+    MatOpParams threshold = {.low = -1.0f, .high = 3.0f, .threshold = 0.25f};
+
+    Matrix *clamped = mat_map(x, clamp_ref);
+    Matrix *thresholded = mat_map(x, threshold_ref);
+    Matrix *rectified = mat_map(x, relu_ref);
+
+    for (SimdTier tier = SimdScalar; tier <= best; tier++)
+    {
+        simd_set_tier(tier);
+        Matrix *sigmoid = mat_apply(x, MAT_OP_SIGMOID, params);
+        Matrix *tanh_res = mat_apply(x, MAT_OP_TANH, params);
+
+        uint32_t max_sigmoid = 0, max_tanh = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            double xi = mat_coef(x, i, 0);
+            float expected_sigmoid = (float)(1.0 / (1.0 + exp(-xi)));
+            float expected_tanh = (float)tanh(xi);
+            uint32_t ulp_sigmoid =
+                ulp_distance(mat_coef(sigmoid, i, 0), expected_sigmoid);
+            uint32_t ulp_tanh =
+                ulp_distance(mat_coef(tanh_res, i, 0), expected_tanh);
+
+            cr_assert_leq(ulp_sigmoid, 4, "sigmoid(%.9g) (%s): got %.9g", xi,
+                          simd_tier_name(tier), mat_coef(sigmoid, i, 0));
+            cr_assert_leq(ulp_tanh, 3, "tanh(%.9g) (%s): got %.9g", xi,
+                          simd_tier_name(tier), mat_coef(tanh_res, i, 0));
+            max_sigmoid = ulp_sigmoid > max_sigmoid ? ulp_sigmoid : max_sigmoid;
+            max_tanh = ulp_tanh > max_tanh ? ulp_tanh : max_tanh;
+        }
+        printf("[INFO] sigmoid, tanh (%s): max errors of %u and %u ulp.\n",
+               simd_tier_name(tier), max_sigmoid, max_tanh);
+
+        Matrix *actual = mat_deepcopy(x);
+        mat_inplace_apply(actual, MAT_OP_CLAMP, params);
+        cr_assert(mat_eq(actual, clamped, 0.0f), "clamp (%s)",
+                  simd_tier_name(tier));
+        mat_free(actual);
+
+        actual = mat_apply(x, MAT_OP_THRESHOLD, threshold);
+        cr_assert(mat_eq(actual, thresholded, 0.0f), "threshold (%s)",
+                  simd_tier_name(tier));
+        mat_free(actual);
+
+        actual = mat_apply(x, MAT_OP_RELU, params);
+        cr_assert(mat_eq(actual, rectified, 0.0f), "relu (%s)",
+                  simd_tier_name(tier));
+        mat_free(actual);
+
+        mat_free(sigmoid);
+        mat_free(tanh_res);
+    }
+
+    mat_free(clamped);
+    mat_free(thresholded);
+    mat_free(rectified);
+    mat_free(x);
+    simd_set_tier(best);
+}
+
+Test(simd, simd_reductions_random_test, .init = simd_setup)
+{
+    SimdTier best = simd_detect_tier();
+
+    REPEAT
+    {
+        size_t height = rand() % 100 + 1;
+        size_t width = rand() % 100 + 1;
+        Matrix *m = rand() % 2 ? mat_create_padded(height, width)
+                               : mat_create_zero(height, width);
+        for (size_t h = 0; h < height; h++)
+            for (size_t w = 0; w < width; w++)
+                *mat_coef_ptr(m, h, w) = rand_f_uniform_nm(-10.0f, 10.0f);
+
+        double sum = 0.0, sq_sum = 0.0;
+        float max = mat_coef(m, 0, 0);
+        size_t max_h = 0;
+        for (size_t h = 0; h < height; h++)
+        {
+            for (size_t w = 0; w < width; w++)
+            {
+                float c = mat_coef(m, h, w);
+                sum += c;
+                sq_sum += (double)c * c;
+                max = c > max ? c : max;
+            }
+            if (mat_coef(m, h, 0) > mat_coef(m, max_h, 0))
+                max_h = h;
+        }
+        double size = (double)(height * width);
+        double mean = sum / size;
+        double stddev = sqrt(sq_sum / size - mean * mean);
+
+        for (SimdTier tier = SimdScalar; tier <= best; tier++)
+        {
+            simd_set_tier(tier);
+
+            float actual_mean, actual_stddev;
+            mat_mean_stddev(m, &actual_mean, &actual_stddev);
+
+            cr_assert_float_eq(mat_sum(m), sum, 1E-3 * size);
+            cr_assert_eq(mat_max(m), max);
+            cr_assert_float_eq(actual_mean, mean, 1E-3);
+            cr_assert_float_eq(actual_stddev, stddev, 1E-3);
+
+            Matrix *column = mat_create_zero(height, 1);
+            for (size_t h = 0; h < height; h++)
+                *mat_coef_ptr(column, h, 0) = mat_coef(m, h, 0);
+            cr_assert_eq(mat_max_h(column), max_h);
+            mat_free(column);
+
+            // Softmax against libm.
+            Matrix *softmax = mat_softmax(m);
+            double exp_sum = 0.0;
+            for (size_t h = 0; h < height; h++)
+                for (size_t w = 0; w < width; w++)
+                    exp_sum += exp((double)(mat_coef(m, h, w) - max));
+            for (size_t h = 0; h < height; h++)
+            {
+                for (size_t w = 0; w < width; w++)
+                {
+                    double expected =
+                        exp((double)(mat_coef(m, h, w) - max)) / exp_sum;
+                    cr_assert_float_eq(mat_coef(softmax, h, w), expected,
+                                       1E-6 + 1E-5 * expected);
+                }
+            }
+            mat_free(softmax);
+        }
+
+        mat_free(m);
+    }
+
+    simd_set_tier(best);
+}
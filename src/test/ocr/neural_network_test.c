@@ -0,0 +1,562 @@
+#include <criterion/criterion.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "matrix/arena.h"
+#include "matrix/matrix.h"
+#include "matrix/parallel.h"
+#include "ocr/dataset.h"
+#include "ocr/neural_network.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+/// @brief Returns the number of matrix heap allocations made by net_train.
+static size_t train_heap_allocations(Neural_Network *net, Dataset *ds,
+                                     size_t epochs)
+{
+    size_t allocations = mat_heap_allocations();
+    net_train(net, ds, epochs, 8, 0.01f);
+    return mat_heap_allocations() - allocations;
+}
+
+Test(neural_network, net_train_steady_state_allocations_test)
+{
+    rand_seed();
+
+    Dataset *ds = ds_create_empty();
+    for (size_t i = 0; i < 32; i++)
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        ds_add_tuple(ds, td_create(input, i % 26));
+    }
+
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+
+    // The matrices of the first batch are recycled by every following one:
+    // more epochs do not mean more heap allocations.
+    size_t one_epoch = train_heap_allocations(net, ds, 1);
+    size_t three_epochs = train_heap_allocations(net, ds, 3);
+
+    cr_assert_eq(one_epoch, three_epochs,
+                 "1 epoch: %zu heap allocations, 3 epochs: %zu", one_epoch,
+                 three_epochs);
+    cr_assert_lt(one_epoch, 64, "%zu heap allocations", one_epoch);
+
+    net_free(net);
+    ds_free(ds);
+}
+
+Test(neural_network, net_feed_forward_random_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(4, (size_t[]){784, 64, 32, 26});
+    size_t layers = net_layer_number(net);
+
+    REPEAT
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        Matrix *results[layers], *activations[layers];
+
+        Matrix *out = net_feed_forward(net, input, results, activations);
+        Matrix *inference = net_feed_forward(net, input, NULL, NULL);
+
+        cr_assert(mat_eq(out, inference, 0.0f));
+        cr_assert(mat_eq(out, activations[layers - 1], 0.0f));
+        cr_assert(mat_eq(input, activations[0], 0.0f));
+
+        for (size_t i = 1; i < layers - 1; i++)
+        {
+            Matrix *relu = mat_relu(results[i]);
+            cr_assert(mat_eq(relu, activations[i], 0.0f));
+            mat_free(relu);
+        }
+
+        float sum = 0.0f;
+        for (size_t h = 0; h < 26; h++)
+            sum += mat_coef(out, h, 0);
+        cr_assert_float_eq(sum, 1.0f, 1E-5f);
+
+        mat_free(input);
+        mat_free(out);
+        mat_free(inference);
+        for (size_t i = 0; i < layers; i++)
+        {
+            if (results[i] != NULL)
+                mat_free(results[i]);
+            mat_free(activations[i]);
+        }
+    }
+
+    net_free(net);
+}
+
+/// @brief Returns the pre-activations of a layer for input columns, computed
+/// by the general matrix product, which has no sparse path.
+static Matrix *dense_reference(const Neural_Network *net, size_t layer,
+                               const Matrix *inputs)
+{
+    Matrix *pre = mat_multiplication(net_layer_weights(net, layer), inputs);
+    mat_inplace_add_column(pre, net_layer_biases(net, layer));
+    return pre;
+}
+
+/// @brief Returns the outputs of a network for input columns, computed layer
+/// by layer by `dense_reference`.
+static Matrix *dense_feed_forward(const Neural_Network *net,
+                                  const Matrix *inputs)
+{
+    size_t layers = net_layer_number(net);
+    Matrix *act = dense_reference(net, 1, inputs);
+    for (size_t i = 2; i < layers; i++)
+    {
+        mat_inplace_relu(act);
+        Matrix *next = dense_reference(net, i, act);
+        mat_free(act);
+        act = next;
+    }
+    mat_inplace_column_softmax(act);
+    return act;
+}
+
+/// @brief Returns a binary input column with about 1 in 8 ones, sparse enough
+/// for the sparse first layer (at most 25% of ones).
+static Matrix *create_sparse_input(void)
+{
+    Matrix *input = mat_create_zero(784, 1);
+    for (size_t h = 0; h < 784; h++)
+        if (rand() % 8 == 0)
+            *mat_coef_ptr(input, h, 0) = 1.0f;
+    return input;
+}
+
+Test(neural_network, net_sparse_input_forward_random_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(4, (size_t[]){784, 64, 32, 26});
+
+    REPEAT
+    {
+        Matrix *input = create_sparse_input();
+
+        // The first layer only sums the weights of the ones.
+        Matrix *pre = mat_create(64, 1), *act = mat_create(64, 1);
+        net_dense_forward(net, 1, input, pre, act);
+        Matrix *expected = dense_reference(net, 1, input);
+        cr_assert(mat_eq(pre, expected, 1E-5f));
+        mat_inplace_relu(expected);
+        cr_assert(mat_eq(act, expected, 1E-5f));
+        mat_free(expected);
+
+        Matrix *out = net_feed_forward(net, input, NULL, NULL);
+        expected = dense_feed_forward(net, input);
+        cr_assert(mat_eq(out, expected, 1E-5f));
+        mat_free(expected);
+
+        mat_free(out);
+        mat_free(act);
+        mat_free(pre);
+        mat_free(input);
+    }
+
+    net_free(net);
+}
+
+Test(neural_network, net_dense_forward_resized_column_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+
+    REPEAT
+    {
+        // Columns resized from batch buffers keep the stride of their rows.
+        Matrix *input = mat_create_random_uniform(784, 4, 0.0f, 1.0f);
+        Matrix *pre = mat_create_zero(32, 4), *act = mat_create_zero(32, 3);
+        Matrix *out = mat_create_zero(26, 2);
+        mat_resize(input, 784, 1);
+        mat_resize(pre, 32, 1);
+        mat_resize(act, 32, 1);
+        mat_resize(out, 26, 1);
+
+        // A sparse binary input, like the images of the OCR.
+        if (rand() % 2)
+        {
+            Matrix *sparse = create_sparse_input();
+            mat_copy(input, sparse);
+            mat_free(sparse);
+        }
+
+        net_dense_forward(net, 1, input, pre, act);
+        Matrix *expected = dense_reference(net, 1, input);
+        cr_assert(mat_eq(pre, expected, 1E-5f));
+        mat_inplace_relu(expected);
+        cr_assert(mat_eq(act, expected, 1E-5f));
+        mat_free(expected);
+
+        net_dense_forward(net, 2, act, out, out);
+        expected = dense_reference(net, 2, act);
+        mat_inplace_softmax(expected);
+        cr_assert(mat_eq(out, expected, 1E-5f));
+        mat_free(expected);
+
+        mat_free(out);
+        mat_free(act);
+        mat_free(pre);
+        mat_free(input);
+    }
+
+    net_free(net);
+}
+
+Test(neural_network, net_feed_forward_batch_random_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+    Matrix *blank = mat_create_zero(784, 1);
+
+    REPEAT
+    {
+        size_t batch_size = rand() % 40 + 1;
+        Matrix *inputs[batch_size];
+        const Matrix *columns[batch_size];
+        for (size_t w = 0; w < batch_size; w++)
+        {
+            // Some images could not be read.
+            inputs[w] = rand() % 4
+                            ? mat_create_random_uniform(784, 1, 0.0f, 1.0f)
+                            : NULL;
+            columns[w] = inputs[w] != NULL ? inputs[w] : blank;
+        }
+
+        Matrix *batch = mat_create(784, batch_size);
+        mat_set_columns(batch, columns);
+
+        Matrix *out = net_feed_forward_batch(net, batch);
+        char letters[batch_size], array_letters[batch_size];
+        float confidences[batch_size];
+        net_decode_letters(net, batch, letters, confidences);
+        net_decode_letter_array(net, inputs, batch_size, array_letters);
+
+        cr_assert_eq(mat_height(out), 26);
+        cr_assert_eq(mat_width(out), batch_size);
+
+        for (size_t w = 0; w < batch_size; w++)
+        {
+            if (inputs[w] == NULL)
+            {
+                cr_assert_eq(array_letters[w], '?');
+                continue;
+            }
+
+            Matrix *expected = net_feed_forward(net, inputs[w], NULL, NULL);
+            for (size_t h = 0; h < 26; h++)
+                cr_assert_float_eq(mat_coef(out, h, w),
+                                   mat_coef(expected, h, 0), 1E-5f);
+
+            char letter = net_decode_letter(net, inputs[w], NULL);
+            cr_assert_eq(letters[w], letter);
+            cr_assert_eq(array_letters[w], letter);
+            cr_assert_float_eq(confidences[w],
+                               mat_coef(expected, letter - 'a', 0), 1E-5f);
+
+            mat_free(expected);
+            mat_free(inputs[w]);
+        }
+
+        mat_free(out);
+        mat_free(batch);
+    }
+
+    mat_free(blank);
+    net_free(net);
+}
+
+/// @brief Sums the gradients of net_back_propagation over the samples of a
+/// dataset into new matrices.
+static void sum_gradients(Neural_Network *net, Dataset *ds, Matrix **nabla_w,
+                          Matrix **nabla_b)
+{
+    size_t layers = net_layer_number(net);
+
+    for (size_t i = 0; i < ds_size(ds); i++)
+    {
+        Training_Data *td = ds_get_data(ds, i);
+        Matrix *results[layers], *activations[layers];
+        Matrix *delta_nabla_w[layers], *delta_nabla_b[layers];
+
+        Matrix *out = net_feed_forward(net, td->input, results, activations);
+        net_back_propagation(net, td->expected, results, activations,
+                             delta_nabla_w, delta_nabla_b);
+
+        for (size_t j = 1; j < layers; j++)
+        {
+            if (i == 0)
+            {
+                nabla_w[j] = delta_nabla_w[j];
+                nabla_b[j] = delta_nabla_b[j];
+                continue;
+            }
+            mat_inplace_addition(nabla_w[j], delta_nabla_w[j]);
+            mat_inplace_addition(nabla_b[j], delta_nabla_b[j]);
+            mat_free(delta_nabla_w[j]);
+            mat_free(delta_nabla_b[j]);
+        }
+
+        mat_free(out);
+        for (size_t j = 0; j < layers; j++)
+        {
+            if (results[j] != NULL)
+                mat_free(results[j]);
+            mat_free(activations[j]);
+        }
+    }
+}
+
+Test(neural_network, net_train_batch_gradients_random_test)
+{
+    unsigned int seed = rand_seed();
+
+    Dataset *ds = ds_create_empty();
+    for (size_t i = 0; i < 16; i++)
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        ds_add_tuple(ds, td_create(input, rand() % 26));
+    }
+
+    // Two identical networks.
+    srand(seed);
+    Neural_Network *net = net_create_empty(4, (size_t[]){784, 64, 32, 26});
+    srand(seed);
+    Neural_Network *ref = net_create_empty(4, (size_t[]){784, 64, 32, 26});
+    size_t layers = net_layer_number(net);
+
+    // A single batch of the whole dataset: its gradients do not depend on the
+    // order of the samples.
+    net_train(net, ds, 1, ds_size(ds), 0.1f);
+
+    Matrix *nabla_w[layers], *nabla_b[layers];
+    sum_gradients(ref, ds, nabla_w, nabla_b);
+    net_update(ref, nabla_w, nabla_b, ds_size(ds), 0.1f);
+
+    REPEAT
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        Matrix *out = net_feed_forward(net, input, NULL, NULL);
+        Matrix *expected = net_feed_forward(ref, input, NULL, NULL);
+
+        cr_assert(mat_eq(out, expected, 1E-5f));
+
+        mat_free(input);
+        mat_free(out);
+        mat_free(expected);
+    }
+
+    for (size_t j = 1; j < layers; j++)
+    {
+        mat_free(nabla_w[j]);
+        mat_free(nabla_b[j]);
+    }
+    net_free(net);
+    net_free(ref);
+    ds_free(ds);
+}
+
+Test(neural_network, net_workspace_random_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(4, (size_t[]){784, 64, 32, 26});
+    size_t layers = net_layer_number(net);
+    Net_Workspace *ws = net_workspace_create(net, 24);
+
+    REPEAT
+    {
+        // Batches of every size up to the maximum share the same buffers.
+        // Sparse binary batches, like the images of the OCR, go through the
+        // sparse first layer and the bit-packed gradients of its weights.
+        size_t batch_size = rand() % 24 + 1;
+        int sparse = rand() % 2;
+        Dataset *ds = ds_create_empty();
+        const Matrix *inputs[batch_size], *expected[batch_size];
+        for (size_t i = 0; i < batch_size; i++)
+        {
+            Matrix *input = sparse
+                                ? create_sparse_input()
+                                : mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+            ds_add_tuple(ds, td_create(input, rand() % 26));
+            inputs[i] = input;
+            expected[i] = ds_get_data(ds, i)->expected;
+        }
+        Matrix *batch = mat_create(784, batch_size);
+        mat_set_columns(batch, inputs);
+
+        size_t allocations = mat_heap_allocations();
+        net_workspace_load(ws, inputs, expected, batch_size);
+        const Matrix *out = net_feed_forward_workspace(net, ws);
+        net_back_propagation_workspace(net, ws);
+        cr_assert_eq(mat_heap_allocations(), allocations);
+
+        Matrix *ref_out = dense_feed_forward(net, batch);
+        cr_assert(mat_eq((Matrix *)out, ref_out, 1E-5f));
+        Matrix *batch_out = net_feed_forward_batch(net, batch);
+        cr_assert(mat_eq(batch_out, ref_out, 1E-5f));
+        mat_free(batch_out);
+
+        Matrix *nabla_w[layers], *nabla_b[layers];
+        sum_gradients(net, ds, nabla_w, nabla_b);
+        for (size_t j = 1; j < layers; j++)
+        {
+            cr_assert(mat_eq(net_workspace_nabla_w(ws, j), nabla_w[j], 1E-4f));
+            cr_assert(mat_eq(net_workspace_nabla_b(ws, j), nabla_b[j], 1E-4f));
+            mat_free(nabla_w[j]);
+            mat_free(nabla_b[j]);
+        }
+
+        mat_free(ref_out);
+        mat_free(batch);
+        ds_free(ds);
+    }
+
+    net_workspace_free(ws);
+    net_free(net);
+}
+
+/// @brief Trains the network created by srand(seed) on a dataset of 40 random
+/// samples with net_train_parallel on threads threads, every loop being
+/// parallelized, and returns it.
+static Neural_Network *train_parallel(unsigned int seed, size_t shard_count,
+                                      size_t threads)
+{
+    srand(seed);
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+    Dataset *ds = ds_create_empty();
+    for (size_t i = 0; i < 40; i++)
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        ds_add_tuple(ds, td_create(input, rand() % 26));
+    }
+
+    mat_set_thread_count(threads);
+    mat_set_parallel_threshold(0);
+    net_train_parallel(net, ds, 2, 10, 0.1f, shard_count);
+    mat_set_parallel_threshold(MAT_PARALLEL_DEFAULT_THRESHOLD);
+    mat_set_thread_count(0);
+
+    ds_free(ds);
+    return net;
+}
+
+Test(neural_network, net_train_parallel_deterministic_test)
+{
+    unsigned int seed = rand_seed();
+
+    Neural_Network *single = train_parallel(seed, 1, 1);
+    Neural_Network *serial = train_parallel(seed, 3, 1);
+    Neural_Network *parallel = train_parallel(seed, 3, 4);
+    Neural_Network *again = train_parallel(seed, 3, 4);
+
+    REPEAT
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        Matrix *single_out = net_feed_forward(single, input, NULL, NULL);
+        Matrix *serial_out = net_feed_forward(serial, input, NULL, NULL);
+        Matrix *parallel_out = net_feed_forward(parallel, input, NULL, NULL);
+        Matrix *again_out = net_feed_forward(again, input, NULL, NULL);
+
+        // Only the rounding of the sums of the shards differs from a single
+        // shard, and the threads running them do not change anything.
+        cr_assert(mat_eq(serial_out, single_out, 1E-5f));
+        cr_assert(mat_eq(parallel_out, serial_out, 0.0f));
+        cr_assert(mat_eq(again_out, serial_out, 0.0f));
+
+        mat_free(input);
+        mat_free(single_out);
+        mat_free(serial_out);
+        mat_free(parallel_out);
+        mat_free(again_out);
+    }
+
+    net_free(single);
+    net_free(serial);
+    net_free(parallel);
+    net_free(again);
+}
+
+/// @brief Asserts that two networks have the same shape, weights and biases.
+static void assert_same_network(const Neural_Network *a,
+                                const Neural_Network *b)
+{
+    cr_assert_eq(net_layer_number(a), net_layer_number(b));
+    for (size_t i = 0; i < net_layer_number(a); i++)
+        cr_assert_eq(net_layer_height(a, i), net_layer_height(b, i));
+    for (size_t i = 1; i < net_layer_number(a); i++)
+    {
+        cr_assert(mat_eq((Matrix *)net_layer_weights(a, i),
+                         (Matrix *)net_layer_weights(b, i), 0.0f));
+        cr_assert(mat_eq((Matrix *)net_layer_biases(a, i),
+                         (Matrix *)net_layer_biases(b, i), 0.0f));
+    }
+}
+
+Test(neural_network, net_save_and_load_v2_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(4, (size_t[]){784, 50, 30, 26});
+    net_save_to_file(net, "./net_save_and_load_legacy_test.nn");
+    net_save_to_file_v2(net, "./net_save_and_load_v2_test.nn");
+
+    Neural_Network *legacy =
+        net_load_from_file("./net_save_and_load_legacy_test.nn");
+    // Loading a version 2 file creates no matrix of its own.
+    size_t allocations = mat_heap_allocations();
+    Neural_Network *mapped =
+        net_load_from_file("./net_save_and_load_v2_test.nn");
+    cr_assert_eq(mat_heap_allocations(), allocations);
+    assert_same_network(legacy, net);
+    assert_same_network(mapped, net);
+
+    // The transposed weights of the sparse inputs are built on the first
+    // sparse pass.
+    Matrix *sparse = mat_create_zero(784, 1);
+    for (size_t h = 0; h < 784; h += 13)
+        *mat_coef_ptr(sparse, h, 0) = 1.0f;
+    Matrix *expected = net_feed_forward(net, sparse, NULL, NULL);
+    Matrix *out = net_feed_forward(mapped, sparse, NULL, NULL);
+    cr_assert(mat_eq(out, expected, 1E-5f));
+    mat_free(out);
+    mat_free(expected);
+    mat_free(sparse);
+
+    // The matrices are used in place, aligned for the kernels.
+    for (size_t i = 1; i < net_layer_number(mapped); i++)
+    {
+        const Matrix *weights = net_layer_weights(mapped, i);
+        uintptr_t first = (uintptr_t)mat_coef_ptr(weights, 0, 0);
+        cr_assert_eq(first % MAT_ALIGNMENT, 0);
+    }
+
+    // Training the mapped network does not modify the file.
+    Dataset *ds = ds_create_empty();
+    for (size_t i = 0; i < 16; i++)
+    {
+        Matrix *input = mat_create_random_uniform(784, 1, 0.0f, 1.0f);
+        ds_add_tuple(ds, td_create(input, i % 26));
+    }
+    net_train(mapped, ds, 1, 8, 0.1f);
+    cr_assert(!mat_eq((Matrix *)net_layer_weights(mapped, 1),
+                      (Matrix *)net_layer_weights(net, 1), 0.0f));
+
+    Neural_Network *reloaded =
+        net_load_from_file("./net_save_and_load_v2_test.nn");
+    assert_same_network(reloaded, net);
+
+    ds_free(ds);
+    net_free(reloaded);
+    net_free(mapped);
+    net_free(legacy);
+    net_free(net);
+}
@@ -0,0 +1,118 @@
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "matrix/matrix.h"
+#include "ocr/neural_network.h"
+#include "ocr/ocr_client.h"
+#include "ocr/ocr_protocol.h"
+#include "ocr/ocr_server.h"
+#include "utils/random/random.h"
+
+#define SOCKET_PATH "./ocr_server_test.sock"
+#define MODEL_PATH "./ocr_server_test.nn"
+
+static void *run_server(void *server)
+{
+    ocr_server_run(server);
+    return NULL;
+}
+
+Test(ocr_server, ocr_server_decode_letters_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+    net_save_to_file_v2(net, MODEL_PATH);
+
+    char *model_paths[] = {MODEL_PATH};
+    OcrServer *server = ocr_server_create(SOCKET_PATH, model_paths, 1);
+    OcrModelId id;
+    cr_assert_eq(ocr_model_id(MODEL_PATH, &id), 0);
+
+    // Only the user may connect to the socket.
+    struct stat st;
+    cr_assert_eq(stat(SOCKET_PATH, &st), 0);
+    cr_assert(S_ISSOCK(st.st_mode));
+    cr_assert_eq(st.st_mode & 077, 0);
+
+    pthread_t thread;
+    cr_assert_eq(pthread_create(&thread, NULL, run_server, server), 0);
+
+    Matrix *inputs = mat_create_random_uniform(784, 37, 0.0f, 1.0f);
+    char expected_letters[37], letters[37];
+    float expected_confidences[37], confidences[37];
+    net_decode_letters(net, inputs, expected_letters, expected_confidences);
+
+    // Several requests are served on the same connection.
+    OcrClient *client = ocr_client_connect(SOCKET_PATH);
+    cr_assert_not_null(client);
+    for (size_t i = 0; i < 2; i++)
+    {
+        cr_assert_eq(ocr_client_decode_letters(client, &id, inputs, letters,
+                                               confidences),
+                     0);
+        cr_assert_arr_eq(letters, expected_letters, sizeof(letters));
+        cr_assert_arr_eq(confidences, expected_confidences,
+                         sizeof(confidences));
+    }
+    ocr_client_close(client);
+
+    // The server refuses the models it did not load, another file of a model
+    // it loaded and the images of another height.
+    client = ocr_client_connect(SOCKET_PATH);
+    OcrModelId other = id;
+    strcpy(other.name, "unknown");
+    cr_assert_eq(ocr_client_decode_letters(client, &other, inputs, letters,
+                                           NULL),
+                 -1);
+    other = id;
+    other.checksum ^= 1;
+    cr_assert_eq(ocr_client_decode_letters(client, &other, inputs, letters,
+                                           NULL),
+                 -1);
+    Matrix *small = mat_create_random_uniform(100, 3, 0.0f, 1.0f);
+    cr_assert_eq(ocr_client_decode_letters(client, &id, small, letters,
+                                           NULL),
+                 -1);
+    ocr_client_close(client);
+
+    // A header announcing 16 GiB of images of the wrong height is refused
+    // without allocating them, and the server still serves.
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    strcpy(addr.sun_path, SOCKET_PATH);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    cr_assert_eq(connect(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    OcrRequest huge = {
+        .magic = OCR_PROTOCOL_MAGIC,
+        .version = OCR_PROTOCOL_VERSION,
+        .count = OCR_MAX_BATCH,
+        .input_height = 1 << 20,
+        .model_checksum = id.checksum,
+    };
+    strcpy(huge.model, id.name);
+    cr_assert_eq(write(fd, &huge, sizeof(huge)), (ssize_t)sizeof(huge));
+    close(fd);
+
+    client = ocr_client_connect(SOCKET_PATH);
+    cr_assert_eq(ocr_client_decode_letters(client, &id, inputs, letters, NULL),
+                 0);
+    cr_assert_arr_eq(letters, expected_letters, sizeof(letters));
+    ocr_client_close(client);
+
+    ocr_server_stop(server);
+    pthread_join(thread, NULL);
+    ocr_server_free(server);
+    // The lock file is left by the server on purpose.
+    unlink(SOCKET_PATH ".lock");
+
+    cr_assert_null(ocr_client_connect(SOCKET_PATH));
+
+    mat_free(small);
+    mat_free(inputs);
+    net_free(net);
+}
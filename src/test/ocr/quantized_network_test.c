@@ -0,0 +1,116 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+
+#include "matrix/matrix.h"
+#include "ocr/neural_network.h"
+#include "ocr/quantized_network.h"
+#include "test_settings.h"
+#include "utils/random/random.h"
+
+/// @brief Returns a random binary letter image.
+static Matrix *random_binary_input(void)
+{
+    Matrix *input = mat_create(784, 1);
+    for (size_t h = 0; h < 784; h++)
+        *mat_coef_ptr(input, h, 0) = rand() % 4 == 0 ? 1.0f : 0.0f;
+    return input;
+}
+
+Test(quantized_network, qnet_feed_forward_random_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(4, (size_t[]){784, 64, 32, 26});
+    Quantized_Network *qnet = qnet_quantize(net);
+
+    cr_assert_eq(qnet_layer_number(qnet), net_layer_number(net));
+    for (size_t i = 0; i < net_layer_number(net); i++)
+        cr_assert_eq(qnet_layer_height(qnet, i), net_layer_height(net, i));
+
+    REPEAT
+    {
+        Matrix *input = random_binary_input();
+
+        Matrix *expected = net_feed_forward(net, input, NULL, NULL);
+        Matrix *out = qnet_feed_forward(qnet, input);
+
+        cr_assert(mat_eq(out, expected, 0.02f));
+
+        float sum = 0.0f;
+        for (size_t h = 0; h < 26; h++)
+            sum += mat_coef(out, h, 0);
+        cr_assert_float_eq(sum, 1.0f, 1E-5f);
+
+        mat_free(input);
+        mat_free(expected);
+        mat_free(out);
+    }
+
+    qnet_free(qnet);
+    net_free(net);
+}
+
+Test(quantized_network, qnet_decode_letters_random_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+    Quantized_Network *qnet = qnet_quantize(net);
+
+    size_t n = rand() % 64 + 1;
+    Matrix *columns[n];
+    for (size_t i = 0; i < n; i++)
+        columns[i] = random_binary_input();
+    Matrix *inputs = mat_create(784, n);
+    mat_set_columns(inputs, (const Matrix **)columns);
+
+    char letters[n];
+    float confidences[n];
+    qnet_decode_letters(qnet, inputs, letters, confidences);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        float confidence;
+        char letter = qnet_decode_letter(qnet, columns[i], &confidence);
+        cr_assert_eq(letters[i], letter);
+        cr_assert_float_eq(confidences[i], confidence, 1E-6f);
+        mat_free(columns[i]);
+    }
+
+    mat_free(inputs);
+    qnet_free(qnet);
+    net_free(net);
+}
+
+Test(quantized_network, qnet_save_and_load_test)
+{
+    rand_seed();
+
+    Neural_Network *net = net_create_empty(3, (size_t[]){784, 32, 26});
+    Quantized_Network *original = qnet_quantize(net);
+    qnet_save_to_file(original, "./qnet_save_and_load_test.qnn");
+    Quantized_Network *loaded =
+        qnet_load_from_file("./qnet_save_and_load_test.qnn");
+
+    cr_assert_eq(qnet_layer_number(loaded), qnet_layer_number(original));
+    for (size_t i = 0; i < qnet_layer_number(original); i++)
+        cr_assert_eq(qnet_layer_height(loaded, i),
+                     qnet_layer_height(original, i));
+
+    REPEAT
+    {
+        Matrix *input = random_binary_input();
+
+        Matrix *expected = qnet_feed_forward(original, input);
+        Matrix *out = qnet_feed_forward(loaded, input);
+        cr_assert(mat_eq(out, expected, 0.0f));
+
+        mat_free(input);
+        mat_free(expected);
+        mat_free(out);
+    }
+
+    qnet_free(loaded);
+    qnet_free(original);
+    net_free(net);
+}
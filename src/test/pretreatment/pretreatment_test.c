@@ -32,3 +32,35 @@ Test(pretreatment, clamp_failure, .exit_code = EXIT_FAILURE)
 {
     clamp(-20, 10, 0);
 }
+
+Test(pretreatment, u8_pipeline_matches_float_random_test)
+{
+    Matrix *gray = mat_create_random_uniform(97, 131, 0.0f, 255.0f);
+    MatU8 *gray_u8 = mat_u8_from_matrix(gray);
+    mat_free(gray);
+    gray = mat_u8_to_matrix(gray_u8);
+
+    Matrix *threshold = adaptative_gaussian_thresholding(gray, 255, 11, 7, 4);
+    MatU8 *threshold_u8 =
+        adaptative_gaussian_thresholding_u8(gray_u8, 255, 11, 7, 4);
+    MatU8 *expected = mat_u8_from_matrix(threshold);
+    cr_assert(mat_u8_eq(threshold_u8, expected));
+    mat_u8_free(expected);
+
+    enum MorphTransform transforms[] = {Erosion, Dilation, Opening, Closing};
+    for (size_t i = 0; i < 4; i++)
+    {
+        Matrix *morph = morph_transform(gray, 3, transforms[i]);
+        MatU8 *morph_u8 = morph_transform_u8(gray_u8, 3, transforms[i]);
+        expected = mat_u8_from_matrix(morph);
+        cr_assert(mat_u8_eq(morph_u8, expected));
+        mat_free(morph);
+        mat_u8_free(morph_u8);
+        mat_u8_free(expected);
+    }
+
+    mat_free(gray);
+    mat_free(threshold);
+    mat_u8_free(gray_u8);
+    mat_u8_free(threshold_u8);
+}
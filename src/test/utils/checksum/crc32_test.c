@@ -0,0 +1,28 @@
+#include <criterion/criterion.h>
+
+#include "utils/checksum/crc32.h"
+
+Test(crc32, crc32_check_value_test)
+{
+    // The check value of the CRC-32 catalogue.
+    const char *digits = "123456789";
+    cr_assert_eq(crc32_update(0, digits, 9), 0xCBF43926u);
+    cr_assert_eq(crc32_update(0, NULL, 0), 0);
+}
+
+Test(crc32, crc32_in_several_calls_test)
+{
+    unsigned char data[100];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (unsigned char)(i * 37 + 11);
+
+    uint32_t whole = crc32_update(0, data, sizeof(data));
+    for (size_t split = 0; split <= sizeof(data); split++)
+        cr_assert_eq(crc32_update(crc32_update(0, data, split), data + split,
+                                  sizeof(data) - split),
+                     whole);
+
+    // A single flipped bit changes the checksum.
+    data[42] ^= 4;
+    cr_assert_neq(crc32_update(0, data, sizeof(data)), whole);
+}